@@ -78,6 +78,7 @@ function(enable_bindings_generation)
 		Mobs/Monster.h
 		Mobs/MonsterTypes.h
 		OSSupport/File.h
+		PreGenerator.h
 		Protocol/MojangAPI.h
 		Registries/CustomStatistics.h
 		Root.h
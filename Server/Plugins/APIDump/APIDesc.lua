@@ -11617,6 +11617,120 @@ a_Player:OpenWindow(Window);
 			Inherits = "cPawn",
 		},  -- cPlayer
 
+		cPreGenerator =
+		{
+			Desc = [[
+				This class is associated with a single {{cWorld}} instance and pre-generates an area of the world in
+				the background - a rectangle or a circle of chunks. Only one area is pre-generated at a time per
+				world. New chunks are only queued while the world's generator, lighting and storage queues are short,
+				so that the players' own chunk requests don't get starved. The progress is saved in the world folder
+				and the pre-generation resumes automatically after a server restart.</p>
+				<p>
+				The queue limits can be set in the [PreGeneration] section of the world.ini file. The same
+				functionality is available through the "pregen" console command.
+			]],
+			Functions =
+			{
+				GetChunksPerSecond =
+				{
+					Returns =
+					{
+						{
+							Type = "number",
+						},
+					},
+					Notes = "Returns the speed of the current pre-generation, in chunks per second, as measured over the last few seconds.",
+				},
+				GetNumChunksDone =
+				{
+					Returns =
+					{
+						{
+							Type = "number",
+						},
+					},
+					Notes = "Returns the number of chunks already prepared by the current pre-generation.",
+				},
+				GetNumChunksTotal =
+				{
+					Returns =
+					{
+						{
+							Type = "number",
+						},
+					},
+					Notes = "Returns the total number of chunks in the area of the current pre-generation.",
+				},
+				IsRunning =
+				{
+					Returns =
+					{
+						{
+							Type = "boolean",
+						},
+					},
+					Notes = "Returns true if a pre-generation is in progress in the world.",
+				},
+				PreGenerateRadius =
+				{
+					Params =
+					{
+						{
+							Name = "CenterChunkX",
+							Type = "number",
+						},
+						{
+							Name = "CenterChunkZ",
+							Type = "number",
+						},
+						{
+							Name = "Radius",
+							Type = "number",
+						},
+					},
+					Returns =
+					{
+						{
+							Type = "boolean",
+						},
+					},
+					Notes = "Starts pre-generating all chunks within the specified radius (in chunks) around the specified center chunk. Replaces any pre-generation already in progress. Returns false if the radius is not positive.",
+				},
+				PreGenerateRect =
+				{
+					Params =
+					{
+						{
+							Name = "MinChunkX",
+							Type = "number",
+						},
+						{
+							Name = "MinChunkZ",
+							Type = "number",
+						},
+						{
+							Name = "MaxChunkX",
+							Type = "number",
+						},
+						{
+							Name = "MaxChunkZ",
+							Type = "number",
+						},
+					},
+					Returns =
+					{
+						{
+							Type = "boolean",
+						},
+					},
+					Notes = "Starts pre-generating the rectangle of chunks between the specified corners (inclusive). Replaces any pre-generation already in progress. Returns false if the corners are not ordered.",
+				},
+				Stop =
+				{
+					Notes = "Cancels the pre-generation in progress, if any, and removes its saved progress.",
+				},
+			},
+		},
 		cRoot =
 		{
 			Desc = [[
@@ -492,6 +492,54 @@ return
 				},
 			},
 
+			FindBlocks =
+			{
+				Params =
+				{
+					{
+						Name = "BlockTypes",
+						Type = "table",
+					},
+					{
+						Name = "MaxResults",
+						Type = "number",
+						IsOptional = true,
+					},
+				},
+				Returns =
+				{
+					{
+						Name = "Coords",
+						Type = "table",
+					},
+				},
+				Notes = "Returns an array-table of {{Vector3i}} absolute coords of all the blocks in the area whose type is in the BlockTypes array-table. The area is scanned natively, which is much faster than calling GetBlockType() for each block. The coords are ordered by Y, then Z, then X. If MaxResults is given and non-zero, at most that many coords are returned. The area must contain the baTypes datatype.",
+			},
+
+			FindRelBlocks =
+			{
+				Params =
+				{
+					{
+						Name = "BlockTypes",
+						Type = "table",
+					},
+					{
+						Name = "MaxResults",
+						Type = "number",
+						IsOptional = true,
+					},
+				},
+				Returns =
+				{
+					{
+						Name = "RelCoords",
+						Type = "table",
+					},
+				},
+				Notes = "Same as FindBlocks(), but returns the coords relative to the area's origin.",
+			},
+
 			ForEachBlockEntity =
 			{
 				Params =
@@ -567,6 +615,18 @@ return
 				Notes = "Returns the block meta at the specified absolute coords",
 			},
 
+			GetBlockMetasString =
+			{
+				Returns =
+				{
+					{
+						Name = "BlockMetas",
+						Type = "string",
+					},
+				},
+				Notes = "Returns the block metas of the whole area as a single string, one byte per block. The blocks are ordered with X changing the fastest, then Z, then Y, so the block at relative coords {x, y, z} is at index 1 + x + z * SizeX + y * SizeX * SizeZ. Use string.byte() to read the values. The area must contain the baMetas datatype.",
+			},
+
 			GetBlockSkyLight =
 			{
 				Params =
@@ -665,6 +725,18 @@ return
 				Notes = "Returns the {{cCuboid|cuboid}} that specifies the original coords of the world from which the area was read. Basically constructs a {{cCuboid}} out of GetOrigin() and GetOrigin() + GetCoordRange().",
 			},
 
+			GetBlockTypesString =
+			{
+				Returns =
+				{
+					{
+						Name = "BlockTypes",
+						Type = "string",
+					},
+				},
+				Notes = "Returns the block types of the whole area as a single string, one byte per block, in the same order as GetBlockMetasString(). Use string.byte() to read the values, or string.find() to quickly check for a block type. The area must contain the baTypes datatype.",
+			},
+
 			GetCoordRange =
 			{
 				Returns =
@@ -1626,6 +1698,18 @@ return
 				},
 				Notes = "Sets the block meta at the specified absolute coords.",
 			},
+			SetBlockMetasFromString =
+			{
+				Params =
+				{
+					{
+						Name = "BlockMetas",
+						Type = "string",
+					},
+				},
+				Notes = "Replaces the block metas of the whole area with the values in the string, one byte per block, in the same order as GetBlockMetasString(). The string length must match the number of blocks in the area. The area must contain the baMetas datatype.",
+			},
+
 			SetBlockSkyLight =
 			{
 				Params =
@@ -1699,6 +1783,18 @@ return
 				},
 				Notes = "Sets the block type and meta at the specified absolute coords",
 			},
+			SetBlockTypesFromString =
+			{
+				Params =
+				{
+					{
+						Name = "BlockTypes",
+						Type = "string",
+					},
+				},
+				Notes = "Replaces the block types of the whole area with the values in the string, one byte per block, in the same order as GetBlockMetasString(). The string length must match the number of blocks in the area. The area must contain the baTypes datatype.",
+			},
+
 			SetOrigin =
 			{
 				{
@@ -1,5 +1,83 @@
 return
 {
+	cLuaWorker =
+	{
+		Desc = [[
+			Represents a separate Lua state that runs a part of the plugin's code on a background thread, so that lengthy computations (pathfinding, database queries, serialization) don't slow down the server's tick. Plugins create a worker by calling cLuaWorker:Create(), giving it a Lua file to load and a callback to receive the worker's answers.</p>
+			<p>
+			The worker's Lua state has no access to the server API (no {{cRoot}}, {{cWorld}}, {{cPlayer}} etc.), nor to the io, debug and package libraries; only the basic Lua libraries, the time functions of the os library, {{cJson}}, sqlite3, the LOG functions and the PostMessage() function are available. The worker file must define a global OnMessage function, which is called with the values of each message that the plugin posts using the Post() function. The worker answers by calling PostMessage(...) with any number of values; these are delivered to the plugin's callback.</p>
+			<p>
+			Messages can only contain nil, boolean, number and string values and tables of those; the values are copied into the receiving Lua state. The messages to a single worker are handled in the order in which they were posted, one at a time. Note that the plugin's callback is called on the worker thread, not in the tick thread, so it should use {{cWorld}}:QueueTask() or similar to access the world, same as with the {{cNetwork}} callbacks.</p>
+			<p>
+			Note that when Lua garbage-collects this class, the worker is closed. Therefore the plugin should keep this object referenced in a global variable for as long as it wants to use the worker. The number of the worker threads is configured in the [LuaWorkers] section of settings.ini.
+		]],
+		Functions =
+		{
+			Close =
+			{
+				Notes = "Closes the worker. Waits for the message being currently handled, if any, the rest of the posted messages are dropped. The worker doesn't accept any more messages.",
+			},
+			Create =
+			{
+				IsStatic = true,
+				Params =
+				{
+					{
+						Name = "FileName",
+						Type = "string",
+					},
+					{
+						Name = "OnMessageCallback",
+						Type = "function",
+					},
+				},
+				Returns =
+				{
+					{
+						Type = "cLuaWorker",
+					},
+				},
+				Notes = "Creates a new worker and loads the specified file, relative to the plugin's folder, into it. The OnMessageCallback is called with the values that the worker posts using PostMessage(...). Returns nil if the file cannot be loaded or doesn't define the global OnMessage function.",
+			},
+			GetNumPendingMessages =
+			{
+				Returns =
+				{
+					{
+						Type = "number",
+					},
+				},
+				Notes = "Returns the number of messages posted to the worker that haven't been handled yet.",
+			},
+			IsOpen =
+			{
+				Returns =
+				{
+					{
+						Type = "boolean",
+					},
+				},
+				Notes = "Returns true if the worker is open and accepts messages.",
+			},
+			Post =
+			{
+				Params =
+				{
+					{
+						Name = "Values...",
+						Type = "...",
+					},
+				},
+				Returns =
+				{
+					{
+						Type = "boolean",
+					},
+				},
+				Notes = "Posts a message consisting of the specified values to the worker, where it is handled by the worker's OnMessage function. Returns false if the worker is closed or any of the values cannot be sent (functions, userdata).",
+			},
+		},
+	},
 	cPlugin =
 	{
 		Desc = "cPlugin describes a Lua plugin. Each plugin has its own cPlugin object.",
@@ -520,6 +598,34 @@ cPluginManager.AddHook(cPluginManager.HOOK_CHAT, OnChatMessage);
 				},
 				Notes = "Returns the permission needed for executing the specified command",
 			},
+			GetHookBudget =
+			{
+				Params =
+				{
+					{
+						Name = "HookType",
+						Type = "number",
+					},
+				},
+				Returns =
+				{
+					{
+						Name = "BudgetMSec",
+						Type = "number",
+					},
+				},
+				Notes = "Returns the soft time budget for a single plugin's handlers of the specified hook type, in milliseconds. Zero means there is no budget. See SetHookBudget().",
+			},
+			GetHookStats =
+			{
+				Returns =
+				{
+					{
+						Type = "table",
+					},
+				},
+				Notes = "Returns an array-table of the time spent in each plugin's handlers of each hook type since the last ResetHookStats(), sorted by the total time, longest first. Each item is a table with the following members: PluginName, HookType, HookName, NumCalls, TotalMSec, MaxMSec and NumOverruns (calls over the hook's budget).",
+			},
 			GetCurrentPlugin =
 			{
 				Returns =
@@ -530,6 +636,32 @@ cPluginManager.AddHook(cPluginManager.HOOK_CHAT, OnChatMessage);
 				},
 				Notes = "Returns the {{cPlugin}} object for the calling plugin. This is the same object that the Initialize function receives as the argument.",
 			},
+			GetLuaProfile =
+			{
+				Params =
+				{
+					{
+						Name = "PluginName",
+						Type = "string",
+					},
+				},
+				Returns =
+				{
+					{
+						Name = "Locations",
+						Type = "table",
+					},
+					{
+						Name = "TotalMSec",
+						Type = "number",
+					},
+					{
+						Name = "IsRunning",
+						Type = "boolean",
+					},
+				},
+				Notes = "Returns the results of the Lua profiler of the specified plugin, or false if the plugin is not loaded. Locations is an array-table of the sampled Lua lines, sorted by the time spent, longest first; each item is a table with the following members: Function, Source, Line, NumSamples and MSec. TotalMSec is the total time sampled, IsRunning is true if the profiler is still sampling. See StartLuaProfiler().",
+			},
 			GetNumLoadedPlugins =
 			{
 				Returns =
@@ -664,6 +796,81 @@ cPluginManager.AddHook(cPluginManager.HOOK_CHAT, OnChatMessage);
 			{
 				Notes = "Reloads all active plugins",
 			},
+			ResetHookStats =
+			{
+				Notes = "Clears the statistics of the time spent in the plugins' hook handlers. See GetHookStats().",
+			},
+			ResetLuaProfile =
+			{
+				Params =
+				{
+					{
+						Name = "PluginName",
+						Type = "string",
+					},
+				},
+				Returns =
+				{
+					{
+						Type = "boolean",
+					},
+				},
+				Notes = "Clears the results of the Lua profiler of the specified plugin. Returns false if the plugin is not loaded.",
+			},
+			SetHookBudget =
+			{
+				Params =
+				{
+					{
+						Name = "HookType",
+						Type = "number",
+					},
+					{
+						Name = "BudgetMSec",
+						Type = "number",
+					},
+				},
+				Notes = "Sets the soft time budget for a single plugin's handlers of the specified hook type, in milliseconds. Calls that take longer are counted as overruns in GetHookStats() and a warning is logged, at most once per 10 seconds for each plugin and hook. A budget of zero disables the checks. The initial budgets are read from the [PluginHookBudgets] section of settings.ini, with the hook names (such as OnPlayerMoving) as the keys and the Default key applying to the rest.",
+			},
+			StartLuaProfiler =
+			{
+				Params =
+				{
+					{
+						Name = "PluginName",
+						Type = "string",
+					},
+					{
+						Name = "InstructionInterval",
+						Type = "number",
+						IsOptional = true,
+					},
+				},
+				Returns =
+				{
+					{
+						Type = "boolean",
+					},
+				},
+				Notes = "Starts the sampling profiler of the specified plugin's Lua code, taking a sample after every InstructionInterval Lua VM instructions (1000 by default). The time between the samples is attributed to the sampled Lua line. Returns false if the plugin is not loaded. See GetLuaProfile().",
+			},
+			StopLuaProfiler =
+			{
+				Params =
+				{
+					{
+						Name = "PluginName",
+						Type = "string",
+					},
+				},
+				Returns =
+				{
+					{
+						Type = "boolean",
+					},
+				},
+				Notes = "Stops the sampling profiler of the specified plugin's Lua code. The results are kept until ResetLuaProfile() is called. Returns false if the plugin is not loaded.",
+			},
 			UnloadPlugin =
 			{
 				Params =
@@ -1219,6 +1219,33 @@ function OnAllChunksAvailable()</pre> All return values from the callbacks are i
 					Notes = "Sets the block at the specified coords, without waking up the simulators or replacing the block entities for the previous block type. Do not use if the block being replaced has a block entity tied to it!",
 				},
 			},
+			FindBlocksInArea =
+			{
+				Params =
+				{
+					{
+						Name = "Bounds",
+						Type = "cCuboid",
+					},
+					{
+						Name = "BlockTypes",
+						Type = "table",
+					},
+					{
+						Name = "MaxResults",
+						Type = "number",
+						IsOptional = true,
+					},
+				},
+				Returns =
+				{
+					{
+						Name = "Coords",
+						Type = "table",
+					},
+				},
+				Notes = "Returns an array-table of {{Vector3i}} coords of all the blocks within Bounds (inclusive) whose type is in the BlockTypes array-table. The area is read from the world at once and scanned natively, which is much faster than calling GetBlock() for each block. The coords are ordered by Y, then Z, then X. If MaxResults is given and non-zero, at most that many coords are returned. Returns nil if any of the chunks in the area is not loaded.",
+			},
 			FindAndDoWithPlayer =
 			{
 				Params =
@@ -1706,6 +1733,28 @@ function OnAllChunksAvailable()</pre> All return values from the callbacks are i
 				},
 				Notes = "Returns the block type and metadata for the block at the specified coords. The first value specifies if the block is in a valid loaded chunk, the other values are valid only if BlockValid is true.",
 			},
+			GetBlocksInArea =
+			{
+				Params =
+				{
+					{
+						Name = "Bounds",
+						Type = "cCuboid",
+					},
+				},
+				Returns =
+				{
+					{
+						Name = "BlockTypes",
+						Type = "string",
+					},
+					{
+						Name = "BlockMetas",
+						Type = "string",
+					},
+				},
+				Notes = "Returns the block types and metas of all the blocks within Bounds (inclusive) as two strings, one byte per block. The blocks are ordered with X changing the fastest, then Z, then Y, same as in {{cBlockArea}}:GetBlockTypesString(). Use string.byte() to read the values. Returns nil if any of the chunks in the area is not loaded. This is much faster than calling GetBlockTypeMeta() for each block.",
+			},
 			GetDataPath =
 			{
 				Returns =
@@ -1944,6 +1993,16 @@ function OnAllChunksAvailable()</pre> All return values from the callbacks are i
 				},
 				Notes = "Returns the number of unused dirty chunks. That's the number of chunks that we can save and then unload.",
 			},
+			GetPreGenerator =
+			{
+				Returns =
+				{
+					{
+						Type = "cPreGenerator",
+					},
+				},
+				Notes = "Returns the {{cPreGenerator|PreGenerator}} object that pre-generates areas of this world in the background.",
+			},
 			GetScoreBoard =
 			{
 				Returns =
@@ -2767,6 +2826,32 @@ function OnAllChunksAvailable()</pre> All return values from the callbacks are i
 					Notes = "Sets the meta for the block at the specified coords. Any call to SetBlockMeta will not generate a simulator update (water, lava, redstone), consider using SetBlock instead.",
 				},
 			},
+			SetBlocksInArea =
+			{
+				Params =
+				{
+					{
+						Name = "Bounds",
+						Type = "cCuboid",
+					},
+					{
+						Name = "BlockTypes",
+						Type = "string",
+					},
+					{
+						Name = "BlockMetas",
+						Type = "string",
+						IsOptional = true,
+					},
+				},
+				Returns =
+				{
+					{
+						Type = "boolean",
+					},
+				},
+				Notes = "Sets all the blocks within Bounds (inclusive) from the strings, one byte per block, in the same order as returned by GetBlocksInArea(). The string lengths must match the number of blocks in the area. If BlockMetas is not given, all the metas are set to zero. The blocks are written at once, without calling the per-block hooks. Returns false, without changing any block, if any of the chunks in the area is not loaded. At most 16777216 (256 * 256 * 256) blocks can be set in a single call.",
+			},
 			SetChunkAlwaysTicked =
 			{
 				Params =
@@ -15,6 +15,7 @@ return
 		{
 			{ Name = "World", Type = "{{cWorld}}", Notes = "World that is ticking" },
 			{ Name = "TimeDelta", Type = "number", Notes = "The number of milliseconds since the previous game tick. Will not be less than 50 msec" },
+			{ Name = "LastTickDurationMSec", Type = "number", Notes = "The number of milliseconds the previous game tick took to process" },
 		},
 		Returns = [[
 			If the function returns false or no value, the next plugin's callback is called. If the function
@@ -2661,6 +2661,113 @@ end
 
 
 
+--- The state of the running "arrowbench" benchmark, nil if none is running
+local g_ArrowBench = nil
+
+--- Monitors the state of the "arrowbench" world tick hook
+-- if false, the hook is installed before the "arrowbench" command processing
+local isArrowBenchHookInstalled = false
+
+--- Number of world ticks measured in each phase of the arrow benchmark
+local ARROW_BENCH_NUM_TICKS = 100
+
+--- Returns the average and maximum of the tick durations in the array
+local function ArrowBenchStats(a_Durations)
+	local sum, max = 0, 0
+	for _, duration in ipairs(a_Durations) do
+		sum = sum + duration
+		max = math.max(max, duration)
+	end
+	return sum / math.max(#a_Durations, 1), max
+end
+
+--- Spawns the benchmark arrows around the world spawn, in random directions, and remembers their IDs
+local function ArrowBenchSpawnArrows(a_World, a_Bench)
+	local spawnX, spawnY, spawnZ = a_World:GetSpawnX(), a_World:GetSpawnY(), a_World:GetSpawnZ()
+	for i = 1, a_Bench.NumArrows do
+		local pos = Vector3d(spawnX + math.random(-64, 64), spawnY + math.random(10, 40), spawnZ + math.random(-64, 64))
+		local speed = Vector3d(math.random() * 40 - 20, math.random() * 20, math.random() * 40 - 20)
+		local id = a_World:CreateProjectile(pos, cProjectileEntity.pkArrow, nil, nil, speed)
+		if (id ~= cEntity.INVALID_ID) then
+			table.insert(a_Bench.ArrowIDs, id)
+		end
+	end
+end
+
+--- The HOOK_WORLD_TICK handler driving the arrow benchmark: measures the ticks without arrows, spawns the arrows, measures again
+local function OnArrowBenchWorldTick(a_World, a_Dt, a_LastTickDurationMSec)
+	local bench = g_ArrowBench
+	if ((bench == nil) or (a_World:GetName() ~= bench.WorldName)) then
+		return false
+	end
+
+	-- The duration reported is the previous tick's; skip the first one in each phase, it contains the phase switch:
+	if (bench.TicksLeft < ARROW_BENCH_NUM_TICKS) then
+		table.insert(bench.Durations[bench.Phase], a_LastTickDurationMSec)
+	end
+	bench.TicksLeft = bench.TicksLeft - 1
+	if (bench.TicksLeft > 0) then
+		return false
+	end
+
+	if (bench.Phase == "Baseline") then
+		ArrowBenchSpawnArrows(a_World, bench)
+		LOG("arrowbench: Spawned " .. #bench.ArrowIDs .. " arrows, measuring...")
+		bench.Phase = "Arrows"
+		bench.TicksLeft = ARROW_BENCH_NUM_TICKS
+		return false
+	end
+
+	-- Finished, remove the arrows and report:
+	for _, id in ipairs(bench.ArrowIDs) do
+		a_World:DoWithEntityByID(id,
+			function (a_CBEntity)
+				a_CBEntity:Destroy()
+			end
+		)
+	end
+	local baseAvg, baseMax = ArrowBenchStats(bench.Durations.Baseline)
+	local arrowsAvg, arrowsMax = ArrowBenchStats(bench.Durations.Arrows)
+	LOG(string.format("arrowbench: Without arrows: avg %.2f msec, max %d msec per tick", baseAvg, baseMax))
+	LOG(string.format("arrowbench: With %d arrows: avg %.2f msec, max %d msec per tick", #bench.ArrowIDs, arrowsAvg, arrowsMax))
+	g_ArrowBench = nil
+	return false
+end
+
+function HandleConsoleArrowBench(a_Split)
+	if (g_ArrowBench ~= nil) then
+		return true, "The arrow benchmark is already running"
+	end
+	local numArrows = tonumber(a_Split[2]) or 10000
+	local world = cRoot:Get():GetDefaultWorld()
+	if (world == nil) then
+		return true, "Cannot run the arrow benchmark, no default world"
+	end
+
+	-- Install the hook, if needed:
+	if not(isArrowBenchHookInstalled) then
+		cPluginManager:AddHook(cPluginManager.HOOK_WORLD_TICK, OnArrowBenchWorldTick)
+		isArrowBenchHookInstalled = true
+	end
+
+	g_ArrowBench =
+	{
+		WorldName = world:GetName(),
+		NumArrows = numArrows,
+		Phase = "Baseline",
+		TicksLeft = ARROW_BENCH_NUM_TICKS,
+		Durations = { Baseline = {}, Arrows = {} },
+		ArrowIDs = {},
+	}
+	return true, string.format("Arrow benchmark started in world %s: %d ticks without, then %d ticks with %d arrows",
+		world:GetName(), ARROW_BENCH_NUM_TICKS, ARROW_BENCH_NUM_TICKS, numArrows
+	)
+end
+
+
+
+
+
 function HandleConsoleBBox(a_Split)
 	local bbox = cBoundingBox(0, 10, 0, 10, 0, 10)
 	local v1 = Vector3d(1, 1, 1)
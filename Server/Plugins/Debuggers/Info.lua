@@ -296,6 +296,12 @@ g_PluginInfo =
 
 	ConsoleCommands =
 	{
+		["arrowbench"] =
+		{
+			Handler = HandleConsoleArrowBench,
+			HelpString = "Fires arrows (10000 by default) around the default world's spawn and reports the world tick durations",
+		},
+
 		["bbox"] =
 		{
 			Handler = HandleConsoleBBox,
@@ -0,0 +1,223 @@
+
+// LuaProfiler.cpp
+
+// Implements the cLuaProfiler class representing a sampling profiler of the Lua code running in a single Lua state
+
+#include "Globals.h"
+#include "LuaProfiler.h"
+
+
+
+
+
+/** The address of this variable is used as the key under which the profiler is stored in the Lua registry. */
+static const char g_RegistryKey = 0;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaProfiler::cCallGuard:
+
+cLuaProfiler::cCallGuard::cCallGuard(lua_State * a_LuaState):
+	m_Profiler(nullptr)
+{
+	// Quick check without touching the registry, nearly all the calls are made without a profiler:
+	if (lua_gethook(a_LuaState) != &cLuaProfiler::OnHook)
+	{
+		return;
+	}
+	m_Profiler = GetFromState(a_LuaState);
+	if (m_Profiler == nullptr)
+	{
+		return;
+	}
+	if (m_Profiler->m_CallDepth == 0)
+	{
+		// Outermost call, the time since the last sample was spent outside of the plugin:
+		m_Profiler->m_LastSampleTime = std::chrono::steady_clock::now();
+		m_Profiler->m_LastLocation = nullptr;
+	}
+	m_Profiler->m_CallDepth += 1;
+}
+
+
+
+
+
+cLuaProfiler::cCallGuard::~cCallGuard()
+{
+	if ((m_Profiler == nullptr) || (m_Profiler->m_CallDepth == 0))
+	{
+		// Not profiled, or the profiler has been restarted during the call
+		return;
+	}
+	m_Profiler->m_CallDepth -= 1;
+	if ((m_Profiler->m_CallDepth == 0) && (m_Profiler->m_LastLocation != nullptr))
+	{
+		// Attribute the rest of the call to the last sampled line:
+		m_Profiler->AddTime(*m_Profiler->m_LastLocation, std::chrono::steady_clock::now());
+		m_Profiler->m_LastLocation = nullptr;
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaProfiler:
+
+cLuaProfiler::cLuaProfiler(void):
+	m_LuaState(nullptr),
+	m_CallDepth(0),
+	m_LastLocation(nullptr),
+	m_TotalTime(0)
+{
+}
+
+
+
+
+
+cLuaProfiler::~cLuaProfiler()
+{
+	// The owner must stop the profiler before closing the Lua state:
+	ASSERT(!IsRunning());
+}
+
+
+
+
+
+void cLuaProfiler::Start(lua_State * a_LuaState, int a_InstructionInterval)
+{
+	ASSERT(a_LuaState != nullptr);
+	ASSERT(a_InstructionInterval > 0);
+
+	if (m_LuaState != a_LuaState)
+	{
+		Stop();
+		m_LuaState = a_LuaState;
+		lua_pushlightuserdata(m_LuaState, const_cast<char *>(&g_RegistryKey));
+		lua_pushlightuserdata(m_LuaState, this);
+		lua_rawset(m_LuaState, LUA_REGISTRYINDEX);
+	}
+
+	// The profiler may be started from within a Lua call (API function), the samples in that call are not attributed:
+	m_CallDepth = 0;
+	m_LastLocation = nullptr;
+	m_LastSampleTime = std::chrono::steady_clock::now();
+	lua_sethook(m_LuaState, &cLuaProfiler::OnHook, LUA_MASKCOUNT, std::max(a_InstructionInterval, 1));
+}
+
+
+
+
+
+void cLuaProfiler::Stop(void)
+{
+	if (m_LuaState == nullptr)
+	{
+		return;
+	}
+	lua_sethook(m_LuaState, nullptr, 0, 0);
+	lua_pushlightuserdata(m_LuaState, const_cast<char *>(&g_RegistryKey));
+	lua_pushnil(m_LuaState);
+	lua_rawset(m_LuaState, LUA_REGISTRYINDEX);
+	m_LuaState = nullptr;
+	m_CallDepth = 0;
+	m_LastLocation = nullptr;
+}
+
+
+
+
+
+void cLuaProfiler::Reset(void)
+{
+	m_Locations.clear();
+	m_LastLocation = nullptr;
+	m_TotalTime = std::chrono::nanoseconds::zero();
+	m_LastSampleTime = std::chrono::steady_clock::now();
+}
+
+
+
+
+
+std::vector<cLuaProfiler::sLocation> cLuaProfiler::GetResults(void) const
+{
+	std::vector<sLocation> Res;
+	Res.reserve(m_Locations.size());
+	for (const auto & Location: m_Locations)
+	{
+		Res.push_back(Location.second);
+	}
+	std::sort(Res.begin(), Res.end(), [](const sLocation & a_First, const sLocation & a_Second)
+		{
+			return (a_First.m_Time > a_Second.m_Time);
+		}
+	);
+	return Res;
+}
+
+
+
+
+
+cLuaProfiler * cLuaProfiler::GetFromState(lua_State * a_LuaState)
+{
+	lua_pushlightuserdata(a_LuaState, const_cast<char *>(&g_RegistryKey));
+	lua_rawget(a_LuaState, LUA_REGISTRYINDEX);
+	auto Res = static_cast<cLuaProfiler *>(lua_touserdata(a_LuaState, -1));
+	lua_pop(a_LuaState, 1);
+	return Res;
+}
+
+
+
+
+
+void cLuaProfiler::OnHook(lua_State * a_LuaState, lua_Debug * a_Debug)
+{
+	auto Now = std::chrono::steady_clock::now();
+	auto Profiler = GetFromState(a_LuaState);
+	if ((Profiler == nullptr) || (lua_getinfo(a_LuaState, "Sln", a_Debug) == 0))
+	{
+		return;
+	}
+
+	auto Key = Printf("%s:%d", a_Debug->short_src, a_Debug->currentline);
+	auto itr = Profiler->m_Locations.find(Key);
+	if (itr == Profiler->m_Locations.end())
+	{
+		sLocation Location;
+		Location.m_Function = (a_Debug->name != nullptr) ? a_Debug->name : Printf("<function at line %d>", a_Debug->linedefined);
+		Location.m_Source = a_Debug->short_src;
+		Location.m_Line = a_Debug->currentline;
+		Location.m_NumSamples = 0;
+		Location.m_Time = std::chrono::nanoseconds::zero();
+		itr = Profiler->m_Locations.emplace(std::move(Key), std::move(Location)).first;
+	}
+	itr->second.m_NumSamples += 1;
+	Profiler->AddTime(itr->second, Now);
+	Profiler->m_LastLocation = &itr->second;
+}
+
+
+
+
+
+void cLuaProfiler::AddTime(sLocation & a_Location, std::chrono::steady_clock::time_point a_Now)
+{
+	auto Elapsed = a_Now - m_LastSampleTime;
+	a_Location.m_Time += Elapsed;
+	m_TotalTime += Elapsed;
+	m_LastSampleTime = a_Now;
+}
+
+
+
+
@@ -0,0 +1,128 @@
+
+// LuaProfiler.h
+
+// Declares the cLuaProfiler class representing a sampling profiler of the Lua code running in a single Lua state
+
+/*
+The profiler installs a count hook into the Lua state, so that Lua calls it after every N executed VM instructions.
+Each call of the hook is a sample: the time elapsed since the previous sample is attributed to the function and line
+being executed at the moment. Time spent in the C functions called from Lua is attributed to the Lua line calling them.
+
+cLuaState notifies the profiler whenever it calls into Lua and when the call returns, so that the time between
+the calls (spent outside the plugin) is not attributed to the first sample of the next call. The time after the last
+sample in a call is attributed to the last sampled line. The results are therefore approximate, with the precision
+given by the sampling interval; they are meant for finding the hot spots, not for exact measurements.
+
+All the functions need to be called with the Lua state's lock held (cPluginLua::cOperation), the hook runs within
+the Lua code that is executing under the same lock.
+*/
+
+
+
+
+
+#pragma once
+
+#include "lua/src/lua.h"
+
+
+
+
+
+class cLuaProfiler
+{
+public:
+
+	/** The statistics of a single line of Lua code. */
+	struct sLocation
+	{
+		/** The name of the function containing the line, as seen in the first sample. */
+		AString m_Function;
+
+		/** The Lua chunk (file) containing the line. */
+		AString m_Source;
+
+		/** The line number within the source. */
+		int m_Line;
+
+		/** Number of samples taken on this line. */
+		UInt64 m_NumSamples;
+
+		/** The total time attributed to this line. */
+		std::chrono::nanoseconds m_Time;
+	};
+
+	/** RAII object for marking a call into Lua code.
+	Used by cLuaState whenever it calls a Lua function; does nothing if the state isn't being profiled. */
+	class cCallGuard
+	{
+	public:
+		cCallGuard(lua_State * a_LuaState);
+		~cCallGuard();
+
+		cCallGuard(const cCallGuard &) = delete;
+		cCallGuard & operator = (const cCallGuard &) = delete;
+
+	private:
+		/** The profiler of the Lua state being called, nullptr if not profiled. */
+		cLuaProfiler * m_Profiler;
+	};
+
+
+	cLuaProfiler(void);
+	~cLuaProfiler();
+
+	/** Starts sampling the Lua state after every a_InstructionInterval VM instructions.
+	The results of any previous profiling are kept, use Reset() to clear them.
+	If the profiler is already running, only the interval is changed. */
+	void Start(lua_State * a_LuaState, int a_InstructionInterval);
+
+	/** Stops sampling, removes the hook from the Lua state. The results are kept. */
+	void Stop(void);
+
+	/** Returns true if the profiler is currently sampling a Lua state. */
+	bool IsRunning(void) const { return (m_LuaState != nullptr); }
+
+	/** Clears all the results collected so far. */
+	void Reset(void);
+
+	/** Returns the statistics of all the sampled lines, sorted by the time attributed to them, longest first. */
+	std::vector<sLocation> GetResults(void) const;
+
+	/** Returns the total time attributed to all the sampled lines. */
+	std::chrono::nanoseconds GetTotalTime(void) const { return m_TotalTime; }
+
+private:
+
+	/** The Lua state being sampled, nullptr when not running. */
+	lua_State * m_LuaState;
+
+	/** The number of nested calls into the Lua state currently executing. */
+	int m_CallDepth;
+
+	/** The time of the last sample, or of the start of the outermost call if there was no sample in it yet. */
+	std::chrono::steady_clock::time_point m_LastSampleTime;
+
+	/** The line of the last sample within the current outermost call, nullptr if there was none yet. */
+	sLocation * m_LastLocation;
+
+	/** The statistics of the sampled lines, indexed by "source:line". */
+	std::unordered_map<AString, sLocation> m_Locations;
+
+	/** The total time attributed to all the sampled lines. */
+	std::chrono::nanoseconds m_TotalTime;
+
+
+	/** Returns the profiler sampling the specified Lua state, or nullptr if the state is not being profiled. */
+	static cLuaProfiler * GetFromState(lua_State * a_LuaState);
+
+	/** The Lua hook function, takes a single sample. */
+	static void OnHook(lua_State * a_LuaState, lua_Debug * a_Debug);
+
+	/** Attributes the time since the last sample to the specified line. */
+	void AddTime(sLocation & a_Location, std::chrono::steady_clock::time_point a_Now);
+};
+
+
+
+
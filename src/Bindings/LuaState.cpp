@@ -14,6 +14,7 @@
 #include "ManualBindings.h"
 #include "DeprecatedBindings.h"
 #include "LuaJson.h"
+#include "LuaProfiler.h"
 #include "../Entities/Entity.h"
 #include "../BlockEntities/BlockEntity.h"
 #include "../DeadlockDetect.h"
@@ -325,6 +326,41 @@ bool cLuaState::cCallback::RefStack(cLuaState & a_LuaState, int a_StackPos)
 
 
 
+bool cLuaState::cCallback::CallWithPushedParams(cFunctionRef<int(cLuaState &)> a_PushParams)
+{
+	auto cs = m_CS.load();
+	if (cs == nullptr)
+	{
+		return false;
+	}
+	cCSLock Lock(*cs);
+	if (!m_Ref.IsValid())
+	{
+		return false;
+	}
+	cLuaState LuaState(m_Ref.GetLuaState());
+	auto Top = lua_gettop(LuaState);
+	LuaState.m_NumCurrentFunctionArgs = -1;
+	if (!LuaState.PushFunction(m_Ref))
+	{
+		return false;
+	}
+	auto NumParams = a_PushParams(LuaState);
+	if (NumParams < 0)
+	{
+		// Nothing to call with, remove the function and the error handler (and anything pushed before the failure):
+		lua_settop(LuaState, Top);
+		LuaState.m_NumCurrentFunctionArgs = -1;
+		return false;
+	}
+	LuaState.m_NumCurrentFunctionArgs = NumParams;
+	return LuaState.CallFunction(0);
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cLuaState::cOptionalCallback:
 
@@ -1627,6 +1663,7 @@ bool cLuaState::CallFunction(int a_NumResults)
 	m_NumCurrentFunctionArgs = -1;
 
 	// Call the function:
+	cLuaProfiler::cCallGuard ProfilerGuard(m_LuaState);
 	int s = lua_pcall(m_LuaState, NumArgs, a_NumResults, -NumArgs - 2);
 	if (s != 0)
 	{
@@ -2217,6 +2254,7 @@ int cLuaState::CallFunctionWithForeignParams(
 	}
 
 	// Call the function, with an error handler:
+	cLuaProfiler::cCallGuard ProfilerGuard(m_LuaState);
 	int s = lua_pcall(m_LuaState, a_SrcParamEnd - a_SrcParamStart + 1, LUA_MULTRET, OldTop + 1);
 	if (ReportErrors(s))
 	{
@@ -305,6 +305,13 @@ public:
 			return cLuaState(m_Ref.GetLuaState()).Call(m_Ref, std::forward<Args>(args)...);
 		}
 
+		/** Calls the Lua callback, if still available, with the params pushed by a_PushParams, ignoring any return values.
+		a_PushParams is called with the callback's Lua state locked, it pushes the params onto the state's stack and returns
+		their number, or a negative number on failure, in which case the callback is not called.
+		Used for params whose number and types are not known at compile time, such as values copied from another Lua state.
+		Returns true if callback has been called. */
+		bool CallWithPushedParams(cFunctionRef<int(cLuaState &)> a_PushParams);
+
 		/** Set the contained callback to the function in the specified Lua state's stack position.
 		If a callback has been previously contained, it is unreferenced first.
 		Returns true on success, false on failure (not a function at the specified stack pos). */
@@ -0,0 +1,507 @@
+
+// LuaWorker.cpp
+
+// Implements the cLuaWorker class representing an isolated Lua state running plugin code on the worker thread pool
+// Implements the cLuaMessageChannel class representing a queue of messages copied between Lua states
+
+#include "Globals.h"
+#include "LuaWorker.h"
+#include "LuaWorkerPool.h"
+#include "LuaJson.h"
+#include "tolua++/include/tolua++.h"
+
+
+
+
+
+// fwd: "SQLite/lsqlite3.cpp"
+int luaopen_lsqlite3(lua_State * L);
+
+
+
+
+
+/** The address of this variable is used as the key under which the worker is stored in its Lua state's registry. */
+static const char g_RegistryKey = 0;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaMessageChannel:
+
+cLuaMessageChannel::cLuaMessageChannel(void):
+	m_Storage("LuaMessageChannel")
+{
+	m_Storage.Create();
+}
+
+
+
+
+
+bool cLuaMessageChannel::Push(cLuaState & a_SrcLuaState, int a_SrcStart, int a_SrcEnd)
+{
+	// Check the values first, so that nothing is copied for invalid messages:
+	for (int i = a_SrcStart; i <= a_SrcEnd; i++)
+	{
+		if (!IsValueCopyable(a_SrcLuaState, i))
+		{
+			LOGWARNING("%s: Cannot post value #%d (%s), only nil, bool, number, string and tables of those can be posted.",
+				a_SrcLuaState.GetSubsystemName().c_str(), i - a_SrcStart + 1, lua_typename(a_SrcLuaState, lua_type(a_SrcLuaState, i))
+			);
+			return false;
+		}
+	}
+
+	cLuaState::cLock Lock(m_Storage);
+	auto NumValues = m_Storage.CopyStackFrom(a_SrcLuaState, a_SrcStart, a_SrcEnd);
+	if (NumValues < 0)
+	{
+		return false;
+	}
+
+	// Pack the values into a table, so that they can be referenced:
+	lua_createtable(m_Storage, NumValues, 0);
+	lua_insert(m_Storage, -NumValues - 1);
+	for (int i = NumValues; i > 0; i--)
+	{
+		lua_rawseti(m_Storage, -i - 1, i);
+	}
+	m_Messages.emplace_back(luaL_ref(m_Storage, LUA_REGISTRYINDEX), NumValues);
+	return true;
+}
+
+
+
+
+
+int cLuaMessageChannel::Pop(cLuaState & a_DstLuaState)
+{
+	cLuaState::cLock Lock(m_Storage);
+	if (m_Messages.empty())
+	{
+		return -1;
+	}
+	auto Message = m_Messages.front();
+	m_Messages.pop_front();
+
+	// Unpack the values from the table:
+	lua_rawgeti(m_Storage, LUA_REGISTRYINDEX, Message.first);
+	luaL_unref(m_Storage, LUA_REGISTRYINDEX, Message.first);
+	auto Top = lua_gettop(m_Storage);
+	for (int i = 1; i <= Message.second; i++)
+	{
+		lua_rawgeti(m_Storage, Top, i);
+	}
+
+	auto Res = a_DstLuaState.CopyStackFrom(m_Storage, Top + 1, Top + Message.second);
+	lua_settop(m_Storage, Top - 1);
+	return Res;
+}
+
+
+
+
+
+void cLuaMessageChannel::Clear(void)
+{
+	cLuaState::cLock Lock(m_Storage);
+	for (const auto & Message: m_Messages)
+	{
+		luaL_unref(m_Storage, LUA_REGISTRYINDEX, Message.first);
+	}
+	m_Messages.clear();
+}
+
+
+
+
+
+size_t cLuaMessageChannel::GetNumMessages(void)
+{
+	cLuaState::cLock Lock(m_Storage);
+	return m_Messages.size();
+}
+
+
+
+
+
+bool cLuaMessageChannel::IsValueCopyable(lua_State * a_LuaState, int a_StackPos, int a_NumAllowedNestingLevels)
+{
+	switch (lua_type(a_LuaState, a_StackPos))
+	{
+		case LUA_TNIL:
+		case LUA_TBOOLEAN:
+		case LUA_TNUMBER:
+		case LUA_TSTRING:
+		{
+			return true;
+		}
+		case LUA_TTABLE:
+		{
+			if ((a_NumAllowedNestingLevels <= 0) || !lua_checkstack(a_LuaState, 3))
+			{
+				return false;
+			}
+			lua_pushvalue(a_LuaState, a_StackPos);  // <table>
+			lua_pushnil(a_LuaState);                // <table> <key>
+			while (lua_next(a_LuaState, -2) != 0)   // <table> <key> <value>
+			{
+				if (!IsValueCopyable(a_LuaState, -2, a_NumAllowedNestingLevels - 1) || !IsValueCopyable(a_LuaState, -1, a_NumAllowedNestingLevels - 1))
+				{
+					lua_pop(a_LuaState, 3);
+					return false;
+				}
+				lua_pop(a_LuaState, 1);               // <table> <key>
+			}
+			lua_pop(a_LuaState, 1);
+			return true;
+		}
+		default:
+		{
+			// Functions, userdata and threads are bound to their Lua state
+			return false;
+		}
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaWorker:
+
+cLuaWorker::cLuaWorker(cLuaWorkerPool & a_Pool, cLuaState::cCallbackPtr && a_OnMessage, const AString & a_SubsystemName):
+	m_Pool(a_Pool),
+	m_LuaState(a_SubsystemName),
+	m_OnMessage(std::move(a_OnMessage)),
+	m_IsOpen(false),
+	m_IsScheduled(false)
+{
+}
+
+
+
+
+
+cLuaWorker::~cLuaWorker()
+{
+	Close();
+}
+
+
+
+
+
+bool cLuaWorker::Open(const AString & a_FileName, cLuaWorkerPtr a_Self)
+{
+	{
+		cLuaState::cLock Lock(m_LuaState);
+		ASSERT(!m_LuaState.IsValid());
+		m_LuaState.Create();
+		RestrictAPI();
+		if (!m_LuaState.LoadFile(a_FileName))
+		{
+			m_LuaState.Close();
+			return false;
+		}
+		if (!m_LuaState.GetNamedGlobal("OnMessage", m_WorkerOnMessage) || (m_WorkerOnMessage == nullptr))
+		{
+			LOGWARNING("%s: The worker file %s doesn't define the OnMessage function.", m_LuaState.GetSubsystemName().c_str(), a_FileName.c_str());
+			m_WorkerOnMessage.reset();
+			m_LuaState.Close();
+			return false;
+		}
+		m_Self = std::move(a_Self);
+		m_IsOpen = true;
+	}
+
+	// The file may have posted some messages to the plugin already while loading:
+	if (m_Outbox.GetNumMessages() > 0)
+	{
+		Schedule();
+	}
+	return true;
+}
+
+
+
+
+
+bool cLuaWorker::Post(cLuaState & a_SrcLuaState, int a_SrcStart, int a_SrcEnd)
+{
+	if (!m_IsOpen)
+	{
+		return false;
+	}
+	if (!m_Inbox.Push(a_SrcLuaState, a_SrcStart, a_SrcEnd))
+	{
+		return false;
+	}
+	Schedule();
+	return true;
+}
+
+
+
+
+
+void cLuaWorker::Close(void)
+{
+	m_IsOpen = false;
+
+	// Taking the lock waits for the message currently being handled, if any.
+	// m_WorkerOnMessage is kept, closing the state invalidates it and the pool thread may still be using the pointer:
+	cLuaState::cLock Lock(m_LuaState);
+	if (m_LuaState.IsValid())
+	{
+		m_LuaState.Close();
+	}
+	m_Inbox.Clear();
+}
+
+
+
+
+
+void cLuaWorker::Release(void)
+{
+	// Close the worker, Lua cannot post to it anymore; the pool may still hold a reference until it's done with it:
+	Close();
+	m_Self.reset();
+}
+
+
+
+
+
+void cLuaWorker::ProcessMessages(void)
+{
+	while (HandleOneMessage())
+	{
+		DeliverMessages();
+	}
+	DeliverMessages();
+
+	// A message may have been posted after the last check but before clearing the flag, reschedule for it:
+	m_IsScheduled = false;
+	if (m_IsOpen && ((m_Inbox.GetNumMessages() > 0) || (m_Outbox.GetNumMessages() > 0)))
+	{
+		Schedule();
+	}
+}
+
+
+
+
+
+void cLuaWorker::Schedule(void)
+{
+	if (!m_IsScheduled.exchange(true))
+	{
+		m_Pool.Schedule(shared_from_this());
+	}
+}
+
+
+
+
+
+bool cLuaWorker::HandleOneMessage(void)
+{
+	// Only the pool thread processing this worker pops from the inbox, so the message cannot disappear after this check:
+	if (!m_IsOpen || (m_Inbox.GetNumMessages() == 0))
+	{
+		return false;
+	}
+
+	// Errors in the handler are logged by the callback, the message is dropped and processing continues:
+	if (!m_WorkerOnMessage->CallWithPushedParams([this](cLuaState & a_LuaState)
+		{
+			return m_Inbox.Pop(a_LuaState);
+		}
+	))
+	{
+		if (!m_IsOpen)
+		{
+			// Closed in the meantime
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+void cLuaWorker::DeliverMessages(void)
+{
+	while (m_Outbox.GetNumMessages() > 0)
+	{
+		if (!m_OnMessage->CallWithPushedParams([this](cLuaState & a_LuaState)
+			{
+				return m_Outbox.Pop(a_LuaState);
+			}
+		))
+		{
+			if (!m_OnMessage->IsValid())
+			{
+				// The plugin has been unloaded, there's nobody to deliver the messages to
+				m_Outbox.Clear();
+				return;
+			}
+		}
+	}
+}
+
+
+
+
+
+void cLuaWorker::RestrictAPI(void)
+{
+	lua_State * L = m_LuaState;
+
+	// Remove the functions that reach outside of the worker (files, the process, other modules):
+	static const char * const RemovedGlobals[] =
+	{
+		"io", "debug", "package", "require", "module", "dofile", "loadfile",
+	};
+	for (auto Name: RemovedGlobals)
+	{
+		lua_pushnil(L);
+		lua_setglobal(L, Name);
+	}
+
+	// Keep only the time-related functions from the os library:
+	lua_getglobal(L, "os");
+	static const char * const OsFunctions[] =
+	{
+		"clock", "date", "difftime", "time",
+	};
+	lua_createtable(L, 0, static_cast<int>(ARRAYCOUNT(OsFunctions)));
+	for (auto Name: OsFunctions)
+	{
+		lua_getfield(L, -2, Name);
+		lua_setfield(L, -2, Name);
+	}
+	lua_setglobal(L, "os");
+	lua_pop(L, 1);
+
+	// Add the libraries that don't touch the server, so that the workers can store data and serialize it:
+	auto Top = lua_gettop(L);
+	tolua_open(L);  // cJson is a tolua class
+	cLuaJson::Bind(m_LuaState);
+	luaopen_lsqlite3(L);
+	lua_settop(L, Top);
+
+	// Add the worker API:
+	lua_pushlightuserdata(L, const_cast<char *>(&g_RegistryKey));
+	lua_pushlightuserdata(L, this);
+	lua_rawset(L, LUA_REGISTRYINDEX);
+	lua_register(L, "PostMessage", &tolua_PostMessage);
+	lua_register(L, "LOG",         &tolua_LOG);
+	lua_register(L, "LOGINFO",     &tolua_LOGINFO);
+	lua_register(L, "LOGWARN",     &tolua_LOGWARNING);
+	lua_register(L, "LOGWARNING",  &tolua_LOGWARNING);
+	lua_register(L, "LOGERROR",    &tolua_LOGERROR);
+}
+
+
+
+
+
+int cLuaWorker::tolua_PostMessage(lua_State * a_LuaState)
+{
+	// Function signature:
+	// PostMessage(...) -> bool
+
+	auto Worker = GetFromState(a_LuaState);
+	if (Worker == nullptr)
+	{
+		return 0;
+	}
+	cLuaState L(a_LuaState);
+	auto Res = Worker->m_Outbox.Push(L, 1, lua_gettop(a_LuaState));
+	L.Push(Res);
+	return 1;
+}
+
+
+
+
+
+int cLuaWorker::tolua_LOG(lua_State * a_LuaState)
+{
+	LogFromLuaStack(a_LuaState, eLogLevel::Regular);
+	return 0;
+}
+
+
+
+
+
+int cLuaWorker::tolua_LOGINFO(lua_State * a_LuaState)
+{
+	LogFromLuaStack(a_LuaState, eLogLevel::Info);
+	return 0;
+}
+
+
+
+
+
+int cLuaWorker::tolua_LOGWARNING(lua_State * a_LuaState)
+{
+	LogFromLuaStack(a_LuaState, eLogLevel::Warning);
+	return 0;
+}
+
+
+
+
+
+int cLuaWorker::tolua_LOGERROR(lua_State * a_LuaState)
+{
+	LogFromLuaStack(a_LuaState, eLogLevel::Error);
+	return 0;
+}
+
+
+
+
+
+cLuaWorker * cLuaWorker::GetFromState(lua_State * a_LuaState)
+{
+	lua_pushlightuserdata(a_LuaState, const_cast<char *>(&g_RegistryKey));
+	lua_rawget(a_LuaState, LUA_REGISTRYINDEX);
+	auto Res = static_cast<cLuaWorker *>(lua_touserdata(a_LuaState, -1));
+	lua_pop(a_LuaState, 1);
+	return Res;
+}
+
+
+
+
+
+void cLuaWorker::LogFromLuaStack(lua_State * a_LuaState, eLogLevel a_LogLevel)
+{
+	cLuaState L(a_LuaState);
+	if (!L.CheckParamString(1))
+	{
+		return;
+	}
+	std::string_view Message;
+	L.GetStackValue(1, Message);
+	auto Worker = GetFromState(a_LuaState);
+	Logger::LogSimple(fmt::format("[{}] {}", (Worker != nullptr) ? Worker->m_LuaState.GetSubsystemName() : "LuaWorker", Message), a_LogLevel);
+}
+
+
+
+
@@ -0,0 +1,183 @@
+
+// LuaWorker.h
+
+// Declares the cLuaWorker class representing an isolated Lua state running plugin code on the worker thread pool
+// Declares the cLuaMessageChannel class representing a queue of messages copied between Lua states
+
+/*
+A worker has its own Lua state, with only the basic Lua libraries and a few logging functions available;
+there's no access to the server API, so the worker code cannot touch the world or the players from the wrong thread.
+The plugin and the worker communicate by posting messages: a message is a list of simple values (nil, bool, number,
+string and tables of those) that are copied into the receiving state, so the two states never share any data.
+
+Messages posted to the worker are handled by the worker script's global OnMessage function on one of the
+cLuaWorkerPool threads; a single worker is never run on two threads at the same time. The worker script can post
+messages back using the global PostMessage function; these are delivered to the callback that the plugin gave
+when creating the worker, also on the pool thread (so the callback must not access the world directly, same as
+the network callbacks).
+
+Locking: the message channels have their own lock, which is always taken last (while holding either the plugin's
+or the worker's state lock). No thread ever holds both the plugin's and the worker's state lock at the same time.
+*/
+
+
+
+
+
+#pragma once
+
+#include "LuaState.h"
+
+
+
+
+
+// fwd:
+class cLuaWorkerPool;
+class cLuaWorker;
+typedef std::shared_ptr<cLuaWorker> cLuaWorkerPtr;
+
+
+
+
+
+class cLuaMessageChannel
+{
+public:
+
+	cLuaMessageChannel(void);
+
+	/** Adds a message consisting of the values at the specified stack positions of a_SrcLuaState.
+	Returns false (and logs a warning) if any of the values cannot be copied. */
+	bool Push(cLuaState & a_SrcLuaState, int a_SrcStart, int a_SrcEnd);
+
+	/** Removes the oldest message and pushes its values onto a_DstLuaState's stack.
+	Returns the number of values pushed, or -1 if there was no message (or it couldn't be copied). */
+	int Pop(cLuaState & a_DstLuaState);
+
+	/** Removes all the messages. */
+	void Clear(void);
+
+	/** Returns the number of messages waiting in the channel. */
+	size_t GetNumMessages(void);
+
+	/** Returns true if the value at the specified stack position can be sent through a channel:
+	nil, bool, number, string, or a table of such values (nested at most a_NumAllowedNestingLevels levels). */
+	static bool IsValueCopyable(lua_State * a_LuaState, int a_StackPos, int a_NumAllowedNestingLevels = 16);
+
+protected:
+
+	/** The Lua state holding the messages between the sender and the receiver.
+	Also provides the lock for the whole channel. */
+	cLuaState m_Storage;
+
+	/** The messages, oldest first. Each is a reference to a table in m_Storage's registry with the message values,
+	and the number of the values (the table may contain nils, so the size is kept here). */
+	std::deque<std::pair<int, int>> m_Messages;
+};
+
+
+
+
+
+class cLuaWorker:
+	public std::enable_shared_from_this<cLuaWorker>
+{
+public:
+
+	/** Creates a new worker that will run on the specified pool and deliver its messages to a_OnMessage.
+	The worker is not usable until Open() is called. */
+	cLuaWorker(cLuaWorkerPool & a_Pool, cLuaState::cCallbackPtr && a_OnMessage, const AString & a_SubsystemName);
+
+	~cLuaWorker();
+
+	/** Creates the worker's Lua state and runs the specified file in it.
+	a_Self is the shared pointer to self that the object keeps to keep itself alive for as long as Lua references it.
+	Returns false (and logs a warning) on failure. */
+	bool Open(const AString & a_FileName, cLuaWorkerPtr a_Self);
+
+	/** Posts a message to the worker, consisting of the values at the specified stack positions of a_SrcLuaState.
+	The message is handled asynchronously on a pool thread.
+	Returns false if the worker is closed or the values cannot be copied. */
+	bool Post(cLuaState & a_SrcLuaState, int a_SrcStart, int a_SrcEnd);
+
+	/** Closes the worker's Lua state. Waits for the message being handled, if any, the rest of the messages are dropped. */
+	void Close(void);
+
+	/** Returns true if the worker is open and accepts messages. */
+	bool IsOpen(void) const { return m_IsOpen.load(); }
+
+	/** Returns the number of messages posted to the worker that haven't been handled yet. */
+	size_t GetNumPendingMessages(void) { return m_Inbox.GetNumMessages(); }
+
+	/** Called when Lua garbage-collects the object.
+	Releases the internal SharedPtr to self, so that the instance may be deallocated once the pool is finished with it. */
+	void Release(void);
+
+	/** Handles all the messages posted to the worker and delivers the worker's messages to the plugin.
+	Called by the pool on one of its threads. */
+	void ProcessMessages(void);
+
+protected:
+
+	/** The pool on whose threads the worker runs. */
+	cLuaWorkerPool & m_Pool;
+
+	/** The worker's own Lua state. */
+	cLuaState m_LuaState;
+
+	/** The messages from the plugin to the worker. */
+	cLuaMessageChannel m_Inbox;
+
+	/** The messages from the worker to the plugin. */
+	cLuaMessageChannel m_Outbox;
+
+	/** The plugin's callback receiving the worker's messages. */
+	cLuaState::cCallbackPtr m_OnMessage;
+
+	/** The worker script's global OnMessage function, handling the messages posted to the worker. */
+	cLuaState::cCallbackPtr m_WorkerOnMessage;
+
+	/** Set while the worker is open and accepts messages. */
+	std::atomic<bool> m_IsOpen;
+
+	/** Set while the worker is queued in the pool or being processed, so that it is queued only once. */
+	std::atomic<bool> m_IsScheduled;
+
+	/** SharedPtr to self, so that the object can keep itself alive for as long as Lua references it. */
+	cLuaWorkerPtr m_Self;
+
+
+	/** Queues the worker in the pool, unless already queued. */
+	void Schedule(void);
+
+	/** Handles a single message from m_Inbox in the worker's state.
+	Returns false if there was no message to handle. */
+	bool HandleOneMessage(void);
+
+	/** Delivers all the messages in m_Outbox to the plugin's callback. */
+	void DeliverMessages(void);
+
+	/** Removes the functions that give access to the filesystem, the OS or other modules from the worker's state
+	and adds the worker API. */
+	void RestrictAPI(void);
+
+	/** The worker state's PostMessage(...) function, adds its params as a message to the plugin. */
+	static int tolua_PostMessage(lua_State * a_LuaState);
+
+	/** The worker state's LOG(...) functions. */
+	static int tolua_LOG(lua_State * a_LuaState);
+	static int tolua_LOGINFO(lua_State * a_LuaState);
+	static int tolua_LOGWARNING(lua_State * a_LuaState);
+	static int tolua_LOGERROR(lua_State * a_LuaState);
+
+	/** Returns the worker owning the specified Lua state, as stored in its registry by RestrictAPI(). */
+	static cLuaWorker * GetFromState(lua_State * a_LuaState);
+
+	/** Logs the string in the first param on the Lua stack, prefixed with the worker's subsystem name. */
+	static void LogFromLuaStack(lua_State * a_LuaState, eLogLevel a_LogLevel);
+};
+
+
+
+
@@ -0,0 +1,78 @@
+
+// LuaWorkerPool.cpp
+
+// Implements the cLuaWorkerPool class representing the threads on which the plugins' Lua workers run
+
+#include "Globals.h"
+#include "LuaWorkerPool.h"
+
+
+
+
+
+cLuaWorkerPool::cLuaWorkerPool(unsigned a_NumThreads):
+	m_ShouldTerminate(false)
+{
+	for (unsigned i = std::max(a_NumThreads, 1U); i > 0; i--)
+	{
+		m_Threads.emplace_back(&cLuaWorkerPool::ThreadExecute, this);
+	}
+}
+
+
+
+
+
+cLuaWorkerPool::~cLuaWorkerPool()
+{
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_ShouldTerminate = true;
+	}
+	m_QueueChanged.notify_all();
+	for (auto & Thread: m_Threads)
+	{
+		Thread.join();
+	}
+	m_Queue.clear();
+}
+
+
+
+
+
+void cLuaWorkerPool::Schedule(cLuaWorkerPtr a_Worker)
+{
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_Queue.push_back(std::move(a_Worker));
+	}
+	m_QueueChanged.notify_one();
+}
+
+
+
+
+
+void cLuaWorkerPool::ThreadExecute(void)
+{
+	for (;;)
+	{
+		cLuaWorkerPtr Worker;
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_QueueChanged.wait(Lock, [this]() { return (m_ShouldTerminate || !m_Queue.empty()); });
+			if (m_ShouldTerminate)
+			{
+				return;
+			}
+			Worker = std::move(m_Queue.front());
+			m_Queue.pop_front();
+		}
+		Worker->ProcessMessages();
+	}
+}
+
+
+
+
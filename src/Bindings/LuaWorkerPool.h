@@ -0,0 +1,59 @@
+
+// LuaWorkerPool.h
+
+// Declares the cLuaWorkerPool class representing the threads on which the plugins' Lua workers run
+
+
+
+
+
+#pragma once
+
+#include "LuaWorker.h"
+
+
+
+
+
+class cLuaWorkerPool
+{
+public:
+
+	/** Starts the specified number of threads (at least one). */
+	cLuaWorkerPool(unsigned a_NumThreads);
+
+	/** Stops all the threads. The workers still queued are dropped without processing. */
+	~cLuaWorkerPool();
+
+	/** Queues the worker to have its messages processed on one of the threads. */
+	void Schedule(cLuaWorkerPtr a_Worker);
+
+	/** Returns the number of threads in the pool. */
+	size_t GetNumThreads(void) const { return m_Threads.size(); }
+
+protected:
+
+	/** The threads processing the queued workers. */
+	std::vector<std::thread> m_Threads;
+
+	/** The workers that have messages to process, in the order of their scheduling.
+	Protected against multithreaded access by m_Mutex. */
+	std::deque<cLuaWorkerPtr> m_Queue;
+
+	/** Set when the threads should terminate. Protected against multithreaded access by m_Mutex. */
+	bool m_ShouldTerminate;
+
+	/** Protects m_Queue and m_ShouldTerminate. */
+	std::mutex m_Mutex;
+
+	/** Signalled when a worker is added to m_Queue or the threads should terminate. */
+	std::condition_variable m_QueueChanged;
+
+
+	/** The body of each thread: processes the queued workers until asked to terminate. */
+	void ThreadExecute(void);
+};
+
+
+
+
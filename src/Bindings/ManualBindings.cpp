@@ -11,6 +11,7 @@
 #include "PluginLua.h"
 #include "PluginManager.h"
 #include "LuaWindow.h"
+#include "LuaWorkerPool.h"
 #include "../BlockArea.h"
 #include "../BlockEntities/BeaconEntity.h"
 #include "../BlockEntities/BrewingstandEntity.h"
@@ -501,6 +502,34 @@ cPluginLua * cManualBindings::GetLuaPlugin(lua_State * L)
 
 
 
+bool cManualBindings::GetStackBlockTypeSet(cLuaState & a_LuaState, int a_StackPos, cBlockTypeSet & a_BlockTypes)
+{
+	if (!lua_istable(a_LuaState, a_StackPos))
+	{
+		return false;
+	}
+	a_BlockTypes.reset();
+	bool isValid = true;
+	cLuaState::cStackTable tbl(a_LuaState, a_StackPos);
+	tbl.ForEachArrayElement([&](cLuaState & a_ElementLuaState, int a_Index)
+		{
+			int blockType;
+			if (!a_ElementLuaState.GetStackValue(-1, blockType) || (blockType < 0) || (blockType >= static_cast<int>(a_BlockTypes.size())))
+			{
+				isValid = false;
+				return true;
+			}
+			a_BlockTypes.set(static_cast<size_t>(blockType));
+			return false;
+		}
+	);
+	return isValid;
+}
+
+
+
+
+
 static int tolua_cFile_ChangeFileExt(lua_State * tolua_S)
 {
 	// API signature:
@@ -1518,6 +1547,199 @@ static int tolua_cPluginManager_ExecuteConsoleCommand(lua_State * tolua_S)
 
 
 
+static int tolua_cPluginManager_GetHookStats(lua_State * tolua_S)
+{
+	/*
+	Function signature:
+	cPluginManager:GetHookStats() -> { {PluginName = ..., HookType = ..., HookName = ..., NumCalls = ..., TotalMSec = ..., MaxMSec = ..., NumOverruns = ...}, ...}
+	*/
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserTable(1, "cPluginManager") ||
+		!L.CheckParamEnd(2)
+	)
+	{
+		return 0;
+	}
+
+	auto Stats = cPluginManager::Get()->GetHookStats();
+	lua_createtable(tolua_S, static_cast<int>(Stats.size()), 0);
+	int newTable = lua_gettop(tolua_S);
+	int index = 1;
+	for (const auto & Item: Stats)
+	{
+		lua_createtable(tolua_S, 0, 7);
+		L.Push(Item.m_PluginName);
+		lua_setfield(tolua_S, -2, "PluginName");
+		L.Push(Item.m_HookType);
+		lua_setfield(tolua_S, -2, "HookType");
+		L.Push(cPluginManager::GetHookName(Item.m_HookType));
+		lua_setfield(tolua_S, -2, "HookName");
+		L.Push(static_cast<double>(Item.m_Stats.m_NumCalls));
+		lua_setfield(tolua_S, -2, "NumCalls");
+		L.Push(std::chrono::duration<double, std::milli>(Item.m_Stats.m_TotalTime).count());
+		lua_setfield(tolua_S, -2, "TotalMSec");
+		L.Push(std::chrono::duration<double, std::milli>(Item.m_Stats.m_MaxTime).count());
+		lua_setfield(tolua_S, -2, "MaxMSec");
+		L.Push(static_cast<double>(Item.m_Stats.m_NumOverruns));
+		lua_setfield(tolua_S, -2, "NumOverruns");
+		lua_rawseti(tolua_S, newTable, index);
+		++index;
+	}
+	return 1;
+}
+
+
+
+
+
+/** Common code for the cPluginManager:*LuaProfile*() bindings.
+Checks the params, then calls a_Action with the Lua plugin of the name given in the first param.
+Pushes false if there's no such plugin loaded; otherwise a_Action pushes the return values.
+Returns the number of values pushed. */
+static int DoWithLuaProfiledPlugin(lua_State * tolua_S, int a_NumOptionalParams, cFunctionRef<int(cLuaState &, cPluginLua &)> a_Action)
+{
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserTable(1, "cPluginManager") ||
+		!L.CheckParamString(2) ||
+		!L.CheckParamEnd(3 + a_NumOptionalParams)
+	)
+	{
+		return 0;
+	}
+
+	AString PluginName;
+	L.GetStackValues(2, PluginName);
+	int NumReturns = 0;
+	cPluginManager::Get()->DoWithPlugin(PluginName, [&](cPlugin & a_Plugin)
+		{
+			if (!a_Plugin.IsLoaded())
+			{
+				return false;
+			}
+			NumReturns = a_Action(L, static_cast<cPluginLua &>(a_Plugin));
+			return true;
+		}
+	);
+	if (NumReturns == 0)
+	{
+		L.Push(false);
+		return 1;
+	}
+	return NumReturns;
+}
+
+
+
+
+
+static int tolua_cPluginManager_StartLuaProfiler(lua_State * tolua_S)
+{
+	/*
+	Function signature:
+	cPluginManager:StartLuaProfiler(PluginName, [InstructionInterval]) -> bool
+	*/
+
+	return DoWithLuaProfiledPlugin(tolua_S, 1, [](cLuaState & a_LuaState, cPluginLua & a_Plugin)
+		{
+			int Interval = 1000;
+			a_LuaState.GetStackValue(3, Interval);
+			a_Plugin.StartProfiling(std::max(Interval, 1));
+			a_LuaState.Push(true);
+			return 1;
+		}
+	);
+}
+
+
+
+
+
+static int tolua_cPluginManager_StopLuaProfiler(lua_State * tolua_S)
+{
+	/*
+	Function signature:
+	cPluginManager:StopLuaProfiler(PluginName) -> bool
+	*/
+
+	return DoWithLuaProfiledPlugin(tolua_S, 0, [](cLuaState & a_LuaState, cPluginLua & a_Plugin)
+		{
+			a_Plugin.StopProfiling();
+			a_LuaState.Push(true);
+			return 1;
+		}
+	);
+}
+
+
+
+
+
+static int tolua_cPluginManager_ResetLuaProfile(lua_State * tolua_S)
+{
+	/*
+	Function signature:
+	cPluginManager:ResetLuaProfile(PluginName) -> bool
+	*/
+
+	return DoWithLuaProfiledPlugin(tolua_S, 0, [](cLuaState & a_LuaState, cPluginLua & a_Plugin)
+		{
+			a_Plugin.ResetProfile();
+			a_LuaState.Push(true);
+			return 1;
+		}
+	);
+}
+
+
+
+
+
+static int tolua_cPluginManager_GetLuaProfile(lua_State * tolua_S)
+{
+	/*
+	Function signature:
+	cPluginManager:GetLuaProfile(PluginName) -> { {Function = ..., Source = ..., Line = ..., NumSamples = ..., MSec = ...}, ...}, TotalMSec, IsRunning
+	Returns false if the plugin is not loaded.
+	*/
+
+	return DoWithLuaProfiledPlugin(tolua_S, 0, [](cLuaState & a_LuaState, cPluginLua & a_Plugin)
+		{
+			std::chrono::nanoseconds TotalTime;
+			auto Locations = a_Plugin.GetProfile(TotalTime);
+			lua_State * L = a_LuaState;
+			lua_createtable(L, static_cast<int>(Locations.size()), 0);
+			int newTable = lua_gettop(L);
+			int index = 1;
+			for (const auto & Location: Locations)
+			{
+				lua_createtable(L, 0, 5);
+				a_LuaState.Push(Location.m_Function);
+				lua_setfield(L, -2, "Function");
+				a_LuaState.Push(Location.m_Source);
+				lua_setfield(L, -2, "Source");
+				a_LuaState.Push(Location.m_Line);
+				lua_setfield(L, -2, "Line");
+				a_LuaState.Push(static_cast<double>(Location.m_NumSamples));
+				lua_setfield(L, -2, "NumSamples");
+				a_LuaState.Push(std::chrono::duration<double, std::milli>(Location.m_Time).count());
+				lua_setfield(L, -2, "MSec");
+				lua_rawseti(L, newTable, index);
+				++index;
+			}
+			a_LuaState.Push(std::chrono::duration<double, std::milli>(TotalTime).count());
+			a_LuaState.Push(a_Plugin.IsProfiling());
+			return 3;
+		}
+	);
+}
+
+
+
+
+
 static int tolua_cPluginManager_FindPlugins(lua_State * tolua_S)
 {
 	// API function no longer exists:
@@ -1533,6 +1755,172 @@ static int tolua_cPluginManager_FindPlugins(lua_State * tolua_S)
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cLuaWorker bindings:
+
+/** Called when Lua destroys the object instance.
+Close the worker and let it deallocate on its own (it's in a SharedPtr). */
+static int tolua_collect_cLuaWorker(lua_State * tolua_S)
+{
+	auto Worker = static_cast<cLuaWorker *>(tolua_tousertype(tolua_S, 1, nullptr));
+	ASSERT(Worker != nullptr);
+	Worker->Release();
+	return 0;
+}
+
+
+
+
+
+/** Binds cLuaWorker:Create() */
+static int tolua_cLuaWorker_Create(lua_State * tolua_S)
+{
+	// Function signature:
+	// cLuaWorker:Create(FileName, OnMessageCallback) -> cLuaWorker
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamStaticSelf("cLuaWorker") ||
+		!L.CheckParamString(2) ||
+		!L.CheckParamFunction(3) ||
+		!L.CheckParamEnd(4)
+	)
+	{
+		return 0;
+	}
+
+	// Read the params:
+	AString FileName;
+	cLuaState::cCallbackPtr OnMessage;
+	if (!L.GetStackValues(2, FileName, OnMessage))
+	{
+		return L.ApiParamError("Cannot read parameters");
+	}
+	auto Plugin = cManualBindings::GetLuaPlugin(tolua_S);
+	if (Plugin == nullptr)
+	{
+		return 0;
+	}
+
+	// Create the worker, the file is relative to the plugin folder:
+	auto Worker = std::make_shared<cLuaWorker>(
+		cRoot::Get()->GetLuaWorkerPool(),
+		std::move(OnMessage),
+		Printf("worker %s of plugin %s", FileName.c_str(), Plugin->GetName().c_str())
+	);
+	if (!Worker->Open(Plugin->GetLocalFolder() + "/" + FileName, Worker))
+	{
+		L.Push(cLuaState::Nil);
+		return 1;
+	}
+
+	// Register the worker to be garbage-collected by Lua:
+	tolua_pushusertype(tolua_S, Worker.get(), "cLuaWorker");
+	tolua_register_gc(tolua_S, lua_gettop(tolua_S));
+	return 1;
+}
+
+
+
+
+
+/** Binds cLuaWorker::Close */
+static int tolua_cLuaWorker_Close(lua_State * tolua_S)
+{
+	// Function signature:
+	// Worker:Close()
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamSelf("cLuaWorker") ||
+		!L.CheckParamEnd(2)
+	)
+	{
+		return 0;
+	}
+
+	auto Worker = *static_cast<cLuaWorker **>(lua_touserdata(tolua_S, 1));
+	ASSERT(Worker != nullptr);
+	Worker->Close();
+	return 0;
+}
+
+
+
+
+
+/** Binds cLuaWorker::GetNumPendingMessages */
+static int tolua_cLuaWorker_GetNumPendingMessages(lua_State * tolua_S)
+{
+	// Function signature:
+	// Worker:GetNumPendingMessages() -> number
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamSelf("cLuaWorker") ||
+		!L.CheckParamEnd(2)
+	)
+	{
+		return 0;
+	}
+
+	auto Worker = *static_cast<cLuaWorker **>(lua_touserdata(tolua_S, 1));
+	ASSERT(Worker != nullptr);
+	L.Push(static_cast<lua_Number>(Worker->GetNumPendingMessages()));
+	return 1;
+}
+
+
+
+
+
+/** Binds cLuaWorker::IsOpen */
+static int tolua_cLuaWorker_IsOpen(lua_State * tolua_S)
+{
+	// Function signature:
+	// Worker:IsOpen() -> bool
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamSelf("cLuaWorker") ||
+		!L.CheckParamEnd(2)
+	)
+	{
+		return 0;
+	}
+
+	auto Worker = *static_cast<cLuaWorker **>(lua_touserdata(tolua_S, 1));
+	ASSERT(Worker != nullptr);
+	L.Push(Worker->IsOpen());
+	return 1;
+}
+
+
+
+
+
+/** Binds cLuaWorker::Post */
+static int tolua_cLuaWorker_Post(lua_State * tolua_S)
+{
+	// Function signature:
+	// Worker:Post(...) -> bool
+
+	cLuaState L(tolua_S);
+	if (!L.CheckParamSelf("cLuaWorker"))
+	{
+		return 0;
+	}
+
+	auto Worker = *static_cast<cLuaWorker **>(lua_touserdata(tolua_S, 1));
+	ASSERT(Worker != nullptr);
+	L.Push(Worker->Post(L, 2, lua_gettop(tolua_S)));
+	return 1;
+}
+
+
+
+
+
 static int tolua_cPlayer_GetPermissions(lua_State * tolua_S)
 {
 	// Function signature: cPlayer:GetPermissions() -> {permissions-array}
@@ -4480,11 +4868,13 @@ void cManualBindings::Bind(lua_State * tolua_S)
 		// Create the new classes:
 		tolua_usertype(tolua_S, "cCryptoHash");
 		tolua_usertype(tolua_S, "cLineBlockTracer");
+		tolua_usertype(tolua_S, "cLuaWorker");
 		tolua_usertype(tolua_S, "cStringCompression");
 		tolua_usertype(tolua_S, "cUrlParser");
 		// StatisticsManager was already created by cPlayer::GetStatistics' autogenerated bindings.
 		tolua_cclass(tolua_S, "cCryptoHash",        "cCryptoHash",        "", nullptr);
 		tolua_cclass(tolua_S, "cLineBlockTracer",   "cLineBlockTracer",   "", nullptr);
+		tolua_cclass(tolua_S, "cLuaWorker",         "cLuaWorker",         "", tolua_collect_cLuaWorker);
 		tolua_cclass(tolua_S, "cStringCompression", "cStringCompression", "", nullptr);
 		tolua_cclass(tolua_S, "cUrlParser",         "cUrlParser",         "", nullptr);
 		tolua_cclass(tolua_S, "StatisticsManager",  "StatisticsManager",  "", nullptr);
@@ -4624,6 +5014,14 @@ void cManualBindings::Bind(lua_State * tolua_S)
 			tolua_function(tolua_S, "GetOwnerUUID", tolua_cMobHeadEntity_GetOwnerUUID);
 		tolua_endmodule(tolua_S);
 
+		tolua_beginmodule(tolua_S, "cLuaWorker");
+			tolua_function(tolua_S, "Close",                 tolua_cLuaWorker_Close);
+			tolua_function(tolua_S, "Create",                tolua_cLuaWorker_Create);
+			tolua_function(tolua_S, "GetNumPendingMessages", tolua_cLuaWorker_GetNumPendingMessages);
+			tolua_function(tolua_S, "IsOpen",                tolua_cLuaWorker_IsOpen);
+			tolua_function(tolua_S, "Post",                  tolua_cLuaWorker_Post);
+		tolua_endmodule(tolua_S);
+
 		tolua_beginmodule(tolua_S, "cMojangAPI");
 			tolua_function(tolua_S, "AddPlayerNameToUUIDMapping", tolua_cMojangAPI_AddPlayerNameToUUIDMapping);
 			tolua_function(tolua_S, "GetPlayerNameFromUUID",      tolua_cMojangAPI_GetPlayerNameFromUUID);
@@ -4663,8 +5061,13 @@ void cManualBindings::Bind(lua_State * tolua_S)
 			tolua_function(tolua_S, "ForEachPlugin",         StaticForEach<cPluginManager, cPlugin, &cPluginManager::ForEachPlugin>);
 			tolua_function(tolua_S, "GetAllPlugins",         tolua_cPluginManager_GetAllPlugins);
 			tolua_function(tolua_S, "GetCurrentPlugin",      tolua_cPluginManager_GetCurrentPlugin);
+			tolua_function(tolua_S, "GetHookStats",          tolua_cPluginManager_GetHookStats);
+			tolua_function(tolua_S, "GetLuaProfile",         tolua_cPluginManager_GetLuaProfile);
 			tolua_function(tolua_S, "GetPlugin",             tolua_cPluginManager_GetPlugin);
 			tolua_function(tolua_S, "LogStackTrace",         tolua_cPluginManager_LogStackTrace);
+			tolua_function(tolua_S, "ResetLuaProfile",       tolua_cPluginManager_ResetLuaProfile);
+			tolua_function(tolua_S, "StartLuaProfiler",      tolua_cPluginManager_StartLuaProfiler);
+			tolua_function(tolua_S, "StopLuaProfiler",       tolua_cPluginManager_StopLuaProfiler);
 		tolua_endmodule(tolua_S);
 
 		tolua_beginmodule(tolua_S, "cRoot");
@@ -50,6 +50,10 @@ protected:
 public:
 	// Helper functions:
 	static cPluginLua * GetLuaPlugin(lua_State * L);
+
+	/** Reads an array-table of block type numbers from the specified stack position into a_BlockTypes.
+	Returns false if the value isn't a table or any of its elements isn't a valid block type. */
+	static bool GetStackBlockTypeSet(cLuaState & a_LuaState, int a_StackPos, cBlockTypeSet & a_BlockTypes);
 	static int tolua_do_error(lua_State * L, const char * a_pMsg, tolua_Error * a_pToLuaError);
 	static int vlua_do_error(lua_State * L, const char * a_pFormat, fmt::printf_args a_ArgList);
 	template <typename... Args>
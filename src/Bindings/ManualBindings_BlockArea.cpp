@@ -251,6 +251,67 @@ static int tolua_cBlockArea_FillRelCuboid(lua_State * a_LuaState)
 
 
 
+/** Bindings for the cBlockArea:FindBlocks() and cBlockArea:FindRelBlocks() functions.
+Both scan the area natively and return an array-table of the coords of the blocks of the specified types;
+FindBlocks() returns the absolute coords, FindRelBlocks() the relative ones. */
+template <bool IsRelative>
+static int FindBlocks(lua_State * a_LuaState)
+{
+	// function cBlockArea::FindBlocks(BlockTypes, [MaxResults])
+	// function cBlockArea::FindRelBlocks(BlockTypes, [MaxResults])
+
+	cLuaState L(a_LuaState);
+	if (
+		!L.CheckParamSelf("cBlockArea") ||
+		!L.CheckParamTable(2) ||
+		!L.CheckParamEnd(4)
+	)
+	{
+		return 0;
+	}
+
+	cBlockArea * self;
+	cBlockTypeSet blockTypes;
+	int maxResults = 0;
+	if (!L.GetStackValues(1, self))
+	{
+		return L.ApiParamError("Cannot read 'self'");
+	}
+	if (self == nullptr)
+	{
+		return L.ApiParamError("Invalid 'self', must not be nil");
+	}
+	if (!cManualBindings::GetStackBlockTypeSet(L, 2, blockTypes))
+	{
+		return L.ApiParamError("Cannot read the BlockTypes, expected an array-table of block type numbers");
+	}
+	if (L.IsParamNumber(3))
+	{
+		L.GetStackValues(3, maxResults);
+	}
+	if (!self->HasBlockTypes())
+	{
+		return L.ApiParamError("The area doesn't contain baTypes datatype");
+	}
+
+	// Scan the area and push the results:
+	auto found = self->FindRelBlocks(blockTypes, static_cast<size_t>(std::max(maxResults, 0)));
+	auto offset = IsRelative ? Vector3i() : self->GetOrigin();
+	lua_createtable(a_LuaState, static_cast<int>(found.size()), 0);
+	int idx = 1;
+	for (const auto & coords: found)
+	{
+		L.Push(coords + offset);
+		lua_rawseti(a_LuaState, -2, idx);
+		idx += 1;
+	}
+	return 1;
+}
+
+
+
+
+
 static int tolua_cBlockArea_GetBlockTypeMeta(lua_State * a_LuaState)
 {
 	// function cBlockArea::GetBlockTypeMeta()
@@ -290,6 +351,97 @@ static int tolua_cBlockArea_GetBlockTypeMeta(lua_State * a_LuaState)
 
 
 
+/** Bindings for the cBlockArea:GetBlockTypesString() and cBlockArea:GetBlockMetasString() functions.
+Returns the whole array as a single string with one byte per block, in the order of the internal arrays. */
+template <int DataType, NIBBLETYPE * (cBlockArea::*GetArrayFn)(void) const>
+static int GetArrayString(lua_State * a_LuaState)
+{
+	// function cBlockArea::GetBlockTypesString()
+	// function cBlockArea::GetBlockMetasString()
+
+	cLuaState L(a_LuaState);
+	if (
+		!L.CheckParamSelf("cBlockArea") ||
+		!L.CheckParamEnd(2)
+	)
+	{
+		return 0;
+	}
+
+	cBlockArea * self;
+	if (!L.GetStackValues(1, self))
+	{
+		return L.ApiParamError("Cannot read 'self'");
+	}
+	if (self == nullptr)
+	{
+		return L.ApiParamError("Invalid 'self', must not be nil");
+	}
+	if ((self->GetDataTypes() & DataType) == 0)
+	{
+		return L.ApiParamError("The area doesn't contain the datatype (%d)", DataType);
+	}
+
+	lua_pushlstring(a_LuaState, reinterpret_cast<const char *>((self->*GetArrayFn)()), self->GetBlockCount());
+	return 1;
+}
+
+
+
+
+
+/** Bindings for the cBlockArea:SetBlockTypesFromString() and cBlockArea:SetBlockMetasFromString() functions.
+Replaces the whole array with the string, one byte per block, in the order of the internal arrays.
+The string needs to be exactly as long as the number of blocks in the area. */
+template <int DataType, NIBBLETYPE * (cBlockArea::*GetArrayFn)(void) const, NIBBLETYPE ValueMask>
+static int SetArrayFromString(lua_State * a_LuaState)
+{
+	// function cBlockArea::SetBlockTypesFromString(Data)
+	// function cBlockArea::SetBlockMetasFromString(Data)
+
+	cLuaState L(a_LuaState);
+	if (
+		!L.CheckParamSelf("cBlockArea") ||
+		!L.CheckParamString(2) ||
+		!L.CheckParamEnd(3)
+	)
+	{
+		return 0;
+	}
+
+	cBlockArea * self;
+	std::string_view data;
+	if (!L.GetStackValues(1, self, data))
+	{
+		return L.ApiParamError("Cannot read params");
+	}
+	if (self == nullptr)
+	{
+		return L.ApiParamError("Invalid 'self', must not be nil");
+	}
+	if ((self->GetDataTypes() & DataType) == 0)
+	{
+		return L.ApiParamError("The area doesn't contain the datatype (%d)", DataType);
+	}
+	if (data.size() != self->GetBlockCount())
+	{
+		return L.ApiParamError("The data length (%u) doesn't match the number of blocks in the area (%u)",
+			static_cast<unsigned>(data.size()), static_cast<unsigned>(self->GetBlockCount())
+		);
+	}
+
+	auto dst = (self->*GetArrayFn)();
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		dst[i] = static_cast<NIBBLETYPE>(data[i]) & ValueMask;
+	}
+	return 0;
+}
+
+
+
+
+
 static int tolua_cBlockArea_GetCoordRange(lua_State * a_LuaState)
 {
 	// function cBlockArea::GetCoordRange()
@@ -1154,12 +1306,16 @@ void cManualBindings::BindBlockArea(lua_State * a_LuaState)
 			tolua_function(a_LuaState, "DoWithBlockEntityAt",     DoWithXYZ<cBlockArea, cBlockEntity, &cBlockArea::DoWithBlockEntityAt,    &cBlockArea::IsValidCoords>);
 			tolua_function(a_LuaState, "DoWithBlockEntityRelAt",  DoWithXYZ<cBlockArea, cBlockEntity, &cBlockArea::DoWithBlockEntityRelAt, &cBlockArea::IsValidRelCoords>);
 			tolua_function(a_LuaState, "FillRelCuboid",           tolua_cBlockArea_FillRelCuboid);
+			tolua_function(a_LuaState, "FindBlocks",              FindBlocks<false>);
+			tolua_function(a_LuaState, "FindRelBlocks",           FindBlocks<true>);
 			tolua_function(a_LuaState, "ForEachBlockEntity",      ForEach<  cBlockArea, cBlockEntity, &cBlockArea::ForEachBlockEntity>);
 			tolua_function(a_LuaState, "GetBlockLight",           GetBlock<NIBBLETYPE, cBlockArea::baLight,    &cBlockArea::GetRelBlockLight>);
 			tolua_function(a_LuaState, "GetBlockMeta",            GetBlock<NIBBLETYPE, cBlockArea::baMetas,    &cBlockArea::GetRelBlockMeta>);
+			tolua_function(a_LuaState, "GetBlockMetasString",     GetArrayString<cBlockArea::baMetas, &cBlockArea::GetBlockMetas>);
 			tolua_function(a_LuaState, "GetBlockSkyLight",        GetBlock<NIBBLETYPE, cBlockArea::baSkyLight, &cBlockArea::GetRelBlockSkyLight>);
 			tolua_function(a_LuaState, "GetBlockType",            GetBlock<BLOCKTYPE,  cBlockArea::baTypes,    &cBlockArea::GetRelBlockType>);
 			tolua_function(a_LuaState, "GetBlockTypeMeta",        tolua_cBlockArea_GetBlockTypeMeta);
+			tolua_function(a_LuaState, "GetBlockTypesString",     GetArrayString<cBlockArea::baTypes, &cBlockArea::GetBlockTypes>);
 			tolua_function(a_LuaState, "GetCoordRange",           tolua_cBlockArea_GetCoordRange);
 			tolua_function(a_LuaState, "GetNonAirCropRelCoords",  tolua_cBlockArea_GetNonAirCropRelCoords);
 			tolua_function(a_LuaState, "GetOrigin",               tolua_cBlockArea_GetOrigin);
@@ -1177,9 +1333,11 @@ void cManualBindings::BindBlockArea(lua_State * a_LuaState)
 			tolua_function(a_LuaState, "SaveToSchematicString",   tolua_cBlockArea_SaveToSchematicString);
 			tolua_function(a_LuaState, "SetBlockType",            SetBlock<BLOCKTYPE,  cBlockArea::baTypes,    &cBlockArea::SetRelBlockType>);
 			tolua_function(a_LuaState, "SetBlockMeta",            SetBlock<NIBBLETYPE, cBlockArea::baMetas,    &cBlockArea::SetRelBlockMeta>);
+			tolua_function(a_LuaState, "SetBlockMetasFromString", SetArrayFromString<cBlockArea::baMetas, &cBlockArea::GetBlockMetas, 0x0f>);
 			tolua_function(a_LuaState, "SetBlockLight",           SetBlock<NIBBLETYPE, cBlockArea::baLight,    &cBlockArea::SetRelBlockLight>);
 			tolua_function(a_LuaState, "SetBlockSkyLight",        SetBlock<NIBBLETYPE, cBlockArea::baSkyLight, &cBlockArea::SetRelBlockSkyLight>);
 			tolua_function(a_LuaState, "SetBlockTypeMeta",        tolua_cBlockArea_SetBlockTypeMeta);
+			tolua_function(a_LuaState, "SetBlockTypesFromString", SetArrayFromString<cBlockArea::baTypes, &cBlockArea::GetBlockTypes, 0xff>);
 			tolua_function(a_LuaState, "SetRelBlockType",         SetRelBlock<BLOCKTYPE,  cBlockArea::baTypes,    &cBlockArea::SetRelBlockType>);
 			tolua_function(a_LuaState, "SetRelBlockMeta",         SetRelBlock<NIBBLETYPE, cBlockArea::baMetas,    &cBlockArea::SetRelBlockMeta>);
 			tolua_function(a_LuaState, "SetRelBlockLight",        SetRelBlock<NIBBLETYPE, cBlockArea::baLight,    &cBlockArea::SetRelBlockLight>);
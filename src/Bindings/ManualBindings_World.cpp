@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "tolua++/include/tolua++.h"
 #include "../World.h"
+#include "../BlockArea.h"
 #include "../UUID.h"
 #include "ManualBindings.h"
 #include "LuaState.h"
@@ -760,6 +761,92 @@ static int tolua_cWorld_FastSetBlock(lua_State * tolua_S)
 
 
 
+/** Reads the cCuboid param at the specified stack index for the bulk block functions, sorts it and checks its height.
+Returns false (and raises an API error) if the bounds are not valid. */
+static bool readBulkBlockBounds(cLuaState & a_LuaState, int a_StackPos, cCuboid & a_Bounds)
+{
+	cCuboid * bounds = nullptr;
+	if (!a_LuaState.GetStackValue(a_StackPos, bounds) || (bounds == nullptr))
+	{
+		a_LuaState.ApiParamError("Cannot read the bounds, expected a cCuboid instance");
+		return false;
+	}
+	a_Bounds = *bounds;
+	a_Bounds.Sort();
+	if (!cChunkDef::IsValidHeight(a_Bounds.p1.y) || !cChunkDef::IsValidHeight(a_Bounds.p2.y))
+	{
+		a_LuaState.FApiParamError("The bounds ({0} - {1}) are out of the world's height range", a_Bounds.p1, a_Bounds.p2);
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+static int tolua_cWorld_FindBlocksInArea(lua_State * tolua_S)
+{
+	/* Function signature:
+	World:FindBlocksInArea(Cuboid, BlockTypes, [MaxResults]) -> {Vector3i, ...}
+	Returns nil if any of the chunks in the area is not loaded.
+	*/
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamSelf("cWorld") ||
+		!L.CheckParamUserType(2, "cCuboid") ||
+		!L.CheckParamTable(3) ||
+		!L.CheckParamEnd(5)
+	)
+	{
+		return 0;
+	}
+
+	cWorld * World;
+	cCuboid Bounds;
+	cBlockTypeSet BlockTypes;
+	int MaxResults = 0;
+	if (!L.GetStackValue(1, World) || (World == nullptr))
+	{
+		return cManualBindings::lua_do_error(tolua_S, "Error in function call '#funcname#': Invalid 'self'");
+	}
+	if (!readBulkBlockBounds(L, 2, Bounds))
+	{
+		return 0;
+	}
+	if (!cManualBindings::GetStackBlockTypeSet(L, 3, BlockTypes))
+	{
+		return L.ApiParamError("Cannot read the BlockTypes, expected an array-table of block type numbers");
+	}
+	if (L.IsParamNumber(4))
+	{
+		L.GetStackValue(4, MaxResults);
+	}
+
+	// Read the whole area at once, under a single lock per chunk, and scan it natively:
+	cBlockArea Area;
+	if (!Area.Read(*World, Bounds, cBlockArea::baTypes))
+	{
+		L.Push(cLuaState::Nil);
+		return 1;
+	}
+	auto Found = Area.FindRelBlocks(BlockTypes, static_cast<size_t>(std::max(MaxResults, 0)));
+	lua_createtable(tolua_S, static_cast<int>(Found.size()), 0);
+	int Index = 1;
+	for (const auto & RelPos: Found)
+	{
+		L.Push(RelPos + Bounds.p1);
+		lua_rawseti(tolua_S, -2, Index);
+		Index += 1;
+	}
+	return 1;
+}
+
+
+
+
+
 static int tolua_cWorld_ForEachEntityInChunk(lua_State * tolua_S)
 {
 	// Check params:
@@ -1222,6 +1309,50 @@ static int tolua_cWorld_GetBlockTypeMeta(lua_State * tolua_S)
 
 
 
+static int tolua_cWorld_GetBlocksInArea(lua_State * tolua_S)
+{
+	/* Function signature:
+	World:GetBlocksInArea(Cuboid) -> BlockTypesString, BlockMetasString
+	The strings contain one byte per block, X changes fastest, then Z, then Y.
+	Returns nil if any of the chunks in the area is not loaded.
+	*/
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamSelf("cWorld") ||
+		!L.CheckParamUserType(2, "cCuboid") ||
+		!L.CheckParamEnd(3)
+	)
+	{
+		return 0;
+	}
+
+	cWorld * World;
+	cCuboid Bounds;
+	if (!L.GetStackValue(1, World) || (World == nullptr))
+	{
+		return cManualBindings::lua_do_error(tolua_S, "Error in function call '#funcname#': Invalid 'self'");
+	}
+	if (!readBulkBlockBounds(L, 2, Bounds))
+	{
+		return 0;
+	}
+
+	cBlockArea Area;
+	if (!Area.Read(*World, Bounds, cBlockArea::baTypes | cBlockArea::baMetas))
+	{
+		L.Push(cLuaState::Nil);
+		return 1;
+	}
+	lua_pushlstring(tolua_S, reinterpret_cast<const char *>(Area.GetBlockTypes()), Area.GetBlockCount());
+	lua_pushlstring(tolua_S, reinterpret_cast<const char *>(Area.GetBlockMetas()), Area.GetBlockCount());
+	return 2;
+}
+
+
+
+
+
 static int tolua_cWorld_GetSignLines(lua_State * tolua_S)
 {
 	// Exported manually, because tolua would generate useless additional parameters (a_Line1 .. a_Line4)
@@ -1541,6 +1672,88 @@ static int tolua_cWorld_SetBlockMeta(lua_State * tolua_S)
 
 
 
+/** The largest number of blocks that SetBlocksInArea() accepts in a single call, 256 x 256 x 256. */
+static const Int64 MAX_SET_BLOCKS_IN_AREA = 256 * 256 * 256;
+
+
+
+
+
+static int tolua_cWorld_SetBlocksInArea(lua_State * tolua_S)
+{
+	/* Function signature:
+	World:SetBlocksInArea(Cuboid, BlockTypesString, [BlockMetasString]) -> bool
+	The strings contain one byte per block, X changes fastest, then Z, then Y; same as returned by GetBlocksInArea().
+	If the metas are not given, they are set to zero.
+	Returns false, without changing any block, if any of the chunks in the area is not loaded.
+	Areas larger than MAX_SET_BLOCKS_IN_AREA blocks are rejected with an error.
+	*/
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamSelf("cWorld") ||
+		!L.CheckParamUserType(2, "cCuboid") ||
+		!L.CheckParamString(3) ||
+		!L.CheckParamEnd(5)
+	)
+	{
+		return 0;
+	}
+
+	cWorld * World;
+	cCuboid Bounds;
+	std::string_view BlockTypes, BlockMetas;
+	if (!L.GetStackValue(1, World) || (World == nullptr))
+	{
+		return cManualBindings::lua_do_error(tolua_S, "Error in function call '#funcname#': Invalid 'self'");
+	}
+	if (!readBulkBlockBounds(L, 2, Bounds))
+	{
+		return 0;
+	}
+	L.GetStackValue(3, BlockTypes);
+	bool HasMetas = (lua_type(tolua_S, 4) == LUA_TSTRING);
+	if (HasMetas)
+	{
+		L.GetStackValue(4, BlockMetas);
+	}
+
+	// Check the sizes before allocating anything, the cuboid may be arbitrarily large.
+	// The sizes are computed in 64 bits, the cuboid's extents may overflow an int:
+	const auto SizeX = static_cast<Int64>(Bounds.p2.x) - Bounds.p1.x + 1;
+	const auto SizeY = static_cast<Int64>(Bounds.p2.y) - Bounds.p1.y + 1;
+	const auto SizeZ = static_cast<Int64>(Bounds.p2.z) - Bounds.p1.z + 1;
+	if ((SizeX > MAX_SET_BLOCKS_IN_AREA) || (SizeZ > MAX_SET_BLOCKS_IN_AREA) || (SizeX * SizeY * SizeZ > MAX_SET_BLOCKS_IN_AREA))
+	{
+		return L.FApiParamError("The area ({0} - {1}) is too large, at most {2} blocks can be set at once", Bounds.p1, Bounds.p2, MAX_SET_BLOCKS_IN_AREA);
+	}
+	const auto NumBlocks = static_cast<size_t>(SizeX * SizeY * SizeZ);
+	if ((BlockTypes.size() != NumBlocks) || (HasMetas && (BlockMetas.size() != NumBlocks)))
+	{
+		return L.ApiParamError("The data length (%u, %u) doesn't match the number of blocks in the area (%u)",
+			static_cast<unsigned>(BlockTypes.size()), static_cast<unsigned>(BlockMetas.size()), static_cast<unsigned>(NumBlocks)
+		);
+	}
+
+	cBlockArea Area;
+	Area.Create(static_cast<int>(SizeX), static_cast<int>(SizeY), static_cast<int>(SizeZ), cBlockArea::baTypes | cBlockArea::baMetas);
+	std::memcpy(Area.GetBlockTypes(), BlockTypes.data(), NumBlocks);
+	if (HasMetas)
+	{
+		auto Metas = Area.GetBlockMetas();
+		for (size_t i = 0; i < NumBlocks; i++)
+		{
+			Metas[i] = static_cast<NIBBLETYPE>(BlockMetas[i]) & 0x0f;
+		}
+	}
+	L.Push(World->WriteBlockAreaIfLoaded(Area, Bounds.p1.x, Bounds.p1.y, Bounds.p1.z, Area.GetDataTypes()));
+	return 1;
+}
+
+
+
+
+
 static int tolua_cWorld_SetSignLines(lua_State * tolua_S)
 {
 	// Exported manually, because tolua would generate useless additional return values (a_Line1 .. a_Line4)
@@ -1760,6 +1973,7 @@ void cManualBindings::BindWorld(lua_State * tolua_S)
 			tolua_function(tolua_S, "DoWithPlayer",                 DoWith<cWorld, cPlayer, &cWorld::DoWithPlayer>);
 			tolua_function(tolua_S, "DoWithPlayerByUUID",           tolua_cWorld_DoWithPlayerByUUID);
 			tolua_function(tolua_S, "FastSetBlock",                 tolua_cWorld_FastSetBlock);
+			tolua_function(tolua_S, "FindBlocksInArea",             tolua_cWorld_FindBlocksInArea);
 			tolua_function(tolua_S, "FindAndDoWithPlayer",          DoWith<cWorld, cPlayer, &cWorld::FindAndDoWithPlayer>);
 			tolua_function(tolua_S, "ForEachBlockEntityInChunk",    ForEachBlockEntityInChunk<cBlockEntity>);
 			tolua_function(tolua_S, "ForEachBrewingstandInChunk",   ForEachBlockEntityInChunk<cBrewingstandEntity, E_BLOCK_BREWING_STAND>);
@@ -1776,6 +1990,7 @@ void cManualBindings::BindWorld(lua_State * tolua_S)
 			tolua_function(tolua_S, "GetBlockMeta",                 tolua_cWorld_GetBlockMeta);
 			tolua_function(tolua_S, "GetBlockSkyLight",             tolua_cWorld_GetBlockSkyLight);
 			tolua_function(tolua_S, "GetBlockTypeMeta",             tolua_cWorld_GetBlockTypeMeta);
+			tolua_function(tolua_S, "GetBlocksInArea",              tolua_cWorld_GetBlocksInArea);
 			tolua_function(tolua_S, "GetSignLines",                 tolua_cWorld_GetSignLines);
 			tolua_function(tolua_S, "GetTimeOfDay",                 tolua_cWorld_GetTimeOfDay);
 			tolua_function(tolua_S, "GetWorldAge",                  tolua_cWorld_GetWorldAge);
@@ -1784,6 +1999,7 @@ void cManualBindings::BindWorld(lua_State * tolua_S)
 			tolua_function(tolua_S, "ScheduleTask",                 tolua_cWorld_ScheduleTask);
 			tolua_function(tolua_S, "SetBlock",                     tolua_cWorld_SetBlock);
 			tolua_function(tolua_S, "SetBlockMeta",                 tolua_cWorld_SetBlockMeta);
+			tolua_function(tolua_S, "SetBlocksInArea",              tolua_cWorld_SetBlocksInArea);
 			tolua_function(tolua_S, "SetSignLines",                 tolua_cWorld_SetSignLines);
 			tolua_function(tolua_S, "SetTimeOfDay",                 tolua_cWorld_SetTimeOfDay);
 			tolua_function(tolua_S, "SpawnSplitExperienceOrbs",     tolua_cWorld_SpawnSplitExperienceOrbs);
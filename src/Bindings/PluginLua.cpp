@@ -68,6 +68,9 @@ void cPluginLua::Close(void)
 	// Release all the references in the hook map:
 	m_HookMap.clear();
 
+	// Remove the profiler's hook, the results stay available:
+	m_Profiler.Stop();
+
 	// Close the Lua engine:
 	op().Close();
 }
@@ -1160,6 +1163,61 @@ bool cPluginLua::AddHookCallback(int a_HookType, cLuaState::cCallbackPtr && a_Ca
 
 
 
+void cPluginLua::StartProfiling(int a_InstructionInterval)
+{
+	cOperation op(*this);
+	if (!op().IsValid())
+	{
+		return;
+	}
+	m_Profiler.Start(op(), a_InstructionInterval);
+}
+
+
+
+
+
+void cPluginLua::StopProfiling(void)
+{
+	cOperation op(*this);
+	m_Profiler.Stop();
+}
+
+
+
+
+
+bool cPluginLua::IsProfiling(void)
+{
+	cOperation op(*this);
+	return m_Profiler.IsRunning();
+}
+
+
+
+
+
+void cPluginLua::ResetProfile(void)
+{
+	cOperation op(*this);
+	m_Profiler.Reset();
+}
+
+
+
+
+
+std::vector<cLuaProfiler::sLocation> cPluginLua::GetProfile(std::chrono::nanoseconds & a_TotalTime)
+{
+	cOperation op(*this);
+	a_TotalTime = m_Profiler.GetTotalTime();
+	return m_Profiler.GetResults();
+}
+
+
+
+
+
 int cPluginLua::CallFunctionFromForeignState(
 	const AString & a_FunctionName,
 	cLuaState & a_ForeignState,
@@ -11,6 +11,7 @@
 
 #include "Plugin.h"
 #include "LuaState.h"
+#include "LuaProfiler.h"
 
 // Names for the global variables through which the plugin is identified in its LuaState
 #define LUA_PLUGIN_INSTANCE_VAR_NAME "_CuberiteInternal_PluginInstance"
@@ -155,6 +156,23 @@ public:
 		int a_ParamEnd
 	);
 
+	/** Starts the sampling profiler of the plugin's Lua code, taking a sample after every a_InstructionInterval Lua VM instructions.
+	If the profiler is already running, only changes the interval. */
+	void StartProfiling(int a_InstructionInterval);
+
+	/** Stops the sampling profiler. The results collected so far are kept until ResetProfile() is called. */
+	void StopProfiling(void);
+
+	/** Returns true if the sampling profiler is running. */
+	bool IsProfiling(void);
+
+	/** Clears the results of the sampling profiler. */
+	void ResetProfile(void);
+
+	/** Returns the results of the sampling profiler, sorted by the time spent, longest first.
+	a_TotalTime receives the total time sampled. */
+	std::vector<cLuaProfiler::sLocation> GetProfile(std::chrono::nanoseconds & a_TotalTime);
+
 	/** Call a Lua function residing in the plugin. */
 	template <typename FnT, typename... Args>
 	bool Call(FnT a_Fn, Args && ... a_Args)
@@ -179,6 +197,9 @@ protected:
 	/** The DeadlockDetect object to which the plugin's CS is tracked. */
 	cDeadlockDetect & m_DeadlockDetect;
 
+	/** The sampling profiler of the plugin's Lua code. Protected by the Lua state's lock. */
+	cLuaProfiler m_Profiler;
+
 
 	/** Releases all Lua references, notifies and removes all m_Resettables[] and closes the m_LuaState. */
 	void Close(void);
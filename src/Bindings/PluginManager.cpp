@@ -29,6 +29,7 @@ cPluginManager::cPluginManager(cDeadlockDetect & a_DeadlockDetect) :
 	m_bReloadPlugins(false),
 	m_DeadlockDetect(a_DeadlockDetect)
 {
+	m_HookBudgets.fill(std::chrono::nanoseconds::zero());
 }
 
 
@@ -123,6 +124,8 @@ void cPluginManager::ReloadPluginsNow(cSettingsRepositoryInterface & a_Settings)
 	// Refresh the list of plugins to load new ones from disk / remove the deleted ones:
 	RefreshPluginList();
 
+	LoadHookBudgets(a_Settings);
+
 	// Load the plugins:
 	AStringVector ToLoad = GetFoldersToLoad(a_Settings);
 	for (auto & pluginFolder: ToLoad)
@@ -230,7 +233,12 @@ void cPluginManager::Tick(float a_Dt)
 
 	for (auto * Plugin : Plugins->second)
 	{
-		Plugin->Tick(a_Dt);
+		TimeHookCall(*Plugin, HOOK_TICK, [&]()
+			{
+				Plugin->Tick(a_Dt);
+				return false;
+			}
+		);
 	}
 }
 
@@ -247,7 +255,63 @@ bool cPluginManager::GenericCallHook(PluginHook a_HookName, HookFunction a_HookF
 		return false;
 	}
 
-	return std::any_of(Plugins->second.begin(), Plugins->second.end(), a_HookFunction);
+	return std::any_of(Plugins->second.begin(), Plugins->second.end(), [&](cPlugin * a_Plugin)
+		{
+			return TimeHookCall(*a_Plugin, a_HookName, [&]()
+				{
+					return a_HookFunction(a_Plugin);
+				}
+			);
+		}
+	);
+}
+
+
+
+
+
+template <typename CallFunction>
+bool cPluginManager::TimeHookCall(cPlugin & a_Plugin, PluginHook a_HookType, CallFunction a_Call)
+{
+	auto Start = std::chrono::steady_clock::now();
+	bool Res = a_Call();
+	AddHookCallTime(a_Plugin, a_HookType, std::chrono::steady_clock::now() - Start);
+	return Res;
+}
+
+
+
+
+
+void cPluginManager::AddHookCallTime(const cPlugin & a_Plugin, PluginHook a_HookType, std::chrono::nanoseconds a_Time)
+{
+	cCSLock Lock(m_CSHookStats);
+	auto & Stats = m_HookStats[&a_Plugin][static_cast<size_t>(a_HookType)];
+	Stats.m_NumCalls += 1;
+	Stats.m_TotalTime += a_Time;
+	Stats.m_MaxTime = std::max(Stats.m_MaxTime, a_Time);
+
+	auto Budget = m_HookBudgets[static_cast<size_t>(a_HookType)];
+	if ((Budget == std::chrono::nanoseconds::zero()) || (a_Time <= Budget))
+	{
+		return;
+	}
+	Stats.m_NumOverruns += 1;
+
+	// Warn only once in a while, a plugin that is slow in a frequent hook would flood the console otherwise:
+	auto Now = std::chrono::steady_clock::now();
+	if ((Stats.m_NumOverruns > 1) && (Now - Stats.m_LastWarning < std::chrono::seconds(10)))
+	{
+		return;
+	}
+	Stats.m_LastWarning = Now;
+	LOGWARNING("Plugin %s took %.2f ms in %s, over the budget of %.2f ms (%llu overruns so far)",
+		a_Plugin.GetName().c_str(),
+		std::chrono::duration<double, std::milli>(a_Time).count(),
+		GetHookName(a_HookType).c_str(),
+		std::chrono::duration<double, std::milli>(Budget).count(),
+		static_cast<unsigned long long>(Stats.m_NumOverruns)
+	);
 }
 
 
@@ -1033,7 +1097,7 @@ bool cPluginManager::CallHookPluginsLoaded(void)
 	bool res = false;
 	for (auto * Plugin : Plugins->second)
 	{
-		if (!Plugin->OnPluginsLoaded())
+		if (!TimeHookCall(*Plugin, HOOK_PLUGINS_LOADED, [&]() { return Plugin->OnPluginsLoaded(); }))
 		{
 			res = true;
 		}
@@ -1383,6 +1447,10 @@ void cPluginManager::RemoveHooks(cPlugin * a_Plugin)
 	{
 		Hook.second.remove(a_Plugin);
 	}
+
+	// The statistics are for the plugin's handlers, which are gone now:
+	cCSLock Lock(m_CSHookStats);
+	m_HookStats.erase(a_Plugin);
 }
 
 
@@ -1724,6 +1792,90 @@ AString cPluginManager::GetPluginFolderName(const AString & a_PluginName)
 
 
 
+std::vector<cPluginManager::sHookStatsItem> cPluginManager::GetHookStats(void) const
+{
+	std::vector<sHookStatsItem> Res;
+	{
+		cCSLock Lock(m_CSHookStats);
+		for (const auto & PluginStats: m_HookStats)
+		{
+			for (size_t HookType = 0; HookType < PluginStats.second.size(); HookType++)
+			{
+				const auto & Stats = PluginStats.second[HookType];
+				if (Stats.m_NumCalls > 0)
+				{
+					Res.push_back({PluginStats.first->GetName(), static_cast<int>(HookType), Stats});
+				}
+			}
+		}
+	}
+
+	std::sort(Res.begin(), Res.end(), [](const sHookStatsItem & a_First, const sHookStatsItem & a_Second)
+		{
+			return (a_First.m_Stats.m_TotalTime > a_Second.m_Stats.m_TotalTime);
+		}
+	);
+	return Res;
+}
+
+
+
+
+
+void cPluginManager::ResetHookStats(void)
+{
+	cCSLock Lock(m_CSHookStats);
+	m_HookStats.clear();
+}
+
+
+
+
+
+void cPluginManager::SetHookBudget(int a_HookType, double a_BudgetMSec)
+{
+	if (!IsValidHookType(a_HookType))
+	{
+		LOGWARNING("%s: Invalid hook type: %d", __FUNCTION__, a_HookType);
+		return;
+	}
+	auto Budget = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double, std::milli>(std::max(a_BudgetMSec, 0.0)));
+	cCSLock Lock(m_CSHookStats);
+	m_HookBudgets[static_cast<size_t>(a_HookType)] = Budget;
+}
+
+
+
+
+
+double cPluginManager::GetHookBudget(int a_HookType) const
+{
+	if (!IsValidHookType(a_HookType))
+	{
+		return 0;
+	}
+	cCSLock Lock(m_CSHookStats);
+	return std::chrono::duration<double, std::milli>(m_HookBudgets[static_cast<size_t>(a_HookType)]).count();
+}
+
+
+
+
+
+AString cPluginManager::GetHookName(int a_HookType)
+{
+	auto Name = cPluginLua::GetHookFnName(a_HookType);
+	if (Name == nullptr)
+	{
+		return Printf("Hook%d", a_HookType);
+	}
+	return Name;
+}
+
+
+
+
+
 void cPluginManager::AddHook(cPlugin * a_Plugin, int a_Hook)
 {
 	if (a_Plugin == nullptr)
@@ -1816,3 +1968,24 @@ AStringVector cPluginManager::GetFoldersToLoad(cSettingsRepositoryInterface & a_
 
 
 
+
+void cPluginManager::LoadHookBudgets(cSettingsRepositoryInterface & a_Settings)
+{
+	float DefaultBudget = 0;
+	StringToFloat(a_Settings.GetValueSet("PluginHookBudgets", "Default", "0"), DefaultBudget);
+	for (int HookType = 0; HookType < HOOK_NUM_HOOKS; HookType++)
+	{
+		float Budget = DefaultBudget;
+		auto Value = a_Settings.GetValue("PluginHookBudgets", GetHookName(HookType));
+		if (!Value.empty() && !StringToFloat(Value, Budget))
+		{
+			LOGWARNING("Invalid time budget for hook %s in settings.ini: \"%s\", using the default.", GetHookName(HookType).c_str(), Value.c_str());
+			Budget = DefaultBudget;
+		}
+		SetHookBudget(HookType, static_cast<double>(Budget));
+	}
+}
+
+
+
+
@@ -235,6 +235,51 @@ public:
 	/** Returns the number of plugins that are psLoaded. */
 	size_t GetNumLoadedPlugins(void) const;  // tolua_export
 
+	/** Timing statistics of a single plugin's handlers for a single hook type. */
+	struct sHookStats
+	{
+		/** Number of times the plugin was called for the hook. */
+		UInt64 m_NumCalls = 0;
+
+		/** Total time spent in the plugin's handlers of the hook. */
+		std::chrono::nanoseconds m_TotalTime{0};
+
+		/** The longest single call of the plugin's handlers of the hook. */
+		std::chrono::nanoseconds m_MaxTime{0};
+
+		/** Number of calls that took longer than the hook's time budget. */
+		UInt64 m_NumOverruns = 0;
+
+		/** When the last overrun warning was logged, used to limit the warnings' rate. */
+		std::chrono::steady_clock::time_point m_LastWarning;
+	};
+
+	/** A single item of the hook statistics, as returned by GetHookStats(). */
+	struct sHookStatsItem
+	{
+		AString m_PluginName;
+		int m_HookType;
+		sHookStats m_Stats;
+	};
+
+	/** Returns the timing statistics of all the plugins' hook handlers called since the last reset,
+	sorted by the total time spent, longest first. Exported in ManualBindings.cpp. */
+	std::vector<sHookStatsItem> GetHookStats(void) const;
+
+	/** Clears the timing statistics of all the plugins' hook handlers. */
+	void ResetHookStats(void);  // tolua_export
+
+	/** Sets the soft time budget for a single plugin's handlers of the specified hook type.
+	Each call that takes longer is counted as an overrun and a warning is logged (at most once per 10 seconds per plugin and hook).
+	A budget of 0 disables the checking for the hook type. */
+	void SetHookBudget(int a_HookType, double a_BudgetMSec);  // tolua_export
+
+	/** Returns the soft time budget for the specified hook type, in milliseconds; 0 if there's no budget. */
+	double GetHookBudget(int a_HookType) const;  // tolua_export
+
+	/** Returns the name used for the specified hook type in the reports and in settings.ini, such as "OnPlayerMoving". */
+	static AString GetHookName(int a_HookType);
+
 	// Calls for individual hooks. Each returns false if the action is to continue or true if the plugin wants to abort
 	bool CallHookBlockSpread              (cWorld & a_World, int a_BlockX, int a_BlockY, int a_BlockZ, eSpreadSource a_Source);
 	bool CallHookBlockToPickups           (cWorld & a_World, Vector3i a_BlockPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, const cBlockEntity * a_BlockEntity, const cEntity * a_Digger, const cItem * a_Tool, cItems & a_Pickups);
@@ -441,6 +486,17 @@ private:
 	/** The deadlock detect in which all plugins should track their CSs. */
 	cDeadlockDetect & m_DeadlockDetect;
 
+	/** The timing statistics for each plugin's hook handlers, indexed by the hook type.
+	Protected against multithreaded access by m_CSHookStats. */
+	std::unordered_map<const cPlugin *, std::array<sHookStats, HOOK_NUM_HOOKS>> m_HookStats;
+
+	/** The soft time budget for each hook type, zero for no budget.
+	Protected against multithreaded access by m_CSHookStats. */
+	std::array<std::chrono::nanoseconds, HOOK_NUM_HOOKS> m_HookBudgets;
+
+	/** Protects m_HookStats and m_HookBudgets against multithreaded access. */
+	mutable cCriticalSection m_CSHookStats;
+
 
 	cPluginManager(cDeadlockDetect & a_DeadlockDetect);
 	virtual ~cPluginManager();
@@ -463,6 +519,19 @@ private:
 	/** Returns the folders that are specified in the settings ini to load plugins from. */
 	AStringVector GetFoldersToLoad(cSettingsRepositoryInterface & a_Settings);
 
+	/** Reads the hook time budgets from the PluginHookBudgets section of the settings.
+	The Default value applies to all hook types that don't have their own value. */
+	void LoadHookBudgets(cSettingsRepositoryInterface & a_Settings);
+
+	/** Calls a_Call, which calls the plugin's handlers of the hook, and adds the time it took to the plugin's statistics.
+	Returns the value returned by a_Call. */
+	template <typename CallFunction>
+	bool TimeHookCall(cPlugin & a_Plugin, PluginHook a_HookType, CallFunction a_Call);
+
+	/** Adds a single call of the plugin's handlers of the hook, taking the specified time, to the statistics.
+	Logs a warning if the call was over the hook's budget. */
+	void AddHookCallTime(const cPlugin & a_Plugin, PluginHook a_HookType, std::chrono::nanoseconds a_Time);
+
 	/** Calls a_HookFunction on each plugin registered to the hook HookName.
 	Returns false if the action is to continue or true if the plugin wants to abort.
 	Accessible only from within PluginManager.cpp */
@@ -1976,6 +1976,42 @@ size_t cBlockArea::CountSpecificBlocks(BLOCKTYPE a_BlockType, NIBBLETYPE a_Block
 
 
 
+std::vector<Vector3i> cBlockArea::FindRelBlocks(const cBlockTypeSet & a_BlockTypes, size_t a_MaxResults) const
+{
+	std::vector<Vector3i> res;
+	if (m_BlockTypes == nullptr)
+	{
+		LOGWARNING("%s: BlockTypes not available!", __FUNCTION__);
+		return res;
+	}
+
+	// Walk the array in its natural order, computing the coords along:
+	size_t idx = 0;
+	for (int y = 0; y < m_Size.y; y++)
+	{
+		for (int z = 0; z < m_Size.z; z++)
+		{
+			for (int x = 0; x < m_Size.x; x++, idx++)
+			{
+				if (!a_BlockTypes[m_BlockTypes[idx]])
+				{
+					continue;
+				}
+				res.emplace_back(x, y, z);
+				if (res.size() == a_MaxResults)
+				{
+					return res;
+				}
+			}  // for x
+		}  // for z
+	}  // for y
+	return res;
+}
+
+
+
+
+
 void cBlockArea::GetNonAirCropRelCoords(int & a_MinRelX, int & a_MinRelY, int & a_MinRelZ, int & a_MaxRelX, int & a_MaxRelY, int & a_MaxRelZ, BLOCKTYPE a_IgnoreBlockType)
 {
 	// Check if blocktypes are valid:
@@ -379,6 +379,12 @@ public:
 
 	// tolua_end
 
+	/** Returns the relative coords of all the blocks whose type is in a_BlockTypes, in the order of the internal arrays
+	(X changes fastest, then Z, then Y). At most a_MaxResults coords are returned, 0 means no limit.
+	Returns an empty vector if blocktypes are not available.
+	Exported to Lua in ManualBindings_BlockArea.cpp. */
+	std::vector<Vector3i> FindRelBlocks(const cBlockTypeSet & a_BlockTypes, size_t a_MaxResults = 0) const;
+
 	/** Returns the minimum and maximum coords in each direction for the first non-ignored block in each direction.
 	If there are no non-ignored blocks within the area, or blocktypes are not present, the returned values are reverse-ranges (MinX <- m_RangeX, MaxX <- 0 etc.)
 	Exported to Lua in ManualBindings.cpp. */
@@ -75,13 +75,13 @@ namespace
 
 
 
-	/** Calls the function object a_Func for every client who has the specified entity
+	/** Calls the function object a_Func for every client who has the chunk of the specified entity, regardless of tracking
 	\param a_Entity Entity to query for clients
 	\param a_World World that the block is in
 	\param a_Exclude Client for which a_Func should not be called
 	\param a_Func Function to be called with each non-excluded client */
 	template <typename Func>
-	void ForClientsWithEntity(const cEntity & a_Entity, cWorld & a_World, const cClientHandle * a_Exclude, Func a_Func)
+	void ForClientsWithEntityChunk(const cEntity & a_Entity, cWorld & a_World, const cClientHandle * a_Exclude, Func a_Func)
 	{
 		cWorld::cLock Lock(a_World);  // Lock world before accessing a_Entity
 		auto Chunk = a_Entity.GetParentChunk();
@@ -100,6 +100,27 @@ namespace
 			ForClientsWithChunk({ a_Entity.GetChunkX(), a_Entity.GetChunkZ() }, a_World, a_Exclude, std::move(a_Func));
 		}
 	}
+
+
+
+	/** Calls the function object a_Func for every client who has the specified entity spawned (see cEntityTracker),
+	and for the client of the entity itself, if it is a player
+	\param a_Entity Entity to query for clients
+	\param a_World World that the block is in
+	\param a_Exclude Client for which a_Func should not be called
+	\param a_Func Function to be called with each non-excluded client */
+	template <typename Func>
+	void ForClientsWithEntity(const cEntity & a_Entity, cWorld & a_World, const cClientHandle * a_Exclude, Func a_Func)
+	{
+		ForClientsWithEntityChunk(a_Entity, a_World, a_Exclude, [&](cClientHandle & a_Client)
+			{
+				if ((a_Client.GetPlayer() == &a_Entity) || a_Client.IsTrackingEntity(a_Entity))
+				{
+					a_Func(a_Client);
+				}
+			}
+		);
+	}
 }  // namespace (anonymous)
 
 
@@ -230,9 +251,9 @@ void cWorld::BroadcastCollectEntity(const cEntity & a_Collected, const cEntity &
 
 void cWorld::BroadcastDestroyEntity(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	ForClientsWithEntity(a_Entity, *this, a_Exclude, [&](cClientHandle & a_Client)
+	ForClientsWithEntityChunk(a_Entity, *this, a_Exclude, [&](cClientHandle & a_Client)
 		{
-			a_Client.SendDestroyEntity(a_Entity);
+			a_Client.UntrackEntity(a_Entity);
 		}
 	);
 }
@@ -568,9 +589,12 @@ void cWorld::BroadcastSoundParticleEffect(const EffectID a_EffectID, Vector3i a_
 
 void cWorld::BroadcastSpawnEntity(cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	ForClientsWithEntity(a_Entity, *this, a_Exclude, [&](cClientHandle & a_Client)
+	ForClientsWithEntityChunk(a_Entity, *this, a_Exclude, [&](cClientHandle & a_Client)
 		{
-			a_Entity.SpawnOn(a_Client);
+			if ((a_Client.GetPlayer() != &a_Entity) && m_EntityTracker.IsInRange(a_Entity, a_Client))
+			{
+				a_Client.TrackEntity(a_Entity);
+			}
 		}
 	);
 }
@@ -35,6 +35,58 @@
 
 
 
+/** Estimated size of a single record in the multi-block change packet: Int16 position plus a VarInt block of up to 3 bytes. */
+static const size_t BLOCK_CHANGE_RECORD_BYTES = 5;
+
+/** Estimated size of the multi-block change packet header: chunk coords and record count. */
+static const size_t BLOCK_CHANGES_HEADER_BYTES = 12;
+
+/** Estimated size of a chunk section in the chunk data packet: 13 bits per block (global palette) plus block light. */
+static const size_t SECTION_DATA_BYTES = ChunkBlockData::SectionBlockCount * 13 / 8 + ChunkLightData::SectionLightCount;
+
+/** Estimated size of the section's sky light in the chunk data packet, sent in the Overworld only. */
+static const size_t SECTION_SKYLIGHT_BYTES = ChunkLightData::SectionLightCount;
+
+/** Estimated size of the chunk data packet parts that don't depend on the sections (header, biomes). */
+static const size_t CHUNK_DATA_HEADER_BYTES = 16 + cChunkDef::Width * cChunkDef::Width;
+
+/** Chunk data compresses several times better than block change records, whose positions are mostly unique.
+The estimated chunk data size is divided by this before being compared to the block changes. */
+static const size_t CHUNK_DATA_COMPRESSION_ADVANTAGE = 4;
+
+/** Maximum number of changed blocks remembered for waking up the resting entities.
+When more blocks change within a single tick, all the resting entities in the chunk are woken up instead. */
+static const size_t MAX_RESTING_WAKEUP_BLOCKS = 64;
+
+
+
+
+
+/** Returns true if the entity touches any of the specified blocks, or rests on one of them. */
+static bool IsTouchingAnyBlock(const cEntity & a_Entity, const std::vector<Vector3i> & a_Blocks)
+{
+	if (a_Blocks.empty())
+	{
+		return false;
+	}
+
+	// Expand the entity's box by a block, so that the block it rests on and the ones next to it are included:
+	auto EntityBox = a_Entity.GetBoundingBox();
+	EntityBox.Expand(1, 1, 1);
+	for (const auto & Block : a_Blocks)
+	{
+		if (EntityBox.DoesIntersect(cBoundingBox(Vector3d(Block), Vector3d(Block) + Vector3d(1, 1, 1))))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cChunk:
 
@@ -54,8 +106,13 @@ cChunk::cChunk(
 	m_WaterSimulatorData(a_World->GetWaterSimulator()->CreateChunkData()),
 	m_LavaSimulatorData (a_World->GetLavaSimulator ()->CreateChunkData()),
 	m_RedstoneSimulatorData(a_World->GetRedstoneSimulator()->CreateChunkData()),
-	m_AlwaysTicked(0)
+	m_AlwaysTicked(0),
+	m_NumTickedEntities(0),
+	m_NumRestingEntities(0),
+	m_ShouldWakeUpAllResting(false)
 {
+	InvalidateAllMapColumns();
+
 	m_NeighborXM = a_ChunkMap->FindChunk(a_ChunkX - 1, a_ChunkZ);
 	m_NeighborXP = a_ChunkMap->FindChunk(a_ChunkX + 1, a_ChunkZ);
 	m_NeighborZM = a_ChunkMap->FindChunk(a_ChunkX, a_ChunkZ - 1);
@@ -119,7 +176,17 @@ cChunk::~cChunk()
 
 void cChunk::BroadcastPendingChanges(void)
 {
-	if (const auto PendingBlocksCount = m_PendingSendBlocks.size(); PendingBlocksCount >= 10240)
+	if (m_LoadedByClient.empty())
+	{
+		// Nobody to send to:
+		m_PendingSendBlocks.clear();
+		m_PendingSendBlockEntities.clear();
+		return;
+	}
+
+	DeduplicatePendingChanges();
+
+	if (const auto PendingBlocksCount = m_PendingSendBlocks.size(); (PendingBlocksCount > 1) && ShouldResendInsteadOfChanges())
 	{
 		// Resend the full chunk:
 		for (const auto ClientHandle : m_LoadedByClient)
@@ -160,6 +227,91 @@ void cChunk::BroadcastPendingChanges(void)
 
 
 
+void cChunk::UpdateEntityTracking(void)
+{
+	if (m_LoadedByClient.empty())
+	{
+		return;
+	}
+
+	auto & Tracker = m_World->GetEntityTracker();
+	for (const auto & Entity : m_Entities)
+	{
+		Tracker.UpdateEntity(*Entity, m_LoadedByClient);
+	}
+}
+
+
+
+
+
+void cChunk::DeduplicatePendingChanges(void)
+{
+	if (m_PendingSendBlocks.size() > 1)
+	{
+		// Order by position, keeping the order of writes to the same block, then keep the last write of each block:
+		const auto Index = [](const sSetBlock & a_Change)
+		{
+			return cChunkDef::MakeIndex(a_Change.m_RelX, a_Change.m_RelY, a_Change.m_RelZ);
+		};
+		std::stable_sort(m_PendingSendBlocks.begin(), m_PendingSendBlocks.end(), [&Index](const sSetBlock & a_First, const sSetBlock & a_Second)
+			{
+				return (Index(a_First) < Index(a_Second));
+			}
+		);
+		size_t NumUnique = 0;
+		const auto Count = m_PendingSendBlocks.size();
+		for (size_t i = 0; i < Count; i++)
+		{
+			if ((i + 1 < Count) && (Index(m_PendingSendBlocks[i]) == Index(m_PendingSendBlocks[i + 1])))
+			{
+				// Overwritten later in the same tick:
+				continue;
+			}
+			m_PendingSendBlocks[NumUnique++] = m_PendingSendBlocks[i];
+		}
+		m_PendingSendBlocks.erase(m_PendingSendBlocks.begin() + static_cast<std::ptrdiff_t>(NumUnique), m_PendingSendBlocks.end());
+	}
+
+	if (m_PendingSendBlockEntities.size() > 1)
+	{
+		std::sort(m_PendingSendBlockEntities.begin(), m_PendingSendBlockEntities.end());
+		m_PendingSendBlockEntities.erase(std::unique(m_PendingSendBlockEntities.begin(), m_PendingSendBlockEntities.end()), m_PendingSendBlockEntities.end());
+	}
+}
+
+
+
+
+
+bool cChunk::ShouldResendInsteadOfChanges(void) const
+{
+	// Number of changes in each section:
+	std::array<size_t, cChunkDef::NumSections> NumChanges{};
+	for (const auto & Change: m_PendingSendBlocks)
+	{
+		NumChanges[static_cast<size_t>(Change.m_RelY) / cChunkDef::SectionHeight]++;
+	}
+
+	const bool HasSkyLight = (m_World->GetDimension() == dimOverworld);
+	size_t ChangesBytes = BLOCK_CHANGES_HEADER_BYTES;
+	size_t ChunkBytes = CHUNK_DATA_HEADER_BYTES;
+	for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+	{
+		ChangesBytes += NumChanges[Y] * BLOCK_CHANGE_RECORD_BYTES;
+		if ((NumChanges[Y] > 0) || (m_BlockData.GetSection(Y) != nullptr))
+		{
+			ChunkBytes += SECTION_DATA_BYTES + (HasSkyLight ? SECTION_SKYLIGHT_BYTES : 0);
+		}
+	}
+
+	return (ChunkBytes / CHUNK_DATA_COMPRESSION_ADVANTAGE < ChangesBytes);
+}
+
+
+
+
+
 void cChunk::SetPresence(cChunk::ePresence a_Presence)
 {
 	m_Presence = a_Presence;
@@ -208,6 +360,7 @@ bool cChunk::CanUnload(void) const
 {
 	return
 		m_LoadedByClient.empty() &&  // The chunk is not used by any client
+		m_PrefetchingClients.empty() &&  // No client will need the chunk soon
 		!HasPlayerEntities() &&      // Ensure not only the absence of ClientHandlers, but also of cPlayer objects
 		!m_IsDirty &&                // The chunk has been saved properly or hasn't been touched since the load / gen
 		(m_StayCount == 0) &&        // The chunk is not in a ChunkStay
@@ -222,6 +375,7 @@ bool cChunk::CanUnloadAfterSaving(void) const
 {
 	return
 		m_LoadedByClient.empty() &&  // The chunk is not used by any client
+		m_PrefetchingClients.empty() &&  // No client will need the chunk soon
 		!HasPlayerEntities() &&      // Ensure not only the absence of ClientHandlers, but also of cPlayer objects
 		m_IsDirty &&                 // The chunk is dirty
 		(m_StayCount == 0) &&        // The chunk is not in a ChunkStay
@@ -304,6 +458,29 @@ void cChunk::MarkLoadFailed(void)
 
 
 
+bool cChunk::TryCancelGeneration(void)
+{
+	if (
+		(m_Presence != cpQueued) ||
+		!m_LoadedByClient.empty() ||
+		!m_PrefetchingClients.empty() ||
+		HasPlayerEntities() ||
+		(m_StayCount != 0)
+	)
+	{
+		return false;
+	}
+
+	// There's nothing to save, the chunk has never been generated:
+	m_IsDirty = false;
+	SetPresence(cpInvalid);
+	return true;
+}
+
+
+
+
+
 void cChunk::GetAllData(cChunkDataCallback & a_Callback) const
 {
 	ASSERT(m_Presence == cpPresent);
@@ -336,6 +513,7 @@ void cChunk::SetAllData(SetChunkData && a_SetChunkData)
 	m_BlockData = std::move(a_SetChunkData.BlockData);
 	m_LightData = std::move(a_SetChunkData.LightData);
 	m_IsLightValid = a_SetChunkData.IsLightValid;
+	InvalidateAllMapColumns();
 
 	m_PendingSendBlocks.clear();
 	m_PendingSendBlockEntities.clear();
@@ -707,6 +885,13 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 		m_IsDirty = KeyPair.second->Tick(a_Dt, *this) | m_IsDirty;
 	}
 
+	// Blocks changed while ticking the entities are checked on the next tick:
+	std::vector<Vector3i> ChangedBlocks;
+	std::swap(ChangedBlocks, m_RestingWakeUpBlocks);
+	const auto ShouldWakeUpAllResting = m_ShouldWakeUpAllResting;
+	m_ShouldWakeUpAllResting = false;
+	size_t NumTicked = 0;
+	size_t NumResting = 0;
 	for (auto itr = m_Entities.begin(); itr != m_Entities.end();)
 	{
 		// Do not tick mobs that are detached from the world. They're either scheduled for teleportation or for removal.
@@ -718,10 +903,34 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 
 		if (!((*itr)->IsMob()))  // Mobs are ticked inside cWorld::TickMobs() (as we don't have to tick them if they are far away from players)
 		{
-			// Tick all entities in this chunk (except mobs):
-			ASSERT((*itr)->GetParentChunk() == this);
-			(*itr)->Tick(a_Dt, *this);
-			ASSERT((*itr)->GetParentChunk() == this);
+			auto & Entity = **itr;
+			ASSERT(Entity.GetParentChunk() == this);
+
+			// Resting entities only keep their timers going, unless a block around them has changed:
+			if (Entity.IsAtRest())
+			{
+				if (ShouldWakeUpAllResting || IsTouchingAnyBlock(Entity, ChangedBlocks))
+				{
+					Entity.WakeUp();
+				}
+				else
+				{
+					Entity.TickAtRest(a_Dt, *this);
+				}
+			}
+
+			// Tick all the other entities in this chunk (except mobs):
+			if (!Entity.IsAtRest() && Entity.IsTicking())
+			{
+				Entity.Tick(a_Dt, *this);
+				NumTicked += 1;
+			}
+			ASSERT(Entity.GetParentChunk() == this);
+
+			if (Entity.IsAtRest() && Entity.IsTicking())
+			{
+				NumResting += 1;
+			}
 		}
 
 		// Do not move mobs that are detached from the world to neighbors. They're either scheduled for teleportation or for removal.
@@ -755,6 +964,8 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 			++itr;
 		}
 	}  // for itr - m_Entitites[]
+	m_NumTickedEntities = NumTicked;
+	m_NumRestingEntities = NumResting;
 
 	ApplyWeatherToTop();
 
@@ -769,6 +980,64 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 
 
 
+void cChunk::WakeUpRestingEntities(Vector3i a_RelPos)
+{
+	const auto AbsPos = RelativeToAbsolute(a_RelPos);
+
+	// Entities in the neighbors may be touching blocks on the border, too:
+	const int MinX = (a_RelPos.x == 0) ? -1 : 0;
+	const int MaxX = (a_RelPos.x == cChunkDef::Width - 1) ? 1 : 0;
+	const int MinZ = (a_RelPos.z == 0) ? -1 : 0;
+	const int MaxZ = (a_RelPos.z == cChunkDef::Width - 1) ? 1 : 0;
+	for (int x = MinX; x <= MaxX; x++)
+	{
+		for (int z = MinZ; z <= MaxZ; z++)
+		{
+			auto Chunk = GetRelNeighborChunk(a_RelPos.x + x, a_RelPos.z + z);
+			if ((Chunk != nullptr) && Chunk->IsValid())
+			{
+				Chunk->QueueRestingWakeUp(AbsPos);
+			}
+		}
+	}
+}
+
+
+
+
+
+void cChunk::QueueRestingWakeUp(Vector3i a_AbsPos)
+{
+	if (m_ShouldWakeUpAllResting)
+	{
+		return;
+	}
+
+	// m_NumRestingEntities is only updated at the end of the entity ticking, check the entities themselves:
+	const auto HasRestingEntities = std::any_of(
+		m_Entities.begin(), m_Entities.end(),
+		[](const auto & Entity)
+		{
+			return Entity->IsAtRest();
+		}
+	);
+	if (!HasRestingEntities)
+	{
+		return;
+	}
+	if (m_RestingWakeUpBlocks.size() >= MAX_RESTING_WAKEUP_BLOCKS)
+	{
+		m_ShouldWakeUpAllResting = true;
+		m_RestingWakeUpBlocks.clear();
+		return;
+	}
+	m_RestingWakeUpBlocks.push_back(a_AbsPos);
+}
+
+
+
+
+
 void cChunk::TickBlock(const Vector3i a_RelPos)
 {
 	cChunkInterface ChunkInterface(this->GetWorld()->GetChunkMap());
@@ -801,12 +1070,13 @@ void cChunk::MoveEntityToNewChunk(OwnedEntity a_Entity)
 	{
 		virtual void Removed(cClientHandle * a_Client) override
 		{
-			a_Client->SendDestroyEntity(m_Entity);
+			a_Client->UntrackEntity(m_Entity);
 		}
 
 		virtual void Added(cClientHandle * a_Client) override
 		{
-			m_Entity.SpawnOn(*a_Client);
+			// Spawned by the entity tracker, if in range
+			UNUSED(a_Client);
 		}
 
 		cEntity & m_Entity;
@@ -1199,6 +1469,61 @@ int cChunk::GetHeight(int a_X, int a_Z) const
 
 
 
+const cChunk::sMapColumn & cChunk::GetMapColumn(int a_RelX, int a_RelZ)
+{
+	ASSERT((a_RelX >= 0) && (a_RelX < cChunkDef::Width) && (a_RelZ >= 0) && (a_RelZ < cChunkDef::Width));
+	auto & Column = m_MapColumns[static_cast<size_t>(a_RelX + a_RelZ * cChunkDef::Width)];
+	if (Column.m_IsValid)
+	{
+		return Column;
+	}
+
+	// Look down from the top of the column for the first coloured block; water is seen through down to its bottom:
+	int Height = GetHeight(a_RelX, a_RelZ);
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	GetBlockTypeMeta(a_RelX, Height, a_RelZ, BlockType, BlockMeta);
+	auto ColourID = cBlockHandler::For(BlockType).GetMapBaseColourID(BlockMeta);
+	bool IsWater = IsBlockWater(BlockType);
+	if (IsWater)
+	{
+		while (((--Height) != -1) && IsBlockWater(GetBlock(a_RelX, Height, a_RelZ)))
+		{
+			continue;
+		}
+	}
+	else if (ColourID == 0)
+	{
+		while (((--Height) != -1) && ((ColourID = cBlockHandler::For(GetBlock(a_RelX, Height, a_RelZ)).GetMapBaseColourID(GetMeta(a_RelX, Height, a_RelZ))) == 0))
+		{
+			continue;
+		}
+	}
+
+	Column.m_ColourID = ColourID;
+	Column.m_Height = static_cast<Int16>(Height);
+	Column.m_IsWater = IsWater;
+	Column.m_IsValid = true;
+	return Column;
+}
+
+
+
+
+
+void cChunk::InvalidateAllMapColumns(void)
+{
+	for (auto & Column: m_MapColumns)
+	{
+		Column.m_IsValid = false;
+		Column.m_Height = -1;
+	}
+}
+
+
+
+
+
 bool cChunk::IsWeatherSunnyAt(int a_RelX, int a_RelZ) const
 {
 	return m_World->IsWeatherSunny() || IsBiomeNoDownfall(GetBiomeAt(a_RelX, a_RelZ));
@@ -1282,8 +1607,9 @@ void cChunk::SetBlock(Vector3i a_RelPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_Blo
 	// Queue a check of this block's neighbors:
 	m_BlocksToCheck.push(a_RelPos);
 
-	// Wake up the simulators for this block:
+	// Wake up the simulators and the resting entities for this block:
 	GetWorld()->GetSimulatorManager()->WakeUp(*this, a_RelPos);
+	WakeUpRestingEntities(a_RelPos);
 
 	// If there was a block entity, remove it:
 	if (const auto FindResult = m_BlockEntities.find(cChunkDef::MakeIndex(a_RelPos)); FindResult != m_BlockEntities.end())
@@ -1349,6 +1675,7 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 	}
 
 	m_BlockData.SetMeta({ a_RelX, a_RelY, a_RelZ }, a_BlockMeta);
+	InvalidateMapColumn({ a_RelX, a_RelY, a_RelZ });
 
 	// ONLY recalculate lighting if it's necessary!
 	if (
@@ -1567,7 +1894,7 @@ void cChunk::RemoveClient(cClientHandle * a_Client)
 				(*itr)->GetUniqueID(), a_Client->GetUsername().c_str()
 			);
 			*/
-			a_Client->SendDestroyEntity(*Entity);
+			a_Client->UntrackEntity(*Entity);
 		}
 	}
 }
@@ -1594,6 +1921,27 @@ bool cChunk::HasAnyClients(void) const
 
 
 
+void cChunk::AddPrefetchingClient(cClientHandle * a_Client)
+{
+	if (std::find(m_PrefetchingClients.begin(), m_PrefetchingClients.end(), a_Client) == m_PrefetchingClients.end())
+	{
+		m_PrefetchingClients.push_back(a_Client);
+	}
+}
+
+
+
+
+
+void cChunk::RemovePrefetchingClient(cClientHandle * a_Client)
+{
+	m_PrefetchingClients.erase(std::remove(m_PrefetchingClients.begin(), m_PrefetchingClients.end(), a_Client), m_PrefetchingClients.end());
+}
+
+
+
+
+
 void cChunk::AddEntity(OwnedEntity a_Entity)
 {
 	if (!a_Entity->IsPlayer())
@@ -1608,6 +1956,12 @@ void cChunk::AddEntity(OwnedEntity a_Entity)
 
 	ASSERT(EntityPtr->GetParentChunk() == nullptr);
 	EntityPtr->SetParentChunk(this);
+
+	// Players are added to the index when they enter the world, and moved between its buckets as they move between chunks:
+	if (EntityPtr->IsPlayer())
+	{
+		m_World->GetPlayerIndex().Update(static_cast<cPlayer &>(*EntityPtr), GetPos());
+	}
 }
 
 
@@ -54,6 +54,9 @@ public:
 	/** Flushes the pending block (entity) queue, and clients' outgoing data buffers. */
 	void BroadcastPendingChanges(void);
 
+	/** Spawns and despawns the entities in this chunk on its clients based on their distance, see cEntityTracker. */
+	void UpdateEntityTracking(void);
+
 	/** Returns true iff the chunk block data is valid (loaded / generated) */
 	bool IsValid(void) const {return (m_Presence == cpPresent); }
 
@@ -96,6 +99,11 @@ public:
 	/** Queues the chunk for generating. */
 	void MarkLoadFailed(void);
 
+	/** Called by the generator when a cancellable generation request gets its turn.
+	If the chunk is still queued and no client, player or ChunkStay needs it, marks the chunk as not present (so that it
+	can be unloaded, or queued again when needed) and returns true. Returns false if the chunk should be generated. */
+	bool TryCancelGeneration(void);
+
 	/** Gets all chunk data, calls the a_Callback's methods for each data type */
 	void GetAllData(cChunkDataCallback & a_Callback) const;
 
@@ -125,6 +133,16 @@ public:
 
 	void Tick(std::chrono::milliseconds a_Dt);
 
+	/** Queues a check of the resting entities around the specified block for the next Tick(), the ones touching it are woken up.
+	Also queues the check in the neighbors, if the block is on the border of the chunk. */
+	void WakeUpRestingEntities(Vector3i a_RelPos);
+
+	/** Returns the number of (non-mob) entities that were fully ticked in the last Tick(). */
+	size_t GetNumTickedEntities(void) const { return m_NumTickedEntities; }
+
+	/** Returns the number of entities that were at rest after the last Tick(). */
+	size_t GetNumRestingEntities(void) const { return m_NumRestingEntities; }
+
 	/** Ticks a single block. Used by cWorld::TickQueuedBlocks() to tick the queued blocks */
 	void TickBlock(const Vector3i a_RelPos);
 
@@ -146,6 +164,9 @@ public:
 	BLOCKTYPE GetBlock(int a_RelX, int a_RelY, int a_RelZ) const { return m_BlockData.GetBlock({ a_RelX, a_RelY, a_RelZ }); }
 	BLOCKTYPE GetBlock(Vector3i a_RelCoords) const { return m_BlockData.GetBlock(a_RelCoords); }
 
+	/** Returns the chunk's block storage, for reading whole sections at once. */
+	const ChunkBlockData & GetBlockData(void) const { return m_BlockData; }
+
 	void GetBlockTypeMeta(Vector3i a_RelPos, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const;
 	void GetBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
 	{
@@ -200,6 +221,26 @@ public:
 
 	int GetHeight( int a_X, int a_Z) const;
 
+	/** Describes what a map sees when looking down at a single column. */
+	struct sMapColumn
+	{
+		/** Base map colour ID of the topmost coloured block. */
+		ColourID m_ColourID;
+
+		/** The height to use for shading the colour; -1 if the column has no coloured block. */
+		Int16 m_Height;
+
+		/** True if the column is seen through water (m_Height is then the bottom of the water). */
+		bool m_IsWater;
+
+		/** False if the column has changed since it was last calculated. */
+		bool m_IsValid;
+	};
+
+	/** Returns the map colour information of the specified column.
+	The result is cached and only recalculated when a block at or above the returned height changes. */
+	const sMapColumn & GetMapColumn(int a_RelX, int a_RelZ);
+
 	/** Returns true if it is sunny at the specified location. This takes into account biomes. */
 	bool IsWeatherSunnyAt(int a_RelX, int a_RelZ) const;
 
@@ -224,6 +265,16 @@ public:
 	/** Returns true if theres any client in the chunk; false otherwise */
 	bool HasAnyClients(void) const;
 
+	/** Marks the chunk as needed by the client ahead of its player's predicted path, so that it is loaded and not unloaded.
+	Ignored if the client already prefetches the chunk. */
+	void AddPrefetchingClient(cClientHandle * a_Client);
+
+	/** Removes the client's prefetch of the chunk; ignored if the client doesn't prefetch the chunk. */
+	void RemovePrefetchingClient(cClientHandle * a_Client);
+
+	/** Returns true if any client prefetches the chunk. */
+	bool IsPrefetched(void) const { return !m_PrefetchingClients.empty(); }
+
 	void AddEntity(OwnedEntity a_Entity);
 
 	/** Releases ownership of the given entity if it was found in this chunk.
@@ -291,6 +342,7 @@ public:
 	inline void SetMeta(Vector3i a_RelPos, NIBBLETYPE a_Meta)
 	{
 		m_BlockData.SetMeta(a_RelPos, a_Meta);
+		InvalidateMapColumn(a_RelPos);
 		MarkDirty();
 		m_PendingSendBlocks.emplace_back(m_PosX, m_PosZ, a_RelPos.x, a_RelPos.y, a_RelPos.z, GetBlock(a_RelPos), a_Meta);
 	}
@@ -497,6 +549,9 @@ private:
 
 	// A critical section is not needed, because all chunk access is protected by its parent ChunkMap's csLayers
 	std::vector<cClientHandle *> m_LoadedByClient;
+
+	/** The clients that need the chunk soon, because it lies on the predicted path of their player. */
+	std::vector<cClientHandle *> m_PrefetchingClients;
 	std::vector<OwnedEntity> m_Entities;
 	cBlockEntities m_BlockEntities;
 
@@ -513,6 +568,9 @@ private:
 	cChunkDef::HeightMap m_HeightMap;
 	cChunkDef::BiomeMap  m_BiomeMap;
 
+	/** Cached map colours of the columns, see GetMapColumn(). Indexed by [x + z * Width]. */
+	std::array<sMapColumn, cChunkDef::Width * cChunkDef::Width> m_MapColumns;
+
 	/** Relative coords of the block to tick first in the next Tick() call.
 	Plugins can use this to force a tick in a specific block, using cWorld:SetNextBlockToTick() API. */
 	Vector3i m_BlockToTick;
@@ -534,6 +592,18 @@ private:
 	This is the support for plugin-accessible chunk tick forcing. */
 	unsigned m_AlwaysTicked;
 
+	/** Number of (non-mob) entities fully ticked in the last Tick(). */
+	size_t m_NumTickedEntities;
+
+	/** Number of entities at rest after the last Tick(). */
+	size_t m_NumRestingEntities;
+
+	/** Absolute coords of the blocks changed since the last Tick(), the resting entities touching them are woken up on the next Tick(). */
+	std::vector<Vector3i> m_RestingWakeUpBlocks;
+
+	/** Set when too many blocks changed for checking them one by one; all the resting entities are woken up on the next Tick(). */
+	bool m_ShouldWakeUpAllResting;
+
 	// Pick up a random block of this chunk
 	void GetRandomBlockCoords(int & a_X, int & a_Y, int & a_Z);
 	void GetThreeRandomNumbers(int & a_X, int & a_Y, int & a_Z, int a_MaxX, int a_MaxY, int a_MaxZ);
@@ -547,6 +617,31 @@ private:
 	/** Checks the block scheduled for checking in m_ToTickBlocks[] */
 	void CheckBlocks();
 
+	/** Adds the block to m_RestingWakeUpBlocks, if any of the entities is currently at rest. */
+	void QueueRestingWakeUp(Vector3i a_AbsPos);
+
+	/** Removes all but the last of repeated changes to the same block from m_PendingSendBlocks,
+	and repeated block entities from m_PendingSendBlockEntities. */
+	void DeduplicatePendingChanges(void);
+
+	/** Returns true if resending the whole chunk is estimated to take fewer bytes on the wire than sending the pending block changes.
+	The estimate is made per section: each changed section contributes its block change records,
+	each present section contributes its serialized size. Expects the pending changes to be deduplicated. */
+	bool ShouldResendInsteadOfChanges(void) const;
+
+	/** Marks the cached map colour of the column as invalid, if the change at the specified block may affect it. */
+	void InvalidateMapColumn(Vector3i a_RelPos)
+	{
+		auto & Column = m_MapColumns[static_cast<size_t>(a_RelPos.x + a_RelPos.z * cChunkDef::Width)];
+		if (a_RelPos.y >= Column.m_Height)
+		{
+			Column.m_IsValid = false;
+		}
+	}
+
+	/** Marks all the cached map colours as invalid. */
+	void InvalidateAllMapColumns(void);
+
 	/** Ticks several random blocks in the chunk. */
 	void TickBlocks(void);
 
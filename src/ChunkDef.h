@@ -48,6 +48,9 @@ typedef unsigned char HEIGHTTYPE;
 
 // tolua_end
 
+/** A set of block types, indexed by the block type. Used for fast "is any of these types" checks. */
+using cBlockTypeSet = std::bitset<256>;
+
 
 
 
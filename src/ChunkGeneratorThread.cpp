@@ -10,15 +10,14 @@
 /** If the generation queue size exceeds this number, a warning will be output */
 const size_t QUEUE_WARNING_LIMIT = 1000;
 
-/** If the generation queue size exceeds this number, chunks with no clients will be skipped */
-const size_t QUEUE_SKIP_LIMIT = 500;
-
 
 
 
 
 cChunkGeneratorThread::cChunkGeneratorThread(void) :
 	Super("Chunk Generator"),
+	m_ShouldRerank(false),
+	m_NextSequence(0),
 	m_Generator(nullptr),
 	m_PluginInterface(nullptr),
 	m_ChunkSink(nullptr)
@@ -77,15 +76,41 @@ void cChunkGeneratorThread::QueueGenerateChunk(
 {
 	ASSERT(m_ChunkSink->IsChunkQueued(a_Coords));
 
+	// Only plain requests made on behalf of clients may be cancelled; ask before locking, the sink has its own locks:
+	bool IsCancellable = !a_ForceRegeneration && (a_Callback == nullptr) && m_ChunkSink->HasChunkAnyClients(a_Coords);
+
 	{
 		cCSLock Lock(m_CS);
 
+		// Merge with an existing request for the same chunk:
+		auto itr = m_Queue.find(a_Coords);
+		if (itr != m_Queue.end())
+		{
+			auto & Item = itr->second;
+			Item.m_ForceRegeneration = Item.m_ForceRegeneration || a_ForceRegeneration;
+			Item.m_IsCancellable = Item.m_IsCancellable && IsCancellable;
+			if (a_Callback != nullptr)
+			{
+				Item.m_Callbacks.push_back(a_Callback);
+			}
+			return;
+		}
+
 		// Add to queue, issue a warning if too many:
 		if (m_Queue.size() >= QUEUE_WARNING_LIMIT)
 		{
 			LOGWARN("WARNING: Adding chunk %s to generation queue; Queue is too big! (%zu)", a_Coords.ToString().c_str(), m_Queue.size());
 		}
-		m_Queue.emplace_back(a_Coords, a_ForceRegeneration, a_Callback);
+		auto & Item = m_Queue[a_Coords];
+		Item.m_ForceRegeneration = a_ForceRegeneration;
+		Item.m_IsCancellable = IsCancellable;
+		Item.m_Sequence = m_NextSequence++;
+		if (a_Callback != nullptr)
+		{
+			Item.m_Callbacks.push_back(a_Callback);
+		}
+		m_Heap.push_back({ GetPriority(a_Coords), Item.m_Sequence, a_Coords });
+		std::push_heap(m_Heap.begin(), m_Heap.end());
 	}
 
 	m_Event.Set();
@@ -95,6 +120,17 @@ void cChunkGeneratorThread::QueueGenerateChunk(
 
 
 
+void cChunkGeneratorThread::SetInterestPoints(std::vector<cChunkCoords> && a_Points)
+{
+	cCSLock Lock(m_CS);
+	m_InterestPoints = std::move(a_Points);
+	m_ShouldRerank = true;
+}
+
+
+
+
+
 void cChunkGeneratorThread::GenerateBiomes(cChunkCoords a_Coords, cChunkDef::BiomeMap & a_BiomeMap)
 {
 	if (m_Generator != nullptr)
@@ -184,13 +220,16 @@ void cChunkGeneratorThread::Execute(void)
 		if (m_Queue.empty())
 		{
 			// Sometimes the queue remains empty
-			// If so, we can't do any front() operations on it!
 			continue;
 		}
 
-		auto item = m_Queue.front();  // Get next chunk from the queue
-		bool SkipEnabled = (m_Queue.size() > QUEUE_SKIP_LIMIT);
-		m_Queue.erase(m_Queue.begin());  // Remove the item from the queue
+		if (m_ShouldRerank)
+		{
+			Rerank();
+		}
+		cChunkCoords Coords(0, 0);
+		QueueItem Item;
+		PopMostUrgent(Coords, Item);
 		Lock.Unlock();  // Unlock ASAP
 		m_evtRemoved.Set();
 
@@ -205,32 +244,28 @@ void cChunkGeneratorThread::Execute(void)
 		}
 
 		// Skip the chunk if it's already generated and regeneration is not forced. Report as success:
-		if (!item.m_ForceRegeneration && m_ChunkSink->IsChunkValid(item.m_Coords))
+		if (!Item.m_ForceRegeneration && m_ChunkSink->IsChunkValid(Coords))
 		{
-			LOGD("Chunk %s already generated, skipping generation", item.m_Coords.ToString().c_str());
-			if (item.m_Callback != nullptr)
+			LOGD("Chunk %s already generated, skipping generation", Coords.ToString().c_str());
+			for (auto Callback: Item.m_Callbacks)
 			{
-				item.m_Callback->Call(item.m_Coords, true);
+				Callback->Call(Coords, true);
 			}
 			continue;
 		}
 
-		// Skip the chunk if the generator is overloaded:
-		if (SkipEnabled && !m_ChunkSink->HasChunkAnyClients(item.m_Coords))
+		// Drop the request if nobody needs the chunk anymore (the player has moved away):
+		if (Item.m_IsCancellable && m_ChunkSink->CancelChunkIfUnneeded(Coords))
 		{
-			LOGWARNING("Chunk generator overloaded, skipping chunk %s", item.m_Coords.ToString().c_str());
-			if (item.m_Callback != nullptr)
-			{
-				item.m_Callback->Call(item.m_Coords, false);
-			}
+			LOGD("Chunk %s no longer needed, cancelling generation", Coords.ToString().c_str());
 			continue;
 		}
 
 		// Generate the chunk:
-		DoGenerate(item.m_Coords);
-		if (item.m_Callback != nullptr)
+		DoGenerate(Coords);
+		for (auto Callback: Item.m_Callbacks)
 		{
-			item.m_Callback->Call(item.m_Coords, true);
+			Callback->Call(Coords, true);
 		}
 		NumChunksGenerated++;
 	}  // while (!bStop)
@@ -257,3 +292,69 @@ void cChunkGeneratorThread::DoGenerate(cChunkCoords a_Coords)
 
 	m_ChunkSink->OnChunkGenerated(ChunkDesc);
 }
+
+
+
+
+
+int cChunkGeneratorThread::GetPriority(cChunkCoords a_Coords) const
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+
+	// Chebyshev distance to the nearest interest point, matching the square view distance of the clients:
+	int Priority = NO_INTEREST_PRIORITY;
+	for (const auto & Point: m_InterestPoints)
+	{
+		auto Distance = std::max(std::abs(a_Coords.m_ChunkX - Point.m_ChunkX), std::abs(a_Coords.m_ChunkZ - Point.m_ChunkZ));
+		Priority = std::min(Priority, Distance);
+	}
+	return Priority;
+}
+
+
+
+
+
+void cChunkGeneratorThread::Rerank(void)
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+
+	m_Heap.clear();
+	m_Heap.reserve(m_Queue.size());
+	for (const auto & Request: m_Queue)
+	{
+		m_Heap.push_back({ GetPriority(Request.first), Request.second.m_Sequence, Request.first });
+	}
+	std::make_heap(m_Heap.begin(), m_Heap.end());
+	m_ShouldRerank = false;
+}
+
+
+
+
+
+void cChunkGeneratorThread::PopMostUrgent(cChunkCoords & a_Coords, QueueItem & a_Item)
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+	ASSERT(!m_Queue.empty());
+
+	for (;;)
+	{
+		// Every queued item has a heap entry, so the heap cannot run out before an item is found:
+		ASSERT(!m_Heap.empty());
+		std::pop_heap(m_Heap.begin(), m_Heap.end());
+		auto Entry = m_Heap.back();
+		m_Heap.pop_back();
+
+		auto itr = m_Queue.find(Entry.m_Coords);
+		if ((itr == m_Queue.end()) || (itr->second.m_Sequence != Entry.m_Sequence))
+		{
+			// Stale entry, the item has already been processed:
+			continue;
+		}
+		a_Coords = Entry.m_Coords;
+		a_Item = std::move(itr->second);
+		m_Queue.erase(itr);
+		return;
+	}
+}
@@ -20,7 +20,9 @@ The requests are not added to the queue if there is already a request with the s
 Before generating, the thread checks if the chunk hasn't been already generated.
 It is theoretically possible to have multiple generator threads by having multiple instances of this object,
 but then it MAY happen that the chunk is generated twice.
-If the generator queue is overloaded, the generator skips chunks with no clients in them. */
+The queue is ordered by the distance to the nearest interest point (player), see SetInterestPoints().
+Requests that were made on behalf of clients are cancelled if no client or ChunkStay needs the chunk anymore
+by the time the request gets its turn. */
 class cChunkGeneratorThread :
 	public cIsThread
 {
@@ -63,10 +65,15 @@ public:
 		If this callback returns true, the chunk is not generated. */
 		virtual bool IsChunkValid(cChunkCoords a_Coords) = 0;
 
-		/** Called when the generator is overloaded to skip chunks that are no longer needed.
-		If this callback returns false, the chunk is not generated. */
+		/** Called when queueing the chunk, to decide whether the request may be cancelled later on.
+		Only requests for chunks that have clients at the time of queueing are cancellable. */
 		virtual bool HasChunkAnyClients(cChunkCoords a_Coords) = 0;
 
+		/** Called just before generating a chunk with a cancellable request.
+		If no client or ChunkStay needs the chunk anymore, the implementation should atomically mark the chunk
+		as no longer queued and return true; the chunk is then not generated. */
+		virtual bool CancelChunkIfUnneeded(cChunkCoords a_Coords) = 0;
+
 		/** Called to check whether the specified chunk is in the queued state.
 		Currently used only in Debug-mode asserts. */
 		virtual bool IsChunkQueued(cChunkCoords a_Coords) = 0;
@@ -85,9 +92,13 @@ public:
 	If a-ForceGenerate is set, the chunk is regenerated even if the data is already present in the chunksink.
 	a_Callback is called after the chunk is generated. If the chunk was already present, the callback is still called, even if not regenerating.
 	It is legal to set the callback to nullptr, no callback is called then.
-	If the generator becomes overloaded and skips this chunk, the callback is still called. */
+	If the chunk is already queued, the requests are merged. Requests with a callback are never cancelled. */
 	void QueueGenerateChunk(cChunkCoords a_Coords, bool a_ForceRegeneration, cChunkCoordCallback * a_Callback = nullptr);
 
+	/** Sets the chunk coords around which the generation is prioritised, typically the chunks where players are.
+	The queue is re-ranked lazily before the next chunk is picked. */
+	void SetInterestPoints(std::vector<cChunkCoords> && a_Points);
+
 	/** Generates the biomes for the specified chunk (directly, not in a separate thread). Used by the world loader if biomes failed loading. */
 	void GenerateBiomes(cChunkCoords a_Coords, cChunkDef::BiomeMap & a_BiomeMap);
 
@@ -103,33 +114,64 @@ public:
 
 private:
 
+	/** Priority used for chunks when there are no interest points. Such chunks are processed in FIFO order. */
+	static const int NO_INTEREST_PRIORITY = std::numeric_limits<int>::max();
+
 	struct QueueItem
 	{
-		/** The chunk coords */
-		cChunkCoords m_Coords;
-
 		/** Force the regeneration of an already existing chunk */
 		bool m_ForceRegeneration;
 
-		/** Callback to call after generating. */
-		cChunkCoordCallback * m_Callback;
+		/** If true, the request is dropped if the chunk is no longer needed by the time it gets its turn. */
+		bool m_IsCancellable;
+
+		/** Sequence number of the request, used for FIFO ordering within the same priority and to detect stale heap entries. */
+		UInt64 m_Sequence;
+
+		/** Callbacks to call after generating. */
+		std::vector<cChunkCoordCallback *> m_Callbacks;
+	};
+
+	/** An entry in the priority heap. Entries are not removed when their item leaves the queue, they are skipped when popped instead. */
+	struct sHeapEntry
+	{
+		/** Distance (in chunks) to the nearest interest point when the entry was ranked. Lower is more urgent. */
+		int m_Priority;
+
+		/** Sequence number of the item this entry has been created for. */
+		UInt64 m_Sequence;
 
-		QueueItem(cChunkCoords a_Coords, bool a_ForceRegeneration, cChunkCoordCallback * a_Callback):
-			m_Coords(a_Coords),
-			m_ForceRegeneration(a_ForceRegeneration),
-			m_Callback(a_Callback)
+		cChunkCoords m_Coords;
+
+		/** Ordering for std::push_heap et al.: the heap top is the entry with the lowest priority value, then the oldest one. */
+		bool operator < (const sHeapEntry & a_Other) const
 		{
+			if (m_Priority != a_Other.m_Priority)
+			{
+				return (m_Priority > a_Other.m_Priority);
+			}
+			return (m_Sequence > a_Other.m_Sequence);
 		}
 	};
 
-	using Queue = std::list<QueueItem>;
-
 
 	/** CS protecting access to the queue. */
 	mutable cCriticalSection m_CS;
 
-	/** Queue of the chunks to be generated. Protected against multithreaded access by m_CS. */
-	Queue m_Queue;
+	/** The chunks to be generated, mapped to their requests. Protected against multithreaded access by m_CS. */
+	std::unordered_map<cChunkCoords, QueueItem, cChunkCoordsHash> m_Queue;
+
+	/** Heap of the queued chunks, ordered by their priority. Protected by m_CS. */
+	std::vector<sHeapEntry> m_Heap;
+
+	/** The chunks around which the generation is prioritised. Protected by m_CS. */
+	std::vector<cChunkCoords> m_InterestPoints;
+
+	/** Set when the interest points change, the heap is then rebuilt before the next chunk is picked. Protected by m_CS. */
+	bool m_ShouldRerank;
+
+	/** Sequence number to assign to the next request. Protected by m_CS. */
+	UInt64 m_NextSequence;
 
 	/** Set when an item is added to the queue or the thread should terminate. */
 	cEvent m_Event;
@@ -152,6 +194,15 @@ private:
 
 	/** Generates the specified chunk and sets it into the chunksink. */
 	void DoGenerate(cChunkCoords a_Coords);
+
+	/** Returns the priority of the specified chunk, based on the current interest points. Expects m_CS to be locked. */
+	int GetPriority(cChunkCoords a_Coords) const;
+
+	/** Recalculates the priorities of all queued chunks and rebuilds the heap. Expects m_CS to be locked. */
+	void Rerank(void);
+
+	/** Removes the most urgent chunk from the queue into a_Coords and a_Item. Expects m_CS to be locked and the queue not empty. */
+	void PopMostUrgent(cChunkCoords & a_Coords, QueueItem & a_Item);
 };
 
 
@@ -160,7 +160,9 @@ void cChunkMap::WakeUpSimulators(Vector3i a_Block)
 		return;
 	}
 
-	m_World->GetSimulatorManager()->WakeUp(*Chunk, cChunkDef::AbsoluteToRelative(a_Block, Position));
+	const auto RelPos = cChunkDef::AbsoluteToRelative(a_Block, Position);
+	m_World->GetSimulatorManager()->WakeUp(*Chunk, RelPos);
+	Chunk->WakeUpRestingEntities(RelPos);
 }
 
 
@@ -898,6 +900,7 @@ void cChunkMap::RemoveClientFromChunks(cClientHandle * a_Client)
 	for (auto & Chunk : m_Chunks)
 	{
 		Chunk.second.RemoveClient(a_Client);
+		Chunk.second.RemovePrefetchingClient(a_Client);
 	}
 }
 
@@ -905,6 +908,41 @@ void cChunkMap::RemoveClientFromChunks(cClientHandle * a_Client)
 
 
 
+void cChunkMap::PrefetchChunk(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
+{
+	cCSLock Lock(m_CSChunks);
+	GetChunk(a_ChunkX, a_ChunkZ).AddPrefetchingClient(a_Client);
+}
+
+
+
+
+
+void cChunkMap::CancelChunkPrefetch(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
+{
+	cCSLock Lock(m_CSChunks);
+	const auto Chunk = FindChunk(a_ChunkX, a_ChunkZ);
+	if (Chunk != nullptr)
+	{
+		Chunk->RemovePrefetchingClient(a_Client);
+	}
+}
+
+
+
+
+
+bool cChunkMap::IsChunkPrefetched(int a_ChunkX, int a_ChunkZ) const
+{
+	cCSLock Lock(m_CSChunks);
+	const auto Chunk = FindChunk(a_ChunkX, a_ChunkZ);
+	return (Chunk != nullptr) && Chunk->IsPrefetched();
+}
+
+
+
+
+
 void cChunkMap::AddEntity(OwnedEntity a_Entity)
 {
 	cCSLock Lock(m_CSChunks);
@@ -1138,6 +1176,17 @@ void cChunkMap::ChunkLoadFailed(int a_ChunkX, int a_ChunkZ)
 
 
 
+bool cChunkMap::CancelChunkGenerationIfUnneeded(int a_ChunkX, int a_ChunkZ)
+{
+	cCSLock Lock(m_CSChunks);
+	const auto Chunk = FindChunk(a_ChunkX, a_ChunkZ);
+	return (Chunk != nullptr) && Chunk->TryCancelGeneration();
+}
+
+
+
+
+
 void cChunkMap::MarkChunkRegenerating(int a_ChunkX, int a_ChunkZ)
 {
 	cCSLock Lock(m_CSChunks);
@@ -1251,6 +1300,38 @@ bool cChunkMap::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBl
 
 
 
+bool cChunkMap::WriteBlockAreaIfLoaded(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes)
+{
+	const auto MinChunk = cChunkDef::BlockToChunk({a_MinBlockX, a_MinBlockY, a_MinBlockZ});
+	const auto MaxChunk = cChunkDef::BlockToChunk({a_MinBlockX + a_Area.GetSizeX() - 1, a_MinBlockY, a_MinBlockZ + a_Area.GetSizeZ() - 1});
+
+	// Check all the chunks and write under the same lock, so that none of them can unload in between:
+	cCSLock Lock(m_CSChunks);
+	for (int z = MinChunk.m_ChunkZ; z <= MaxChunk.m_ChunkZ; z++)
+	{
+		for (int x = MinChunk.m_ChunkX; x <= MaxChunk.m_ChunkX; x++)
+		{
+			const auto Chunk = FindChunk(x, z);
+			if ((Chunk == nullptr) || !Chunk->IsValid())
+			{
+				return false;
+			}
+		}
+	}
+	for (int z = MinChunk.m_ChunkZ; z <= MaxChunk.m_ChunkZ; z++)
+	{
+		for (int x = MinChunk.m_ChunkX; x <= MaxChunk.m_ChunkX; x++)
+		{
+			FindChunk(x, z)->WriteBlockArea(a_Area, a_MinBlockX, a_MinBlockY, a_MinBlockZ, a_DataTypes);
+		}
+	}
+	return true;
+}
+
+
+
+
+
 void cChunkMap::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const
 {
 	a_NumChunksValid = 0;
@@ -1270,6 +1351,22 @@ void cChunkMap::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) co
 
 
 
+void cChunkMap::GetEntityStats(size_t & a_NumTicked, size_t & a_NumResting) const
+{
+	a_NumTicked = 0;
+	a_NumResting = 0;
+	cCSLock Lock(m_CSChunks);
+	for (const auto & Chunk : m_Chunks)
+	{
+		a_NumTicked += Chunk.second.GetNumTickedEntities();
+		a_NumResting += Chunk.second.GetNumRestingEntities();
+	}
+}
+
+
+
+
+
 int cChunkMap::GrowPlantAt(Vector3i a_BlockPos, int a_NumStages)
 {
 	auto chunkPos = cChunkDef::BlockToChunk(a_BlockPos);
@@ -1361,6 +1458,19 @@ void cChunkMap::Tick(std::chrono::milliseconds a_Dt)
 
 
 
+void cChunkMap::UpdateEntityTracking(void)
+{
+	cCSLock Lock(m_CSChunks);
+	for (auto & Chunk : m_Chunks)
+	{
+		Chunk.second.UpdateEntityTracking();
+	}
+}
+
+
+
+
+
 void cChunkMap::TickBlock(const Vector3i a_BlockPos)
 {
 	auto ChunkPos = cChunkDef::BlockToChunk(a_BlockPos);
@@ -1394,6 +1504,9 @@ void cChunkMap::UnloadUnusedChunks(void)
 			// Notify entities within the chunk, while everything's still valid:
 			itr->second.OnUnload();
 
+			// The chunk is clean, so its cached data (if any) is current; keep it the longest in the cache:
+			m_World->GetStorage().GetChunkCache().Touch(itr->first);
+
 			// Kill the chunk:
 			itr = m_Chunks.erase(itr);
 		}
@@ -1424,6 +1537,22 @@ void cChunkMap::SaveAllChunks(void) const
 
 
 
+void cChunkMap::SaveUnusedDirtyChunks(void) const
+{
+	cCSLock Lock(m_CSChunks);
+	for (const auto & Chunk : m_Chunks)
+	{
+		if (Chunk.second.IsValid() && Chunk.second.CanUnloadAfterSaving())
+		{
+			GetWorld()->GetStorage().QueueSaveChunk(Chunk.first.m_ChunkX, Chunk.first.m_ChunkZ);
+		}
+	}
+}
+
+
+
+
+
 size_t cChunkMap::GetNumChunks(void) const
 {
 	cCSLock Lock(m_CSChunks);
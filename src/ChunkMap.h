@@ -169,6 +169,16 @@ public:
 	/** Removes the client from all chunks it is present in */
 	void RemoveClientFromChunks(cClientHandle * a_Client);
 
+	/** Queues the chunk for loading / generating, if it isn't valid yet, and keeps it loaded until the client cancels the prefetch.
+	Used for the chunks on the predicted path of the client's player, so that they are ready by the time the player gets there. */
+	void PrefetchChunk(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client);
+
+	/** Cancels the client's prefetch of the chunk. If nothing else needs the chunk, its queued generation is cancelled and it may be unloaded. */
+	void CancelChunkPrefetch(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client);
+
+	/** Returns true if any client prefetches the chunk. */
+	bool IsChunkPrefetched(int a_ChunkX, int a_ChunkZ) const;
+
 	/** Adds the entity to its appropriate chunk, takes ownership of the entity pointer */
 	void AddEntity(OwnedEntity a_Entity);
 
@@ -218,6 +228,10 @@ public:
 	/** Marks the chunk as failed-to-load */
 	void ChunkLoadFailed(int a_ChunkX, int a_ChunkZ);
 
+	/** Cancels the chunk's pending generation if nothing needs the chunk anymore, see cChunk::TryCancelGeneration().
+	Returns true if cancelled. */
+	bool CancelChunkGenerationIfUnneeded(int a_ChunkX, int a_ChunkZ);
+
 	/** Marks the chunk as being regenerated - all its clients want that chunk again (used by cWorld::RegenerateChunk()) */
 	void MarkChunkRegenerating(int a_ChunkX, int a_ChunkZ);
 
@@ -232,9 +246,16 @@ public:
 	/** Writes the block area into the specified coords. Returns true if all chunks have been processed. Prefer cBlockArea::Write() instead. */
 	bool WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes);
 
+	/** Writes the block area into the specified coords, but only if all the chunks it covers are valid.
+	Returns false, without writing anything, if any of them isn't. */
+	bool WriteBlockAreaIfLoaded(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes);
+
 	/** Returns the number of valid chunks and the number of dirty chunks */
 	void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const;
 
+	/** Returns the number of (non-mob) entities the chunks fully ticked in their last tick, and the number of entities at rest. */
+	void GetEntityStats(size_t & a_NumTicked, size_t & a_NumResting) const;
+
 	/** Grows the plant at the specified position by at most a_NumStages.
 	The block's Grow handler is invoked.
 	Returns the number of stages the plant has grown, 0 if not a plant. */
@@ -253,12 +274,19 @@ public:
 
 	void Tick(std::chrono::milliseconds a_Dt);
 
+	/** Spawns and despawns entities on clients based on their distance, see cEntityTracker.
+	Called after all entities have been ticked. */
+	void UpdateEntityTracking(void);
+
 	/** Ticks a single block. Used by cWorld::TickQueuedBlocks() to tick the queued blocks */
 	void TickBlock(const Vector3i a_BlockPos);
 
 	void UnloadUnusedChunks(void);
 	void SaveAllChunks(void) const;
 
+	/** Queues saving only the dirty chunks that could be unloaded once saved (no clients, players or ChunkStays). */
+	void SaveUnusedDirtyChunks(void) const;
+
 	cWorld * GetWorld(void) const { return m_World; }
 
 	size_t GetNumChunks(void) const;
@@ -251,7 +251,7 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, const WeakClients & a_C
 		// Send entity packets:
 		for (const auto EntityID : m_EntityIDs)
 		{
-			m_World.DoWithEntityByID(EntityID, [Client](cEntity & a_Entity)
+			m_World.DoWithEntityByID(EntityID, [this, Client](cEntity & a_Entity)
 			{
 				/*
 				// DEBUG:
@@ -269,7 +269,13 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, const WeakClients & a_C
 				A better way involves fixing chunk sending (GH #3696) to obviate calling SpawnOn from this thread in the first place. */
 				if (!Client->IsDestroyed())
 				{
-					a_Entity.SpawnOn(*Client);
+					// The client has dropped the entity together with the old chunk data, if any.
+					// Spawn it only if in range, otherwise the entity tracker will spawn it once it comes in range:
+					Client->ForgetEntity(a_Entity);
+					if (m_World.GetEntityTracker().IsInRange(a_Entity, *Client))
+					{
+						Client->TrackEntity(a_Entity);
+					}
 				}
 
 				return true;
@@ -52,6 +52,33 @@
 /** Maximum number of chunks to stream per tick. */
 #define MAX_CHUNKS_STREAMED_PER_TICK 4
 
+/** Maximum number of incoming packets to handle per tick, the rest waits for the next tick. */
+#define MAX_INCOMING_PACKETS_PER_TICK 100
+
+/** Number of waiting incoming packets at which the reading from the client's link is paused. */
+#define INCOMING_PACKETS_PAUSE_READING 300
+
+/** Number of waiting incoming packets at which the paused reading from the client's link is resumed. */
+#define INCOMING_PACKETS_RESUME_READING 100
+
+/** Maximum number of waiting incoming packets, a client sending more than this is kicked. */
+#define MAX_INCOMING_PACKETS 3000
+
+/** The interval at which the player's path is predicted and the chunks on it prefetched. */
+#define PREFETCH_INTERVAL std::chrono::milliseconds(500)
+
+/** Minimum horizontal speed, in blocks per second, at which chunks are prefetched; faster than sprinting. */
+#define PREFETCH_MIN_SPEED 10.0
+
+/** Maximum horizontal speed, in blocks per second, at which chunks are prefetched; anything faster is a teleport. */
+#define PREFETCH_MAX_SPEED 100.0
+
+/** How far ahead the player's path is predicted, in seconds. */
+#define PREFETCH_SECONDS 3.0
+
+/** Maximum number of chunks prefetched for a single player. */
+#define PREFETCH_MAX_CHUNKS 256
+
 
 
 
@@ -70,6 +97,8 @@ cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_CurrentViewDistance(a_ViewDistance),
 	m_RequestedViewDistance(a_ViewDistance),
 	m_IPString(a_IPString),
+	m_ShouldSplitIncomingData(false),
+	m_IsReadingPaused(false),
 	m_Player(nullptr),
 	m_CachedSentChunk(std::numeric_limits<decltype(m_CachedSentChunk.m_ChunkX)>::max(), std::numeric_limits<decltype(m_CachedSentChunk.m_ChunkZ)>::max()),
 	m_HasSentDC(false),
@@ -77,6 +106,7 @@ cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_LastStreamedChunkZ(std::numeric_limits<decltype(m_LastStreamedChunkZ)>::max()),
 	m_TicksSinceLastPacket(0),
 	m_TimeSinceLastUnloadCheck(0),
+	m_TimeSinceLastPrefetch(0),
 	m_Ping(1000),
 	m_PingID(1),
 	m_BlockDigAnimStage(-1),
@@ -93,6 +123,7 @@ cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_NumBlockChangeInteractionsThisTick(0),
 	m_UniqueID(0),
 	m_HasSentPlayerChunk(false),
+	m_IsWaitingForPlayerData(false),
 	m_Locale("en_GB"),
 	m_LastPlacedSign(0, -1, 0),
 	m_ProtocolVersion(0)
@@ -246,6 +277,13 @@ void cClientHandle::ProxyInit(const AString & a_IPString, const cUUID & a_UUID,
 
 void cClientHandle::ProcessProtocolIn(void)
 {
+	if (m_ShouldSplitIncomingData)
+	{
+		// The data has already been split into packets on the network thread, only handle them:
+		ProcessIncomingPackets();
+		return;
+	}
+
 	// Process received network data:
 	decltype(m_IncomingData) IncomingData;
 	{
@@ -268,6 +306,79 @@ void cClientHandle::ProcessProtocolIn(void)
 	{
 		Kick(Oops.what());
 	}
+
+	// Once the protocol allows it, move the decryption, decompression and splitting into packets to the network thread:
+	if (m_Protocol.CanSplitIncomingData())
+	{
+		cCSLock Lock(m_CSIncomingData);
+		m_ShouldSplitIncomingData = true;
+		SplitIncomingData();  // The data received since the swap above
+	}
+}
+
+
+
+
+
+void cClientHandle::ProcessIncomingPackets(void)
+{
+	cProtocol::cReceivedPackets Packets;
+	AString Error;
+	size_t NumWaiting;
+	{
+		cCSLock Lock(m_CSIncomingData);
+		std::swap(Error, m_IncomingDataError);
+		auto End = m_IncomingPackets.begin() + static_cast<ptrdiff_t>(std::min<size_t>(m_IncomingPackets.size(), MAX_INCOMING_PACKETS_PER_TICK));
+		Packets.insert(Packets.end(), std::make_move_iterator(m_IncomingPackets.begin()), std::make_move_iterator(End));
+		m_IncomingPackets.erase(m_IncomingPackets.begin(), End);
+		NumWaiting = m_IncomingPackets.size();
+	}
+
+	for (size_t i = 0, NumPackets = Packets.size(); i < NumPackets; i++)
+	{
+		auto & Packet = Packets[i];
+
+		// Skip the movement packets that are superseded by the next packet, a lagging client won't get replayed all of its moves:
+		if (
+			(i + 1 < NumPackets) &&
+			(Packets[i + 1].m_PacketType == Packet.m_PacketType) &&
+			m_Protocol->IsAbsoluteMovementPacket(Packet.m_PacketType)
+		)
+		{
+			continue;
+		}
+
+		try
+		{
+			m_Protocol->HandleReceivedPacket(Packet);
+		}
+		catch (const std::exception & Oops)
+		{
+			Kick(Oops.what());
+			return;
+		}
+	}
+
+	if (!Error.empty())
+	{
+		Kick(Error);
+		return;
+	}
+
+	// Throttle a client that sends more packets than we handle, by not reading its data until the queue shrinks:
+	if (auto Link = m_Link; Link != nullptr)
+	{
+		if (!m_IsReadingPaused && (NumWaiting >= INCOMING_PACKETS_PAUSE_READING))
+		{
+			Link->PauseReading();
+			m_IsReadingPaused = true;
+		}
+		else if (m_IsReadingPaused && (NumWaiting <= INCOMING_PACKETS_RESUME_READING))
+		{
+			Link->ResumeReading();
+			m_IsReadingPaused = false;
+		}
+	}
 }
 
 
@@ -397,6 +508,9 @@ void cClientHandle::Authenticate(AString && a_Name, const cUUID & a_UUID, Json::
 		m_Properties = std::move(a_Properties);
 	}
 
+	// Start reading the player's files in the background, the player object is created once they have been read:
+	cPlayer::PrefetchFromDisk(m_UUID);
+
 	// Send login success (if the protocol supports it):
 	m_Protocol->SendLoginSuccess();
 
@@ -404,10 +518,15 @@ void cClientHandle::Authenticate(AString && a_Name, const cUUID & a_UUID, Json::
 	{
 		m_ForgeHandshake.BeginForgeHandshake(*this);
 	}
-	else
+	else if (cPlayer::IsPrefetchedFromDisk(m_UUID))
 	{
 		FinishAuthenticate();
 	}
+	else
+	{
+		// ServerTick() will finish once the files have been read:
+		m_IsWaitingForPlayerData = true;
+	}
 }
 
 
@@ -673,6 +792,77 @@ void cClientHandle::UnloadOutOfRangeChunks(void)
 
 
 
+void cClientHandle::UpdatePrefetch(std::chrono::milliseconds a_Dt)
+{
+	using namespace std::chrono_literals;
+
+	if ((m_TimeSinceLastPrefetch += a_Dt) < PREFETCH_INTERVAL)
+	{
+		return;
+	}
+
+	// Estimate the horizontal velocity from the distance travelled since the last run:
+	const auto Position = m_Player->GetPosition();
+	auto Velocity = (Position - m_PrefetchLastPosition) / std::chrono::duration<double>(m_TimeSinceLastPrefetch).count();
+	Velocity.y = 0;
+	const auto Speed = Velocity.Length();
+	m_PrefetchLastPosition = Position;
+	m_TimeSinceLastPrefetch = 0s;
+
+	// The predicted corridor: the view squares around the positions along the predicted path, one chunk apart, without the current view square:
+	std::vector<cChunkCoords> Corridor;
+	std::unordered_set<cChunkCoords, cChunkCoordsHash> NewPrefetchedChunks;
+	if ((Speed >= PREFETCH_MIN_SPEED) && (Speed <= PREFETCH_MAX_SPEED))
+	{
+		const int ChunkPosX = FAST_FLOOR_DIV(FloorC(Position.x), cChunkDef::Width);
+		const int ChunkPosZ = FAST_FLOOR_DIV(FloorC(Position.z), cChunkDef::Width);
+		const auto Direction = Velocity / Speed;
+		for (double Distance = cChunkDef::Width; (Distance <= Speed * PREFETCH_SECONDS) && (Corridor.size() < PREFETCH_MAX_CHUNKS); Distance += cChunkDef::Width)
+		{
+			const auto Predicted = Position + Direction * Distance;
+			const int CenterX = FAST_FLOOR_DIV(FloorC(Predicted.x), cChunkDef::Width);
+			const int CenterZ = FAST_FLOOR_DIV(FloorC(Predicted.z), cChunkDef::Width);
+			for (int ChunkX = CenterX - m_CurrentViewDistance; (ChunkX <= CenterX + m_CurrentViewDistance) && (Corridor.size() < PREFETCH_MAX_CHUNKS); ChunkX++)
+			{
+				for (int ChunkZ = CenterZ - m_CurrentViewDistance; (ChunkZ <= CenterZ + m_CurrentViewDistance) && (Corridor.size() < PREFETCH_MAX_CHUNKS); ChunkZ++)
+				{
+					if ((Diff(ChunkX, ChunkPosX) <= m_CurrentViewDistance) && (Diff(ChunkZ, ChunkPosZ) <= m_CurrentViewDistance))
+					{
+						// Already streamed to the client
+						continue;
+					}
+					if (NewPrefetchedChunks.emplace(ChunkX, ChunkZ).second)
+					{
+						Corridor.emplace_back(ChunkX, ChunkZ);
+					}
+				}
+			}
+		}
+	}
+
+	// Cancel the chunks no longer predicted, so that their generation can be skipped, and prefetch the newly predicted ones, nearest first:
+	const auto World = m_Player->GetWorld();
+	for (const auto & Chunk: m_PrefetchedChunks)
+	{
+		if (NewPrefetchedChunks.find(Chunk) == NewPrefetchedChunks.end())
+		{
+			World->CancelChunkPrefetch(Chunk.m_ChunkX, Chunk.m_ChunkZ, this);
+		}
+	}
+	for (const auto & Chunk: Corridor)
+	{
+		if (m_PrefetchedChunks.find(Chunk) == m_PrefetchedChunks.end())
+		{
+			World->PrefetchChunk(Chunk.m_ChunkX, Chunk.m_ChunkZ, this);
+		}
+	}
+	m_PrefetchedChunks = std::move(NewPrefetchedChunks);
+}
+
+
+
+
+
 void cClientHandle::StreamChunk(int a_ChunkX, int a_ChunkZ, cChunkSender::Priority a_Priority)
 {
 	cWorld * World = m_Player->GetWorld();
@@ -2071,7 +2261,7 @@ void cClientHandle::SendData(const ContiguousByteBufferView a_Data)
 
 
 
-void cClientHandle::RemoveFromWorld(void)
+void cClientHandle::RemoveFromWorld(const Vector3d a_NewPosition)
 {
 	// Remove all associated chunks:
 	{
@@ -2081,6 +2271,12 @@ void cClientHandle::RemoveFromWorld(void)
 		m_SentChunks.clear();
 	}
 
+	// The client destroys all entities by itself:
+	{
+		cCSLock Lock(m_CSTrackedEntities);
+		m_TrackedEntities.clear();
+	}
+
 	// Flush outgoing data:
 	ProcessProtocolOut();
 
@@ -2090,6 +2286,12 @@ void cClientHandle::RemoveFromWorld(void)
 	m_LastStreamedChunkX = std::numeric_limits<decltype(m_LastStreamedChunkX)>::max();
 	m_LastStreamedChunkZ = std::numeric_limits<decltype(m_LastStreamedChunkZ)>::max();
 
+	// The old world has already dropped the prefetches (cWorld::RemoveClientFromChunks()), start predicting anew.
+	// Measure from the new position, the old one would make the warp look like a huge velocity:
+	m_PrefetchedChunks.clear();
+	m_PrefetchLastPosition = a_NewPosition;
+	m_TimeSinceLastPrefetch = std::chrono::milliseconds(0);
+
 	// Restart player unloaded chunk checking and freezing:
 	m_CachedSentChunk = cChunkCoords(std::numeric_limits<decltype(m_CachedSentChunk.m_ChunkX)>::max(), std::numeric_limits<decltype(m_CachedSentChunk.m_ChunkZ)>::max());
 }
@@ -2199,6 +2401,9 @@ void cClientHandle::Tick(std::chrono::milliseconds a_Dt)
 	// Send a couple of chunks to the player:
 	StreamNextChunks();
 
+	// Get the chunks ahead of a fast moving player ready:
+	UpdatePrefetch(a_Dt);
+
 	// Unload all chunks that are out of the view distance (every 5 seconds):
 	if ((m_TimeSinceLastUnloadCheck += a_Dt) > 5s)
 	{
@@ -2242,6 +2447,17 @@ void cClientHandle::ServerTick(float a_Dt)
 	ProcessProtocolIn();
 	ProcessProtocolOut();
 
+	// Finish the authentication once the player's files have been read:
+	if (m_IsWaitingForPlayerData && cPlayer::IsPrefetchedFromDisk(m_UUID))
+	{
+		cCSLock Lock(m_CSState);
+		m_IsWaitingForPlayerData = false;
+		if (m_State == csAuthenticating)
+		{
+			FinishAuthenticate();
+		}
+	}
+
 	m_TicksSinceLastPacket += 1;
 	if (m_TicksSinceLastPacket > 600)  // 30 seconds
 	{
@@ -2769,9 +2985,9 @@ void cClientHandle::SendInventorySlot(char a_WindowID, short a_SlotNum, const cI
 
 
 
-void cClientHandle::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cClientHandle::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY)
 {
-	m_Protocol->SendMapData(a_Map, a_DataStartX, a_DataStartY);
+	m_Protocol->SendMapData(a_Map, a_DataStartX, a_DataStartY, a_DataSizeX, a_DataSizeY);
 }
 
 
@@ -3371,6 +3587,55 @@ void cClientHandle::AddWantedChunk(int a_ChunkX, int a_ChunkZ)
 
 
 
+bool cClientHandle::IsTrackingEntity(const cEntity & a_Entity) const
+{
+	cCSLock Lock(m_CSTrackedEntities);
+	return (m_TrackedEntities.find(a_Entity.GetUniqueID()) != m_TrackedEntities.end());
+}
+
+
+
+
+
+void cClientHandle::TrackEntity(cEntity & a_Entity)
+{
+	{
+		cCSLock Lock(m_CSTrackedEntities);
+		m_TrackedEntities.insert(a_Entity.GetUniqueID());
+	}
+	a_Entity.SpawnOn(*this);
+}
+
+
+
+
+
+void cClientHandle::UntrackEntity(const cEntity & a_Entity)
+{
+	{
+		cCSLock Lock(m_CSTrackedEntities);
+		if (m_TrackedEntities.erase(a_Entity.GetUniqueID()) == 0)
+		{
+			return;
+		}
+	}
+	SendDestroyEntity(a_Entity);
+}
+
+
+
+
+
+void cClientHandle::ForgetEntity(const cEntity & a_Entity)
+{
+	cCSLock Lock(m_CSTrackedEntities);
+	m_TrackedEntities.erase(a_Entity.GetUniqueID());
+}
+
+
+
+
+
 void cClientHandle::PacketBufferFull(void)
 {
 	// Too much data in the incoming queue, the server is probably too busy, kick the client:
@@ -3405,6 +3670,42 @@ void cClientHandle::PacketError(UInt32 a_PacketType)
 
 
 
+void cClientHandle::SplitIncomingData(void)
+{
+	ASSERT(m_ShouldSplitIncomingData);
+
+	if (m_IncomingData.empty())
+	{
+		return;
+	}
+	if (!m_IncomingDataError.empty())
+	{
+		// The client is about to be kicked, ignore any further data:
+		m_IncomingData.clear();
+		return;
+	}
+
+	try
+	{
+		m_Protocol.SplitIncomingData(m_IncomingData, m_IncomingPackets);
+	}
+	catch (const std::exception & Oops)
+	{
+		m_IncomingDataError = Oops.what();
+	}
+	m_IncomingData.clear();
+
+	if (m_IncomingPackets.size() > MAX_INCOMING_PACKETS)
+	{
+		m_IncomingDataError = "Too many packets";
+		m_IncomingPackets.clear();
+	}
+}
+
+
+
+
+
 void cClientHandle::SocketClosed(void)
 {
 	// The socket has been closed for any reason
@@ -3461,6 +3762,12 @@ void cClientHandle::OnReceivedData(const char * a_Data, size_t a_Length)
 	// Queue the incoming data to be processed in the tick thread:
 	cCSLock Lock(m_CSIncomingData);
 	m_IncomingData.append(reinterpret_cast<const std::byte *>(a_Data), a_Length);
+
+	// Once the protocol allows it, split the data into packets right away, off the tick thread:
+	if (m_ShouldSplitIncomingData)
+	{
+		SplitIncomingData();
+	}
 }
 
 
@@ -134,6 +134,10 @@ public:  // tolua_export
 	/** Remove all loaded chunks that are no longer in range */
 	void UnloadOutOfRangeChunks(void);
 
+	/** Prefetches the chunks that the player will see within the next few seconds, if they keep moving fast in the same direction.
+	Cancels the prefetch of the chunks that are no longer on the predicted path. */
+	void UpdatePrefetch(std::chrono::milliseconds a_Dt);
+
 	inline bool IsLoggedIn(void) const { return (m_State >= csAuthenticating); }
 
 	/** Called while the client is being ticked from the world via its cPlayer object */
@@ -193,7 +197,7 @@ public:  // tolua_export
 	void SendHideTitle                  (void);   // tolua_export
 	void SendInventorySlot              (char a_WindowID, short a_SlotNum, const cItem & a_Item);
 	void SendLeashEntity                (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo);  // tolua_export
-	void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY);
+	void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY);
 	void SendPaintingSpawn              (const cPainting & a_Painting);
 	void SendParticleEffect             (const AString & a_ParticleName, float a_SrcX, float a_SrcY, float a_SrcZ, float a_OffsetX, float a_OffsetY, float a_OffsetZ, float a_ParticleData, int a_ParticleAmount);
 	void SendParticleEffect             (const AString & a_ParticleName, const Vector3f a_Src, const Vector3f a_Offset, float a_ParticleData, int a_ParticleAmount, std::array<int, 2> a_Data);
@@ -303,6 +307,18 @@ public:  // tolua_export
 	/** Adds the chunk specified to the list of chunks wanted for sending (m_ChunksToSend) */
 	void AddWantedChunk(int a_ChunkX, int a_ChunkZ);
 
+	/** Returns true if the entity has been spawned on this client (see cEntityTracker). */
+	bool IsTrackingEntity(const cEntity & a_Entity) const;
+
+	/** Spawns the entity on this client and remembers it as tracked. */
+	void TrackEntity(cEntity & a_Entity);
+
+	/** If the entity is tracked, destroys it on this client and forgets it. */
+	void UntrackEntity(const cEntity & a_Entity);
+
+	/** Forgets the entity without sending anything, used when the client has lost the entity by itself (chunk resent). */
+	void ForgetEntity(const cEntity & a_Entity);
+
 	// Calls that cProtocol descendants use to report state:
 	void PacketBufferFull(void);
 	void PacketUnknown(UInt32 a_PacketType);
@@ -410,8 +426,9 @@ public:  // tolua_export
 	void SendData(ContiguousByteBufferView a_Data);
 
 	/** Called when the player moves into a different world.
-	Sends an UnloadChunk packet for each loaded chunk and resets the streamed chunks. */
-	void RemoveFromWorld(void);
+	Sends an UnloadChunk packet for each loaded chunk and resets the streamed chunks.
+	a_NewPosition is the player's position in the new world, the chunk prefetching measures the movement from there. */
+	void RemoveFromWorld(Vector3d a_NewPosition);
 
 	/** Called by the protocol recognizer when the protocol version is known. */
 	void SetProtocolVersion(UInt32 a_ProtocolVersion) { m_ProtocolVersion = a_ProtocolVersion; }
@@ -453,13 +470,36 @@ private:
 
 	cMultiVersionProtocol m_Protocol;
 
+	/** Protects m_TrackedEntities against multithreaded access (the chunk sender spawns entities, too). */
+	mutable cCriticalSection m_CSTrackedEntities;
+
+	/** IDs of the entities spawned on this client, maintained by cEntityTracker. Protected by m_CSTrackedEntities. */
+	std::unordered_set<UInt32> m_TrackedEntities;
+
 	/** Protects m_IncomingData against multithreaded access. */
 	cCriticalSection m_CSIncomingData;
 
 	/** Queue for the incoming data received on the link until it is processed in ProcessProtocolIn().
+	Once m_ShouldSplitIncomingData is set, only used as a temporary buffer for splitting the data into packets.
 	Protected by m_CSIncomingData. */
 	ContiguousByteBuffer m_IncomingData;
 
+	/** Set once the protocol allows the incoming data to be split into packets right as it is received, on the network thread.
+	Only ever set in the tick thread, while holding m_CSIncomingData. */
+	bool m_ShouldSplitIncomingData;
+
+	/** Complete packets split off the incoming data, waiting to be handled in ProcessProtocolIn().
+	Protected by m_CSIncomingData. */
+	cProtocol::cReceivedPackets m_IncomingPackets;
+
+	/** The error encountered while splitting the incoming data on the network thread, empty if none.
+	The client is kicked with this reason in the next ProcessProtocolIn(). Protected by m_CSIncomingData. */
+	AString m_IncomingDataError;
+
+	/** Set while the reading from the link is paused, because too many packets are waiting in m_IncomingPackets.
+	Only accessed in the tick thread. */
+	bool m_IsReadingPaused;
+
 	/** Protects m_OutgoingData against multithreaded access. */
 	cCriticalSection m_CSOutgoingData;
 
@@ -495,6 +535,15 @@ private:
 	/** The time since UnloadOutOfRangeChunks was last called. */
 	std::chrono::milliseconds m_TimeSinceLastUnloadCheck;
 
+	/** The chunks prefetched for the player's predicted path, outside of the view distance. Used only in the world tick thread. */
+	std::unordered_set<cChunkCoords, cChunkCoordsHash> m_PrefetchedChunks;
+
+	/** The player's position at the last UpdatePrefetch() run, used to compute the player's speed. */
+	Vector3d m_PrefetchLastPosition;
+
+	/** The time since the last UpdatePrefetch() run. */
+	std::chrono::milliseconds m_TimeSinceLastPrefetch;
+
 	/** Duration of the last completed client ping. */
 	std::chrono::steady_clock::duration m_Ping;
 
@@ -553,6 +602,10 @@ private:
 	/** Set to true when the chunk where the player is is sent to the client. Used for spawning the player */
 	bool m_HasSentPlayerChunk;
 
+	/** Set when the client has been authenticated, but the player's files are still being read in the background.
+	ServerTick() finishes the authentication once they have been read. */
+	std::atomic<bool> m_IsWaitingForPlayerData;
+
 	/** Client Settings */
 	AString m_Locale;
 
@@ -603,6 +656,14 @@ private:
 	/** Removes all of the channels from the list of current plugin channels. Ignores channels that are not found. */
 	void UnregisterPluginChannels(const AStringVector & a_ChannelList);
 
+	/** Splits m_IncomingData into packets appended to m_IncomingPackets, records any error into m_IncomingDataError.
+	Expects m_CSIncomingData to be held and m_ShouldSplitIncomingData to be set. */
+	void SplitIncomingData(void);
+
+	/** Handles the packets waiting in m_IncomingPackets, up to a per-tick limit, coalescing the superseded movement packets.
+	Pauses the reading from the link while too many packets are waiting, so that a flooding client is throttled. */
+	void ProcessIncomingPackets(void);
+
 	/** Called when the network socket has been closed. */
 	void SocketClosed(void);
 
@@ -7,6 +7,17 @@
 #include "CraftingRecipes.h"
 #include "Root.h"
 #include "Bindings/PluginManager.h"
+#include "Entities/Player.h"
+
+
+
+
+
+/** Number of recent lookups remembered for each player. */
+static const size_t MEMO_ENTRIES_PER_PLAYER = 4;
+
+/** When the memo holds this many players, it is cleared, so that players who have left don't accumulate. */
+static const size_t MEMO_MAX_PLAYERS = 1024;
 
 
 
@@ -263,10 +274,12 @@ void cCraftingRecipe::Dump(void)
 ////////////////////////////////////////////////////////////////////////////////
 // cCraftingRecipes:
 
-cCraftingRecipes::cCraftingRecipes(void)
+cCraftingRecipes::cCraftingRecipes(void):
+	m_MaxIngredientCount(1)
 {
 	LoadRecipes();
 	PopulateRecipeNameMap();
+	BuildRecipeIndex();
 }
 
 
@@ -357,7 +370,7 @@ void cCraftingRecipes::GetRecipe(cPlayer & a_Player, cCraftingGrid & a_CraftingG
 	}
 
 	// Built-in recipes:
-	std::unique_ptr<cRecipe> Recipe(FindRecipe(a_CraftingGrid.GetItems(), a_CraftingGrid.GetWidth(), a_CraftingGrid.GetHeight()));
+	std::unique_ptr<cRecipe> Recipe(FindRecipeMemoized(a_Player.GetUniqueID(), a_CraftingGrid.GetItems(), a_CraftingGrid.GetWidth(), a_CraftingGrid.GetHeight()));
 	a_Recipe.Clear();
 	if (Recipe.get() == nullptr)
 	{
@@ -442,6 +455,139 @@ void cCraftingRecipes::ClearRecipes(void)
 		delete *itr;
 	}
 	m_Recipes.clear();
+	m_RecipeIndex.clear();
+	{
+		cCSLock Lock(m_CSMemo);
+		m_Memo.clear();
+	}
+}
+
+
+
+
+
+void cCraftingRecipes::BuildRecipeIndex(void)
+{
+	m_RecipeIndex.clear();
+	m_MaxIngredientCount = 1;
+	std::vector<short> ItemTypes;
+	for (size_t i = 0; i < m_Recipes.size(); i++)
+	{
+		// Each regular ingredient position takes one grid cell, each "anywhere" ingredient takes another one:
+		ItemTypes.clear();
+		bool IsOccupied[MAX_GRID_WIDTH][MAX_GRID_HEIGHT] = {};
+		for (const auto & Slot: m_Recipes[i]->m_Ingredients)
+		{
+			m_MaxIngredientCount = std::max(m_MaxIngredientCount, Slot.m_Item.m_ItemCount);
+			if ((Slot.x >= 0) && (Slot.y >= 0))
+			{
+				if (IsOccupied[Slot.x][Slot.y])
+				{
+					continue;
+				}
+				IsOccupied[Slot.x][Slot.y] = true;
+			}
+			ItemTypes.push_back(Slot.m_Item.m_ItemType);
+		}
+		m_RecipeIndex[GetIngredientsHash(ItemTypes)].push_back(i);
+	}
+	LOGD("Crafting recipes indexed into %zu buckets", m_RecipeIndex.size());
+}
+
+
+
+
+
+UInt64 cCraftingRecipes::GetIngredientsHash(std::vector<short> & a_ItemTypes)
+{
+	// FNV-1a over the sorted item types:
+	std::sort(a_ItemTypes.begin(), a_ItemTypes.end());
+	UInt64 Hash = 14695981039346656037ULL;
+	for (auto ItemType: a_ItemTypes)
+	{
+		Hash = (Hash ^ static_cast<UInt16>(ItemType)) * 1099511628211ULL;
+	}
+	return (Hash ^ a_ItemTypes.size()) * 1099511628211ULL;
+}
+
+
+
+
+
+bool cCraftingRecipes::IsSameForMatching(const cItem & a_Item1, const cItem & a_Item2) const
+{
+	if (a_Item1.IsEmpty() || a_Item2.IsEmpty())
+	{
+		return (a_Item1.IsEmpty() && a_Item2.IsEmpty());
+	}
+	return (
+		a_Item1.IsEqual(a_Item2) &&
+		(a_Item1.m_ItemColor.m_Color == a_Item2.m_ItemColor.m_Color) &&
+		(std::min(a_Item1.m_ItemCount, m_MaxIngredientCount) == std::min(a_Item2.m_ItemCount, m_MaxIngredientCount))
+	);
+}
+
+
+
+
+
+cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipeMemoized(UInt32 a_PlayerID, const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight)
+{
+	const auto NumCells = static_cast<size_t>(a_GridWidth * a_GridHeight);
+	{
+		cCSLock Lock(m_CSMemo);
+		auto & Entries = m_Memo[a_PlayerID];
+		for (auto itr = Entries.begin(); itr != Entries.end(); ++itr)
+		{
+			if ((itr->m_GridWidth != a_GridWidth) || (itr->m_GridHeight != a_GridHeight))
+			{
+				continue;
+			}
+			bool IsSame = true;
+			for (size_t i = 0; i < NumCells; i++)
+			{
+				if (!IsSameForMatching(itr->m_Grid[i], a_CraftingGrid[i]))
+				{
+					IsSame = false;
+					break;
+				}
+			}
+			if (!IsSame)
+			{
+				continue;
+			}
+
+			// Found, move to front and return a copy:
+			auto Recipe = itr->m_Recipe;
+			std::rotate(Entries.begin(), itr, itr + 1);
+			return (Recipe == nullptr) ? nullptr : new cRecipe(*Recipe);
+		}
+	}
+
+	// Not memoized, search for the recipe without holding the lock:
+	cRecipe * Recipe = FindRecipe(a_CraftingGrid, a_GridWidth, a_GridHeight);
+
+	cMemoEntry Entry;
+	Entry.m_GridWidth = a_GridWidth;
+	Entry.m_GridHeight = a_GridHeight;
+	Entry.m_Grid.assign(a_CraftingGrid, a_CraftingGrid + NumCells);
+	if (Recipe != nullptr)
+	{
+		Entry.m_Recipe = std::make_shared<const cRecipe>(*Recipe);
+	}
+
+	cCSLock Lock(m_CSMemo);
+	if ((m_Memo.size() >= MEMO_MAX_PLAYERS) && (m_Memo.find(a_PlayerID) == m_Memo.end()))
+	{
+		m_Memo.clear();
+	}
+	auto & Entries = m_Memo[a_PlayerID];
+	Entries.insert(Entries.begin(), std::move(Entry));
+	if (Entries.size() > MEMO_ENTRIES_PER_PLAYER)
+	{
+		Entries.pop_back();
+	}
+	return Recipe;
 }
 
 
@@ -716,8 +862,26 @@ cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipe(const cItem * a_Craftin
 
 cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipeCropped(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride)
 {
-	for (cRecipes::const_iterator itr = m_Recipes.begin(); itr != m_Recipes.end(); ++itr)
+	// Only the recipes made of the same items as the grid can match:
+	std::vector<short> ItemTypes;
+	for (int y = 0; y < a_GridHeight; y++) for (int x = 0; x < a_GridWidth; x++)
+	{
+		const cItem & Item = a_CraftingGrid[x + y * a_GridStride];
+		if (!Item.IsEmpty())
+		{
+			ItemTypes.push_back(Item.m_ItemType);
+		}
+	}
+	const auto Candidates = m_RecipeIndex.find(GetIngredientsHash(ItemTypes));
+	if (Candidates == m_RecipeIndex.end())
 	{
+		return nullptr;
+	}
+
+	for (const auto Index: Candidates->second)
+	{
+		const auto itr = m_Recipes.begin() + static_cast<std::ptrdiff_t>(Index);
+
 		// Both the crafting grid and the recipes are normalized. The only variable possible is the "anywhere" items.
 		// This still means that the "anywhere" item may be the one that is offsetting the grid contents to the right or downwards, so we need to check all possible positions.
 		// E. g. recipe "A, * | B, 1:1 | ..." still needs to check grid for B at 2:2 (in case A was in grid's 1:1)
@@ -734,7 +898,7 @@ cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipeCropped(const cItem * a_
 				return Recipe;
 			}
 		}  // for y, for x
-	}  // for itr - m_Recipes[]
+	}  // for Index - Candidates[]
 
 	// No matching recipe found
 	return nullptr;
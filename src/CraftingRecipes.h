@@ -113,6 +113,12 @@ name.
 
 To handle the crafting recipes internally efficient the vector index of the
 `cRecipes` is used as `RecipeId`.
+
+Since a recipe needs to match every non-empty cell of the grid, the multiset of item types in the grid
+is the same as the multiset of item types of the matching recipe's ingredients. The recipes are indexed
+by a hash of this multiset, so that a lookup only tries the few recipes made of the same items.
+The last few grids looked up by each player are memoized, because the grid is re-checked on every click
+and shift-crafting repeatedly looks up the same grid with decreasing counts.
 */
 class cCraftingRecipes
 {
@@ -161,9 +167,46 @@ protected:
 
 	cRecipes m_Recipes;
 
+	/** The recipes indexed by the hash of their ingredient item types (GetIngredientsHash()).
+	Each value lists the indices into m_Recipes, in ascending order, so that the first matching recipe is the same as with a linear search. */
+	std::unordered_map<UInt64, std::vector<size_t>> m_RecipeIndex;
+
+	/** The largest item count required by any single ingredient.
+	Grid items with at least this many items in them are equivalent as far as matching is concerned. */
+	char m_MaxIngredientCount;
+
+	/** A single memoized lookup. */
+	struct cMemoEntry
+	{
+		int m_GridWidth;
+		int m_GridHeight;
+		std::vector<cItem> m_Grid;
+
+		/** The recipe found for the grid, nullptr if none. */
+		std::shared_ptr<const cRecipe> m_Recipe;
+	};
+
+	/** The most recent lookups of each player (by player's UniqueID), most recent first. Protected by m_CSMemo. */
+	std::unordered_map<UInt32, std::vector<cMemoEntry>> m_Memo;
+
+	/** Protects m_Memo, the lookups come from multiple worlds' tick threads. */
+	cCriticalSection m_CSMemo;
+
 	void LoadRecipes(void);
 	void ClearRecipes(void);
 
+	/** Builds m_RecipeIndex and m_MaxIngredientCount from m_Recipes. */
+	void BuildRecipeIndex(void);
+
+	/** Returns the hash of the multiset of the specified item types. Reorders the types. */
+	static UInt64 GetIngredientsHash(std::vector<short> & a_ItemTypes);
+
+	/** Returns true if the two grid items are the same for the purpose of recipe matching, including the data used by HandleFireworks() and HandleDyedLeather(). */
+	bool IsSameForMatching(const cItem & a_Item1, const cItem & a_Item2) const;
+
+	/** Same as FindRecipe, but uses and updates the per-player memo of recent lookups. */
+	cRecipe * FindRecipeMemoized(UInt32 a_PlayerID, const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight);
+
 	/** Parses the recipe line and adds it into m_Recipes. a_LineNum is used for diagnostic warnings only */
 	void AddRecipeLine(int a_LineNum, const AString & a_RecipeLine);
 
@@ -20,6 +20,22 @@
 
 
 
+/** Number of consecutive full ticks an entity needs to lie still before it is put to rest. */
+static const int TICKS_BEFORE_REST = 20;
+
+/** Number of ticks between the full ticks that a resting entity gets to re-check its surroundings. */
+static const int REST_CHECK_INTERVAL = 100;
+
+/** Squared length of the per-tick movement below which an entity is considered lying still. */
+static const double REST_MAX_MOVEMENT_SQR = 0.01 * 0.01;
+
+/** Squared speed (in m / s) below which an entity is considered lying still. */
+static const double REST_MAX_SPEED_SQR = 0.02 * 0.02;
+
+
+
+
+
 static UInt32 GetNextUniqueID(void)
 {
 	static std::atomic<UInt32> counter(1);
@@ -46,6 +62,7 @@ cEntity::cEntity(eEntityType a_EntityType, Vector3d a_Pos, float a_Width, float
 	m_Gravity(-9.81f),
 	m_AirDrag(0.02f),
 	m_LastSentPosition(a_Pos),
+	m_MovementUpdatePeriod(2_tick),
 	m_LastPosition(a_Pos),
 	m_EntityType(a_EntityType),
 	m_World(nullptr),
@@ -62,6 +79,10 @@ cEntity::cEntity(eEntityType a_EntityType, Vector3d a_Pos, float a_Width, float
 	m_AirLevel(MAX_AIR_LEVEL),
 	m_AirTickTimer(DROWNING_TICKS),
 	m_TicksAlive(0),
+	m_IsAtRest(false),
+	m_TicksMotionless(0),
+	m_TicksUntilRestCheck(0),
+	m_RestCheckPosition(a_Pos),
 	m_IsTicking(false),
 	m_ParentChunk(nullptr),
 	m_HeadYaw(0.0),
@@ -402,6 +423,8 @@ void cEntity::SetPitchFromSpeed(void)
 
 bool cEntity::DoTakeDamage(TakeDamageInfo & a_TDI)
 {
+	WakeUp();
+
 	if (m_Health <= 0)
 	{
 		// Can't take damage if already dead
@@ -988,6 +1011,7 @@ void cEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 		{
 			// None of the above functions changed position, we remain in the chunk of NextChunk
 			HandlePhysics(a_Dt, *NextChunk);
+			UpdateRestState();
 		}
 	}
 }
@@ -996,6 +1020,71 @@ void cEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 
 
 
+void cEntity::TickAtRest(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
+{
+	UNUSED(a_Dt);
+	UNUSED(a_Chunk);
+	ASSERT(m_IsAtRest);
+
+	// Once in a while, give the entity a full tick, so that it notices the changes that don't wake it up explicitly:
+	m_TicksUntilRestCheck -= 1;
+	if (m_TicksUntilRestCheck <= 0)
+	{
+		// Get back to rest right after the full tick, if the entity still doesn't move:
+		m_IsAtRest = false;
+		m_TicksMotionless = TICKS_BEFORE_REST - 1;
+		return;
+	}
+
+	m_TicksAlive++;
+	if (m_InvulnerableTicks > 0)
+	{
+		m_InvulnerableTicks--;
+	}
+}
+
+
+
+
+
+void cEntity::WakeUp(void)
+{
+	m_IsAtRest = false;
+	m_TicksMotionless = 0;
+}
+
+
+
+
+
+void cEntity::UpdateRestState(void)
+{
+	const auto HasMoved = (m_Position - m_RestCheckPosition).SqrLength() > REST_MAX_MOVEMENT_SQR;
+	m_RestCheckPosition = m_Position;
+	if (
+		!CanRest() || HasMoved || !IsOnGround() ||
+		(m_Speed.SqrLength() > REST_MAX_SPEED_SQR) || m_WaterSpeed.HasNonZeroLength() ||
+		IsOnFire() || IsInWater() || IsInLava() ||
+		(m_AttachedTo != nullptr) || (m_Attachee != nullptr)
+	)
+	{
+		m_TicksMotionless = 0;
+		return;
+	}
+
+	m_TicksMotionless += 1;
+	if (m_TicksMotionless >= TICKS_BEFORE_REST)
+	{
+		m_IsAtRest = true;
+		m_TicksUntilRestCheck = REST_CHECK_INTERVAL;
+		m_Speed.Set(0, 0, 0);
+	}
+}
+
+
+
+
+
 void cEntity::HandlePhysics(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 {
 	int BlockX = POSX_TOINT;
@@ -1156,7 +1245,7 @@ void cEntity::HandlePhysics(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 		Vector3i HitBlockCoords;
 		eBlockFace HitBlockFace;
 		Vector3d wantNextPos = NextPos + NextSpeed * DtSec.count();
-		auto isHit = cLineBlockTracer::FirstSolidHitTrace(*GetWorld(), NextPos, wantNextPos, HitCoords, HitBlockCoords, HitBlockFace);
+		auto isHit = cLineBlockTracer::FirstSolidHitTrace(a_Chunk, NextPos, wantNextPos, HitCoords, HitBlockCoords, HitBlockFace);
 		if (isHit)
 		{
 			// Set our position to where the block was hit:
@@ -1913,6 +2002,7 @@ void cEntity::StartBurning(int a_TicksLeftBurning)
 	}
 
 	m_TicksLeftBurning = a_TicksLeftBurning;
+	WakeUp();
 	OnStartedBurning();
 }
 
@@ -1963,8 +2053,8 @@ void cEntity::TeleportToCoords(double a_PosX, double a_PosY, double a_PosZ)
 
 void cEntity::BroadcastMovementUpdate(const cClientHandle * a_Exclude)
 {
-	// Process packet sending every two ticks:
-	if ((GetWorld()->GetWorldTickAge() % 2_tick) != 0_tick)
+	// Process packet sending every two ticks for nearby clients, less often for far away ones (see cEntityTracker):
+	if (!IsMovementUpdateDue())
 	{
 		return;
 	}
@@ -2014,6 +2104,16 @@ void cEntity::BroadcastMovementUpdate(const cClientHandle * a_Exclude)
 
 
 
+bool cEntity::IsMovementUpdateDue(void) const
+{
+	const auto Phase = cTickTimeLong(static_cast<cTickTimeLong::rep>(m_UniqueID));
+	return (((GetWorld()->GetWorldTickAge() + Phase) % m_MovementUpdatePeriod) == 0_tick);
+}
+
+
+
+
+
 cEntity * cEntity::GetAttached()
 {
 	return m_AttachedTo;
@@ -2157,6 +2257,12 @@ void cEntity::SetSpeed(double a_SpeedX, double a_SpeedY, double a_SpeedZ)
 {
 	m_Speed.Set(a_SpeedX, a_SpeedY, a_SpeedZ);
 	WrapSpeed();
+
+	// A resting entity that has been pushed needs its physics back:
+	if (m_IsAtRest && m_Speed.HasNonZeroLength())
+	{
+		WakeUp();
+	}
 }
 
 
@@ -2289,6 +2395,12 @@ void cEntity::SetPosition(const Vector3d & a_Position)
 
 	m_LastPosition = m_Position;
 	m_Position = {ClampedPosX, ClampedPosY, ClampedPosZ};
+
+	// A resting entity that has been moved needs its physics back:
+	if (m_IsAtRest && (m_Position != m_LastPosition))
+	{
+		WakeUp();
+	}
 }
 
 
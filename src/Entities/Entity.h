@@ -373,6 +373,16 @@ public:
 
 	virtual void Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk);
 
+	/** Called by the parent chunk instead of Tick() while the entity is at rest.
+	Keeps the entity's timers going; once in a while, wakes the entity up for a single full tick, so that it re-checks its surroundings. */
+	virtual void TickAtRest(std::chrono::milliseconds a_Dt, cChunk & a_Chunk);
+
+	/** Returns true if the entity has settled down and its parent chunk doesn't run its physics. */
+	bool IsAtRest(void) const { return m_IsAtRest; }
+
+	/** Brings a resting entity back to full ticking. Called when something around the entity changes. */
+	void WakeUp(void);
+
 	/** Handles the physics of the entity - updates position based on speed, updates speed based on environment */
 	virtual void HandlePhysics(std::chrono::milliseconds a_Dt, cChunk & a_Chunk);
 
@@ -455,6 +465,13 @@ public:
 	/** Updates clients of changes in the entity. */
 	virtual void BroadcastMovementUpdate(const cClientHandle * a_Exclude = nullptr);
 
+	/** Returns true if the movement updates are to be sent in the current tick, based on the period set by the entity tracker.
+	The periods are phase-shifted by the entity ID, so that not all entities send their updates in the same tick. */
+	bool IsMovementUpdateDue(void) const;
+
+	/** Sets how often the movement updates are sent to the clients. Used by cEntityTracker. */
+	void SetMovementUpdatePeriod(cTickTimeLong a_Period) { m_MovementUpdatePeriod = a_Period; }
+
 	/** Gets entity (vehicle) attached to this entity */
 	cEntity * GetAttached();
 
@@ -617,6 +634,9 @@ protected:
 	Only updated if cEntity::BroadcastMovementUpdate() is called! */
 	Vector3d m_LastSentPosition;
 
+	/** How often BroadcastMovementUpdate() sends the updates, depends on the distance to the nearest tracking client. */
+	cTickTimeLong m_MovementUpdatePeriod;
+
 	Vector3d m_LastPosition;
 
 	eEntityType m_EntityType;
@@ -666,6 +686,18 @@ protected:
 	/** The number of ticks this entity has been alive for */
 	long int m_TicksAlive;
 
+	/** True if the entity has settled down; its parent chunk calls TickAtRest() instead of Tick(). */
+	bool m_IsAtRest;
+
+	/** Number of consecutive full ticks in which the entity hasn't moved, see UpdateRestState(). */
+	int m_TicksMotionless;
+
+	/** Number of TickAtRest() calls left until the resting entity gets a full tick. */
+	int m_TicksUntilRestCheck;
+
+	/** The position at the end of the previous full tick, used for detecting that the entity doesn't move. */
+	Vector3d m_RestCheckPosition;
+
 	/** Handles the moving of this entity between worlds.
 	Should handle degenerate cases such as moving to the same world. */
 	void DoMoveToWorld(const sWorldChangeInfo & a_WorldChangeInfo);
@@ -678,6 +710,14 @@ protected:
 	/** Called in each tick to handle air-related processing i.e. drowning */
 	virtual void HandleAir(void);
 
+	/** Returns true if the entity may be put to rest when it stops moving.
+	Only the entities that don't do anything on their own while lying still should return true;
+	those need to keep their timers going in TickAtRest(). */
+	virtual bool CanRest(void) const { return false; }
+
+	/** Puts the entity to rest if it has been lying still for a while. Called at the end of each full tick. */
+	void UpdateRestState(void);
+
 	/** Called once per tick to set m_IsInFire, m_IsInLava, m_IsInWater and
 	m_IsHeadInWater */
 	virtual void SetSwimState(cChunk & a_Chunk);
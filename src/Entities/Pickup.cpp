@@ -32,6 +32,17 @@ public:
 	bool operator () (cEntity & a_Entity)
 	{
 		ASSERT(a_Entity.IsTicking());
+
+		// Older pickups only look for pickups to take in on their full ticks; wake up the resting ones so that they take this one in right away:
+		if (
+			a_Entity.IsAtRest() && a_Entity.IsPickup() && (a_Entity.GetUniqueID() < m_Pickup->GetUniqueID()) &&
+			static_cast<cPickup &>(a_Entity).GetItem().IsEqual(m_Pickup->GetItem())
+		)
+		{
+			a_Entity.WakeUp();
+			return false;
+		}
+
 		if (!a_Entity.IsPickup() || (a_Entity.GetUniqueID() <= m_Pickup->GetUniqueID()) || !a_Entity.IsOnGround())
 		{
 			return false;
@@ -196,6 +207,26 @@ void cPickup::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 
 
 
+void cPickup::TickAtRest(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
+{
+	Super::TickAtRest(a_Dt, a_Chunk);
+	if (!IsAtRest())
+	{
+		// Getting a full tick instead, which handles the timers itself
+		return;
+	}
+
+	m_Timer += a_Dt;
+	if (m_Timer > m_Lifetime)
+	{
+		Destroy();
+	}
+}
+
+
+
+
+
 bool cPickup::DoTakeDamage(TakeDamageInfo & a_TDI)
 {
 	if (a_TDI.DamageType == dtCactusContact)
@@ -258,6 +289,7 @@ bool cPickup::CollectedBy(cEntity & a_Dest)
 				{
 					// All of the pickup has been collected, schedule the pickup for destroying
 					m_bCollected = true;
+					WakeUp();
 				}
 				m_Timer = std::chrono::milliseconds(0);
 				return true;
@@ -304,6 +336,7 @@ bool cPickup::CollectedBy(cEntity & a_Dest)
 			{
 				// All of the pickup has been collected, schedule the pickup for destroying
 				m_bCollected = true;
+				WakeUp();
 			}
 			m_Timer = std::chrono::milliseconds(0);
 			return true;
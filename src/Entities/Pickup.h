@@ -36,6 +36,7 @@ public:  // tolua_export
 	bool CollectedBy(cEntity & a_Dest);  // tolua_export
 
 	virtual void Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk) override;
+	virtual void TickAtRest(std::chrono::milliseconds a_Dt, cChunk & a_Chunk) override;
 
 	virtual bool DoTakeDamage(TakeDamageInfo & a_TDI) override;
 
@@ -65,6 +66,11 @@ public:  // tolua_export
 	/** Returns true if created by player (i.e. vomiting), used for determining picking-up delay time */
 	bool IsPlayerCreated(void) const { return m_bIsPlayerCreated; }  // tolua_export
 
+protected:
+
+	// cEntity overrides:
+	virtual bool CanRest(void) const override { return !m_bCollected; }
+
 private:
 
 	/** The number of ticks that the entity has existed / timer between collect and destroy; in msec */
@@ -35,27 +35,6 @@
 
 
 
-namespace
-{
-
-/** Returns the folder for the player data based on the UUID given.
-This can be used both for online and offline UUIDs. */
-AString GetUUIDFolderName(const cUUID & a_Uuid)
-{
-	AString UUID = a_Uuid.ToShortString();
-
-	AString res("players/");
-	res.append(UUID, 0, 2);
-	res.push_back('/');
-	return res;
-}
-
-}  // namespace (anonymous)
-
-
-
-
-
 const int cPlayer::MAX_HEALTH = 20;
 
 const int cPlayer::MAX_FOOD_LEVEL = 20;
@@ -1807,26 +1786,36 @@ void cPlayer::LoadFromDisk()
 	Json::Value Root;
 	const auto & UUID = GetUUID();
 	const auto & FileName = GetUUIDFileName(UUID);
+	auto & Storage = cRoot::Get()->GetPlayerDataStorage();
 
-	try
+	// Load the data from the save file (or the data still queued for writing into it) and parse:
+	AString Data;
+	if (Storage.Load(FileName, Data))
 	{
-		// Load the data from the save file and parse:
-		InputFileStream(FileName) >> Root;
-
-		// Load the player stats.
-		// We use the default world name (like bukkit) because stats are shared between dimensions / worlds.
-		StatisticsSerializer::Load(m_Stats, m_DefaultWorldPath, UUID.ToLongString());
+		AString ParseError;
+		if (!JsonUtils::ParseString(Data, Root, &ParseError))
+		{
+			throw std::runtime_error(fmt::format("Cannot parse the save file \"{}\": {}", FileName, ParseError));
+		}
+	}
+	else
+	{
+		// This is a new player whom we haven't seen yet with no save file, let them have the defaults:
+		LOG("Player \"%s\" (%s) save file not found, resetting to defaults", GetName().c_str(), UUID.ToShortString().c_str());
 	}
-	catch (const InputFileStream::failure &)
+
+	// Load the player stats.
+	// We use the default world name (like bukkit) because stats are shared between dimensions / worlds.
+	const auto StatisticsFileName = GetStatisticsFileName(m_DefaultWorldPath, UUID);
+	if (Storage.Load(StatisticsFileName, Data))
 	{
-		if (errno != ENOENT)
+		Json::Value StatisticsRoot;
+		AString ParseError;
+		if (!JsonUtils::ParseString(Data, StatisticsRoot, &ParseError))
 		{
-			// Save file exists but unreadable:
-			throw;
+			throw std::runtime_error(fmt::format("Cannot parse the statistics file \"{}\": {}", StatisticsFileName, ParseError));
 		}
-
-		// This is a new player whom we haven't seen yet with no save file, let them have the defaults:
-		LOG("Player \"%s\" (%s) save or statistics file not found, resetting to defaults", GetName().c_str(), UUID.ToShortString().c_str());
+		StatisticsSerializer::FromJson(m_Stats, StatisticsRoot);
 	}
 
 	m_CurrentWorldName = Root.get("world", cRoot::Get()->GetDefaultWorld()->GetName()).asString();
@@ -1930,10 +1919,33 @@ void cPlayer::OpenHorseInventory()
 
 
 
+void cPlayer::PrefetchFromDisk(const cUUID & a_UUID)
+{
+	auto & Storage = cRoot::Get()->GetPlayerDataStorage();
+	Storage.Prefetch(GetUUIDFileName(a_UUID));
+	Storage.Prefetch(GetStatisticsFileName(cRoot::Get()->GetDefaultWorld()->GetDataPath(), a_UUID));
+}
+
+
+
+
+
+bool cPlayer::IsPrefetchedFromDisk(const cUUID & a_UUID)
+{
+	auto & Storage = cRoot::Get()->GetPlayerDataStorage();
+	return (
+		Storage.IsReadyToLoad(GetUUIDFileName(a_UUID)) &&
+		Storage.IsReadyToLoad(GetStatisticsFileName(cRoot::Get()->GetDefaultWorld()->GetDataPath(), a_UUID))
+	);
+}
+
+
+
+
+
 void cPlayer::SaveToDisk()
 {
 	const auto & UUID = GetUUID();
-	cFile::CreateFolderRecursive(GetUUIDFolderName(UUID));
 
 	// create the JSON data
 	Json::Value JSON_PlayerPosition;
@@ -1994,36 +2006,12 @@ void cPlayer::SaveToDisk()
 	root["world"]               = m_CurrentWorldName;
 	root["gamemode"]            = static_cast<int>(m_GameMode);
 
-	auto JsonData = JsonUtils::WriteStyledString(root);
-	AString SourceFile = GetUUIDFileName(UUID);
-
-	cFile f;
-	if (!f.Open(SourceFile, cFile::fmWrite))
-	{
-		LOGWARNING("Error writing player \"%s\" to file \"%s\": cannot open file. Player will lose their progress",
-			GetName().c_str(), SourceFile.c_str()
-		);
-		return;
-	}
-	if (f.Write(JsonData.c_str(), JsonData.size()) != static_cast<int>(JsonData.size()))
-	{
-		LOGWARNING("Error writing player \"%s\" to file \"%s\": cannot save data. Player will lose their progress",
-			GetName().c_str(), SourceFile.c_str()
-		);
-		return;
-	}
-
-	try
-	{
-		// Save the player stats.
-		// We use the default world name (like bukkit) because stats are shared between dimensions / worlds.
-		// TODO: save together with player.dat, not in some other place.
-		StatisticsSerializer::Save(m_Stats, m_DefaultWorldPath, GetUUID().ToLongString());
-	}
-	catch (...)
-	{
-		LOGWARNING("Error writing player \"%s\" statistics to file", GetName().c_str());
-	}
+	// Hand the data over to the storage thread for writing.
+	// The stats are saved in the default world's folder, because they are shared between dimensions / worlds.
+	// TODO: save together with player.dat, not in some other place.
+	auto & Storage = cRoot::Get()->GetPlayerDataStorage();
+	Storage.Save(GetUUIDFileName(UUID), std::move(root));
+	Storage.Save(GetStatisticsFileName(m_DefaultWorldPath, UUID), StatisticsSerializer::ToJson(m_Stats));
 }
 
 
@@ -2527,6 +2515,15 @@ AString cPlayer::GetUUIDFileName(const cUUID & a_UUID)
 
 
 
+AString cPlayer::GetStatisticsFileName(const AString & a_DefaultWorldPath, const cUUID & a_UUID)
+{
+	return StatisticsSerializer::GetFileName(a_DefaultWorldPath, a_UUID.ToLongString());
+}
+
+
+
+
+
 void cPlayer::FreezeInternal(const Vector3d & a_Location, bool a_ManuallyFrozen)
 {
 	SetSpeed(0, 0, 0);
@@ -3119,7 +3116,7 @@ void cPlayer::OnRemoveFromWorld(cWorld & a_World)
 	m_World->BroadcastPlayerListUpdateGameMode(*this);
 
 	// Clear sent chunk lists from the clienthandle:
-	m_ClientHandle->RemoveFromWorld();
+	m_ClientHandle->RemoveFromWorld(m_WorldChangeInfo.m_NewPosition);
 }
 
 
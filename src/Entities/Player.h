@@ -419,13 +419,21 @@ public:
 
 	void SetVisible( bool a_bVisible);  // tolua_export
 
-	/** Saves all player data, such as inventory, to JSON. */
+	/** Saves all player data, such as inventory, to JSON.
+	The data is only snapshotted here, it is written to the disk by cPlayerDataStorage. */
 	void SaveToDisk(void);
 
 	/** Loads the player data from the save file.
 	Sets m_World to the world where the player will spawn, based on the stored world name or the default world by calling LoadFromFile(). */
 	void LoadFromDisk();
 
+	/** Queues the save and statistics files of the player with the specified UUID to be read in the background,
+	so that LoadFromDisk() doesn't need to wait for the disk. Called while the player is logging in. */
+	static void PrefetchFromDisk(const cUUID & a_UUID);
+
+	/** Returns true if the files queued by PrefetchFromDisk() can be loaded without waiting for the disk. */
+	static bool IsPrefetchedFromDisk(const cUUID & a_UUID);
+
 	const AString & GetLoadedWorldName() const { return m_CurrentWorldName; }
 
 	/** Opens the inventory of any tame horse the player is riding.
@@ -761,7 +769,11 @@ private:
 
 	/** Returns the filename for the player data based on the UUID given.
 	This can be used both for online and offline UUIDs. */
-	AString GetUUIDFileName(const cUUID & a_UUID);
+	static AString GetUUIDFileName(const cUUID & a_UUID);
+
+	/** Returns the filename for the player statistics based on the UUID given.
+	The statistics are stored in the default world's folder, they are shared between worlds. */
+	static AString GetStatisticsFileName(const AString & a_DefaultWorldPath, const cUUID & a_UUID);
 
 	/** Pins the player to a_Location until Unfreeze() is called.
 	If ManuallyFrozen is false, the player will unfreeze when the chunk is loaded. */
@@ -411,7 +411,7 @@ void cProjectileEntity::HandlePhysics(std::chrono::milliseconds a_Dt, cChunk & a
 
 	// Trace the tick's worth of movement as a line:
 	cProjectileTracerCallback TracerCallback(this);
-	if (!cLineBlockTracer::Trace(*m_World, TracerCallback, Pos, NextPos))
+	if (!cLineBlockTracer::Trace(a_Chunk, TracerCallback, Pos, NextPos))
 	{
 		// Something has been hit, abort all other processing
 		return;
@@ -0,0 +1,145 @@
+// EntityTracker.cpp
+
+// Implements the cEntityTracker class that decides which entities are spawned on which clients, and how often their movement is sent
+
+#include "Globals.h"
+#include "EntityTracker.h"
+#include "ClientHandle.h"
+#include "Entities/Entity.h"
+#include "Entities/Player.h"
+#include "IniFile.h"
+
+
+
+
+
+cEntityTracker::cEntityTracker(void):
+	m_PlayerRange(512),
+	m_MonsterRange(80),
+	m_VehicleRange(80),
+	m_ItemRange(64),
+	m_HangingRange(160),
+	m_OtherRange(160)
+{
+}
+
+
+
+
+
+void cEntityTracker::Initialize(cIniFile & a_IniFile)
+{
+	m_PlayerRange  = a_IniFile.GetValueSetI("EntityTracking", "PlayerRange",  static_cast<int>(m_PlayerRange));
+	m_MonsterRange = a_IniFile.GetValueSetI("EntityTracking", "MonsterRange", static_cast<int>(m_MonsterRange));
+	m_VehicleRange = a_IniFile.GetValueSetI("EntityTracking", "VehicleRange", static_cast<int>(m_VehicleRange));
+	m_ItemRange    = a_IniFile.GetValueSetI("EntityTracking", "ItemRange",    static_cast<int>(m_ItemRange));
+	m_HangingRange = a_IniFile.GetValueSetI("EntityTracking", "HangingRange", static_cast<int>(m_HangingRange));
+	m_OtherRange   = a_IniFile.GetValueSetI("EntityTracking", "OtherRange",   static_cast<int>(m_OtherRange));
+}
+
+
+
+
+
+double cEntityTracker::GetTrackingRange(const cEntity & a_Entity) const
+{
+	switch (a_Entity.GetEntityType())
+	{
+		case cEntity::etPlayer:       return m_PlayerRange;
+		case cEntity::etMonster:      return m_MonsterRange;
+		case cEntity::etMinecart:
+		case cEntity::etBoat:         return m_VehicleRange;
+		case cEntity::etPickup:
+		case cEntity::etProjectile:
+		case cEntity::etFloater:      return m_ItemRange;
+		case cEntity::etItemFrame:
+		case cEntity::etPainting:
+		case cEntity::etLeashKnot:    return m_HangingRange;
+		case cEntity::etEntity:
+		case cEntity::etEnderCrystal:
+		case cEntity::etFallingBlock:
+		case cEntity::etTNT:
+		case cEntity::etExpOrb:       return m_OtherRange;
+	}
+	UNREACHABLE("Unsupported entity type");
+}
+
+
+
+
+
+bool cEntityTracker::IsInRange(const cEntity & a_Entity, cClientHandle & a_Client) const
+{
+	const auto Player = a_Client.GetPlayer();
+	if (Player == nullptr)
+	{
+		return false;
+	}
+	return (GetTrackingDistance(a_Entity, *Player) <= GetTrackingRange(a_Entity));
+}
+
+
+
+
+
+void cEntityTracker::UpdateEntity(cEntity & a_Entity, const std::vector<cClientHandle *> & a_Clients)
+{
+	// Only re-evaluate right after the movement update has been sent, so that newly spawned clients share its position:
+	if (!a_Entity.IsTicking() || !a_Entity.IsMovementUpdateDue())
+	{
+		return;
+	}
+
+	const auto Range = GetTrackingRange(a_Entity);
+	auto Nearest = std::numeric_limits<double>::max();
+	for (const auto Client : a_Clients)
+	{
+		const auto Player = Client->GetPlayer();
+		if ((Player == nullptr) || (Player == &a_Entity) || Client->IsDestroyed())
+		{
+			continue;
+		}
+
+		const auto Distance = GetTrackingDistance(a_Entity, *Player);
+		const bool ShouldTrack = IsInRange(a_Entity, *Client);
+		if (ShouldTrack != Client->IsTrackingEntity(a_Entity))
+		{
+			if (ShouldTrack)
+			{
+				Client->TrackEntity(a_Entity);
+			}
+			else
+			{
+				Client->UntrackEntity(a_Entity);
+			}
+		}
+		if (ShouldTrack)
+		{
+			Nearest = std::min(Nearest, Distance);
+		}
+	}
+
+	// Nearby clients get the movement every 2 ticks, farther ones less often:
+	if (Nearest <= Range / 4)
+	{
+		a_Entity.SetMovementUpdatePeriod(2_tick);
+	}
+	else if (Nearest <= Range / 2)
+	{
+		a_Entity.SetMovementUpdatePeriod(4_tick);
+	}
+	else
+	{
+		a_Entity.SetMovementUpdatePeriod(8_tick);
+	}
+}
+
+
+
+
+
+double cEntityTracker::GetTrackingDistance(const cEntity & a_Entity, const cEntity & a_Player)
+{
+	const auto Diff = a_Entity.GetPosition() - a_Player.GetPosition();
+	return std::max(std::abs(Diff.x), std::abs(Diff.z));
+}
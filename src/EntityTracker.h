@@ -0,0 +1,67 @@
+// EntityTracker.h
+
+// Declares the cEntityTracker class that decides which entities are spawned on which clients, and how often their movement is sent
+
+/*
+Each client keeps a set of the entities that have been spawned on it (cClientHandle::IsTrackingEntity()). Only the clients
+that have the entity's chunk loaded are candidates, and of those only the ones whose player is within the entity type's
+tracking range (horizontally, measured the same way as the vanilla server) get the entity spawned.
+The tracker re-evaluates each entity whenever its movement update is due, right after the update has been broadcast, so
+that the position the new clients get in the spawn packet matches the position that the following relative moves are based on.
+Entities moving into range are spawned, entities moving out of range are despawned, and the movement update period is set
+based on the distance to the nearest tracking client.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cClientHandle;
+class cEntity;
+class cIniFile;
+
+
+
+
+
+class cEntityTracker
+{
+public:
+
+	cEntityTracker(void);
+
+	/** Loads the tracking ranges from the world.ini. */
+	void Initialize(cIniFile & a_IniFile);
+
+	/** Returns the distance (in blocks) up to which the entity is spawned on clients. */
+	double GetTrackingRange(const cEntity & a_Entity) const;
+
+	/** Returns true if the client's player is close enough to the entity to have it spawned. */
+	bool IsInRange(const cEntity & a_Entity, cClientHandle & a_Client) const;
+
+	/** Spawns and despawns the entity on the specified clients (those that have the entity's chunk loaded) based on their distance,
+	and updates the entity's movement update period. Does nothing if the entity's movement update isn't due in this tick.
+	Expects the world to be locked. */
+	void UpdateEntity(cEntity & a_Entity, const std::vector<cClientHandle *> & a_Clients);
+
+private:
+
+	/** Tracking ranges, in blocks, per entity category. */
+	double m_PlayerRange;
+	double m_MonsterRange;
+	double m_VehicleRange;
+	double m_ItemRange;
+	double m_HangingRange;
+	double m_OtherRange;
+
+
+	/** Returns the distance used for tracking: the larger of the X and Z distances, the same as the vanilla server. */
+	static double GetTrackingDistance(const cEntity & a_Entity, const cEntity & a_Player);
+};
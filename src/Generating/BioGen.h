@@ -15,6 +15,7 @@ Interfaces to the various biome generators:
 #pragma once
 
 #include "ComposableGenerator.h"
+#include "GenCache.h"
 #include "../Noise/Noise.h"
 #include "../VoronoiMap.h"
 
@@ -41,7 +42,8 @@ protected:
 
 
 
-/** A simple cache that stores N most recently generated chunks' biomes; N being settable upon creation */
+/** A cache that stores the most recently generated chunks' biomes, N slots being settable upon creation.
+The cache is lock-free and safe to use from multiple threads at once, see cGenCache for details. */
 class cBioGenCache:
 	public cBiomeGen
 {
@@ -51,33 +53,20 @@ public:
 
 	cBioGenCache(cBiomeGen & a_BioGenToCache, size_t a_CacheSize);
 
+	/** Returns the number of lookups that were served from the cache. */
+	size_t GetNumHits(void) const { return m_Cache.GetNumHits(); }
+
+	/** Returns the number of lookups that had to be generated by the underlying generator. */
+	size_t GetNumMisses(void) const { return m_Cache.GetNumMisses(); }
+
 protected:
 
 	friend class cBioGenMulticache;
 
 	cBiomeGen & m_BioGenToCache;
 
-	struct sCacheData
-	{
-		cChunkCoords m_Coords;
-		cChunkDef::BiomeMap m_BiomeMap;
-
-		/** Default constructor: Fill in bogus coords so that the item is not used in the cache until properly calculated. */
-		sCacheData():
-			m_Coords(0x7fffffff, 0x7fffffff)
-		{
-		}
-	} ;
-
-	// To avoid moving large amounts of data for the MRU behavior, we MRU-ize indices to an array of the actual data
-	size_t                  m_CacheSize;
-	std::vector<size_t>     m_CacheOrder;  // MRU-ized order, indices into m_CacheData array
-	std::vector<sCacheData> m_CacheData;   // m_CacheData[m_CacheOrder[0]] is the most recently used
-
-	// Cache statistics
-	size_t m_NumHits;
-	size_t m_NumMisses;
-	size_t m_TotalChain;  // Number of cache items walked to get to a hit (only added for hits)
+	/** The cached biome maps. */
+	cGenCache<cChunkDef::BiomeMap> m_Cache;
 
 	virtual void GenBiomes(cChunkCoords a_ChunkCoords, cChunkDef::BiomeMap & a_BiomeMap) override;
 	virtual void InitializeBiomeGen(cIniFile & a_IniFile) override;
@@ -87,29 +76,35 @@ protected:
 
 
 
+/** A cache that owns its underlying biome generator.
+Historically this divided the caching into several MRU sub-caches based on the chunk coords, to keep the lookups short (#381).
+cBioGenCache is sharded by itself now, so this is a single cache of (a_SubCacheSize * a_NumSubCaches) slots;
+the parameters are kept to match the settings in world.ini. */
 class cBioGenMulticache:
 	public cBiomeGen
 {
 	using Super = cBiomeGen;
 
 public:
-	/* Creates a new multicache - a cache that divides the caching into several sub-caches based on the chunk coords.
-	This allows us to use shorter cache depths with faster lookups for more covered area. (#381)
+	/* Creates a new multicache.
 	a_SubCacheSize defines the size of each sub-cache
 	a_NumSubCaches defines how many sub-caches are used for the multicache. */
 	cBioGenMulticache(std::unique_ptr<cBiomeGen> a_BioGenToCache, size_t a_SubCacheSize, size_t a_NumSubCaches);
 
-protected:
+	/** Returns the number of lookups that were served from the cache. */
+	size_t GetNumHits(void) const { return m_Cache.GetNumHits(); }
 
-	/** Number of sub-caches. Pulled out of m_Caches.size() for faster access. */
-	size_t m_NumSubCaches;
+	/** Returns the number of lookups that had to be generated by the underlying generator. */
+	size_t GetNumMisses(void) const { return m_Cache.GetNumMisses(); }
 
-	/** Individual sub-caches. */
-	std::vector<std::unique_ptr<cBioGenCache>> m_Caches;
+protected:
 
 	/** The underlying biome generator. */
 	std::unique_ptr<cBiomeGen> m_Underlying;
 
+	/** The cache over m_Underlying. */
+	cBioGenCache m_Cache;
+
 
 	virtual void GenBiomes(cChunkCoords a_ChunkCoords, cChunkDef::BiomeMap & a_BiomeMap) override;
 	virtual void InitializeBiomeGen(cIniFile & a_IniFile) override;
@@ -0,0 +1,228 @@
+// GenCache.h
+
+// Declares the cGenCache class template, a lock-free cache of per-chunk generated data shared by the generator caches
+
+/*
+The cache is a hashed, set-associative table. Each chunk coord hashes into exactly one set (shard) of cGenCache::NUM_WAYS
+slots; only those slots are ever examined, so a lookup is O(1) regardless of the cache size.
+Eviction within a set uses the CLOCK algorithm - each slot has a "referenced" bit that is set on every hit and
+cleared as the clock hand sweeps over it looking for a victim.
+
+Each slot is protected by a sequence lock: writers make the sequence number odd while updating the slot and even again
+when done; readers copy the data out and then verify that the sequence number hasn't changed in the meantime.
+Readers never block and never write anything but the referenced bit. A writer that finds its victim slot being
+written by another thread simply gives up on caching its data, so writers never block either.
+This makes the cache safe to share between multiple generator threads and the tick thread (cChunkGeneratorThread::GenerateBiomes)
+without any locks. Note that the underlying generator still needs to be safe to call concurrently if it is to be shared.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+
+
+
+
+
+template <typename T>
+class cGenCache
+{
+public:
+
+	/** Number of slots in each set (shard). */
+	static const size_t NUM_WAYS = 4;
+
+
+	/** Creates a new cache with (at least) the specified number of slots.
+	The number of sets is rounded up to a power of two, so that the set index can be calculated by masking. */
+	cGenCache(size_t a_NumSlots):
+		m_NumHits(0),
+		m_NumMisses(0)
+	{
+		size_t NumSets = 1;
+		while (NumSets * NUM_WAYS < a_NumSlots)
+		{
+			NumSets *= 2;
+		}
+		m_SetMask = NumSets - 1;
+		m_Sets.reset(new cSet[NumSets]);
+	}
+
+
+	/** Looks up the data for the specified chunk.
+	If found, calls a_Reader with a const reference to the cached data and returns true.
+	a_Reader must only copy out what it needs; it may be called multiple times (if a concurrent write is detected)
+	and the data it sees in such a discarded call may be inconsistent.
+	Returns false if the data is not in the cache. */
+	template <typename Reader>
+	bool Read(cChunkCoords a_Coords, Reader && a_Reader) const
+	{
+		auto & Set = GetSet(a_Coords);
+		for (auto & Slot: Set.m_Slots)
+		{
+			auto SeqBefore = Slot.m_Sequence.load(std::memory_order_acquire);
+			if ((SeqBefore & 1) != 0)
+			{
+				// Being written right now, cannot be the one we want:
+				continue;
+			}
+			if (
+				(Slot.m_ChunkX.load(std::memory_order_relaxed) != a_Coords.m_ChunkX) ||
+				(Slot.m_ChunkZ.load(std::memory_order_relaxed) != a_Coords.m_ChunkZ)
+			)
+			{
+				continue;
+			}
+			a_Reader(Slot.m_Data);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (Slot.m_Sequence.load(std::memory_order_relaxed) != SeqBefore)
+			{
+				// The slot has been overwritten while we were reading it, the data is not valid:
+				continue;
+			}
+			Slot.m_IsReferenced.store(true, std::memory_order_relaxed);
+			m_NumHits.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		m_NumMisses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+
+	/** Copies the data for the specified chunk into a_Data, if present in the cache.
+	Returns true if found, false if not. */
+	bool Get(cChunkCoords a_Coords, T & a_Data) const
+	{
+		return Read(a_Coords, [&a_Data](const T & a_Cached)
+			{
+				memcpy(&a_Data, &a_Cached, sizeof(T));
+			}
+		);
+	}
+
+
+	/** Stores the data for the specified chunk into the cache, evicting an older item from the chunk's set.
+	If another thread is writing into the victim slot at the same time, the data is silently not cached. */
+	void Put(cChunkCoords a_Coords, const T & a_Data)
+	{
+		auto & Set = GetSet(a_Coords);
+
+		// If another thread has cached the same chunk in the meantime, there's nothing to do:
+		for (const auto & Slot: Set.m_Slots)
+		{
+			if (
+				(Slot.m_ChunkX.load(std::memory_order_relaxed) == a_Coords.m_ChunkX) &&
+				(Slot.m_ChunkZ.load(std::memory_order_relaxed) == a_Coords.m_ChunkZ)
+			)
+			{
+				return;
+			}
+		}
+
+		// Pick a victim using the CLOCK algorithm; two sweeps are enough to find one even if all slots are referenced:
+		size_t Victim = 0;
+		for (size_t i = 0; i < 2 * NUM_WAYS; i++)
+		{
+			Victim = Set.m_ClockHand.fetch_add(1, std::memory_order_relaxed) % NUM_WAYS;
+			if (!Set.m_Slots[Victim].m_IsReferenced.exchange(false, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+
+		// Lock the slot for writing by making its sequence number odd:
+		auto & Slot = Set.m_Slots[Victim];
+		auto Seq = Slot.m_Sequence.load(std::memory_order_relaxed);
+		if (((Seq & 1) != 0) || !Slot.m_Sequence.compare_exchange_strong(Seq, Seq + 1, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			// Another writer is in there, don't wait for it:
+			return;
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+
+		Slot.m_ChunkX.store(a_Coords.m_ChunkX, std::memory_order_relaxed);
+		Slot.m_ChunkZ.store(a_Coords.m_ChunkZ, std::memory_order_relaxed);
+		memcpy(&Slot.m_Data, &a_Data, sizeof(T));
+		Slot.m_IsReferenced.store(false, std::memory_order_relaxed);
+
+		// Unlock:
+		Slot.m_Sequence.store(Seq + 2, std::memory_order_release);
+	}
+
+
+	/** Returns the number of lookups that found their data in the cache. */
+	size_t GetNumHits(void) const { return m_NumHits.load(std::memory_order_relaxed); }
+
+	/** Returns the number of lookups that didn't find their data in the cache. */
+	size_t GetNumMisses(void) const { return m_NumMisses.load(std::memory_order_relaxed); }
+
+protected:
+
+	struct cSlot
+	{
+		/** Sequence lock counter. Odd while the slot is being written. */
+		std::atomic<UInt32> m_Sequence;
+
+		/** The CLOCK "referenced" bit, set on each hit. */
+		mutable std::atomic<bool> m_IsReferenced;
+
+		/** Coords of the chunk whose data is stored in the slot. */
+		std::atomic<int> m_ChunkX;
+		std::atomic<int> m_ChunkZ;
+
+		/** The cached data itself. */
+		T m_Data;
+
+		/** Fill in bogus coords so that the slot is not used until properly calculated. */
+		cSlot(void):
+			m_Sequence(0),
+			m_IsReferenced(false),
+			m_ChunkX(0x7fffffff),
+			m_ChunkZ(0x7fffffff)
+		{
+		}
+	};
+
+
+	struct cSet
+	{
+		cSlot m_Slots[NUM_WAYS];
+
+		/** The CLOCK hand, points to the next eviction candidate (modulo NUM_WAYS). */
+		std::atomic<UInt8> m_ClockHand;
+
+		cSet(void):
+			m_ClockHand(0)
+		{
+		}
+	};
+
+
+	/** The sets (shards) of the cache, (m_SetMask + 1) of them. */
+	std::unique_ptr<cSet[]> m_Sets;
+
+	/** Mask to apply to the hashed chunk coords to get the set index. */
+	size_t m_SetMask;
+
+	// Cache statistics:
+	mutable std::atomic<size_t> m_NumHits;
+	mutable std::atomic<size_t> m_NumMisses;
+
+
+	/** Returns the set into which the specified chunk coords hash. */
+	cSet & GetSet(cChunkCoords a_Coords) const
+	{
+		// Multiplicative hashing, so that neighbouring chunks end up in different sets:
+		auto Hash = (static_cast<UInt32>(a_Coords.m_ChunkX) * 0x9e3779b1u) ^ (static_cast<UInt32>(a_Coords.m_ChunkZ) * 0x85ebca77u);
+		Hash ^= Hash >> 15;
+		return m_Sets[Hash & m_SetMask];
+	}
+};
+
+
+
+
@@ -108,17 +108,8 @@ void cHeiGenFlat::InitializeHeightGen(cIniFile & a_IniFile)
 
 cHeiGenCache::cHeiGenCache(cTerrainHeightGen & a_HeiGenToCache, size_t a_CacheSize) :
 	m_HeiGenToCache(a_HeiGenToCache),
-	m_CacheSize(a_CacheSize),
-	m_NumHits(0),
-	m_NumMisses(0),
-	m_TotalChain(0)
+	m_Cache(a_CacheSize)
 {
-	m_CacheOrder.resize(a_CacheSize);
-	m_CacheData.resize(a_CacheSize);
-	for (size_t i = 0; i < m_CacheSize; i++)
-	{
-		m_CacheOrder[i] = i;
-	}
 }
 
 
@@ -127,51 +118,14 @@ cHeiGenCache::cHeiGenCache(cTerrainHeightGen & a_HeiGenToCache, size_t a_CacheSi
 
 void cHeiGenCache::GenHeightMap(cChunkCoords a_ChunkCoords, cChunkDef::HeightMap & a_HeightMap)
 {
-	/*
-	if (((m_NumHits + m_NumMisses) % 1024) == 10)
-	{
-		LOGD("HeiGenCache: %d hits, %d misses, saved %.2f %%", m_NumHits, m_NumMisses, 100.0 * m_NumHits / (m_NumHits + m_NumMisses));
-		LOGD("HeiGenCache: Avg cache chain length: %.2f", static_cast<double>(m_TotalChain) / m_NumHits);
-	}
-	//*/
-
-	for (size_t i = 0; i < m_CacheSize; i++)
+	if (m_Cache.Get(a_ChunkCoords, a_HeightMap))
 	{
-		if (m_CacheData[m_CacheOrder[i]].m_Coords != a_ChunkCoords)
-		{
-			continue;
-		}
-		// Found it in the cache
-		auto Idx = m_CacheOrder[i];
-
-		// Move to front:
-		for (size_t j = i; j > 0; j--)
-		{
-			m_CacheOrder[j] = m_CacheOrder[j - 1];
-		}
-		m_CacheOrder[0] = Idx;
-
-		// Use the cached data:
-		memcpy(a_HeightMap, m_CacheData[Idx].m_HeightMap, sizeof(a_HeightMap));
-
-		m_NumHits++;
-		m_TotalChain += i;
 		return;
-	}  // for i - cache
+	}
 
 	// Not in the cache:
-	m_NumMisses++;
 	m_HeiGenToCache.GenHeightMap(a_ChunkCoords, a_HeightMap);
-
-	// Insert it as the first item in the MRU order:
-	auto Idx = m_CacheOrder[m_CacheSize - 1];
-	for (auto i = m_CacheSize - 1; i > 0; i--)
-	{
-		m_CacheOrder[i] = m_CacheOrder[i - 1];
-	}  // for i - m_CacheOrder[]
-	m_CacheOrder[0] = Idx;
-	memcpy(m_CacheData[Idx].m_HeightMap, a_HeightMap, sizeof(a_HeightMap));
-	m_CacheData[Idx].m_Coords = a_ChunkCoords;
+	m_Cache.Put(a_ChunkCoords, a_HeightMap);
 }
 
 
@@ -201,15 +155,12 @@ HEIGHTTYPE cHeiGenCache::GetHeightAt(int a_BlockX, int a_BlockZ)
 
 bool cHeiGenCache::GetHeightAt(int a_ChunkX, int a_ChunkZ, int a_RelX, int a_RelZ, HEIGHTTYPE & a_Height)
 {
-	for (size_t i = 0; i < m_CacheSize; i++)
-	{
-		if ((m_CacheData[i].m_Coords.m_ChunkX == a_ChunkX) && (m_CacheData[i].m_Coords.m_ChunkZ == a_ChunkZ))
+	// Only copy out the single value, not the whole heightmap:
+	return m_Cache.Read({a_ChunkX, a_ChunkZ}, [&](const cChunkDef::HeightMap & a_HeightMap)
 		{
-			a_Height = cChunkDef::GetHeight(m_CacheData[i].m_HeightMap, a_RelX, a_RelZ);
-			return true;
+			a_Height = cChunkDef::GetHeight(a_HeightMap, a_RelX, a_RelZ);
 		}
-	}  // for i - m_CacheData[]
-	return false;
+	);
 }
 
 
@@ -220,15 +171,9 @@ bool cHeiGenCache::GetHeightAt(int a_ChunkX, int a_ChunkZ, int a_RelX, int a_Rel
 // cHeiGenMultiCache:
 
 cHeiGenMultiCache::cHeiGenMultiCache(std::unique_ptr<cTerrainHeightGen> a_HeiGenToCache, size_t a_SubCacheSize, size_t a_NumSubCaches):
-	m_NumSubCaches(a_NumSubCaches),
-	m_Underlying(std::move(a_HeiGenToCache))
+	m_Underlying(std::move(a_HeiGenToCache)),
+	m_Cache(*m_Underlying, a_SubCacheSize * std::max<size_t>(a_NumSubCaches, 1))
 {
-	// Create the individual sub-caches:
-	m_SubCaches.reserve(a_NumSubCaches);
-	for (size_t i = 0; i < a_NumSubCaches; i++)
-	{
-		m_SubCaches.push_back(std::make_unique<cHeiGenCache>(*m_Underlying, a_SubCacheSize));
-	}
 }
 
 
@@ -237,11 +182,7 @@ cHeiGenMultiCache::cHeiGenMultiCache(std::unique_ptr<cTerrainHeightGen> a_HeiGen
 
 void cHeiGenMultiCache::GenHeightMap(cChunkCoords a_ChunkCoords, cChunkDef::HeightMap & a_HeightMap)
 {
-	// Get the subcache responsible for this chunk:
-	const size_t cacheIdx = (static_cast<size_t>(a_ChunkCoords.m_ChunkX) + m_CoeffZ * static_cast<size_t>(a_ChunkCoords.m_ChunkZ)) % m_NumSubCaches;
-
-	// Ask the subcache:
-	m_SubCaches[cacheIdx]->GenHeightMap(a_ChunkCoords, a_HeightMap);
+	m_Cache.GenHeightMap(a_ChunkCoords, a_HeightMap);
 }
 
 
@@ -250,19 +191,7 @@ void cHeiGenMultiCache::GenHeightMap(cChunkCoords a_ChunkCoords, cChunkDef::Heig
 
 HEIGHTTYPE cHeiGenMultiCache::GetHeightAt(int a_BlockX, int a_BlockZ)
 {
-	// First try if the chunk is already in the cache:
-	int chunkX, chunkZ;
-	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, chunkX, chunkZ);
-	HEIGHTTYPE res;
-	if (GetHeightAt(chunkX, chunkZ, a_BlockX - chunkX * cChunkDef::Width, a_BlockZ - chunkZ * cChunkDef::Width, res))
-	{
-		return res;
-	}
-
-	// Chunk not in cache, generate the chunk and ask again:
-	cChunkDef::HeightMap heightMap;
-	GenHeightMap({chunkX, chunkZ}, heightMap);
-	return cChunkDef::GetHeight(heightMap, a_BlockX - chunkX * cChunkDef::Width, a_BlockZ - chunkZ * cChunkDef::Width);
+	return m_Cache.GetHeightAt(a_BlockX, a_BlockZ);
 }
 
 
@@ -271,11 +200,7 @@ HEIGHTTYPE cHeiGenMultiCache::GetHeightAt(int a_BlockX, int a_BlockZ)
 
 bool cHeiGenMultiCache::GetHeightAt(int a_ChunkX, int a_ChunkZ, int a_RelX, int a_RelZ, HEIGHTTYPE & a_Height)
 {
-	// Get the subcache responsible for this chunk:
-	const size_t cacheIdx = (static_cast<size_t>(a_ChunkX) + m_CoeffZ * static_cast<size_t>(a_ChunkZ)) % m_NumSubCaches;
-
-	// Ask the subcache:
-	return m_SubCaches[cacheIdx]->GetHeightAt(a_ChunkX, a_ChunkZ, a_RelX, a_RelZ, a_Height);
+	return m_Cache.GetHeightAt(a_ChunkX, a_ChunkZ, a_RelX, a_RelZ, a_Height);
 }
 
 
@@ -17,13 +17,15 @@ Also implements the heightmap cache
 #pragma once
 
 #include "ComposableGenerator.h"
+#include "GenCache.h"
 #include "../Noise/Noise.h"
 
 
 
 
 
-/** A simple cache that stores N most recently generated chunks' heightmaps; N being settable upon creation */
+/** A cache that stores the most recently generated chunks' heightmaps, N slots being settable upon creation.
+The cache is lock-free and safe to use from multiple threads at once, see cGenCache for details. */
 class cHeiGenCache :
 	public cTerrainHeightGen
 {
@@ -37,37 +39,28 @@ public:
 	/** Retrieves height at the specified point in the cache, returns true if found, false if not found */
 	bool GetHeightAt(int a_ChunkX, int a_ChunkZ, int a_RelX, int a_RelZ, HEIGHTTYPE & a_Height);
 
-protected:
-	struct sCacheData
-	{
-		cChunkCoords m_Coords;
-		cChunkDef::HeightMap m_HeightMap;
+	/** Returns the number of lookups that were served from the cache. */
+	size_t GetNumHits(void) const { return m_Cache.GetNumHits(); }
 
-		/** Default constructor: Fill in bogus coords, so that the item is not used until properly calculated. */
-		sCacheData():
-			m_Coords(0x7fffffff, 0x7fffffff)
-		{}
-	} ;
+	/** Returns the number of lookups that had to be generated by the underlying generator. */
+	size_t GetNumMisses(void) const { return m_Cache.GetNumMisses(); }
+
+protected:
 
 	/** The terrain height generator that is being cached. */
 	cTerrainHeightGen & m_HeiGenToCache;
 
-	// To avoid moving large amounts of data for the MRU behavior, we MRU-ize indices to an array of the actual data
-	size_t                  m_CacheSize;
-	std::vector<size_t>     m_CacheOrder;  // MRU-ized order, indices into m_CacheData array
-	std::vector<sCacheData> m_CacheData;   // m_CacheData[m_CacheOrder[0]] is the most recently used
-
-	// Cache statistics
-	size_t m_NumHits;
-	size_t m_NumMisses;
-	size_t m_TotalChain;  // Number of cache items walked to get to a hit (only added for hits)
+	/** The cached heightmaps. */
+	cGenCache<cChunkDef::HeightMap> m_Cache;
 } ;
 
 
 
 
 
-/** Caches heightmaps in multiple underlying caches to improve the distribution and lower the chain length. */
+/** A heightmap cache that owns its underlying height generator.
+Historically this divided the caching into multiple MRU sub-caches to improve the distribution and lower the chain length.
+cHeiGenCache is sharded by itself now, so this is a single cache of (a_SubCacheSize * a_NumSubCaches) slots. */
 class cHeiGenMultiCache:
 	public cTerrainHeightGen
 {
@@ -81,19 +74,19 @@ public:
 	/** Retrieves height at the specified point in the cache, returns true if found, false if not found */
 	bool GetHeightAt(int a_ChunkX, int a_ChunkZ, int a_RelX, int a_RelZ, HEIGHTTYPE & a_Height);
 
-protected:
-
-	/** The coefficient used to turn Z coords into index (x + Coeff * z). */
-	static const size_t m_CoeffZ = 5;
+	/** Returns the number of lookups that were served from the cache. */
+	size_t GetNumHits(void) const { return m_Cache.GetNumHits(); }
 
-	/** Number of sub-caches, pulled out of m_SubCaches.size() for performance reasons. */
-	size_t m_NumSubCaches;
+	/** Returns the number of lookups that had to be generated by the underlying generator. */
+	size_t GetNumMisses(void) const { return m_Cache.GetNumMisses(); }
 
-	/** The individual sub-caches. */
-	std::vector<std::unique_ptr<cHeiGenCache>> m_SubCaches;
+protected:
 
 	/** The underlying height generator. */
 	std::unique_ptr<cTerrainHeightGen> m_Underlying;
+
+	/** The cache over m_Underlying. */
+	cHeiGenCache m_Cache;
 };
 
 
@@ -101,6 +101,8 @@ bool cHTTPServer::Initialize(void)
 				auto Config = cSslConfig::MakeDefaultConfig(false);
 				Config->SetOwnCert(Cert, CertPrivKey);
 				m_SslConfig = std::move(Config);
+				m_SslCert = std::move(Cert);
+				m_SslKeyData = std::move(KeyFile);
 			}
 			else
 			{
@@ -186,6 +188,25 @@ void cHTTPServer::Stop(void)
 
 
 
+std::shared_ptr<const cSslConfig> cHTTPServer::MakeConnectionSslConfig(void) const
+{
+	auto PrivKey = std::make_shared<cCryptoKey>();
+	int res = PrivKey->ParsePrivate(m_SslKeyData.data(), m_SslKeyData.size(), "");
+	if (res != 0)
+	{
+		// The same data has already been parsed successfully in Initialize()
+		LOGWARNING("WebServer: Cannot read HTTPS certificate private key: -0x%x", -res);
+		return nullptr;
+	}
+	auto Config = cSslConfig::MakeDefaultConfig(false);
+	Config->SetOwnCert(m_SslCert, std::move(PrivKey));
+	return Config;
+}
+
+
+
+
+
 cTCPLink::cCallbacksPtr cHTTPServer::OnIncomingConnection(const AString & a_RemoteIPAddress, UInt16 a_RemotePort)
 {
 	UNUSED(a_RemoteIPAddress);
@@ -193,7 +214,7 @@ cTCPLink::cCallbacksPtr cHTTPServer::OnIncomingConnection(const AString & a_Remo
 
 	if (m_SslConfig != nullptr)
 	{
-		return std::make_shared<cSslHTTPServerConnection>(*this, m_SslConfig);
+		return std::make_shared<cSslHTTPServerConnection>(*this, MakeConnectionSslConfig());
 	}
 	else
 	{
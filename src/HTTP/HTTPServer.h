@@ -70,9 +70,21 @@ protected:
 	/** The callbacks to call for various events */
 	cCallbacks * m_Callbacks;
 
-	/** Configuration for server ssl connections. */
+	/** Configuration for server ssl connections, nullptr if HTTPS is disabled.
+	The connections don't use it directly, each one gets its own config from MakeConnectionSslConfig(). */
 	std::shared_ptr<const cSslConfig> m_SslConfig;
 
+	/** The HTTPS certificate, shared by all the ssl connections. */
+	cX509CertPtr m_SslCert;
+
+	/** The HTTPS private key file contents, parsed anew for each ssl connection. */
+	AString m_SslKeyData;
+
+
+	/** Creates the ssl config for a new connection, with its own copy of the private key.
+	mbedTLS updates the key's blinding values on each use without any locking, and the connections may run
+	on different network event loops, so they cannot share the key. */
+	std::shared_ptr<const cSslConfig> MakeConnectionSslConfig(void) const;
 
 	/** Called by cHTTPServerListenCallbacks when there's a new incoming connection.
 	Returns the connection instance to be used as the cTCPLink callbacks. */
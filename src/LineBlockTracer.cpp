@@ -14,6 +14,32 @@
 
 
 
+/** cBlockInfo::IsSolid() for all block types, precomputed so that the solid hit trace needs a single bit test per block. */
+static const std::bitset<256> g_IsSolidBlock = []()
+{
+	std::bitset<256> Res;
+	for (size_t i = 0; i < Res.size(); i++)
+	{
+		Res[i] = cBlockInfo::IsSolid(static_cast<BLOCKTYPE>(i));
+	}
+	return Res;
+}();
+
+
+
+
+
+/** Returns the line coefficient at which a line, starting at a_Start and moving by a_InvDiff ^ -1,
+crosses the wall of block a_Current in the direction a_Dir. */
+static inline double CalcNextWallCoeff(int a_Current, int a_Dir, double a_Start, double a_InvDiff)
+{
+	return (a_Current + ((a_Dir > 0) ? 1 : 0) - a_Start) * a_InvDiff;
+}
+
+
+
+
+
 cLineBlockTracer::cLineBlockTracer(cWorld & a_World, cCallbacks & a_Callbacks) :
 	Super(a_World, a_Callbacks),
 	m_Start(),
@@ -21,7 +47,9 @@ cLineBlockTracer::cLineBlockTracer(cWorld & a_World, cCallbacks & a_Callbacks) :
 	m_Diff(),
 	m_Dir(),
 	m_Current(),
-	m_CurrentFace(BLOCK_FACE_NONE)
+	m_CurrentFace(BLOCK_FACE_NONE),
+	m_NextWallCoeff(),
+	m_InvDiff()
 {
 }
 
@@ -39,6 +67,16 @@ bool cLineBlockTracer::Trace(cWorld & a_World, cBlockTracer::cCallbacks & a_Call
 
 
 
+bool cLineBlockTracer::Trace(cChunk & a_Chunk, cBlockTracer::cCallbacks & a_Callbacks, const Vector3d a_Start, const Vector3d a_End)
+{
+	cLineBlockTracer Tracer(*a_Chunk.GetWorld(), a_Callbacks);
+	return Tracer.Trace(a_Chunk, a_Start, a_End);
+}
+
+
+
+
+
 bool cLineBlockTracer::LineOfSightTrace(cWorld & a_World, const Vector3d & a_Start, const Vector3d & a_End, int a_Sight)
 {
 	static class LineOfSightCallbacks:
@@ -78,6 +116,54 @@ bool cLineBlockTracer::LineOfSightTrace(cWorld & a_World, const Vector3d & a_Sta
 
 
 
+/** The callbacks for FirstSolidHitTrace(): stop at the first solid block and calculate the exact hit point. */
+class cSolidHitCallbacks:
+	public cBlockTracer::cCallbacks
+{
+public:
+	cSolidHitCallbacks(const Vector3d & a_CBStart, const Vector3d & a_CBEnd, Vector3d & a_CBHitCoords, Vector3i & a_CBHitBlockCoords, eBlockFace & a_CBHitBlockFace):
+		m_Start(a_CBStart),
+		m_End(a_CBEnd),
+		m_HitCoords(a_CBHitCoords),
+		m_HitBlockCoords(a_CBHitBlockCoords),
+		m_HitBlockFace(a_CBHitBlockFace)
+	{
+	}
+
+	virtual bool OnNextBlock(Vector3i a_BlockPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, eBlockFace a_EntryFace) override
+	{
+		if (!g_IsSolidBlock[a_BlockType])
+		{
+			return false;
+		}
+
+		// We hit a solid block, calculate the exact hit coords and abort trace:
+		m_HitBlockCoords = a_BlockPos;
+		m_HitBlockFace = a_EntryFace;
+		cBoundingBox bb(a_BlockPos, a_BlockPos + Vector3i(1, 1, 1));  // Bounding box of the block hit
+		double LineCoeff = 0;  // Used to calculate where along the line an intersection with the bounding box occurs
+		eBlockFace Face;  // Face hit
+		if (!bb.CalcLineIntersection(m_Start, m_End, LineCoeff, Face))
+		{
+			// Math rounding errors have caused the calculation to miss the block completely, assume immediate hit
+			LineCoeff = 0;
+		}
+		m_HitCoords = m_Start + (m_End - m_Start) * LineCoeff;  // Point where projectile goes into the hit block
+		return true;
+	}
+
+protected:
+	const Vector3d & m_Start;
+	const Vector3d & m_End;
+	Vector3d & m_HitCoords;
+	Vector3i & m_HitBlockCoords;
+	eBlockFace & m_HitBlockFace;
+};
+
+
+
+
+
 bool cLineBlockTracer::FirstSolidHitTrace(
 	cWorld & a_World,
 	const Vector3d & a_Start, const Vector3d & a_End,
@@ -85,49 +171,23 @@ bool cLineBlockTracer::FirstSolidHitTrace(
 	Vector3i & a_HitBlockCoords, eBlockFace & a_HitBlockFace
 )
 {
-	class cSolidHitCallbacks:
-		public cCallbacks
-	{
-	public:
-		cSolidHitCallbacks(const Vector3d & a_CBStart, const Vector3d & a_CBEnd, Vector3d & a_CBHitCoords, Vector3i & a_CBHitBlockCoords, eBlockFace & a_CBHitBlockFace):
-			m_Start(a_CBStart),
-			m_End(a_CBEnd),
-			m_HitCoords(a_CBHitCoords),
-			m_HitBlockCoords(a_CBHitBlockCoords),
-			m_HitBlockFace(a_CBHitBlockFace)
-		{
-		}
+	cSolidHitCallbacks Callbacks(a_Start, a_End, a_HitCoords, a_HitBlockCoords, a_HitBlockFace);
+	return !Trace(a_World, Callbacks, a_Start, a_End);
+}
+
 
-		virtual bool OnNextBlock(Vector3i a_BlockPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, eBlockFace a_EntryFace) override
-		{
-			if (!cBlockInfo::IsSolid(a_BlockType))
-			{
-				return false;
-			}
 
-			// We hit a solid block, calculate the exact hit coords and abort trace:
-			m_HitBlockCoords = a_BlockPos;
-			m_HitBlockFace = a_EntryFace;
-			cBoundingBox bb(a_BlockPos, a_BlockPos + Vector3i(1, 1, 1));  // Bounding box of the block hit
-			double LineCoeff = 0;  // Used to calculate where along the line an intersection with the bounding box occurs
-			eBlockFace Face;  // Face hit
-			if (!bb.CalcLineIntersection(m_Start, m_End, LineCoeff, Face))
-			{
-				// Math rounding errors have caused the calculation to miss the block completely, assume immediate hit
-				LineCoeff = 0;
-			}
-			m_HitCoords = m_Start + (m_End - m_Start) * LineCoeff;  // Point where projectile goes into the hit block
-			return true;
-		}
 
-	protected:
-		const Vector3d & m_Start;
-		const Vector3d & m_End;
-		Vector3d & m_HitCoords;
-		Vector3i & m_HitBlockCoords;
-		eBlockFace & m_HitBlockFace;
-	} callbacks(a_Start, a_End, a_HitCoords, a_HitBlockCoords, a_HitBlockFace);
-	return !Trace(a_World, callbacks, a_Start, a_End);
+
+bool cLineBlockTracer::FirstSolidHitTrace(
+	cChunk & a_Chunk,
+	const Vector3d & a_Start, const Vector3d & a_End,
+	Vector3d & a_HitCoords,
+	Vector3i & a_HitBlockCoords, eBlockFace & a_HitBlockFace
+)
+{
+	cSolidHitCallbacks Callbacks(a_Start, a_End, a_HitCoords, a_HitBlockCoords, a_HitBlockFace);
+	return !Trace(a_Chunk, Callbacks, a_Start, a_End);
 }
 
 
@@ -135,6 +195,46 @@ bool cLineBlockTracer::FirstSolidHitTrace(
 
 
 bool cLineBlockTracer::Trace(const Vector3d a_Start, const Vector3d a_End)
+{
+	if (!InitTrace(a_Start, a_End))
+	{
+		return true;
+	}
+
+	// The actual trace is handled with ChunkMapCS locked by calling our ChunkCallback for the specified chunk
+	int BlockX = FloorC(m_Start.x);
+	int BlockZ = FloorC(m_Start.z);
+	int ChunkX, ChunkZ;
+	cChunkDef::BlockToChunk(BlockX, BlockZ, ChunkX, ChunkZ);
+	return m_World->DoWithChunk(ChunkX, ChunkZ, [this](cChunk & a_Chunk) { return ChunkCallback(&a_Chunk); });
+}
+
+
+
+
+
+bool cLineBlockTracer::Trace(cChunk & a_Chunk, const Vector3d a_Start, const Vector3d a_End)
+{
+	if (!InitTrace(a_Start, a_End))
+	{
+		return true;
+	}
+
+	// Walk the neighbors to the chunk containing the (adjusted) start, no chunkmap lookup needed for nearby chunks:
+	auto StartChunk = a_Chunk.GetNeighborChunk(m_Current.x, m_Current.z);
+	if (StartChunk == nullptr)
+	{
+		m_Callbacks->OnNoChunk();
+		return false;
+	}
+	return ChunkCallback(StartChunk);
+}
+
+
+
+
+
+bool cLineBlockTracer::InitTrace(const Vector3d a_Start, const Vector3d a_End)
 {
 	// Initialize the member veriables:
 	m_Start = a_Start;
@@ -151,7 +251,7 @@ bool cLineBlockTracer::Trace(const Vector3d a_Start, const Vector3d a_End)
 		{
 			// Nothing to trace
 			m_Callbacks->OnNoMoreHits();
-			return true;
+			return false;
 		}
 		FixStartBelowWorld();
 		m_Callbacks->OnIntoWorld(m_Start);
@@ -161,7 +261,7 @@ bool cLineBlockTracer::Trace(const Vector3d a_Start, const Vector3d a_End)
 		if (m_End.y >= cChunkDef::Height)
 		{
 			m_Callbacks->OnNoMoreHits();
-			return true;
+			return false;
 		}
 		FixStartAboveWorld();
 		m_Callbacks->OnIntoWorld(m_Start);
@@ -171,12 +271,16 @@ bool cLineBlockTracer::Trace(const Vector3d a_Start, const Vector3d a_End)
 
 	m_Diff = m_End -  m_Start;
 
-	// The actual trace is handled with ChunkMapCS locked by calling our ChunkCallback for the specified chunk
-	int BlockX = FloorC(m_Start.x);
-	int BlockZ = FloorC(m_Start.z);
-	int ChunkX, ChunkZ;
-	cChunkDef::BlockToChunk(BlockX, BlockZ, ChunkX, ChunkZ);
-	return m_World->DoWithChunk(ChunkX, ChunkZ, [this](cChunk & a_Chunk) { return ChunkCallback(&a_Chunk); });
+	// Precalculate the voxel walk; axes with (nearly) no movement never reach their next wall:
+	static const double EPS = 0.00001;
+	const auto Infinity = std::numeric_limits<double>::infinity();
+	m_InvDiff.x = (std::abs(m_Diff.x) > EPS) ? (1 / m_Diff.x) : 0;
+	m_InvDiff.y = (std::abs(m_Diff.y) > EPS) ? (1 / m_Diff.y) : 0;
+	m_InvDiff.z = (std::abs(m_Diff.z) > EPS) ? (1 / m_Diff.z) : 0;
+	m_NextWallCoeff.x = (m_InvDiff.x != 0) ? CalcNextWallCoeff(m_Current.x, m_Dir.x, m_Start.x, m_InvDiff.x) : Infinity;
+	m_NextWallCoeff.y = (m_InvDiff.y != 0) ? CalcNextWallCoeff(m_Current.y, m_Dir.y, m_Start.y, m_InvDiff.y) : Infinity;
+	m_NextWallCoeff.z = (m_InvDiff.z != 0) ? CalcNextWallCoeff(m_Current.z, m_Dir.z, m_Start.z, m_InvDiff.z) : Infinity;
+	return true;
 }
 
 
@@ -219,59 +323,38 @@ void cLineBlockTracer::CalcXZIntersection(double a_Y, double & a_IntersectX, dou
 
 bool cLineBlockTracer::MoveToNextBlock(void)
 {
-	// Find out which of the current block's walls gets hit by the path:
-	static const double EPS = 0.00001;
-	enum
-	{
-		dirNONE,
-		dirX,
-		dirY,
-		dirZ,
-	} Direction = dirNONE;
-
-	// Calculate the next YZ wall hit:
-	double Coeff = 1;
-	if (std::abs(m_Diff.x) > EPS)
+	// Find out which of the current block's walls gets hit by the path first.
+	// On a tie, Z wins over Y and Y over X, same as when the walls were compared one by one:
+	const auto & Coeff = m_NextWallCoeff;
+	const bool IsYBeforeX = (Coeff.y <= Coeff.x);
+	const double MinXY = IsYBeforeX ? Coeff.y : Coeff.x;
+	const bool IsZFirst = (Coeff.z <= MinXY);
+	const double MinCoeff = IsZFirst ? Coeff.z : MinXY;
+
+	// We need to include equality for the last block in the trace:
+	if (MinCoeff > 1)
 	{
-		double DestX = (m_Dir.x > 0) ? (m_Current.x + 1) : m_Current.x;
-		double CoeffX = (DestX - m_Start.x) / m_Diff.x;
-		if (CoeffX <= 1)  // We need to include equality for the last block in the trace
-		{
-			Coeff = CoeffX;
-			Direction = dirX;
-		}
+		return false;
 	}
 
-	// If the next XZ wall hit is closer, use it instead:
-	if (std::abs(m_Diff.y) > EPS)
+	// Based on the wall hit, adjust the current coords and the next wall on that axis:
+	if (IsZFirst)
 	{
-		double DestY = (m_Dir.y > 0) ? (m_Current.y + 1) : m_Current.y;
-		double CoeffY = (DestY - m_Start.y) / m_Diff.y;
-		if (CoeffY <= Coeff)  // We need to include equality for the last block in the trace
-		{
-			Coeff = CoeffY;
-			Direction = dirY;
-		}
+		m_Current.z += m_Dir.z;
+		m_CurrentFace = (m_Dir.z > 0) ? BLOCK_FACE_ZM : BLOCK_FACE_ZP;
+		m_NextWallCoeff.z = CalcNextWallCoeff(m_Current.z, m_Dir.z, m_Start.z, m_InvDiff.z);
 	}
-
-	// If the next XY wall hit is closer, use it instead:
-	if (std::abs(m_Diff.z) > EPS)
+	else if (IsYBeforeX)
 	{
-		double DestZ = (m_Dir.z > 0) ? (m_Current.z + 1) : m_Current.z;
-		double CoeffZ = (DestZ - m_Start.z) / m_Diff.z;
-		if (CoeffZ <= Coeff)  // We need to include equality for the last block in the trace
-		{
-			Direction = dirZ;
-		}
+		m_Current.y += m_Dir.y;
+		m_CurrentFace = (m_Dir.y > 0) ? BLOCK_FACE_YM : BLOCK_FACE_YP;
+		m_NextWallCoeff.y = CalcNextWallCoeff(m_Current.y, m_Dir.y, m_Start.y, m_InvDiff.y);
 	}
-
-	// Based on the wall hit, adjust the current coords
-	switch (Direction)
+	else
 	{
-		case dirX:    m_Current.x += m_Dir.x; m_CurrentFace = (m_Dir.x > 0) ? BLOCK_FACE_XM : BLOCK_FACE_XP; break;
-		case dirY:    m_Current.y += m_Dir.y; m_CurrentFace = (m_Dir.y > 0) ? BLOCK_FACE_YM : BLOCK_FACE_YP; break;
-		case dirZ:    m_Current.z += m_Dir.z; m_CurrentFace = (m_Dir.z > 0) ? BLOCK_FACE_ZM : BLOCK_FACE_ZP; break;
-		case dirNONE: return false;
+		m_Current.x += m_Dir.x;
+		m_CurrentFace = (m_Dir.x > 0) ? BLOCK_FACE_XM : BLOCK_FACE_XP;
+		m_NextWallCoeff.x = CalcNextWallCoeff(m_Current.x, m_Dir.x, m_Start.x, m_InvDiff.x);
 	}
 	return true;
 }
@@ -312,12 +395,19 @@ bool cLineBlockTracer::ChunkCallback(cChunk * a_Chunk)
 			return true;
 		}
 
-		// Update the current chunk
-		a_Chunk = a_Chunk->GetNeighborChunk(m_Current.x, m_Current.z);
-		if (a_Chunk == nullptr)
+		// Update the current chunk, only when the line leaves it:
+		int RelX = m_Current.x - a_Chunk->GetPosX() * cChunkDef::Width;
+		int RelZ = m_Current.z - a_Chunk->GetPosZ() * cChunkDef::Width;
+		if ((RelX < 0) || (RelX >= cChunkDef::Width) || (RelZ < 0) || (RelZ >= cChunkDef::Width))
 		{
-			m_Callbacks->OnNoChunk();
-			return false;
+			a_Chunk = a_Chunk->GetRelNeighborChunk(RelX, RelZ);
+			if (a_Chunk == nullptr)
+			{
+				m_Callbacks->OnNoChunk();
+				return false;
+			}
+			RelX = m_Current.x - a_Chunk->GetPosX() * cChunkDef::Width;
+			RelZ = m_Current.z - a_Chunk->GetPosZ() * cChunkDef::Width;
 		}
 
 		// Report the current block through the callbacks:
@@ -325,8 +415,6 @@ bool cLineBlockTracer::ChunkCallback(cChunk * a_Chunk)
 		{
 			BLOCKTYPE BlockType;
 			NIBBLETYPE BlockMeta;
-			int RelX = m_Current.x - a_Chunk->GetPosX() * cChunkDef::Width;
-			int RelZ = m_Current.z - a_Chunk->GetPosZ() * cChunkDef::Width;
 			a_Chunk->GetBlockTypeMeta(RelX, m_Current.y, RelZ, BlockType, BlockMeta);
 			if (m_Callbacks->OnNextBlock(m_Current, BlockType, BlockMeta, m_CurrentFace))
 			{
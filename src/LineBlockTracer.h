@@ -47,12 +47,21 @@ public:
 	/** Traces one line between Start and End; returns true if the entire line was traced (until OnNoMoreHits()) */
 	bool Trace(Vector3d a_Start, Vector3d a_End);
 
+	/** Traces one line between Start and End, starting the chunk walk from a_Chunk (or its neighbor containing a_Start)
+	instead of looking the chunk up in the world. For callers that already have the chunk and hold the chunkmap lock,
+	such as the entity physics. Returns true if the entire line was traced (until OnNoMoreHits()) */
+	bool Trace(cChunk & a_Chunk, Vector3d a_Start, Vector3d a_End);
+
 
 	// Utility functions for simple one-line usage:
 
 	/** Traces one line between Start and End; returns true if the entire line was traced (until OnNoMoreHits()) */
 	static bool Trace(cWorld & a_World, cCallbacks & a_Callbacks, const Vector3d a_Start, const Vector3d a_End);
 
+	/** Traces one line between Start and End, starting from the specified chunk; see the Trace(cChunk &, ...) member.
+	Returns true if the entire line was traced (until OnNoMoreHits()) */
+	static bool Trace(cChunk & a_Chunk, cCallbacks & a_Callbacks, const Vector3d a_Start, const Vector3d a_End);
+
 	/** Returns true if the two positions are within line of sight (not obscured by blocks).
 	a_Sight specifies which blocks are considered transparent for the trace, is an OR-combination of eLineOfSight constants. */
 	static bool LineOfSightTrace(cWorld & a_World, const Vector3d & a_Start, const Vector3d & a_End, int a_Sight);
@@ -71,6 +80,16 @@ public:
 		eBlockFace & a_HitBlockFace
 	);
 
+	/** Same as the cWorld-based FirstSolidHitTrace(), but starts the chunk walk from the specified chunk
+	instead of looking the chunk up in the world. To be used with the chunkmap lock held, such as in the entity physics. */
+	static bool FirstSolidHitTrace(
+		cChunk & a_Chunk,
+		const Vector3d & a_Start, const Vector3d & a_End,
+		Vector3d & a_HitCoords,
+		Vector3i & a_HitBlockCoords,
+		eBlockFace & a_HitBlockFace
+	);
+
 protected:
 	/** The start point of the trace */
 	Vector3d m_Start;
@@ -90,6 +109,18 @@ protected:
 	/** The face through which the current block has been entered */
 	eBlockFace m_CurrentFace;
 
+	/** For each axis, the line coefficient at which the line crosses the next block wall perpendicular to that axis.
+	Infinity for the axes along which the line doesn't move. */
+	Vector3d m_NextWallCoeff;
+
+	/** For each axis, 1 / m_Diff, so that stepping the line doesn't need any division. */
+	Vector3d m_InvDiff;
+
+
+	/** Initializes the trace's member variables and adjusts the start into the world.
+	Returns false if there's nothing to trace (the callbacks have already been notified then). */
+	bool InitTrace(Vector3d a_Start, Vector3d a_End);
+
 
 	/** Adjusts the start point above the world to just at the world's top */
 	void FixStartAboveWorld(void);
@@ -26,6 +26,7 @@ cMap::cMap(unsigned int a_ID, cWorld * a_World):
 	m_World(a_World)
 {
 	m_Data.assign(m_Width * m_Height, E_BASE_COLOR_TRANSPARENT);
+	MarkAllDirty();
 
 	Printf(m_Name, "map_%i", m_ID);
 }
@@ -44,6 +45,7 @@ cMap::cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, un
 	, m_World(a_World)
 {
 	m_Data.assign(m_Width * m_Height, E_BASE_COLOR_TRANSPARENT);
+	MarkAllDirty();
 
 	Printf(m_Name, "map_%i", m_ID);
 }
@@ -54,12 +56,36 @@ cMap::cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, un
 
 void cMap::Tick()
 {
+	std::vector<int> ClientsInThisTick;
+	ClientsInThisTick.reserve(m_ClientsInCurrentTick.size());
 	for (const auto & Client : m_ClientsInCurrentTick)
 	{
-		Client->SendMapData(*this, 0, 0);
+		const auto ClientID = Client->GetUniqueID();
+		ClientsInThisTick.push_back(ClientID);
+		if (std::find(m_ClientsInLastTick.begin(), m_ClientsInLastTick.end(), ClientID) == m_ClientsInLastTick.end())
+		{
+			// The client may have an outdated copy of the map (or none at all), send everything:
+			Client->SendMapData(*this, 0, 0, static_cast<int>(m_Width), static_cast<int>(m_Height));
+		}
+		else if (m_DirtyMaxX >= m_DirtyMinX)
+		{
+			Client->SendMapData(*this, m_DirtyMinX, m_DirtyMinZ, m_DirtyMaxX - m_DirtyMinX + 1, m_DirtyMaxZ - m_DirtyMinZ + 1);
+		}
+		else
+		{
+			// Nothing has changed, send the decorators only:
+			Client->SendMapData(*this, 0, 0, 0, 0);
+		}
 	}
+	m_ClientsInLastTick = std::move(ClientsInThisTick);
 	m_ClientsInCurrentTick.clear();
 	m_Decorators.clear();
+
+	// Reset the dirty rectangle:
+	m_DirtyMinX = static_cast<int>(m_Width);
+	m_DirtyMinZ = static_cast<int>(m_Height);
+	m_DirtyMaxX = -1;
+	m_DirtyMaxZ = -1;
 }
 
 
@@ -68,26 +94,76 @@ void cMap::Tick()
 
 void cMap::UpdateRadius(int a_PixelX, int a_PixelZ, unsigned int a_Radius)
 {
-	int PixelRadius = static_cast<int>(a_Radius / GetPixelWidth());
+	ASSERT(m_World != nullptr);
 
-	unsigned int StartX = static_cast<unsigned int>(Clamp(a_PixelX - PixelRadius, 0, static_cast<int>(m_Width)));
-	unsigned int StartZ = static_cast<unsigned int>(Clamp(a_PixelZ - PixelRadius, 0, static_cast<int>(m_Height)));
+	if (GetDimension() == dimNether)
+	{
+		// TODO 2014-02-22 xdot: Nether maps
+		return;
+	}
+
+	const int PixelWidth = static_cast<int>(GetPixelWidth());
+	const int PixelRadius = static_cast<int>(a_Radius) / PixelWidth;
 
-	unsigned int EndX   = static_cast<unsigned int>(Clamp(a_PixelX + PixelRadius, 0, static_cast<int>(m_Width)));
-	unsigned int EndZ   = static_cast<unsigned int>(Clamp(a_PixelZ + PixelRadius, 0, static_cast<int>(m_Height)));
+	const int StartX = Clamp(a_PixelX - PixelRadius, 0, static_cast<int>(m_Width));
+	const int StartZ = Clamp(a_PixelZ - PixelRadius, 0, static_cast<int>(m_Height));
 
-	for (unsigned int X = StartX; X < EndX; ++X)
+	const int EndX   = Clamp(a_PixelX + PixelRadius, 0, static_cast<int>(m_Width));
+	const int EndZ   = Clamp(a_PixelZ + PixelRadius, 0, static_cast<int>(m_Height));
+
+	// Block coords of the pixels' columns:
+	auto PixelToBlockX = [this, PixelWidth](int a_X) { return m_CenterX + (a_X - static_cast<int>(m_Width  / 2)) * PixelWidth; };
+	auto PixelToBlockZ = [this, PixelWidth](int a_Z) { return m_CenterZ + (a_Z - static_cast<int>(m_Height / 2)) * PixelWidth; };
+
+	// Process the pixels in runs that fall into a single chunk, so that each chunk is only looked up once:
+	for (int RunStartX = StartX; RunStartX < EndX;)
 	{
-		for (unsigned int Z = StartZ; Z < EndZ; ++Z)
+		const int ChunkX = cChunkDef::BlockToChunk({PixelToBlockX(RunStartX), 0, 0}).m_ChunkX;
+		int RunEndX = RunStartX + 1;
+		while ((RunEndX < EndX) && (cChunkDef::BlockToChunk({PixelToBlockX(RunEndX), 0, 0}).m_ChunkX == ChunkX))
 		{
-			int dX = static_cast<int>(X) - a_PixelX;
-			int dZ = static_cast<int>(Z) - a_PixelZ;
+			RunEndX++;
+		}
 
-			if ((dX * dX) + (dZ * dZ) < (PixelRadius * PixelRadius))
+		for (int RunStartZ = StartZ; RunStartZ < EndZ;)
+		{
+			const int ChunkZ = cChunkDef::BlockToChunk({0, 0, PixelToBlockZ(RunStartZ)}).m_ChunkZ;
+			int RunEndZ = RunStartZ + 1;
+			while ((RunEndZ < EndZ) && (cChunkDef::BlockToChunk({0, 0, PixelToBlockZ(RunEndZ)}).m_ChunkZ == ChunkZ))
 			{
-				UpdatePixel(X, Z);
+				RunEndZ++;
 			}
+
+			m_World->DoWithChunk(ChunkX, ChunkZ, [&](cChunk & a_Chunk)
+				{
+					static const std::array<unsigned char, 4> BrightnessID = { { 3, 0, 1, 2 } };  // Darkest to lightest
+					const int BrightnessIDSize = static_cast<int>(BrightnessID.size());
+
+					for (int X = RunStartX; X < RunEndX; ++X)
+					{
+						for (int Z = RunStartZ; Z < RunEndZ; ++Z)
+						{
+							int dX = X - a_PixelX;
+							int dZ = Z - a_PixelZ;
+							if ((dX * dX) + (dZ * dZ) >= (PixelRadius * PixelRadius))
+							{
+								continue;
+							}
+
+							const auto & Column = a_Chunk.GetMapColumn(PixelToBlockX(X) - ChunkX * cChunkDef::Width, PixelToBlockZ(Z) - ChunkZ * cChunkDef::Width);
+							const int ChunkHeight = Column.m_IsWater ? (cChunkDef::Height / 4) : cChunkDef::Height;
+
+							// Multiply base color ID by 4 and add brightness ID
+							const auto Brightness = BrightnessID[static_cast<size_t>(Clamp<int>((BrightnessIDSize * Column.m_Height) / ChunkHeight, 0, BrightnessIDSize - 1))];
+							SetPixel(static_cast<unsigned>(X), static_cast<unsigned>(Z), static_cast<ColorID>(Column.m_ColourID * 4 + Brightness));
+						}
+					}
+					return false;
+				}
+			);
+			RunStartZ = RunEndZ;
 		}
+		RunStartX = RunEndX;
 	}
 }
 
@@ -109,70 +185,6 @@ void cMap::UpdateRadius(cPlayer & a_Player, unsigned int a_Radius)
 
 
 
-bool cMap::UpdatePixel(unsigned int a_X, unsigned int a_Z)
-{
-	int BlockX = m_CenterX + static_cast<int>((a_X - m_Width  / 2) * GetPixelWidth());
-	int BlockZ = m_CenterZ + static_cast<int>((a_Z - m_Height / 2) * GetPixelWidth());
-
-	int ChunkX, ChunkZ;
-	cChunkDef::BlockToChunk(BlockX, BlockZ, ChunkX, ChunkZ);
-
-	int RelX = BlockX - (ChunkX * cChunkDef::Width);
-	int RelZ = BlockZ - (ChunkZ * cChunkDef::Width);
-
-	ASSERT(m_World != nullptr);
-
-	ColorID PixelData;
-	m_World->DoWithChunk(ChunkX, ChunkZ, [&](cChunk & a_Chunk)
-		{
-			if (GetDimension() == dimNether)
-			{
-				// TODO 2014-02-22 xdot: Nether maps
-
-				return false;
-			}
-
-			static const std::array<unsigned char, 4> BrightnessID = { { 3, 0, 1, 2 } };  // Darkest to lightest
-			BLOCKTYPE TargetBlock;
-			NIBBLETYPE TargetMeta;
-
-			auto Height = a_Chunk.GetHeight(RelX, RelZ);
-			auto ChunkHeight = cChunkDef::Height;
-			a_Chunk.GetBlockTypeMeta(RelX, Height, RelZ, TargetBlock, TargetMeta);
-			auto ColourID = cBlockHandler::For(TargetBlock).GetMapBaseColourID(TargetMeta);
-
-			if (IsBlockWater(TargetBlock))
-			{
-				ChunkHeight /= 4;
-				while (((--Height) != -1) && IsBlockWater(a_Chunk.GetBlock(RelX, Height, RelZ)))
-				{
-					continue;
-				}
-			}
-			else if (ColourID == 0)
-			{
-				while (((--Height) != -1) && ((ColourID = cBlockHandler::For(a_Chunk.GetBlock(RelX, Height, RelZ)).GetMapBaseColourID(a_Chunk.GetMeta(RelX, Height, RelZ))) == 0))
-				{
-					continue;
-				}
-			}
-
-			// Multiply base color ID by 4 and add brightness ID
-			const int BrightnessIDSize = static_cast<int>(BrightnessID.size());
-			PixelData = ColourID * 4 + BrightnessID[static_cast<size_t>(Clamp<int>((BrightnessIDSize * Height) / ChunkHeight, 0, BrightnessIDSize - 1))];
-			return false;
-		}
-	);
-
-	SetPixel(a_X, a_Z, PixelData);
-
-	return true;
-}
-
-
-
-
-
 void cMap::UpdateClient(cPlayer * a_Player)
 {
 	ASSERT(a_Player != nullptr);
@@ -205,6 +217,7 @@ void cMap::Resize(unsigned int a_Width, unsigned int a_Height)
 	m_Height = a_Height;
 
 	m_Data.assign(m_Width * m_Height, 0);
+	MarkAllDirty();
 }
 
 
@@ -215,6 +228,7 @@ void cMap::SetPosition(int a_CenterX, int a_CenterZ)
 {
 	m_CenterX = a_CenterX;
 	m_CenterZ = a_CenterZ;
+	MarkAllDirty();
 }
 
 
@@ -225,7 +239,12 @@ bool cMap::SetPixel(unsigned int a_X, unsigned int a_Z, cMap::ColorID a_Data)
 {
 	if ((a_X < m_Width) && (a_Z < m_Height))
 	{
-		m_Data[a_Z * m_Width + a_X] = a_Data;
+		auto & Pixel = m_Data[a_Z * m_Width + a_X];
+		if (Pixel != a_Data)
+		{
+			Pixel = a_Data;
+			MarkDirty(a_X, a_Z);
+		}
 
 		return true;
 	}
@@ -332,3 +351,27 @@ unsigned int cMap::GetPixelWidth(void) const
 
 
 
+void cMap::MarkDirty(unsigned int a_X, unsigned int a_Z)
+{
+	m_DirtyMinX = std::min(m_DirtyMinX, static_cast<int>(a_X));
+	m_DirtyMinZ = std::min(m_DirtyMinZ, static_cast<int>(a_Z));
+	m_DirtyMaxX = std::max(m_DirtyMaxX, static_cast<int>(a_X));
+	m_DirtyMaxZ = std::max(m_DirtyMaxZ, static_cast<int>(a_Z));
+}
+
+
+
+
+
+void cMap::MarkAllDirty(void)
+{
+	m_DirtyMinX = 0;
+	m_DirtyMinZ = 0;
+	m_DirtyMaxX = static_cast<int>(m_Width) - 1;
+	m_DirtyMaxZ = static_cast<int>(m_Height) - 1;
+}
+
+
+
+
+
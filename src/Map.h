@@ -117,10 +117,12 @@ public:
 	cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, unsigned int a_Scale = 3);
 
 	/** Sends a map update to all registered clients
+	Clients that have been sent the map in the previous tick only receive the rectangle changed since then.
 	Clears the list holding registered clients and decorators */
 	void Tick();
 
-	/** Update a circular region with the specified radius and center (in pixels). */
+	/** Update a circular region with the specified radius and center (in pixels).
+	The pixels are processed chunk by chunk, using the chunks' cached map colours (cChunk::GetMapColumn()). */
 	void UpdateRadius(int a_PixelX, int a_PixelZ, unsigned int a_Radius);
 
 	/** Update a circular region around the specified player. */
@@ -135,7 +137,7 @@ public:
 
 	void SetPosition(int a_CenterX, int a_CenterZ);
 
-	void SetScale(unsigned int a_Scale) { m_Scale = a_Scale; }
+	void SetScale(unsigned int a_Scale) { m_Scale = a_Scale; MarkAllDirty(); }
 
 	bool SetPixel(unsigned int a_X, unsigned int a_Z, ColorID a_Data);
 
@@ -171,8 +173,11 @@ public:
 
 private:
 
-	/** Update the specified pixel. */
-	bool UpdatePixel(unsigned int a_X, unsigned int a_Z);
+	/** Marks the specified pixel as changed, so that it is sent to the clients in the next Tick(). */
+	void MarkDirty(unsigned int a_X, unsigned int a_Z);
+
+	/** Marks the whole map as changed. */
+	void MarkAllDirty(void);
 
 	unsigned int m_ID;
 
@@ -192,6 +197,15 @@ private:
 
 	cMapClientList m_ClientsInCurrentTick;
 
+	/** UniqueIDs of the clients that were sent the map in the last Tick(). They have the map data up to date except for the dirty rectangle. */
+	std::vector<int> m_ClientsInLastTick;
+
+	/** The rectangle of pixels changed since the last Tick(), inclusive. Empty if m_DirtyMaxX < m_DirtyMinX. */
+	int m_DirtyMinX;
+	int m_DirtyMinZ;
+	int m_DirtyMaxX;
+	int m_DirtyMaxZ;
+
 	cMapDecoratorList m_Decorators;
 
 	AString m_Name;
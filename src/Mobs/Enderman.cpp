@@ -111,8 +111,9 @@ void cEnderman::CheckEventSeePlayer(cChunk & a_Chunk)
 		return;
 	}
 
+	// The range is measured to the players' feet, while the callback compares the heads:
 	cPlayerLookCheck Callback(GetPosition().addedY(GetHeight()), m_SightDistance);
-	if (m_World->ForEachPlayer(Callback))
+	if (m_World->ForEachPlayerInRange(GetPosition(), m_SightDistance + GetHeight(), Callback))
 	{
 		return;
 	}
@@ -25,6 +25,11 @@
 
 
 
+/** How long a line of sight check result is reused for, in HasLineOfSightTo(). */
+static const cTickTimeLong LINE_OF_SIGHT_CACHE_TICKS = 5_tick;
+
+
+
 /** Map for eType <-> string
 Needs to be alpha-sorted by the strings, because binary search is used in StringToMobType()
 The strings need to be lowercase (for more efficient comparisons in StringToMobType())
@@ -740,8 +745,9 @@ void cMonster::CheckEventSeePlayer(cChunk & a_Chunk)
 	double ClosestDistance = m_SightDistance * m_SightDistance;
 	const auto MyHeadPosition = GetPosition().addedY(GetHeight());
 
-	// Enumerate all players within sight:
-	m_World->ForEachPlayer([this, &TargetPlayer, &ClosestDistance, MyHeadPosition](cPlayer & a_Player)
+	// Enumerate all players within sight; the index measures to the players' feet, so allow for the difference in heights:
+	const auto SearchRange = m_SightDistance + std::max<double>(GetHeight(), 2.0);
+	m_World->ForEachPlayerInRange(GetPosition(), SearchRange, [this, &TargetPlayer, &ClosestDistance, MyHeadPosition](cPlayer & a_Player)
 	{
 		if (!a_Player.CanMobsTarget())
 		{
@@ -754,7 +760,7 @@ void cMonster::CheckEventSeePlayer(cChunk & a_Chunk)
 		// TODO: Currently all mobs see through lava, but only Nether-native mobs should be able to.
 		if (
 			(TargetDistance < ClosestDistance) &&
-			cLineBlockTracer::LineOfSightTrace(*GetWorld(), MyHeadPosition, TargetHeadPosition, cLineBlockTracer::losAirWaterLava)
+			HasLineOfSightTo(a_Player, MyHeadPosition, TargetHeadPosition, cLineBlockTracer::losAirWaterLava)
 		)
 		{
 			TargetPlayer = &a_Player;
@@ -775,6 +781,37 @@ void cMonster::CheckEventSeePlayer(cChunk & a_Chunk)
 
 
 
+bool cMonster::HasLineOfSightTo(const cPlayer & a_Player, Vector3d a_From, Vector3d a_To, int a_Sight)
+{
+	const auto Now = m_World->GetWorldTickAge();
+	const auto PlayerID = a_Player.GetUniqueID();
+
+	// Forget the results that are too old, reuse the one for this player if it's still fresh:
+	m_LineOfSightCache.erase(
+		std::remove_if(m_LineOfSightCache.begin(), m_LineOfSightCache.end(), [Now](const sLineOfSight & a_Entry)
+			{
+				return (Now - a_Entry.m_CheckedAt >= LINE_OF_SIGHT_CACHE_TICKS);
+			}
+		),
+		m_LineOfSightCache.end()
+	);
+	for (const auto & Entry: m_LineOfSightCache)
+	{
+		if (Entry.m_PlayerID == PlayerID)
+		{
+			return Entry.m_HasLineOfSight;
+		}
+	}
+
+	const auto HasLineOfSight = cLineBlockTracer::LineOfSightTrace(*GetWorld(), a_From, a_To, a_Sight);
+	m_LineOfSightCache.push_back({PlayerID, HasLineOfSight, Now});
+	return HasLineOfSight;
+}
+
+
+
+
+
 void cMonster::CheckEventLostPlayer(const std::chrono::milliseconds a_Dt)
 {
 	const auto Target = GetTarget();
@@ -294,6 +294,21 @@ protected:
 	/** Sets the body yaw and head yaw */
 	void SetPitchAndYawFromDestination(bool a_IsFollowingPath);
 
+	/** A line of sight check result, remembered per player for a few ticks. */
+	struct sLineOfSight
+	{
+		UInt32 m_PlayerID;
+		bool m_HasLineOfSight;
+		cTickTimeLong m_CheckedAt;
+	};
+
+	/** The recent line of sight check results, see HasLineOfSightTo(). */
+	std::vector<sLineOfSight> m_LineOfSightCache;
+
+	/** Returns whether there's a line of sight from a_From to a_To, the position of a_Player's head, through the specified kinds of blocks.
+	The result is remembered per player for a few ticks, so that the target search doesn't trace the same lines every tick. */
+	bool HasLineOfSightTo(const cPlayer & a_Player, Vector3d a_From, Vector3d a_To, int a_Sight);
+
 	int m_JumpCoolDown;
 
 	std::chrono::milliseconds m_IdleInterval;
@@ -77,15 +77,11 @@ void cWither::KilledBy(TakeDamageInfo & a_TDI)
 	Super::KilledBy(a_TDI);
 
 	Vector3d Pos = GetPosition();
-	m_World->ForEachPlayer([=](cPlayer & a_Player)
+	// TODO 2014-05-21 xdot: Vanilla minecraft uses an AABB check instead of a radius one
+	m_World->ForEachPlayerInRange(Pos, 50.0, [](cPlayer & a_Player)
 		{
-			// TODO 2014-05-21 xdot: Vanilla minecraft uses an AABB check instead of a radius one
-			double Dist = (a_Player.GetPosition() - Pos).Length();
-			if (Dist < 50.0)
-			{
-				// If player is close, award achievement
-				a_Player.AwardAchievement(CustomStatistic::AchKillWither);
-			}
+			// If player is close, award achievement
+			a_Player.AwardAchievement(CustomStatistic::AchKillWither);
 			return false;
 		}
 	);
@@ -8,6 +8,7 @@
 #include "File.h"
 #include <sys/stat.h>
 #ifdef _WIN32
+	#include <io.h>  // for _commit()
 	#include <share.h>  // for _SH_DENYWRITE
 #else
 	#include <dirent.h>
@@ -712,6 +713,25 @@ void cFile::Flush(void)
 
 
 
+bool cFile::Sync(void)
+{
+	ASSERT(IsOpen());
+
+	if (!IsOpen() || (fflush(m_File) != 0))
+	{
+		return false;
+	}
+	#ifdef _WIN32
+		return (_commit(_fileno(m_File)) == 0);
+	#else
+		return (fsync(fileno(m_File)) == 0);
+	#endif  // _WIN32
+}
+
+
+
+
+
 template <class StreamType>
 FileStream<StreamType>::FileStream(const std::string & Path)
 {
@@ -178,6 +178,10 @@ public:
 	/** Flushes all the bufferef output into the file (only when writing) */
 	void Flush(void);
 
+	/** Flushes the buffered output and makes the OS write the file's data to the disk, so that it survives a crash.
+	Returns true on success. Much slower than Flush(), use only when the order of writes across files matters. */
+	bool Sync(void);
+
 private:
 	FILE * m_File;
 } ;  // tolua_export
@@ -0,0 +1,682 @@
+
+// LockFreeQueue.h
+
+// Implements the lock-free queues used for handing items over between threads:
+//   - cSpscQueue, a bounded ring buffer for a single producer and a single consumer
+//   - cMpscQueue, an unbounded linked list for multiple producers and a single consumer
+//   - cMpmcQueue, a bounded ring buffer for multiple producers and multiple consumers
+// Implements the cQueueWaiter class that lets threads sleep until a queue changes
+
+/*
+Unlike cQueue, none of these queues takes a lock when adding or removing an item. A thread that wants to block
+until there's an item (or free space) parks on a cQueueWaiter; the thread that changes the queue only touches the
+waiter's mutex if there is somebody parked, similar to a futex. While nobody waits, a notification costs a fence
+and an atomic load.
+
+Each queue counts the contended events: retries caused by other threads, attempts to push into a full queue
+and waits that had to put the thread to sleep. GetStats() returns a snapshot, for tuning the hand-offs.
+
+The "single producer" / "single consumer" limitations are promises by the caller, they are not checked;
+breaking them corrupts the queue. The sizes reported are only approximate while other threads use the queue.
+*/
+
+
+
+
+
+#pragma once
+
+#include <optional>
+
+
+
+
+
+/** Contention counters of a queue, as returned by the GetStats() functions. */
+struct sQueueStats
+{
+	/** Number of times an operation had to retry because another thread changed the queue at the same time. */
+	UInt64 m_NumRetries = 0;
+
+	/** Number of times an item couldn't be pushed because the queue was full. */
+	UInt64 m_NumFull = 0;
+
+	/** Number of times a thread had to go to sleep, waiting for the queue to change. */
+	UInt64 m_NumParks = 0;
+};
+
+
+
+
+
+/** Lets threads sleep until a condition on a lock-free structure becomes true.
+The thread changing the structure calls NotifyAll() afterwards, which is nearly free if nobody is waiting. */
+class cQueueWaiter
+{
+public:
+
+	cQueueWaiter(void):
+		m_NumWaiters(0),
+		m_NumParks(0)
+	{
+	}
+
+	/** Blocks until a_Predicate returns true.
+	Spins for a short while first, since the queues tend to be refilled quickly, then goes to sleep. */
+	template <typename Predicate>
+	void Wait(Predicate a_Predicate)
+	{
+		for (int i = 0; i < NUM_SPINS; i++)
+		{
+			if (a_Predicate())
+			{
+				return;
+			}
+			std::this_thread::yield();
+		}
+
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_NumWaiters.fetch_add(1, std::memory_order_relaxed);
+
+		// Pairs with the fence in NotifyAll(): either the predicate sees the change, or the notifier sees this waiter:
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!a_Predicate())
+		{
+			m_NumParks.fetch_add(1, std::memory_order_relaxed);
+			m_CondVar.wait(Lock);
+		}
+		m_NumWaiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	/** Wakes up all the threads blocked in Wait(), if there are any.
+	To be called after the change that the waiters may be waiting for is made. */
+	void NotifyAll(void)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_NumWaiters.load(std::memory_order_relaxed) == 0)
+		{
+			return;
+		}
+
+		// Taking the mutex makes sure the waiter is either still before its predicate check, or already asleep:
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+		}
+		m_CondVar.notify_all();
+	}
+
+	/** Returns the number of times a waiting thread has been put to sleep. */
+	UInt64 GetNumParks(void) const { return m_NumParks.load(std::memory_order_relaxed); }
+
+private:
+
+	/** Number of times the predicate is re-checked before going to sleep. */
+	static const int NUM_SPINS = 64;
+
+	/** Number of threads currently inside the sleeping part of Wait(). */
+	std::atomic<int> m_NumWaiters;
+
+	/** Number of times a waiting thread has been put to sleep. */
+	std::atomic<UInt64> m_NumParks;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_CondVar;
+};
+
+
+
+
+
+/** Spaces out the retries of a thread that lost a race for a queue index to another thread.
+Busy-waits for twice as long after each call, so that the contending threads get out of each other's way,
+and only yields the CPU once the busy-waits get long. */
+class cQueueBackoff
+{
+public:
+
+	cQueueBackoff(void):
+		m_NumSpins(1)
+	{
+	}
+
+	/** Waits a little before the next retry, longer with each call. */
+	void Pause(void)
+	{
+		if (m_NumSpins > MAX_SPINS)
+		{
+			std::this_thread::yield();
+			return;
+		}
+		for (unsigned i = 0; i < m_NumSpins; i++)
+		{
+			// Keeps the compiler from removing the loop, without touching any memory:
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+		}
+		m_NumSpins *= 2;
+	}
+
+private:
+
+	/** The longest busy-wait, in loop iterations, before switching to yielding. */
+	static const unsigned MAX_SPINS = 1024;
+
+	/** The length of the next busy-wait, in loop iterations. */
+	unsigned m_NumSpins;
+};
+
+
+
+
+
+/** The assumed size of a cache line; the indices written by different threads are kept this far apart. */
+static const size_t QUEUE_CACHE_LINE_SIZE = 64;
+
+/** Returns the smallest power of two that is at least a_Value (and at least 2). */
+inline size_t QueueRoundUpToPowerOfTwo(size_t a_Value)
+{
+	size_t Res = 2;
+	while (Res < a_Value)
+	{
+		Res *= 2;
+	}
+	return Res;
+}
+
+
+
+
+
+/** A bounded FIFO queue for exactly one producer thread and one consumer thread.
+A ring buffer of slots; each side only writes its own index and caches the other side's index,
+so the uncontended push and pop don't write to any cache line shared with the other thread. */
+template <typename T>
+class cSpscQueue
+{
+public:
+
+	/** Creates a queue that can hold at least a_Capacity items (the capacity is rounded up to a power of two). */
+	explicit cSpscQueue(size_t a_Capacity):
+		m_Mask(QueueRoundUpToPowerOfTwo(a_Capacity) - 1),
+		m_Slots(new std::optional<T>[m_Mask + 1]),
+		m_Head(0),
+		m_CachedTail(0),
+		m_Tail(0),
+		m_CachedHead(0),
+		m_NumFull(0)
+	{
+	}
+
+	DISALLOW_COPY_AND_ASSIGN(cSpscQueue);
+
+	/** Adds the item to the queue, unless it is full. Producer thread only.
+	Returns false if the queue is full; the item is left untouched then. */
+	template <typename U>
+	bool TryPush(U && a_Item)
+	{
+		auto Tail = m_Tail.load(std::memory_order_relaxed);
+		if (Tail - m_CachedHead > m_Mask)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (Tail - m_CachedHead > m_Mask)
+			{
+				m_NumFull.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		m_Slots[Tail & m_Mask].emplace(std::forward<U>(a_Item));
+		m_Tail.store(Tail + 1, std::memory_order_release);
+		m_ItemAdded.NotifyAll();
+		return true;
+	}
+
+	/** Adds the item to the queue, waiting for free space if the queue is full. Producer thread only. */
+	template <typename U>
+	void Push(U && a_Item)
+	{
+		while (!TryPush(std::forward<U>(a_Item)))
+		{
+			m_ItemRemoved.Wait([this]() { return (Size() <= m_Mask); });
+		}
+	}
+
+	/** Removes the oldest item from the queue into a_Item. Consumer thread only.
+	Returns false if the queue is empty. */
+	bool TryPop(T & a_Item)
+	{
+		auto Head = m_Head.load(std::memory_order_relaxed);
+		if (Head == m_CachedTail)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			if (Head == m_CachedTail)
+			{
+				return false;
+			}
+		}
+		auto & Slot = m_Slots[Head & m_Mask];
+		a_Item = std::move(*Slot);
+		Slot.reset();
+		m_Head.store(Head + 1, std::memory_order_release);
+		m_ItemRemoved.NotifyAll();
+		return true;
+	}
+
+	/** Removes the oldest item from the queue, waiting for one if the queue is empty. Consumer thread only. */
+	T Pop(void)
+	{
+		// Size() reads m_Tail with acquire semantics, so once it's non-zero the slot's item is visible:
+		m_ItemAdded.Wait([this]() { return !IsEmpty(); });
+		m_CachedTail = m_Tail.load(std::memory_order_acquire);
+		auto Head = m_Head.load(std::memory_order_relaxed);
+		auto & Slot = m_Slots[Head & m_Mask];
+		T Item(std::move(*Slot));
+		Slot.reset();
+		m_Head.store(Head + 1, std::memory_order_release);
+		m_ItemRemoved.NotifyAll();
+		return Item;
+	}
+
+	/** Returns the number of items in the queue. */
+	size_t Size(void) const
+	{
+		return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+	}
+
+	/** Returns true if the queue is empty. */
+	bool IsEmpty(void) const { return (Size() == 0); }
+
+	/** Returns the maximum number of items the queue can hold. */
+	size_t GetCapacity(void) const { return m_Mask + 1; }
+
+	/** Returns the contention counters. */
+	sQueueStats GetStats(void) const
+	{
+		sQueueStats Res;
+		Res.m_NumFull = m_NumFull.load(std::memory_order_relaxed);
+		Res.m_NumParks = m_ItemAdded.GetNumParks() + m_ItemRemoved.GetNumParks();
+		return Res;
+	}
+
+private:
+
+	/** The capacity minus one, used for wrapping the indices into m_Slots. */
+	const size_t m_Mask;
+
+	/** The ring buffer of the items. */
+	std::unique_ptr<std::optional<T>[]> m_Slots;
+
+	/** The index of the next item to pop. Written only by the consumer. */
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_Head;
+
+	/** The consumer's copy of m_Tail, refreshed only when the queue seems empty. */
+	size_t m_CachedTail;
+
+	/** The index of the next slot to push into. Written only by the producer. */
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_Tail;
+
+	/** The producer's copy of m_Head, refreshed only when the queue seems full. */
+	size_t m_CachedHead;
+
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<UInt64> m_NumFull;
+
+	/** Notified when an item is pushed, the consumer waits on it in Pop(). */
+	cQueueWaiter m_ItemAdded;
+
+	/** Notified when an item is popped, the producer waits on it in Push(). */
+	cQueueWaiter m_ItemRemoved;
+};
+
+
+
+
+
+/** An unbounded FIFO queue for any number of producer threads and exactly one consumer thread.
+A singly linked list with a stub node (D. Vyukov's design); a push is a single atomic exchange,
+regardless of how many producers there are, and never fails or waits. Each item takes one allocation. */
+template <typename T>
+class cMpscQueue
+{
+public:
+
+	cMpscQueue(void):
+		m_Tail(new sNode),
+		m_Head(m_Tail),
+		m_Size(0),
+		m_NumRetries(0)
+	{
+	}
+
+	DISALLOW_COPY_AND_ASSIGN(cMpscQueue);
+
+	~cMpscQueue()
+	{
+		// Delete all the nodes, including the stub:
+		auto Node = m_Tail;
+		while (Node != nullptr)
+		{
+			auto Next = Node->m_Next.load(std::memory_order_relaxed);
+			delete Node;
+			Node = Next;
+		}
+	}
+
+	/** Adds the item to the queue. Any thread. */
+	template <typename U>
+	void Push(U && a_Item)
+	{
+		auto Node = new sNode;
+		Node->m_Item.emplace(std::forward<U>(a_Item));
+		m_Size.fetch_add(1, std::memory_order_relaxed);
+		auto Prev = m_Head.exchange(Node, std::memory_order_acq_rel);
+
+		// Between the exchange and this store the list is broken, the consumer sees the queue as empty until it's linked:
+		Prev->m_Next.store(Node, std::memory_order_release);
+		m_ItemAdded.NotifyAll();
+	}
+
+	/** Removes the oldest item from the queue into a_Item. Consumer thread only.
+	Returns false if the queue is empty (or the oldest item is still being linked in by its producer). */
+	bool TryPop(T & a_Item)
+	{
+		auto Tail = m_Tail;
+		auto Next = Tail->m_Next.load(std::memory_order_acquire);
+		if (Next == nullptr)
+		{
+			if (m_Head.load(std::memory_order_relaxed) != Tail)
+			{
+				// A producer is in the middle of linking its node
+				m_NumRetries.fetch_add(1, std::memory_order_relaxed);
+			}
+			return false;
+		}
+
+		// The popped node becomes the new stub:
+		a_Item = std::move(*Next->m_Item);
+		Next->m_Item.reset();
+		m_Tail = Next;
+		delete Tail;
+		m_Size.fetch_sub(1, std::memory_order_release);
+		m_ItemRemoved.NotifyAll();
+		return true;
+	}
+
+	/** Removes the oldest item from the queue, waiting for one if the queue is empty. Consumer thread only. */
+	T Pop(void)
+	{
+		m_ItemAdded.Wait([this]() { return (m_Tail->m_Next.load(std::memory_order_acquire) != nullptr); });
+		auto Tail = m_Tail;
+		auto Next = Tail->m_Next.load(std::memory_order_acquire);
+		T Item(std::move(*Next->m_Item));
+		Next->m_Item.reset();
+		m_Tail = Next;
+		delete Tail;
+		m_Size.fetch_sub(1, std::memory_order_release);
+		m_ItemRemoved.NotifyAll();
+		return Item;
+	}
+
+	/** Blocks until all the items pushed so far have been popped. Any thread but the consumer. */
+	void WaitUntilEmpty(void)
+	{
+		m_ItemRemoved.Wait([this]() { return IsEmpty(); });
+	}
+
+	/** Returns the number of items in the queue, including the ones still being pushed. */
+	size_t Size(void) const { return m_Size.load(std::memory_order_acquire); }
+
+	/** Returns true if the queue is empty. */
+	bool IsEmpty(void) const { return (Size() == 0); }
+
+	/** Returns the contention counters. */
+	sQueueStats GetStats(void) const
+	{
+		sQueueStats Res;
+		Res.m_NumRetries = m_NumRetries.load(std::memory_order_relaxed);
+		Res.m_NumParks = m_ItemAdded.GetNumParks() + m_ItemRemoved.GetNumParks();
+		return Res;
+	}
+
+private:
+
+	struct sNode
+	{
+		std::atomic<sNode *> m_Next;
+
+		/** The item; empty in the stub node. */
+		std::optional<T> m_Item;
+
+		sNode(void):
+			m_Next(nullptr)
+		{
+		}
+	};
+
+	/** The stub node, whose successor is the oldest item. Accessed only by the consumer. */
+	sNode * m_Tail;
+
+	/** The newest node, producers swap their new nodes in here. */
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<sNode *> m_Head;
+
+	/** The number of items pushed but not popped yet. */
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_Size;
+
+	std::atomic<UInt64> m_NumRetries;
+
+	/** Notified when an item is pushed, the consumer waits on it in Pop(). */
+	cQueueWaiter m_ItemAdded;
+
+	/** Notified when an item is popped, WaitUntilEmpty() waits on it. */
+	cQueueWaiter m_ItemRemoved;
+};
+
+
+
+
+
+/** A bounded FIFO queue for any number of producer and consumer threads.
+A ring buffer where each slot carries a sequence number telling whether it's ready for writing or reading
+in the current lap (D. Vyukov's design); producers and consumers each claim slots with a CAS on their own index.
+A thread that loses the CAS backs off before retrying. The blocking Push() and Pop() wait on the state of the next
+cell rather than on Size(), because a cell stays busy for a while after its index has been claimed.
+Nothing in the server uses it yet; it's exercised only by tests/OSSupport/StressQueues. */
+template <typename T>
+class cMpmcQueue
+{
+public:
+
+	/** Creates a queue that can hold at least a_Capacity items (the capacity is rounded up to a power of two). */
+	explicit cMpmcQueue(size_t a_Capacity):
+		m_Mask(QueueRoundUpToPowerOfTwo(a_Capacity) - 1),
+		m_Cells(new sCell[m_Mask + 1]),
+		m_PushPos(0),
+		m_PopPos(0),
+		m_NumRetries(0),
+		m_NumFull(0)
+	{
+		for (size_t i = 0; i <= m_Mask; i++)
+		{
+			m_Cells[i].m_Sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	DISALLOW_COPY_AND_ASSIGN(cMpmcQueue);
+
+	/** Adds the item to the queue, unless it is full. Any thread.
+	Returns false if the queue is full; the item is left untouched then. */
+	template <typename U>
+	bool TryPush(U && a_Item)
+	{
+		cQueueBackoff Backoff;
+		auto Pos = m_PushPos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			auto & Cell = m_Cells[Pos & m_Mask];
+			auto Seq = Cell.m_Sequence.load(std::memory_order_acquire);
+			auto Diff = static_cast<std::ptrdiff_t>(Seq - Pos);
+			if (Diff == 0)
+			{
+				// The cell is free in this lap, try to claim it:
+				if (m_PushPos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					Cell.m_Item.emplace(std::forward<U>(a_Item));
+					Cell.m_Sequence.store(Pos + 1, std::memory_order_release);
+					m_ItemAdded.NotifyAll();
+					return true;
+				}
+				m_NumRetries.fetch_add(1, std::memory_order_relaxed);
+				Backoff.Pause();
+			}
+			else if (Diff < 0)
+			{
+				// The cell still holds an item from the previous lap, the queue is full:
+				m_NumFull.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				// Another producer has claimed the cell, catch up:
+				m_NumRetries.fetch_add(1, std::memory_order_relaxed);
+				Backoff.Pause();
+				Pos = m_PushPos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** Adds the item to the queue, waiting for free space if the queue is full. Any thread. */
+	template <typename U>
+	void Push(U && a_Item)
+	{
+		while (!TryPush(std::forward<U>(a_Item)))
+		{
+			m_ItemRemoved.Wait([this]() { return IsNextPushCellFree(); });
+		}
+	}
+
+	/** Removes the oldest item from the queue into a_Item. Any thread.
+	Returns false if the queue is empty. */
+	bool TryPop(T & a_Item)
+	{
+		cQueueBackoff Backoff;
+		auto Pos = m_PopPos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			auto & Cell = m_Cells[Pos & m_Mask];
+			auto Seq = Cell.m_Sequence.load(std::memory_order_acquire);
+			auto Diff = static_cast<std::ptrdiff_t>(Seq - (Pos + 1));
+			if (Diff == 0)
+			{
+				// The cell has an item in this lap, try to claim it:
+				if (m_PopPos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					a_Item = std::move(*Cell.m_Item);
+					Cell.m_Item.reset();
+					Cell.m_Sequence.store(Pos + m_Mask + 1, std::memory_order_release);
+					m_ItemRemoved.NotifyAll();
+					return true;
+				}
+				m_NumRetries.fetch_add(1, std::memory_order_relaxed);
+				Backoff.Pause();
+			}
+			else if (Diff < 0)
+			{
+				// The cell hasn't been filled in this lap yet, the queue is empty:
+				return false;
+			}
+			else
+			{
+				// Another consumer has claimed the cell, catch up:
+				m_NumRetries.fetch_add(1, std::memory_order_relaxed);
+				Backoff.Pause();
+				Pos = m_PopPos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** Removes the oldest item from the queue into a_Item, waiting for one if the queue is empty. Any thread. */
+	void Pop(T & a_Item)
+	{
+		while (!TryPop(a_Item))
+		{
+			m_ItemAdded.Wait([this]() { return IsNextPopCellFilled(); });
+		}
+	}
+
+	/** Returns the number of items in the queue. */
+	size_t Size(void) const
+	{
+		auto PopPos = m_PopPos.load(std::memory_order_acquire);
+		auto PushPos = m_PushPos.load(std::memory_order_acquire);
+		return (PushPos > PopPos) ? (PushPos - PopPos) : 0;
+	}
+
+	/** Returns true if the queue is empty. */
+	bool IsEmpty(void) const { return (Size() == 0); }
+
+	/** Returns the maximum number of items the queue can hold. */
+	size_t GetCapacity(void) const { return m_Mask + 1; }
+
+	/** Returns the contention counters. */
+	sQueueStats GetStats(void) const
+	{
+		sQueueStats Res;
+		Res.m_NumRetries = m_NumRetries.load(std::memory_order_relaxed);
+		Res.m_NumFull = m_NumFull.load(std::memory_order_relaxed);
+		Res.m_NumParks = m_ItemAdded.GetNumParks() + m_ItemRemoved.GetNumParks();
+		return Res;
+	}
+
+private:
+
+	struct sCell
+	{
+		/** Equal to the cell's position when it's free for the push in that lap, to the position + 1 when it holds that push's item. */
+		std::atomic<size_t> m_Sequence;
+
+		std::optional<T> m_Item;
+	};
+
+	/** The capacity minus one, used for wrapping the positions into m_Cells. */
+	const size_t m_Mask;
+
+	/** The ring buffer of the cells. */
+	std::unique_ptr<sCell[]> m_Cells;
+
+	/** The position of the next push. */
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_PushPos;
+
+	/** The position of the next pop. */
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> m_PopPos;
+
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<UInt64> m_NumRetries;
+	std::atomic<UInt64> m_NumFull;
+
+	/** Notified when an item is pushed, consumers wait on it in Pop(). */
+	cQueueWaiter m_ItemAdded;
+
+	/** Notified when an item is popped, producers wait on it in Push(). */
+	cQueueWaiter m_ItemRemoved;
+
+
+	/** Returns true if the cell at the push position has been emptied for the current lap (or a later push has
+	already claimed it), so that TryPush() won't report the queue as full.
+	Size() may already show free space while the consumer that claimed the cell is still moving its item out. */
+	bool IsNextPushCellFree(void) const
+	{
+		auto Pos = m_PushPos.load(std::memory_order_relaxed);
+		auto Seq = m_Cells[Pos & m_Mask].m_Sequence.load(std::memory_order_acquire);
+		return (static_cast<std::ptrdiff_t>(Seq - Pos) >= 0);
+	}
+
+	/** Returns true if the cell at the pop position has been filled for the current lap (or a later pop has
+	already claimed it), so that TryPop() won't report the queue as empty.
+	Size() may already show an item while the producer that claimed the cell is still moving its item in. */
+	bool IsNextPopCellFilled(void) const
+	{
+		auto Pos = m_PopPos.load(std::memory_order_relaxed);
+		auto Seq = m_Cells[Pos & m_Mask].m_Sequence.load(std::memory_order_acquire);
+		return (static_cast<std::ptrdiff_t>(Seq - (Pos + 1)) >= 0);
+	}
+};
+
+
+
+
@@ -106,6 +106,13 @@ public:
 	Sends the RST packet, queued outgoing and incoming data is lost. */
 	virtual void Close(void) = 0;
 
+	/** Stops reading the incoming data from the remote peer, until ResumeReading() is called.
+	The data is left in the OS's buffers, so that a peer sending too much is eventually throttled by the TCP flow control. */
+	virtual void PauseReading(void) = 0;
+
+	/** Resumes reading the incoming data after a PauseReading() call. */
+	virtual void ResumeReading(void) = 0;
+
 	/** Starts a TLS handshake as a client connection.
 	If a client certificate should be used for the connection, set the certificate into a_OwnCertData and
 	its corresponding private key to a_OwnPrivKeyData. If both are empty, no client cert is presented.
@@ -361,6 +368,12 @@ public:
 
 	/** Returns all local IP addresses for network interfaces currently available. */
 	static AStringVector EnumLocalIPAddresses(void);
+
+	/** Starts additional network event loops, so that there are (at least) a_NumEventLoops in total.
+	New TCP links are spread over the loops by their load, each link stays on its loop for its whole lifetime.
+	Note that the callbacks of different links may then be called in parallel.
+	Implemented in NetworkSingleton.cpp. */
+	static void StartEventLoops(unsigned a_NumEventLoops);
 };
 
 
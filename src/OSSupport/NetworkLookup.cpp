@@ -30,7 +30,7 @@ cNetworkLookup::~cNetworkLookup()
 
 void cNetworkLookup::ScheduleLookup(std::function<void()> a_Lookup)
 {
-	m_WorkQueue.EnqueueItem(std::move(a_Lookup));
+	m_WorkQueue.Push(std::move(a_Lookup));
 }
 
 
@@ -39,9 +39,9 @@ void cNetworkLookup::ScheduleLookup(std::function<void()> a_Lookup)
 
 void cNetworkLookup::Stop()
 {
+	// The tasks still queued are never executed once m_ShouldTerminate is set, they get deleted with the queue:
 	m_ShouldTerminate = true;
-	m_WorkQueue.Clear();
-	m_WorkQueue.EnqueueItem([](){});  // Dummy work to wake up the thread
+	m_WorkQueue.Push([](){});  // Dummy work to wake up the thread
 	cIsThread::Stop();
 }
 
@@ -54,7 +54,11 @@ void cNetworkLookup::Execute()
 	while (!m_ShouldTerminate)
 	{
 		// Execute the next task in the queue
-		auto Work = m_WorkQueue.DequeueItem();
+		auto Work = m_WorkQueue.Pop();
+		if (m_ShouldTerminate)
+		{
+			return;
+		}
 		Work();
 	}
 }
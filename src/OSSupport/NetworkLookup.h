@@ -8,7 +8,7 @@
 #include <functional>
 
 #include "IsThread.h"
-#include "Queue.h"
+#include "LockFreeQueue.h"
 
 
 
@@ -35,8 +35,8 @@ protected:
 
 private:
 
-	/** The queue of lookup tasks waiting to be executed. */
-	cQueue<std::function<void()>> m_WorkQueue;
+	/** The queue of lookup tasks waiting to be executed. Pushed by any thread, popped only by the lookup thread. */
+	cMpscQueue<std::function<void()>> m_WorkQueue;
 };
 
 
@@ -2,7 +2,7 @@
 // NetworkSingleton.cpp
 
 // Implements the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
 
 #include "Globals.h"
 #include "NetworkSingleton.h"
@@ -16,6 +16,8 @@
 
 
 cNetworkSingleton::cNetworkSingleton() :
+	m_EventBase(nullptr),
+	m_NextEventLoop(0),
 	m_HasTerminated(true)
 {
 }
@@ -74,21 +76,47 @@ void cNetworkSingleton::Initialise(void)
 		#error No threading implemented for EVTHREAD
 	#endif
 
-	// Create the main event_base:
-	event_config * config = event_config_new();
-	event_config_set_flag(config, EVENT_BASE_FLAG_STARTUP_IOCP);
-	m_EventBase = event_base_new_with_config(config);
-	if (m_EventBase == nullptr)
+	// Create the main event loop:
+	auto MainLoop = StartEventLoop();
+	m_EventBase = MainLoop->m_EventBase;
 	{
-		LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
-		abort();
+		cCSLock Lock(m_CS);
+		m_EventLoops.push_back(std::move(MainLoop));
+		m_NextEventLoop = 0;
 	}
-	event_config_free(config);
-
-	// Create the event loop thread:
 	m_HasTerminated = false;
-	m_EventLoopThread = std::thread(RunEventLoop, this);
-	m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+}
+
+
+
+
+
+void cNetworkSingleton::StartEventLoops(unsigned a_NumEventLoops)
+{
+	ASSERT(!m_HasTerminated);
+
+	// Start the loops without holding the lock, the startup waits for the loop thread:
+	size_t NumToStart;
+	{
+		cCSLock Lock(m_CS);
+		NumToStart = (a_NumEventLoops > m_EventLoops.size()) ? (a_NumEventLoops - m_EventLoops.size()) : 0;
+	}
+	if (NumToStart == 0)
+	{
+		return;
+	}
+	std::vector<std::unique_ptr<sEventLoop>> NewLoops;
+	for (size_t i = 0; i < NumToStart; i++)
+	{
+		NewLoops.push_back(StartEventLoop());
+	}
+
+	cCSLock Lock(m_CS);
+	for (auto & Loop: NewLoops)
+	{
+		m_EventLoops.push_back(std::move(Loop));
+	}
+	LOGD("Network: running %u event loops", static_cast<unsigned>(m_EventLoops.size()));
 }
 
 
@@ -102,9 +130,16 @@ void cNetworkSingleton::Terminate(void)
 	// Wait for the lookup thread to stop
 	m_LookupThread.Stop();
 
-	// Wait for the LibEvent event loop to terminate:
-	event_base_loopbreak(m_EventBase);
-	m_EventLoopThread.join();
+	// Wait for all the LibEvent event loops to terminate:
+	// (no new loops can be added while terminating, so the list can be walked without the lock, which the loop threads may need)
+	for (auto & Loop: m_EventLoops)
+	{
+		event_base_loopbreak(Loop->m_EventBase);
+	}
+	for (auto & Loop: m_EventLoops)
+	{
+		Loop->m_Thread.join();
+	}
 
 	// Close all open connections:
 	{
@@ -128,7 +163,15 @@ void cNetworkSingleton::Terminate(void)
 	}
 
 	// Free the underlying LibEvent objects:
-	event_base_free(m_EventBase);
+	{
+		cCSLock Lock(m_CS);
+		for (auto & Loop: m_EventLoops)
+		{
+			event_base_free(Loop->m_EventBase);
+		}
+		m_EventLoops.clear();
+		m_EventBase = nullptr;
+	}
 
 	libevent_global_shutdown();
 
@@ -161,12 +204,36 @@ void cNetworkSingleton::LogCallback(int a_Severity, const char * a_Msg)
 
 
 
-void cNetworkSingleton::RunEventLoop(cNetworkSingleton * a_Self)
+std::unique_ptr<cNetworkSingleton::sEventLoop> cNetworkSingleton::StartEventLoop(void)
 {
-	auto timer = evtimer_new(a_Self->m_EventBase, SignalizeStartup, a_Self);
+	// Create the event_base:
+	auto Loop = std::make_unique<sEventLoop>();
+	event_config * config = event_config_new();
+	event_config_set_flag(config, EVENT_BASE_FLAG_STARTUP_IOCP);
+	Loop->m_EventBase = event_base_new_with_config(config);
+	if (Loop->m_EventBase == nullptr)
+	{
+		LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
+		abort();
+	}
+	event_config_free(config);
+
+	// Create the event loop thread:
+	Loop->m_Thread = std::thread(RunEventLoop, Loop.get());
+	Loop->m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+	return Loop;
+}
+
+
+
+
+
+void cNetworkSingleton::RunEventLoop(sEventLoop * a_EventLoop)
+{
+	auto timer = evtimer_new(a_EventLoop->m_EventBase, SignalizeStartup, a_EventLoop);
 	timeval timeout{};  // Zero timeout - execute immediately
 	evtimer_add(timer, &timeout);
-	event_base_loop(a_Self->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
+	event_base_loop(a_EventLoop->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
 	event_free(timer);
 }
 
@@ -174,11 +241,65 @@ void cNetworkSingleton::RunEventLoop(cNetworkSingleton * a_Self)
 
 
 
-void cNetworkSingleton::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self)
+void cNetworkSingleton::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop)
+{
+	auto Loop = static_cast<sEventLoop *>(a_EventLoop);
+	ASSERT(Loop != nullptr);
+	Loop->m_StartupEvent.Set();
+}
+
+
+
+
+
+event_base * cNetworkSingleton::AcquireLinkEventBase(void)
 {
-	auto self = static_cast<cNetworkSingleton *>(a_Self);
-	ASSERT(self != nullptr);
-	self->m_StartupEvent.Set();
+	cCSLock Lock(m_CS);
+	ASSERT(!m_EventLoops.empty());
+
+	// Pick the loop with the fewest links, starting after the last picked one so that the equally loaded loops take turns:
+	auto NumLoops = m_EventLoops.size();
+	auto Best = m_NextEventLoop % NumLoops;
+	for (size_t i = 1; i < NumLoops; i++)
+	{
+		auto Idx = (m_NextEventLoop + i) % NumLoops;
+		if (m_EventLoops[Idx]->m_NumLinks < m_EventLoops[Best]->m_NumLinks)
+		{
+			Best = Idx;
+		}
+	}
+	m_NextEventLoop = Best + 1;
+	m_EventLoops[Best]->m_NumLinks += 1;
+	return m_EventLoops[Best]->m_EventBase;
+}
+
+
+
+
+
+void cNetworkSingleton::ReleaseLinkEventBase(event_base * a_EventBase)
+{
+	cCSLock Lock(m_CS);
+	for (auto & Loop: m_EventLoops)
+	{
+		if (Loop->m_EventBase == a_EventBase)
+		{
+			ASSERT(Loop->m_NumLinks > 0);
+			Loop->m_NumLinks -= 1;
+			return;
+		}
+	}
+	// The link has outlived the loop (freed after Terminate()), nothing to update
+}
+
+
+
+
+
+size_t cNetworkSingleton::GetNumEventLoops(void)
+{
+	cCSLock Lock(m_CS);
+	return m_EventLoops.size();
 }
 
 
@@ -242,3 +363,15 @@ void cNetworkSingleton::RemoveServer(const cServerHandle * a_Server)
 
 
 
+
+////////////////////////////////////////////////////////////////////////////////
+// cNetwork API:
+
+void cNetwork::StartEventLoops(unsigned a_NumEventLoops)
+{
+	cNetworkSingleton::Get().StartEventLoops(a_NumEventLoops);
+}
+
+
+
+
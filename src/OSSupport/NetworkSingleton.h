@@ -2,11 +2,19 @@
 // NetworkSingleton.h
 
 // Declares the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
 
 // This is an internal header, no-one outside OSSupport should need to include it; use Network.h instead;
 // the only exception being the main app entrypoint that needs to call Terminate before quitting.
 
+/*
+There is always the main event loop, which handles the listening sockets, the UDP endpoints and the TCP links
+created until more loops are started. Additional loops can be started by StartEventLoops() to spread the TCP links
+over more threads; each link is assigned to the loop with the fewest links when it is created and stays on that loop
+for its whole lifetime, so all of a link's callbacks are still called from a single thread, in order.
+Callbacks of different links may run in parallel, though.
+*/
+
 
 
 
@@ -45,9 +53,14 @@ public:
 	static cNetworkSingleton & Get(void);
 
 	/** Initialises all network-related threads.
+	Only the main event loop is started, use StartEventLoops() to add more.
 	To be called on first run or after app restart. */
 	void Initialise(void);
 
+	/** Starts additional event loops for the TCP links, so that there are (at least) a_NumEventLoops loops in total.
+	The number of loops can only grow, all of them are stopped in Terminate(). */
+	void StartEventLoops(unsigned a_NumEventLoops);
+
 	/** Terminates all network-related threads.
 	To be used only on app shutdown or restart.
 	MSVC runtime requires that the LibEvent networking be shut down before the main() function is exitted; this is the way to do it. */
@@ -56,6 +69,16 @@ public:
 	/** Returns the main LibEvent handle for event registering. */
 	event_base * GetEventBase(void) { return m_EventBase; }
 
+	/** Returns the LibEvent handle on which a new TCP link should be created, the one with the fewest links.
+	Each call must be paired with a ReleaseLinkEventBase() call once the link's bufferevent is freed. */
+	event_base * AcquireLinkEventBase(void);
+
+	/** Notifies the singleton that a link created on the specified LibEvent handle has been freed. */
+	void ReleaseLinkEventBase(event_base * a_EventBase);
+
+	/** Returns the number of event loops currently running. */
+	size_t GetNumEventLoops(void);
+
 	/** Returns the thread used to perform hostname and IP lookups */
 	cNetworkLookup & GetLookupThread() { return m_LookupThread; }
 
@@ -78,9 +101,39 @@ public:
 
 protected:
 
-	/** The main LibEvent container for driving the event loop. */
+	/** A single LibEvent loop with its own thread. */
+	struct sEventLoop
+	{
+		/** The LibEvent container driving the loop. */
+		event_base * m_EventBase;
+
+		/** The thread in which the loop runs. */
+		std::thread m_Thread;
+
+		/** Event that is signalled once the loop is actually running. */
+		cEvent m_StartupEvent;
+
+		/** The number of TCP links currently assigned to this loop. Protected by cNetworkSingleton::m_CS. */
+		size_t m_NumLinks;
+
+		sEventLoop(void):
+			m_EventBase(nullptr),
+			m_NumLinks(0)
+		{
+		}
+	};
+
+	/** The main LibEvent container for driving the event loop.
+	Same as m_EventLoops[0]->m_EventBase, kept separately so that it can be read without locking. */
 	event_base * m_EventBase;
 
+	/** All the event loops, the main loop being the first one. Protected by m_CS. */
+	std::vector<std::unique_ptr<sEventLoop>> m_EventLoops;
+
+	/** Index into m_EventLoops where the search for the least loaded loop starts, so that the loops with the
+	same load are used in a round-robin fashion. Protected by m_CS. */
+	size_t m_NextEventLoop;
+
 	/** Container for all client connections, including ones with pending-connect. */
 	cTCPLinkPtrs m_Connections;
 
@@ -93,12 +146,6 @@ protected:
 	/** Set to true if Terminate has been called. */
 	std::atomic<bool> m_HasTerminated;
 
-	/** The thread in which the main LibEvent loop runs. */
-	std::thread m_EventLoopThread;
-
-	/** Event that is signalled once the startup is finished and the LibEvent loop is running. */
-	cEvent m_StartupEvent;
-
 	/** The thread on which hostname and ip address lookup is performed. */
 	cNetworkLookup m_LookupThread;
 
@@ -106,11 +153,15 @@ protected:
 	/** Converts LibEvent-generated log events into log messages in MCS log. */
 	static void LogCallback(int a_Severity, const char * a_Msg);
 
+	/** Creates a new event_base and starts its loop on a new thread.
+	Returns once the loop is running. Aborts the server if LibEvent fails to create the base. */
+	static std::unique_ptr<sEventLoop> StartEventLoop(void);
+
 	/** Implements the thread that runs LibEvent's event dispatcher loop. */
-	static void RunEventLoop(cNetworkSingleton * a_Self);
+	static void RunEventLoop(sEventLoop * a_EventLoop);
 
 	/** Callback called by LibEvent when the event loop is started. */
-	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self);
+	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop);
 };
 
 
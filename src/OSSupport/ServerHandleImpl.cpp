@@ -324,7 +324,7 @@ void cServerHandleImpl::Callback(evconnlistener * a_Listener, evutil_socket_t a_
 		return;
 	}
 
-	// Create a new cTCPLink for the incoming connection:
+	// Create a new cTCPLink for the incoming connection (the link picks the least loaded event loop to run on):
 	cTCPLinkImplPtr Link = std::make_shared<cTCPLinkImpl>(a_Socket, LinkCallbacks, Self->m_SelfPtr, a_Addr, static_cast<socklen_t>(a_Len));
 	{
 		cCSLock Lock(Self->m_CS);
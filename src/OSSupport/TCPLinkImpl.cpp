@@ -19,7 +19,8 @@
 
 cTCPLinkImpl::cTCPLinkImpl(cTCPLink::cCallbacksPtr a_LinkCallbacks):
 	Super(std::move(a_LinkCallbacks)),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventBase(cNetworkSingleton::Get().AcquireLinkEventBase()),
+	m_BufferEvent(bufferevent_socket_new(m_EventBase, -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_LocalPort(0),
 	m_RemotePort(0),
 	m_ShouldShutdown(false)
@@ -32,7 +33,8 @@ cTCPLinkImpl::cTCPLinkImpl(cTCPLink::cCallbacksPtr a_LinkCallbacks):
 
 cTCPLinkImpl::cTCPLinkImpl(evutil_socket_t a_Socket, cTCPLink::cCallbacksPtr a_LinkCallbacks, cServerHandleImplPtr a_Server, const sockaddr * a_Address, socklen_t a_AddrLen):
 	Super(std::move(a_LinkCallbacks)),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventBase(cNetworkSingleton::Get().AcquireLinkEventBase()),
+	m_BufferEvent(bufferevent_socket_new(m_EventBase, a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_Server(std::move(a_Server)),
 	m_LocalPort(0),
 	m_RemotePort(0),
@@ -53,6 +55,7 @@ cTCPLinkImpl::~cTCPLinkImpl()
 	m_TlsContext.reset();
 
 	bufferevent_free(m_BufferEvent);
+	cNetworkSingleton::Get().ReleaseLinkEventBase(m_EventBase);
 }
 
 
@@ -235,6 +238,24 @@ void cTCPLinkImpl::Close(void)
 
 
 
+void cTCPLinkImpl::PauseReading(void)
+{
+	bufferevent_disable(m_BufferEvent, EV_READ);
+}
+
+
+
+
+
+void cTCPLinkImpl::ResumeReading(void)
+{
+	bufferevent_enable(m_BufferEvent, EV_READ);
+}
+
+
+
+
+
 AString cTCPLinkImpl::StartTLSClient(
 	cX509CertPtr a_OwnCert,
 	cCryptoKeyPtr a_OwnPrivKey
@@ -66,6 +66,8 @@ public:
 	virtual UInt16 GetRemotePort(void) const override { return m_RemotePort; }
 	virtual void Shutdown(void) override;
 	virtual void Close(void) override;
+	virtual void PauseReading(void) override;
+	virtual void ResumeReading(void) override;
 	virtual AString StartTLSClient(
 		cX509CertPtr a_OwnCert,
 		cCryptoKeyPtr a_OwnPrivKey
@@ -137,6 +139,10 @@ protected:
 	May be NULL if not used. Only used for outgoing connections (cNetwork::Connect()). */
 	cNetwork::cConnectCallbacksPtr m_ConnectCallbacks;
 
+	/** The LibEvent base of the event loop that handles this connection.
+	Acquired from cNetworkSingleton in the constructor, released in the destructor. */
+	event_base * m_EventBase;
+
 	/** The LibEvent handle representing this connection. */
 	bufferevent * m_BufferEvent;
 
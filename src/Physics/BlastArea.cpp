@@ -0,0 +1,449 @@
+// BlastArea.cpp
+
+// Implements the cBlastArea class representing a snapshot of the blocks around an explosion, in which the explosion's rays are traced
+
+#include "Globals.h"
+#include "BlastArea.h"
+#include "BlockType.h"
+
+
+
+
+
+/** Distance travelled by a destruction ray in a single step. */
+static const float StepUnit = 0.3f;
+
+/** Intensity lost by a destruction ray in each step, in addition to the absorption of the block it is in. */
+static const float StepAttenuation = 0.225f;
+
+/** Length of the side of the cube whose surface points give the directions of the destruction rays. */
+static const int TraceCubeSideLength = 16;
+
+/** Distance between the sample points of an entity's bounding box, for calculating its exposure. */
+static const double BoundingBoxStepUnit = 0.5;
+
+/** The largest radius of an area, regardless of the explosion's power.
+Limits the memory used for the huge powers that plugins may ask for, to about 4 MiB of blocks. */
+static const int MaxRadius = 64;
+
+
+
+
+
+/** Returns the steps of all the destruction rays of an explosion, in the order the rays are traced.
+The rays go from the explosion centre to all points on the surface of a TraceCubeSideLength cube,
+as described in http://minecraft.gamepedia.com/Explosion */
+static const std::vector<Vector3f> & GetRaySteps(void)
+{
+	static const std::vector<Vector3f> Steps = []()
+	{
+		const int HalfSide = TraceCubeSideLength / 2;
+		std::vector<Vector3f> Res;
+		auto AddRay = [&Res](int a_X, int a_Y, int a_Z)
+		{
+			Res.push_back(Vector3f(Vector3i(a_X, a_Y, a_Z)).NormalizeCopy() * StepUnit);
+		};
+
+		// Top and bottom sides:
+		for (int OffsetX = -HalfSide; OffsetX < HalfSide; OffsetX++)
+		{
+			for (int OffsetZ = -HalfSide; OffsetZ < HalfSide; OffsetZ++)
+			{
+				AddRay(OffsetX, +HalfSide, OffsetZ);
+				AddRay(OffsetX, -HalfSide, OffsetZ);
+			}
+		}
+
+		// Left and right sides, avoid duplicates at top and bottom edges:
+		for (int OffsetX = -HalfSide; OffsetX < HalfSide; OffsetX++)
+		{
+			for (int OffsetY = -HalfSide + 1; OffsetY < HalfSide - 1; OffsetY++)
+			{
+				AddRay(OffsetX, OffsetY, +HalfSide);
+				AddRay(OffsetX, OffsetY, -HalfSide);
+			}
+		}
+
+		// Front and back sides, avoid all edges:
+		for (int OffsetZ = -HalfSide + 1; OffsetZ < HalfSide - 1; OffsetZ++)
+		{
+			for (int OffsetY = -HalfSide + 1; OffsetY < HalfSide - 1; OffsetY++)
+			{
+				AddRay(+HalfSide, OffsetY, OffsetZ);
+				AddRay(-HalfSide, OffsetY, OffsetZ);
+			}
+		}
+		return Res;
+	}();
+	return Steps;
+}
+
+
+
+
+
+/** Returns the explosion absorption of all block types, as a lookup table. */
+static const std::array<float, 256> & GetAbsorptionTable(void)
+{
+	static const std::array<float, 256> Table = []()
+	{
+		std::array<float, 256> Res;
+		for (size_t i = 0; i < Res.size(); i++)
+		{
+			Res[i] = cBlastArea::GetExplosionAbsorption(static_cast<BLOCKTYPE>(i));
+		}
+		return Res;
+	}();
+	return Table;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cBlastArea:
+
+cBlastArea::cBlastArea(const Vector3i a_Centre, int a_Radius)
+{
+	a_Radius = Clamp(a_Radius, 0, MaxRadius);
+	const int MinY = std::max(a_Centre.y - a_Radius, 0);
+	const int MaxY = std::min(a_Centre.y + a_Radius, cChunkDef::Height - 1);
+	m_Origin = { a_Centre.x - a_Radius, MinY, a_Centre.z - a_Radius };
+	m_Size = { 2 * a_Radius + 1, std::max(MaxY - MinY + 1, 0), 2 * a_Radius + 1 };
+	m_Blocks.assign(static_cast<size_t>(m_Size.x * m_Size.y * m_Size.z), E_BLOCK_AIR);
+	m_HasData.assign(static_cast<size_t>(m_Size.x * m_Size.z), false);
+}
+
+
+
+
+
+int cBlastArea::GetRadiusForPower(const int a_Power)
+{
+	// The strongest ray has intensity 1.3 * Power and loses at least StepAttenuation + air absorption in each step:
+	const auto MinLossPerStep = StepAttenuation + GetExplosionAbsorption(E_BLOCK_AIR);
+	const auto RayReach = std::ceil(1.3f * static_cast<float>(a_Power) / MinLossPerStep * StepUnit) + 1;
+
+	// Entities are affected within twice the power, their sample points may be in the next block:
+	const auto EntityReach = 2 * static_cast<float>(a_Power) + 1;
+
+	// Computed in floats, so that huge powers don't overflow before being clamped:
+	return static_cast<int>(Clamp(std::max(RayReach, EntityReach), 0.f, static_cast<float>(MaxRadius)));
+}
+
+
+
+
+
+float cBlastArea::GetExplosionAbsorption(const BLOCKTYPE a_Block)
+{
+	switch (a_Block)
+	{
+		case E_BLOCK_BEDROCK:
+		case E_BLOCK_COMMAND_BLOCK:
+		case E_BLOCK_END_GATEWAY:
+		case E_BLOCK_END_PORTAL:
+		case E_BLOCK_END_PORTAL_FRAME: return 1080000.09f;
+		case E_BLOCK_ANVIL:
+		case E_BLOCK_ENCHANTMENT_TABLE:
+		case E_BLOCK_OBSIDIAN: return 360.09f;
+		case E_BLOCK_ENDER_CHEST: return 180.09f;
+		case E_BLOCK_LAVA:
+		case E_BLOCK_STATIONARY_LAVA:
+		case E_BLOCK_WATER:
+		case E_BLOCK_STATIONARY_WATER: return 30.09f;
+		case E_BLOCK_DRAGON_EGG:
+		case E_BLOCK_END_STONE:
+		case E_BLOCK_END_BRICKS: return 2.79f;
+		case E_BLOCK_STONE:
+		case E_BLOCK_BLOCK_OF_COAL:
+		case E_BLOCK_DIAMOND_BLOCK:
+		case E_BLOCK_EMERALD_BLOCK:
+		case E_BLOCK_GOLD_BLOCK:
+		case E_BLOCK_IRON_BLOCK:
+		case E_BLOCK_BLOCK_OF_REDSTONE:
+		case E_BLOCK_BRICK:
+		case E_BLOCK_BRICK_STAIRS:
+		case E_BLOCK_COBBLESTONE:
+		case E_BLOCK_COBBLESTONE_STAIRS:
+		case E_BLOCK_IRON_BARS:
+		case E_BLOCK_JUKEBOX:
+		case E_BLOCK_MOSSY_COBBLESTONE:
+		case E_BLOCK_NETHER_BRICK:
+		case E_BLOCK_NETHER_BRICK_FENCE:
+		case E_BLOCK_NETHER_BRICK_STAIRS:
+		case E_BLOCK_PRISMARINE_BLOCK:
+		case E_BLOCK_STONE_BRICKS:
+		case E_BLOCK_STONE_BRICK_STAIRS:
+		case E_BLOCK_COBBLESTONE_WALL: return 1.89f;
+		case E_BLOCK_IRON_DOOR:
+		case E_BLOCK_IRON_TRAPDOOR:
+		case E_BLOCK_MOB_SPAWNER: return 1.59f;
+		case E_BLOCK_HOPPER: return 1.53f;
+		case E_BLOCK_TERRACOTTA: return 1.35f;
+		case E_BLOCK_COBWEB: return 1.29f;
+		case E_BLOCK_DISPENSER:
+		case E_BLOCK_DROPPER:
+		case E_BLOCK_FURNACE:
+		case E_BLOCK_OBSERVER: return 1.14f;
+		case E_BLOCK_BEACON:
+		case E_BLOCK_COAL_ORE:
+		case E_BLOCK_COCOA_POD:
+		case E_BLOCK_DIAMOND_ORE:
+		case E_BLOCK_EMERALD_ORE:
+		case E_BLOCK_GOLD_ORE:
+		case E_BLOCK_IRON_ORE:
+		case E_BLOCK_LAPIS_BLOCK:
+		case E_BLOCK_LAPIS_ORE:
+		case E_BLOCK_NETHER_QUARTZ_ORE:
+		case E_BLOCK_PLANKS:
+		case E_BLOCK_REDSTONE_ORE:
+		case E_BLOCK_FENCE:
+		case E_BLOCK_FENCE_GATE:
+		case E_BLOCK_WOODEN_DOOR:
+		case E_BLOCK_WOODEN_SLAB:
+		case E_BLOCK_WOODEN_STAIRS:
+		case E_BLOCK_TRAPDOOR: return 0.99f;
+		case E_BLOCK_CHEST:
+		case E_BLOCK_WORKBENCH:
+		case E_BLOCK_TRAPPED_CHEST: return 0.84f;
+		case E_BLOCK_BONE_BLOCK:
+		case E_BLOCK_CAULDRON:
+		case E_BLOCK_LOG: return 0.69f;  // nIcE
+		case E_BLOCK_CONCRETE: return 0.63f;
+		case E_BLOCK_BOOKCASE: return 0.54f;
+		case E_BLOCK_STANDING_BANNER:
+		case E_BLOCK_WALL_BANNER:
+		case E_BLOCK_JACK_O_LANTERN:
+		case E_BLOCK_MELON:
+		case E_BLOCK_HEAD:
+		case E_BLOCK_NETHER_WART_BLOCK:
+		case E_BLOCK_PUMPKIN:
+		case E_BLOCK_SIGN_POST:
+		case E_BLOCK_WALLSIGN: return 0.39f;
+		case E_BLOCK_QUARTZ_BLOCK:
+		case E_BLOCK_QUARTZ_STAIRS:
+		case E_BLOCK_RED_SANDSTONE:
+		case E_BLOCK_RED_SANDSTONE_STAIRS:
+		case E_BLOCK_SANDSTONE:
+		case E_BLOCK_SANDSTONE_STAIRS:
+		case E_BLOCK_WOOL: return 0.33f;
+		case E_BLOCK_SILVERFISH_EGG: return 0.315f;
+		case E_BLOCK_ACTIVATOR_RAIL:
+		case E_BLOCK_DETECTOR_RAIL:
+		case E_BLOCK_POWERED_RAIL:
+		case E_BLOCK_RAIL: return 0.3f;
+		case E_BLOCK_GRASS_PATH:
+		case E_BLOCK_CLAY:
+		case E_BLOCK_FARMLAND:
+		case E_BLOCK_GRASS:
+		case E_BLOCK_GRAVEL:
+		case E_BLOCK_SPONGE: return 0.27f;
+		case E_BLOCK_BREWING_STAND:
+		case E_BLOCK_STONE_BUTTON:
+		case E_BLOCK_WOODEN_BUTTON:
+		case E_BLOCK_CAKE:
+		case E_BLOCK_CONCRETE_POWDER:
+		case E_BLOCK_DIRT:
+		case E_BLOCK_FROSTED_ICE:
+		case E_BLOCK_HAY_BALE:
+		case E_BLOCK_ICE: return 0.24f;
+		default: return 0.09f;
+	}
+}
+
+
+
+
+
+void cBlastArea::SetBlock(const Vector3i a_Pos, const BLOCKTYPE a_BlockType)
+{
+	const auto RelPos = a_Pos - m_Origin;
+	ASSERT(IsInside(RelPos));
+	m_Blocks[MakeIndex(RelPos)] = a_BlockType;
+	m_HasData[static_cast<size_t>(RelPos.x + RelPos.z * m_Size.x)] = true;
+}
+
+
+
+
+
+std::vector<Vector3i> cBlastArea::TraceDestruction(const Vector3f a_Position, const int a_Power, MTRand & a_Random)
+{
+	const auto & Absorption = GetAbsorptionTable();
+	const auto Origin = a_Position - Vector3f(m_Origin);
+	const auto SizeX = static_cast<unsigned>(m_Size.x);
+	const auto SizeY = static_cast<unsigned>(m_Size.y);
+	const auto SizeZ = static_cast<unsigned>(m_Size.z);
+
+	std::vector<Vector3i> Destroyed;
+	for (const auto & Step: GetRaySteps())
+	{
+		// Each ray has a random intensity and loses some of it in each step until it is exhausted:
+		auto Intensity = static_cast<float>(a_Power) * (0.7f + a_Random.RandReal(0.6f));
+		auto Checkpoint = Origin;
+		while (Intensity > 0)
+		{
+			if ((Checkpoint.x < 0) || (Checkpoint.y < 0) || (Checkpoint.z < 0))
+			{
+				// Out of the area (or the world) on the lower side:
+				break;
+			}
+
+			// The coords are non-negative, truncating is the same as flooring, only faster:
+			const auto X = static_cast<unsigned>(Checkpoint.x);
+			const auto Y = static_cast<unsigned>(Checkpoint.y);
+			const auto Z = static_cast<unsigned>(Checkpoint.z);
+			if ((X >= SizeX) || (Y >= SizeY) || (Z >= SizeZ))
+			{
+				// Out of the area (or the world) on the upper side:
+				break;
+			}
+
+			if (!m_HasData[X + SizeX * Z])
+			{
+				// Hit a chunk that isn't available:
+				break;
+			}
+
+			// The destroyed blocks are turned into air right in the area, so the later rays pass through them:
+			const auto Index = X + SizeX * (Z + SizeZ * Y);
+			Intensity -= Absorption[m_Blocks[Index]];
+			if (Intensity <= 0)
+			{
+				// The ray is exhausted:
+				break;
+			}
+
+			if (m_Blocks[Index] != E_BLOCK_AIR)
+			{
+				m_Blocks[Index] = E_BLOCK_AIR;
+				Destroyed.emplace_back(Vector3i(static_cast<int>(X), static_cast<int>(Y), static_cast<int>(Z)) + m_Origin);
+			}
+
+			// Increment the simulation, weaken the ray:
+			Checkpoint += Step;
+			Intensity -= StepAttenuation;
+		}
+	}
+	return Destroyed;
+}
+
+
+
+
+
+float cBlastArea::CalculateExposure(const Vector3d a_Position, const cBoundingBox & a_Box, const double a_SquareRadius) const
+{
+	const Vector3d Origin(m_Origin);
+	const auto Start = a_Position - Origin;
+	unsigned Unobstructed = 0, Total = 0;
+
+	for (double X = a_Box.GetMinX(); X < a_Box.GetMaxX(); X += BoundingBoxStepUnit)
+	{
+		for (double Y = a_Box.GetMinY(); Y < a_Box.GetMaxY(); Y += BoundingBoxStepUnit)
+		{
+			for (double Z = a_Box.GetMinZ(); Z < a_Box.GetMaxZ(); Z += BoundingBoxStepUnit)
+			{
+				const Vector3d Destination{X, Y, Z};
+				if ((Destination - a_Position).SqrLength() > a_SquareRadius)
+				{
+					// Don't bother with points outside our designated area-of-effect
+					continue;
+				}
+
+				if (HasLineOfSight(Start, Destination - Origin))
+				{
+					Unobstructed++;
+				}
+				Total++;
+			}
+		}
+	}
+
+	return (Total == 0) ? 0 : (static_cast<float>(Unobstructed) / static_cast<float>(Total));
+}
+
+
+
+
+
+bool cBlastArea::HasLineOfSight(const Vector3d a_Start, const Vector3d a_End) const
+{
+	// Walk the blocks along the line the same way cLineBlockTracer does, always moving to the neighbour through the nearest wall:
+	static const double EPS = 0.00001;
+	const Vector3d Diff = a_End - a_Start;
+	const Vector3i Dir(
+		(a_Start.x < a_End.x) ? 1 : -1,
+		(a_Start.y < a_End.y) ? 1 : -1,
+		(a_Start.z < a_End.z) ? 1 : -1
+	);
+	const int WorldMinY = -m_Origin.y;
+	const int WorldMaxY = cChunkDef::Height - 1 - m_Origin.y;
+	auto Current = a_Start.Floor();
+	if ((Current.y < WorldMinY) || (Current.y > WorldMaxY))
+	{
+		// Starting outside the world, there's nothing to block the view
+		return true;
+	}
+
+	for (;;)
+	{
+		// Find the nearest wall hit by the line:
+		double Coeff = 1;
+		int Axis = -1;
+		if (std::abs(Diff.x) > EPS)
+		{
+			double CoeffX = (((Dir.x > 0) ? (Current.x + 1) : Current.x) - a_Start.x) / Diff.x;
+			if (CoeffX <= 1)
+			{
+				Coeff = CoeffX;
+				Axis = 0;
+			}
+		}
+		if (std::abs(Diff.y) > EPS)
+		{
+			double CoeffY = (((Dir.y > 0) ? (Current.y + 1) : Current.y) - a_Start.y) / Diff.y;
+			if (CoeffY <= Coeff)
+			{
+				Coeff = CoeffY;
+				Axis = 1;
+			}
+		}
+		if (std::abs(Diff.z) > EPS)
+		{
+			double CoeffZ = (((Dir.z > 0) ? (Current.z + 1) : Current.z) - a_Start.z) / Diff.z;
+			if (CoeffZ <= Coeff)
+			{
+				Axis = 2;
+			}
+		}
+		switch (Axis)
+		{
+			case 0: Current.x += Dir.x; break;
+			case 1: Current.y += Dir.y; break;
+			case 2: Current.z += Dir.z; break;
+			default:
+			{
+				// Reached the end
+				return true;
+			}
+		}
+
+		if ((Current.y < WorldMinY) || (Current.y > WorldMaxY))
+		{
+			// Left the world vertically
+			return true;
+		}
+		if (!IsInside(Current) || !HasData(Current) || (m_Blocks[MakeIndex(Current)] != E_BLOCK_AIR))
+		{
+			return false;
+		}
+	}
+}
+
+
+
+
+
@@ -0,0 +1,104 @@
+
+// BlastArea.h
+
+// Declares the cBlastArea class representing a snapshot of the blocks around an explosion, in which the explosion's rays are traced
+
+/*
+Tracing the explosion directly in the world means resolving the chunk and reading the block for every step of each
+of the 1352 rays, and a full line trace for each sample point of each entity in range. The area is filled once per
+explosion from the chunks and then all the tracing is done in a dense array, with no chunk lookups.
+
+The destruction rays turn the blocks they destroy into air in the area itself, so that the following rays see them
+the same as if the blocks were destroyed in the world right away. The destroyed blocks are collected and returned,
+so that the caller can apply all of them in a single pass afterwards. Since the tracing changes the area, the exposure
+of the entities is calculated before it.
+The radius of the area is limited, explosions of huge powers only affect the blocks and entities within the limit.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../BoundingBox.h"
+#include "../ChunkDef.h"
+#include "../FastRandom.h"
+
+
+
+
+
+class cBlastArea
+{
+public:
+
+	/** Creates an area of blocks within the specified radius around the centre block, with no block data yet.
+	The radius is clamped to a fixed maximum, the area is clipped to the world's height. */
+	cBlastArea(Vector3i a_Centre, int a_Radius);
+
+	/** Returns the radius of the area needed to trace an explosion of the specified power,
+	covering both the reach of its destruction rays and the range where it damages entities, up to the maximum radius. */
+	static int GetRadiusForPower(int a_Power);
+
+	/** Returns the amount of an explosion ray's intensity absorbed by the block in each 0.3-block step. */
+	static float GetExplosionAbsorption(BLOCKTYPE a_Block);
+
+	/** Returns the absolute coords of the area's bounds, inclusive. */
+	Vector3i GetMinPos(void) const { return m_Origin; }
+	Vector3i GetMaxPos(void) const { return m_Origin + m_Size - Vector3i(1, 1, 1); }
+
+	/** Stores the block at the specified absolute coords, which must be within the area.
+	Marks the whole column as having data; columns without data stop any rays passing through them. */
+	void SetBlock(Vector3i a_Pos, BLOCKTYPE a_BlockType);
+
+	/** Traces the block-destroying rays of an explosion of the specified power, centred at the specified absolute position.
+	Returns the absolute coords of the non-air blocks destroyed, each only once, in the order they were first reached.
+	The destroyed blocks are replaced with air in the area. */
+	std::vector<Vector3i> TraceDestruction(Vector3f a_Position, int a_Power, MTRand & a_Random);
+
+	/** Returns the fraction of the sample points of the bounding box, within the specified square radius of the position,
+	that have an unobstructed line of sight to the position. */
+	float CalculateExposure(Vector3d a_Position, const cBoundingBox & a_Box, double a_SquareRadius) const;
+
+private:
+
+	/** Absolute coords of the area's lowest corner. */
+	Vector3i m_Origin;
+
+	/** Size of the area, in blocks. */
+	Vector3i m_Size;
+
+	/** The blocks, indexed by MakeIndex(). */
+	std::vector<BLOCKTYPE> m_Blocks;
+
+	/** Whether each column (indexed by x + z * m_Size.x) has been filled with block data. */
+	std::vector<bool> m_HasData;
+
+
+	/** Returns true if the relative coords are within the area. */
+	bool IsInside(Vector3i a_RelPos) const
+	{
+		return (
+			(a_RelPos.x >= 0) && (a_RelPos.x < m_Size.x) &&
+			(a_RelPos.y >= 0) && (a_RelPos.y < m_Size.y) &&
+			(a_RelPos.z >= 0) && (a_RelPos.z < m_Size.z)
+		);
+	}
+
+	/** Returns the index into m_Blocks of the block at the specified relative coords. */
+	size_t MakeIndex(Vector3i a_RelPos) const
+	{
+		return static_cast<size_t>(a_RelPos.x + m_Size.x * (a_RelPos.z + m_Size.z * a_RelPos.y));
+	}
+
+	/** Returns true if the column at the specified relative coords has block data. */
+	bool HasData(Vector3i a_RelPos) const
+	{
+		return m_HasData[static_cast<size_t>(a_RelPos.x + a_RelPos.z * m_Size.x)];
+	}
+
+	/** Returns true if there are only air blocks on the line between the two points (relative coords).
+	The starting block is not checked, the ending block is; leaving the world vertically counts as unobstructed. */
+	bool HasLineOfSight(Vector3d a_Start, Vector3d a_End) const;
+};
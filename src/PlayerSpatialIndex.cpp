@@ -0,0 +1,157 @@
+
+// PlayerSpatialIndex.cpp
+
+// Implements the cPlayerSpatialIndex class representing the players of a world bucketed by the chunk they're in
+
+#include "Globals.h"
+#include "PlayerSpatialIndex.h"
+#include "Entities/Player.h"
+
+
+
+
+
+void cPlayerSpatialIndex::Update(cPlayer & a_Player, cChunkCoords a_Chunk)
+{
+	auto itr = m_PlayerChunks.find(&a_Player);
+	if (itr != m_PlayerChunks.end())
+	{
+		if (itr->second == a_Chunk)
+		{
+			return;
+		}
+		RemoveFromBucket(a_Player, itr->second);
+		itr->second = a_Chunk;
+	}
+	else
+	{
+		m_PlayerChunks.emplace(&a_Player, a_Chunk);
+	}
+	m_Buckets[a_Chunk].push_back(&a_Player);
+}
+
+
+
+
+
+void cPlayerSpatialIndex::Remove(cPlayer & a_Player)
+{
+	auto itr = m_PlayerChunks.find(&a_Player);
+	if (itr == m_PlayerChunks.end())
+	{
+		return;
+	}
+	RemoveFromBucket(a_Player, itr->second);
+	m_PlayerChunks.erase(itr);
+}
+
+
+
+
+
+bool cPlayerSpatialIndex::ForEachPlayerInRange(Vector3d a_Pos, double a_Range, cFunctionRef<bool(cPlayer &)> a_Callback) const
+{
+	// Collect the players first, so that the callback may safely do anything that moves players in the index:
+	cNearestPlayers Players;
+	CollectPlayersInRange(a_Pos, a_Range, Players);
+	for (const auto & Player: Players)
+	{
+		if (a_Callback(*Player.second))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+void cPlayerSpatialIndex::FindNearestPlayers(Vector3d a_Pos, double a_Range, size_t a_MaxCount, cNearestPlayers & a_Nearest) const
+{
+	a_Nearest.clear();
+	CollectPlayersInRange(a_Pos, a_Range, a_Nearest);
+	if (a_Nearest.size() > a_MaxCount)
+	{
+		std::partial_sort(a_Nearest.begin(), a_Nearest.begin() + static_cast<std::ptrdiff_t>(a_MaxCount), a_Nearest.end());
+		a_Nearest.resize(a_MaxCount);
+	}
+	else
+	{
+		std::sort(a_Nearest.begin(), a_Nearest.end());
+	}
+}
+
+
+
+
+
+void cPlayerSpatialIndex::RemoveFromBucket(cPlayer & a_Player, cChunkCoords a_Chunk)
+{
+	auto Bucket = m_Buckets.find(a_Chunk);
+	if (Bucket == m_Buckets.end())
+	{
+		ASSERT(!"Indexed player not found in their bucket");
+		return;
+	}
+	auto & Players = Bucket->second;
+	Players.erase(std::remove(Players.begin(), Players.end(), &a_Player), Players.end());
+	if (Players.empty())
+	{
+		m_Buckets.erase(Bucket);
+	}
+}
+
+
+
+
+
+void cPlayerSpatialIndex::CollectPlayersInRange(Vector3d a_Pos, double a_Range, cNearestPlayers & a_Players) const
+{
+	const auto RangeSqr = a_Range * a_Range;
+	auto AddBucket = [&a_Players, a_Pos, RangeSqr](const std::vector<cPlayer *> & a_Bucket)
+	{
+		for (const auto Player: a_Bucket)
+		{
+			const auto DistanceSqr = (Player->GetPosition() - a_Pos).SqrLength();
+			if (DistanceSqr <= RangeSqr)
+			{
+				a_Players.emplace_back(DistanceSqr, Player);
+			}
+		}
+	};
+
+	// The chunks intersecting the range, in doubles so that huge ranges don't overflow:
+	const auto MinChunkX = std::floor((a_Pos.x - a_Range) / cChunkDef::Width);
+	const auto MaxChunkX = std::floor((a_Pos.x + a_Range) / cChunkDef::Width);
+	const auto MinChunkZ = std::floor((a_Pos.z - a_Range) / cChunkDef::Width);
+	const auto MaxChunkZ = std::floor((a_Pos.z + a_Range) / cChunkDef::Width);
+	const auto NumChunks = (MaxChunkX - MinChunkX + 1) * (MaxChunkZ - MinChunkZ + 1);
+
+	// If the range covers more chunks than there are buckets, it's cheaper to go through the buckets:
+	if (NumChunks > static_cast<double>(m_Buckets.size()))
+	{
+		for (const auto & Bucket: m_Buckets)
+		{
+			AddBucket(Bucket.second);
+		}
+		return;
+	}
+
+	for (auto ChunkX = static_cast<int>(MinChunkX); ChunkX <= static_cast<int>(MaxChunkX); ChunkX++)
+	{
+		for (auto ChunkZ = static_cast<int>(MinChunkZ); ChunkZ <= static_cast<int>(MaxChunkZ); ChunkZ++)
+		{
+			auto Bucket = m_Buckets.find({ChunkX, ChunkZ});
+			if (Bucket != m_Buckets.end())
+			{
+				AddBucket(Bucket->second);
+			}
+		}
+	}
+}
+
+
+
+
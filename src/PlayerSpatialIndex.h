@@ -0,0 +1,80 @@
+
+// PlayerSpatialIndex.h
+
+// Declares the cPlayerSpatialIndex class representing the players of a world bucketed by the chunk they're in
+
+/*
+The index lets the range and nearest-player queries look only at the chunks around the queried position,
+instead of going through all the players in the world.
+
+A player is moved between buckets when their entity is moved into a new chunk (cChunk::AddEntity()),
+which happens on the chunk's tick; a player that has just moved (or teleported) across a chunk border
+may be found in their old bucket until then. The queries compare the players' current positions, though.
+
+The index is owned by cWorld and is protected by the same lock as the world's player list (the chunkmap lock).
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkDef.h"
+#include "FunctionRef.h"
+
+
+
+
+
+// fwd:
+class cPlayer;
+
+
+
+
+
+class cPlayerSpatialIndex
+{
+public:
+
+	/** A player found by FindNearestPlayers(), along with their squared distance from the queried position. */
+	using cNearestPlayers = std::vector<std::pair<double, cPlayer *>>;
+
+
+	/** Adds the player to the bucket of the specified chunk, moving them out of their previous bucket, if any. */
+	void Update(cPlayer & a_Player, cChunkCoords a_Chunk);
+
+	/** Removes the player from the index. Ignored if the player is not indexed. */
+	void Remove(cPlayer & a_Player);
+
+	/** Calls the callback for each player whose position is within a_Range of a_Pos.
+	Returns true if all the players were processed, false if the callback aborted by returning true. */
+	bool ForEachPlayerInRange(Vector3d a_Pos, double a_Range, cFunctionRef<bool(cPlayer &)> a_Callback) const;
+
+	/** Fills a_Nearest with at most a_MaxCount players within a_Range of a_Pos, nearest first. */
+	void FindNearestPlayers(Vector3d a_Pos, double a_Range, size_t a_MaxCount, cNearestPlayers & a_Nearest) const;
+
+	/** Returns the number of players in the index. */
+	size_t GetNumPlayers(void) const { return m_PlayerChunks.size(); }
+
+protected:
+
+	/** The players in each chunk. Chunks without players have no entry. */
+	std::unordered_map<cChunkCoords, std::vector<cPlayer *>, cChunkCoordsHash> m_Buckets;
+
+	/** The bucket in which each indexed player currently is. */
+	std::unordered_map<const cPlayer *, cChunkCoords> m_PlayerChunks;
+
+
+	/** Removes the player from the specified bucket, erasing the bucket if it becomes empty. */
+	void RemoveFromBucket(cPlayer & a_Player, cChunkCoords a_Chunk);
+
+	/** Appends all the players within a_Range of a_Pos to a_Players, in no particular order.
+	Looks only at the buckets of the chunks intersecting the range, or at all the buckets if there are fewer of them. */
+	void CollectPlayersInRange(Vector3d a_Pos, double a_Range, cNearestPlayers & a_Players) const;
+};
+
+
+
+
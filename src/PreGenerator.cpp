@@ -0,0 +1,657 @@
+// PreGenerator.cpp
+
+// Implements the cPreGenerator class representing the background pre-generation service of a single world
+
+#include "Globals.h"
+
+#include "PreGenerator.h"
+#include "IniFile.h"
+#include "World.h"
+
+
+
+
+
+namespace
+{
+	/** Name of the ini section used both in world.ini and the progress file. */
+	const AString INI_SECTION = "PreGeneration";
+
+	/** How often the progress is reported into the log and saved to disk. */
+	const std::chrono::seconds REPORT_INTERVAL(10);
+
+
+
+
+
+	/** Converts a distance along a Hilbert curve filling a square of a_Side x a_Side (a power of 2) into XY coords. */
+	void HilbertToXY(int a_Side, UInt64 a_Idx, int & a_X, int & a_Y)
+	{
+		a_X = 0;
+		a_Y = 0;
+		for (int s = 1; s < a_Side; s *= 2)
+		{
+			int rx = static_cast<int>((a_Idx / 2) & 1);
+			int ry = static_cast<int>((a_Idx ^ static_cast<UInt64>(rx)) & 1);
+			if (ry == 0)
+			{
+				// Rotate the quadrant:
+				if (rx == 1)
+				{
+					a_X = s - 1 - a_X;
+					a_Y = s - 1 - a_Y;
+				}
+				std::swap(a_X, a_Y);
+			}
+			a_X += s * rx;
+			a_Y += s * ry;
+			a_Idx /= 4;
+		}
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPreGenerator::cJob:
+
+/** A single pre-generation job - the area to generate and the progress made so far. */
+class cPreGenerator::cJob
+{
+public:
+
+	/** Creates a job covering the rectangle between the specified corners (inclusive).
+	If a_Radius is positive, only the chunks within a_Radius of the rectangle's center are included. */
+	cJob(int a_MinChunkX, int a_MinChunkZ, int a_MaxChunkX, int a_MaxChunkZ, int a_Radius):
+		m_MinChunkX(a_MinChunkX),
+		m_MinChunkZ(a_MinChunkZ),
+		m_MaxChunkX(a_MaxChunkX),
+		m_MaxChunkZ(a_MaxChunkZ),
+		m_Radius(a_Radius),
+		m_Side(1),
+		m_NextIdx(0),
+		m_NumDoneBeforeResumeIdx(0),
+		m_NumTotal(0),
+		m_NumDone(0),
+		m_LastReportNumDone(0),
+		m_LastReportTime(std::chrono::steady_clock::now()),
+		m_ChunksPerSecond(0)
+	{
+		while ((m_Side < m_MaxChunkX - m_MinChunkX + 1) || (m_Side < m_MaxChunkZ - m_MinChunkZ + 1))
+		{
+			m_Side *= 2;
+		}
+		m_CurveLength = static_cast<UInt64>(m_Side) * static_cast<UInt64>(m_Side);
+		m_NumTotal = CountChunks();
+	}
+
+
+	/** Returns true if the specified chunk belongs to the job's area. */
+	bool Contains(int a_ChunkX, int a_ChunkZ) const
+	{
+		if ((a_ChunkX < m_MinChunkX) || (a_ChunkX > m_MaxChunkX) || (a_ChunkZ < m_MinChunkZ) || (a_ChunkZ > m_MaxChunkZ))
+		{
+			return false;
+		}
+		if (m_Radius <= 0)
+		{
+			return true;
+		}
+		Int64 DiffX = a_ChunkX - (m_MinChunkX + m_Radius);
+		Int64 DiffZ = a_ChunkZ - (m_MinChunkZ + m_Radius);
+		return (DiffX * DiffX + DiffZ * DiffZ <= static_cast<Int64>(m_Radius) * m_Radius);
+	}
+
+
+	/** Converts the index along the job's curve into chunk coords. */
+	void IdxToChunk(UInt64 a_Idx, int & a_ChunkX, int & a_ChunkZ) const
+	{
+		HilbertToXY(m_Side, a_Idx, a_ChunkX, a_ChunkZ);
+		a_ChunkX += m_MinChunkX;
+		a_ChunkZ += m_MinChunkZ;
+	}
+
+
+	/** Returns true if any chunk of the square of a_Size x a_Size chunks, starting at the specified chunk, belongs to the job's area. */
+	bool IntersectsSquare(int a_MinChunkX, int a_MinChunkZ, int a_Size) const
+	{
+		const int MaxChunkX = a_MinChunkX + a_Size - 1;
+		const int MaxChunkZ = a_MinChunkZ + a_Size - 1;
+		if ((MaxChunkX < m_MinChunkX) || (a_MinChunkX > m_MaxChunkX) || (MaxChunkZ < m_MinChunkZ) || (a_MinChunkZ > m_MaxChunkZ))
+		{
+			return false;
+		}
+		if (m_Radius <= 0)
+		{
+			return true;
+		}
+
+		// The chunk of the square nearest to the circle's center decides:
+		const int CenterX = m_MinChunkX + m_Radius;
+		const int CenterZ = m_MinChunkZ + m_Radius;
+		Int64 DiffX = Clamp(CenterX, a_MinChunkX, MaxChunkX) - CenterX;
+		Int64 DiffZ = Clamp(CenterZ, a_MinChunkZ, MaxChunkZ) - CenterZ;
+		return (DiffX * DiffX + DiffZ * DiffZ <= static_cast<Int64>(m_Radius) * m_Radius);
+	}
+
+
+	/** Returns the first curve index, starting at a_Idx, whose chunk belongs to the job's area; m_CurveLength if there's none.
+	Each block of 4^k indices starting at a multiple of 4^k fills an aligned square of 2^k x 2^k chunks,
+	so whole blocks that lie outside the area are skipped at once. */
+	UInt64 FindNextContained(UInt64 a_Idx) const
+	{
+		while (a_Idx < m_CurveLength)
+		{
+			int ChunkX, ChunkZ;
+			IdxToChunk(a_Idx, ChunkX, ChunkZ);
+			if (Contains(ChunkX, ChunkZ))
+			{
+				return a_Idx;
+			}
+
+			// Find the largest block starting at a_Idx that is completely outside the area:
+			UInt64 BlockLength = 1;
+			int BlockSide = 1;
+			while ((BlockSide < m_Side) && ((a_Idx % (BlockLength * 4)) == 0))
+			{
+				const int Side = BlockSide * 2;
+				const int SquareX = ChunkX - (ChunkX - m_MinChunkX) % Side;
+				const int SquareZ = ChunkZ - (ChunkZ - m_MinChunkZ) % Side;
+				if (IntersectsSquare(SquareX, SquareZ, Side))
+				{
+					break;
+				}
+				BlockSide = Side;
+				BlockLength *= 4;
+			}
+			a_Idx += BlockLength;
+		}
+		return m_CurveLength;
+	}
+
+
+	/** Returns the number of chunks within the job's area. */
+	int CountChunks(void) const
+	{
+		if (m_Radius <= 0)
+		{
+			return (m_MaxChunkX - m_MinChunkX + 1) * (m_MaxChunkZ - m_MinChunkZ + 1);
+		}
+
+		// Add up the columns of the circle:
+		const Int64 RadiusSq = static_cast<Int64>(m_Radius) * m_Radius;
+		Int64 Res = 0;
+		for (Int64 DiffX = -m_Radius; DiffX <= m_Radius; DiffX++)
+		{
+			const Int64 MaxDiffZSq = RadiusSq - DiffX * DiffX;
+			auto MaxDiffZ = static_cast<Int64>(std::sqrt(static_cast<double>(MaxDiffZSq)));
+
+			// Correct the rounding errors of the floating-point sqrt:
+			while (MaxDiffZ * MaxDiffZ > MaxDiffZSq)
+			{
+				MaxDiffZ -= 1;
+			}
+			while ((MaxDiffZ + 1) * (MaxDiffZ + 1) <= MaxDiffZSq)
+			{
+				MaxDiffZ += 1;
+			}
+			Res += 2 * MaxDiffZ + 1;
+		}
+		return static_cast<int>(Res);
+	}
+
+
+	/** Continues the job from the specified curve index; a_NumDone chunks, all of them before that index, are already done. */
+	void Resume(UInt64 a_Idx, int a_NumDone)
+	{
+		m_NextIdx = std::min(a_Idx, m_CurveLength);
+		m_NumDoneBeforeResumeIdx = Clamp(a_NumDone, 0, m_NumTotal);
+		m_NumDone = m_NumDoneBeforeResumeIdx;
+		m_LastReportNumDone = m_NumDone;
+	}
+
+
+	/** Returns the curve index from which the job can be resumed so that no chunk is skipped,
+	and the number of chunks before that index that have been prepared. */
+	void GetResumeState(UInt64 & a_Idx, int & a_NumDone)
+	{
+		cCSLock Lock(m_CS);
+		a_Idx = GetResumeIdx();
+		a_NumDone = m_NumDoneBeforeResumeIdx + static_cast<int>(std::distance(m_DoneAhead.begin(), m_DoneAhead.lower_bound(a_Idx)));
+	}
+
+
+	/** Returns the curve index from which the job can be resumed so that no chunk is skipped. Expects m_CS to be held. */
+	UInt64 GetResumeIdx(void) const
+	{
+		return m_InFlight.empty() ? m_NextIdx : *m_InFlight.begin();
+	}
+
+
+	/** Returns true if all the job's chunks have been prepared. */
+	bool IsFinished(void)
+	{
+		cCSLock Lock(m_CS);
+		return (m_NextIdx >= m_CurveLength) && m_InFlight.empty();
+	}
+
+
+	/** Called by the PrepareChunk() callback when the chunk at the specified curve index has been prepared. */
+	void ChunkPrepared(UInt64 a_Idx)
+	{
+		cCSLock Lock(m_CS);
+		m_InFlight.erase(a_Idx);
+		m_NumDone += 1;
+
+		// The chunks before the resume index are done for good, the rest would be queued again when resuming:
+		m_DoneAhead.insert(a_Idx);
+		const auto ResumeIdx = GetResumeIdx();
+		while (!m_DoneAhead.empty() && (*m_DoneAhead.begin() < ResumeIdx))
+		{
+			m_DoneAhead.erase(m_DoneAhead.begin());
+			m_NumDoneBeforeResumeIdx += 1;
+		}
+	}
+
+
+	// The job's area; the circle of m_Radius, if positive, is inscribed into the rectangle:
+	int m_MinChunkX;
+	int m_MinChunkZ;
+	int m_MaxChunkX;
+	int m_MaxChunkZ;
+	int m_Radius;
+
+	/** Size of the square covered by the Hilbert curve, a power of 2. */
+	int m_Side;
+
+	/** Total length of the Hilbert curve (m_Side * m_Side). */
+	UInt64 m_CurveLength;
+
+	/** Protects m_NextIdx, m_InFlight, m_DoneAhead and m_NumDoneBeforeResumeIdx. */
+	cCriticalSection m_CS;
+
+	/** The next curve index to be examined for queueing. */
+	UInt64 m_NextIdx;
+
+	/** Curve indices of the chunks that have been queued, but not yet prepared. */
+	std::set<UInt64> m_InFlight;
+
+	/** Curve indices of the prepared chunks that lie after the resume index (the earliest chunk still in flight). */
+	std::set<UInt64> m_DoneAhead;
+
+	/** Number of the prepared chunks that lie before the resume index. Persisted, so that resuming needn't count them. */
+	int m_NumDoneBeforeResumeIdx;
+
+	/** Total number of chunks within the job's area. */
+	int m_NumTotal;
+
+	/** Number of chunks already prepared. */
+	std::atomic<int> m_NumDone;
+
+	/** Value of m_NumDone at the last progress report, used for calculating the speed. Used only in the world's tick thread. */
+	int m_LastReportNumDone;
+
+	/** The time when the progress was last reported and saved. Used only in the world's tick thread. */
+	std::chrono::steady_clock::time_point m_LastReportTime;
+
+	/** Speed measured at the last progress report. */
+	std::atomic<double> m_ChunksPerSecond;
+} ;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPreGenerator::cPreparedCallback:
+
+/** Notifies the job once a chunk it has queued is generated and lit. */
+class cPreGenerator::cPreparedCallback:
+	public cChunkCoordCallback
+{
+public:
+
+	cPreparedCallback(std::shared_ptr<cJob> a_Job, UInt64 a_Idx):
+		m_Job(std::move(a_Job)),
+		m_Idx(a_Idx)
+	{
+	}
+
+protected:
+
+	std::shared_ptr<cJob> m_Job;
+	UInt64 m_Idx;
+
+	virtual void Call(cChunkCoords a_Coords, bool a_IsSuccess) override
+	{
+		UNUSED(a_Coords);
+		UNUSED(a_IsSuccess);
+		m_Job->ChunkPrepared(m_Idx);
+	}
+} ;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPreGenerator:
+
+cPreGenerator::cPreGenerator(cWorld & a_World):
+	m_World(a_World),
+	m_MaxChunksInFlight(64),
+	m_MaxChunksPerTick(16),
+	m_MaxGeneratorQueue(16),
+	m_MaxLightingQueue(64),
+	m_MaxStorageLoadQueue(64),
+	m_MaxStorageSaveQueue(512)
+{
+}
+
+
+
+
+
+void cPreGenerator::Initialize(cIniFile & a_IniFile)
+{
+	m_MaxChunksInFlight   = std::max(1, a_IniFile.GetValueSetI(INI_SECTION, "MaxChunksInFlight",   m_MaxChunksInFlight));
+	m_MaxChunksPerTick    = std::max(1, a_IniFile.GetValueSetI(INI_SECTION, "MaxChunksPerTick",    m_MaxChunksPerTick));
+	m_MaxGeneratorQueue   = static_cast<size_t>(std::max(1, a_IniFile.GetValueSetI(INI_SECTION, "MaxGeneratorQueue",   static_cast<int>(m_MaxGeneratorQueue))));
+	m_MaxLightingQueue    = static_cast<size_t>(std::max(1, a_IniFile.GetValueSetI(INI_SECTION, "MaxLightingQueue",    static_cast<int>(m_MaxLightingQueue))));
+	m_MaxStorageLoadQueue = static_cast<size_t>(std::max(1, a_IniFile.GetValueSetI(INI_SECTION, "MaxStorageLoadQueue", static_cast<int>(m_MaxStorageLoadQueue))));
+	m_MaxStorageSaveQueue = static_cast<size_t>(std::max(1, a_IniFile.GetValueSetI(INI_SECTION, "MaxStorageSaveQueue", static_cast<int>(m_MaxStorageSaveQueue))));
+
+	// Resume the job in progress, if any:
+	cIniFile Progress;
+	if (!Progress.ReadFile(GetProgressFileName(), false))
+	{
+		return;
+	}
+	auto Job = std::make_shared<cJob>(
+		Progress.GetValueI(INI_SECTION, "MinChunkX"),
+		Progress.GetValueI(INI_SECTION, "MinChunkZ"),
+		Progress.GetValueI(INI_SECTION, "MaxChunkX"),
+		Progress.GetValueI(INI_SECTION, "MaxChunkZ"),
+		Progress.GetValueI(INI_SECTION, "Radius")
+	);
+	UInt64 ResumeIdx = 0;
+	if (!StringToInteger(Progress.GetValue(INI_SECTION, "ResumeIdx", "0"), ResumeIdx))
+	{
+		LOGWARNING("Pre-generation progress file \"%s\" is damaged, starting the job from the beginning.", GetProgressFileName().c_str());
+		ResumeIdx = 0;
+	}
+	Job->Resume(ResumeIdx, (ResumeIdx == 0) ? 0 : Progress.GetValueI(INI_SECTION, "NumDone"));
+	LOG("Resuming pre-generation of world %s: %d of %d chunks already done.", m_World.GetName().c_str(), Job->m_NumDone.load(), Job->m_NumTotal);
+
+	cCSLock Lock(m_CS);
+	m_Job = std::move(Job);
+}
+
+
+
+
+
+void cPreGenerator::Tick(void)
+{
+	std::shared_ptr<cJob> Job;
+	{
+		cCSLock Lock(m_CS);
+		Job = m_Job;
+	}
+	if (Job == nullptr)
+	{
+		return;
+	}
+
+	if (Job->IsFinished())
+	{
+		cCSLock Lock(m_CS);
+		if (m_Job == Job)
+		{
+			LOG("Pre-generation of world %s finished, %d chunks prepared.", m_World.GetName().c_str(), Job->m_NumTotal);
+			m_Job.reset();
+			cFile::DeleteFile(GetProgressFileName());
+		}
+		return;
+	}
+
+	// Report progress and save it periodically:
+	auto Now = std::chrono::steady_clock::now();
+	if (Now - Job->m_LastReportTime > REPORT_INTERVAL)
+	{
+		int NumDone = Job->m_NumDone;
+		auto Elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Now - Job->m_LastReportTime).count();
+		Job->m_ChunksPerSecond = static_cast<double>(NumDone - Job->m_LastReportNumDone) * 1000 / static_cast<double>(std::max<decltype(Elapsed)>(Elapsed, 1));
+		Job->m_LastReportNumDone = NumDone;
+		Job->m_LastReportTime = Now;
+		LOG("Pre-generating world %s: %.02f%% (%d/%d; %.02f chunks / sec)",
+			m_World.GetName().c_str(), static_cast<double>(NumDone) * 100 / std::max(Job->m_NumTotal, 1), NumDone, Job->m_NumTotal, Job->m_ChunksPerSecond.load()
+		);
+
+		// Stop() or StartJob() may have replaced the job since the snapshot was taken, don't bring it back into the file:
+		cCSLock Lock(m_CS);
+		if (m_Job == Job)
+		{
+			SaveJobProgress(*Job);
+		}
+	}
+
+	if (!HasQueueCapacity())
+	{
+		return;
+	}
+
+	// Pick the next chunks along the curve, as long as there's room in flight:
+	std::vector<std::pair<cChunkCoords, UInt64>> ToQueue;
+	{
+		cCSLock Lock(Job->m_CS);
+		auto NumToQueue = std::min<size_t>(static_cast<size_t>(m_MaxChunksPerTick), static_cast<size_t>(m_MaxChunksInFlight) - std::min(Job->m_InFlight.size(), static_cast<size_t>(m_MaxChunksInFlight)));
+		while (ToQueue.size() < NumToQueue)
+		{
+			auto Idx = Job->FindNextContained(Job->m_NextIdx);
+			Job->m_NextIdx = std::min(Idx + 1, Job->m_CurveLength);
+			if (Idx >= Job->m_CurveLength)
+			{
+				break;
+			}
+			int ChunkX, ChunkZ;
+			Job->IdxToChunk(Idx, ChunkX, ChunkZ);
+			Job->m_InFlight.insert(Idx);
+			ToQueue.emplace_back(cChunkCoords(ChunkX, ChunkZ), Idx);
+		}
+	}
+
+	// Queue them outside the lock, the callback may be called synchronously:
+	for (const auto & Item: ToQueue)
+	{
+		m_World.PrepareChunk(Item.first.m_ChunkX, Item.first.m_ChunkZ, std::make_unique<cPreparedCallback>(Job, Item.second));
+	}
+}
+
+
+
+
+
+void cPreGenerator::SaveProgress(void)
+{
+	cCSLock Lock(m_CS);
+	if (m_Job != nullptr)
+	{
+		SaveJobProgress(*m_Job);
+	}
+}
+
+
+
+
+
+bool cPreGenerator::PreGenerateRect(int a_MinChunkX, int a_MinChunkZ, int a_MaxChunkX, int a_MaxChunkZ)
+{
+	if ((a_MinChunkX > a_MaxChunkX) || (a_MinChunkZ > a_MaxChunkZ))
+	{
+		return false;
+	}
+	StartJob(std::make_shared<cJob>(a_MinChunkX, a_MinChunkZ, a_MaxChunkX, a_MaxChunkZ, 0));
+	return true;
+}
+
+
+
+
+
+bool cPreGenerator::PreGenerateRadius(int a_CenterChunkX, int a_CenterChunkZ, int a_Radius)
+{
+	if (a_Radius <= 0)
+	{
+		return false;
+	}
+	StartJob(std::make_shared<cJob>(
+		a_CenterChunkX - a_Radius, a_CenterChunkZ - a_Radius,
+		a_CenterChunkX + a_Radius, a_CenterChunkZ + a_Radius,
+		a_Radius
+	));
+	return true;
+}
+
+
+
+
+
+void cPreGenerator::Stop(void)
+{
+	{
+		cCSLock Lock(m_CS);
+		if (m_Job == nullptr)
+		{
+			return;
+		}
+		m_Job.reset();
+		cFile::DeleteFile(GetProgressFileName());
+	}
+	LOG("Pre-generation of world %s cancelled.", m_World.GetName().c_str());
+}
+
+
+
+
+
+bool cPreGenerator::IsRunning(void)
+{
+	cCSLock Lock(m_CS);
+	return (m_Job != nullptr);
+}
+
+
+
+
+
+int cPreGenerator::GetNumChunksDone(void)
+{
+	cCSLock Lock(m_CS);
+	return (m_Job == nullptr) ? 0 : m_Job->m_NumDone.load();
+}
+
+
+
+
+
+int cPreGenerator::GetNumChunksTotal(void)
+{
+	cCSLock Lock(m_CS);
+	return (m_Job == nullptr) ? 0 : m_Job->m_NumTotal;
+}
+
+
+
+
+
+double cPreGenerator::GetChunksPerSecond(void)
+{
+	cCSLock Lock(m_CS);
+	return (m_Job == nullptr) ? 0 : m_Job->m_ChunksPerSecond.load();
+}
+
+
+
+
+
+AString cPreGenerator::GetStatusText(void)
+{
+	cCSLock Lock(m_CS);
+	if (m_Job == nullptr)
+	{
+		return Printf("World %s: no pre-generation in progress", m_World.GetName().c_str());
+	}
+	int NumDone = m_Job->m_NumDone;
+	return Printf("World %s: pre-generating chunks [%d, %d] - [%d, %d]%s: %.02f%% (%d/%d; %.02f chunks / sec)",
+		m_World.GetName().c_str(),
+		m_Job->m_MinChunkX, m_Job->m_MinChunkZ, m_Job->m_MaxChunkX, m_Job->m_MaxChunkZ,
+		(m_Job->m_Radius > 0) ? Printf(" within radius %d", m_Job->m_Radius).c_str() : "",
+		static_cast<double>(NumDone) * 100 / std::max(m_Job->m_NumTotal, 1), NumDone, m_Job->m_NumTotal,
+		m_Job->m_ChunksPerSecond.load()
+	);
+}
+
+
+
+
+
+AString cPreGenerator::GetProgressFileName(void) const
+{
+	return m_World.GetDataPath() + cFile::GetPathSeparator() + "pregen.ini";
+}
+
+
+
+
+
+void cPreGenerator::StartJob(std::shared_ptr<cJob> a_Job)
+{
+	LOG("Starting pre-generation of world %s: %d chunks.", m_World.GetName().c_str(), a_Job->m_NumTotal);
+	cCSLock Lock(m_CS);
+	SaveJobProgress(*a_Job);
+	m_Job = std::move(a_Job);
+}
+
+
+
+
+
+void cPreGenerator::SaveJobProgress(cJob & a_Job)
+{
+	cIniFile Progress;
+	Progress.SetValueI(INI_SECTION, "MinChunkX", a_Job.m_MinChunkX);
+	Progress.SetValueI(INI_SECTION, "MinChunkZ", a_Job.m_MinChunkZ);
+	Progress.SetValueI(INI_SECTION, "MaxChunkX", a_Job.m_MaxChunkX);
+	Progress.SetValueI(INI_SECTION, "MaxChunkZ", a_Job.m_MaxChunkZ);
+	Progress.SetValueI(INI_SECTION, "Radius",    a_Job.m_Radius);
+	UInt64 ResumeIdx;
+	int NumDone;
+	a_Job.GetResumeState(ResumeIdx, NumDone);
+	Progress.SetValue(INI_SECTION,  "ResumeIdx", Printf("%llu", ResumeIdx));
+	Progress.SetValueI(INI_SECTION, "NumDone",   NumDone);
+	if (!Progress.WriteFile(GetProgressFileName()))
+	{
+		LOGWARNING("Cannot save the pre-generation progress to \"%s\".", GetProgressFileName().c_str());
+	}
+}
+
+
+
+
+
+bool cPreGenerator::HasQueueCapacity(void)
+{
+	return (
+		(m_World.GetGeneratorQueueLength()   < m_MaxGeneratorQueue) &&
+		(m_World.GetLightingQueueLength()    < m_MaxLightingQueue) &&
+		(m_World.GetStorageLoadQueueLength() < m_MaxStorageLoadQueue) &&
+		(m_World.GetStorageSaveQueueLength() < m_MaxStorageSaveQueue)
+	);
+}
+
+
+
+
@@ -0,0 +1,128 @@
+// PreGenerator.h
+
+// Declares the cPreGenerator class representing the background pre-generation service of a single world
+
+/*
+A pre-generation job covers either a rectangle or a circle (radius) of chunks. The chunks are visited along a
+Hilbert curve over the job's bounding square, so that consecutively queued chunks are close to each other and the
+generator's biome / height caches stay warm.
+
+The job is driven from the world's tick thread (cWorld::Tick() calls Tick()). Each tick, new chunks are queued using
+cWorld::PrepareChunk(), but only while the generator, lighting and storage queues are short, and only up to a
+limited number of chunks in flight. Together with the generator ranking chunks near players first, this keeps the
+delay that pre-generation adds to player-driven chunk requests bounded.
+
+The progress is persisted into the world's folder every now and then and when the world stops, and the job is
+resumed automatically when the world starts again.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cIniFile;
+class cWorld;
+
+
+
+
+
+// tolua_begin
+
+/** Pre-generates an area of a single world in the background. Thread safe. */
+class cPreGenerator
+{
+public:
+	// tolua_end
+
+	cPreGenerator(cWorld & a_World);
+
+	/** Loads the pre-generation settings from the world.ini and resumes a job that was in progress when the world last stopped. */
+	void Initialize(cIniFile & a_IniFile);
+
+	/** Queues more chunks for the current job, if the world's queues allow it. Called from the world's tick thread. */
+	void Tick(void);
+
+	/** Saves the current job's progress, so that it can be resumed later. */
+	void SaveProgress(void);
+
+	// tolua_begin
+
+	/** Starts pre-generating the rectangle of chunks between the specified corners (inclusive).
+	Any job already running is replaced. Returns false if the rectangle is invalid. */
+	bool PreGenerateRect(int a_MinChunkX, int a_MinChunkZ, int a_MaxChunkX, int a_MaxChunkZ);
+
+	/** Starts pre-generating all chunks within the specified radius (in chunks) around the center chunk.
+	Any job already running is replaced. Returns false if the radius is invalid. */
+	bool PreGenerateRadius(int a_CenterChunkX, int a_CenterChunkZ, int a_Radius);
+
+	/** Cancels the current job and removes its saved progress. */
+	void Stop(void);
+
+	/** Returns true if a job is in progress. */
+	bool IsRunning(void);
+
+	/** Returns the number of chunks of the current job that have already been prepared. */
+	int GetNumChunksDone(void);
+
+	/** Returns the total number of chunks in the current job. */
+	int GetNumChunksTotal(void);
+
+	/** Returns the speed of the current job, in chunks per second, measured since the previous progress report. */
+	double GetChunksPerSecond(void);
+
+	// tolua_end
+
+	/** Returns a human-readable single-line description of the current job's state. */
+	AString GetStatusText(void);
+
+protected:
+
+	class cJob;
+	class cPreparedCallback;
+
+	/** The world being pre-generated. */
+	cWorld & m_World;
+
+	/** Protects m_Job and the progress file, so that the file always belongs to the current job. */
+	cCriticalSection m_CS;
+
+	/** The current job, nullptr if none.
+	Shared with the PrepareChunk() callbacks of the job, so that a replaced job stays alive until all its callbacks have finished. */
+	std::shared_ptr<cJob> m_Job;
+
+	/** Maximum number of the job's chunks that may be in the prepare pipeline at once. */
+	int m_MaxChunksInFlight;
+
+	/** Maximum number of chunks to queue within a single tick. */
+	int m_MaxChunksPerTick;
+
+	/** New chunks are not queued while any of the world's queues is longer than its respective limit. */
+	size_t m_MaxGeneratorQueue;
+	size_t m_MaxLightingQueue;
+	size_t m_MaxStorageLoadQueue;
+	size_t m_MaxStorageSaveQueue;
+
+
+	/** Returns the name of the file where the progress is persisted. */
+	AString GetProgressFileName(void) const;
+
+	/** Replaces the current job with the specified one and saves its initial progress. */
+	void StartJob(std::shared_ptr<cJob> a_Job);
+
+	/** Saves the progress of the specified job. Expects m_CS to be held and a_Job to be the current job. */
+	void SaveJobProgress(cJob & a_Job);
+
+	/** Returns true if all the world's queues are short enough to queue more chunks. */
+	bool HasQueueCapacity(void);
+} ;  // tolua_export
+
+
+
+
@@ -350,6 +350,35 @@ public:
 	The protocol uses the provided buffers for storage and processing, and must have exclusive access to them. */
 	virtual void DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data) = 0;
 
+	/** A complete packet received from the client, already decrypted and decompressed, but not handled yet. */
+	struct sReceivedPacket
+	{
+		/** The (protocol-specific) packet type, as read from the packet data. */
+		UInt32 m_PacketType;
+
+		/** The packet data, including the packet type. */
+		std::unique_ptr<cByteBuffer> m_Data;
+	};
+	using cReceivedPackets = std::deque<sReceivedPacket>;
+
+	/** Returns true if the framing of the incoming data no longer depends on the packets being handled,
+	so that cClientHandle may split the data into packets using SplitReceivedData() on the network thread
+	and handle them later using HandleReceivedPacket(), instead of using DataReceived(). */
+	virtual bool CanSplitReceivedData(void) const = 0;
+
+	/** Called by cClientHandle, typically on the network thread, to process data when the client sends some, once CanSplitReceivedData() is true.
+	Decrypts, decompresses and splits the data into packets, which are appended to a_Packets; doesn't handle them.
+	The protocol uses the provided buffers for storage and processing, and must have exclusive access to them.
+	Throws a std::runtime_error on malformed data. */
+	virtual void SplitReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data, cReceivedPackets & a_Packets) = 0;
+
+	/** Handles a packet previously split off the received data by SplitReceivedData(). */
+	virtual void HandleReceivedPacket(sReceivedPacket & a_Packet) = 0;
+
+	/** Returns true if the packet of the specified type only carries the player's absolute position and / or look,
+	so that it can be dropped if it is followed by a packet of the same type. */
+	virtual bool IsAbsoluteMovementPacket(UInt32 a_PacketType) const = 0;
+
 	/** Called by cClientHandle to finalise a buffer of prepared data before they are sent to the client.
 	Descendants may for example, encrypt the data if needed.
 	The protocol modifies the provided buffer in-place. */
@@ -396,7 +425,7 @@ public:
 	virtual void SendLeashEntity                (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo) = 0;
 	virtual void SendLogin                      (const cPlayer & a_Player, const cWorld & a_World) = 0;
 	virtual void SendLoginSuccess               (void) = 0;
-	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY) = 0;
+	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY) = 0;
 	virtual void SendPaintingSpawn              (const cPainting & a_Painting) = 0;
 	virtual void SendPlayerAbilities            (void) = 0;
 	virtual void SendParticleEffect             (const AString & a_SoundName, float a_SrcX, float a_SrcY, float a_SrcZ, float a_OffsetX, float a_OffsetY, float a_OffsetZ, float a_ParticleData, int a_ParticleAmount) = 0;
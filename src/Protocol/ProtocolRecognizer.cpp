@@ -204,6 +204,25 @@ void cMultiVersionProtocol::HandleIncomingData(cClientHandle & a_Client, Contigu
 
 
 
+bool cMultiVersionProtocol::CanSplitIncomingData(void) const
+{
+	return (!m_WaitingForData && (m_Protocol != nullptr) && m_Protocol->CanSplitReceivedData());
+}
+
+
+
+
+
+void cMultiVersionProtocol::SplitIncomingData(ContiguousByteBuffer & a_Data, cProtocol::cReceivedPackets & a_Packets)
+{
+	ASSERT(CanSplitIncomingData());
+	m_Protocol->SplitReceivedData(m_Buffer, a_Data, a_Packets);
+}
+
+
+
+
+
 void cMultiVersionProtocol::HandleOutgoingData(ContiguousByteBuffer & a_Data)
 {
 	// Normally only the protocol sends data, so outgoing data are only present when m_Protocol != nullptr.
@@ -42,6 +42,15 @@ public:
 	The protocol modifies the provided buffer in-place. */
 	void HandleIncomingData(cClientHandle & a_Client, ContiguousByteBuffer & a_Data);
 
+	/** Returns true if a protocol has been recognised and it allows the incoming data to be split into packets
+	by SplitIncomingData() instead of being handled by HandleIncomingData(). */
+	bool CanSplitIncomingData(void) const;
+
+	/** Splits the incoming protocol data into complete packets appended to a_Packets, without handling them.
+	May be called from any thread, but never concurrently with HandleIncomingData().
+	The protocol modifies the provided buffer in-place. Throws a std::runtime_error on malformed data. */
+	void SplitIncomingData(ContiguousByteBuffer & a_Data, cProtocol::cReceivedPackets & a_Packets);
+
 	/** Allows the protocol (if any) to do a final pass on outgiong data, possibly modifying the provided buffer in-place. */
 	void HandleOutgoingData(ContiguousByteBuffer & a_Data);
 
@@ -1185,6 +1185,29 @@ bool cProtocol_1_12::HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketTyp
 
 
 
+bool cProtocol_1_12::IsAbsoluteMovementPacket(UInt32 a_PacketType) const
+{
+	if (m_State != State::Game)
+	{
+		return false;
+	}
+
+	switch (a_PacketType)
+	{
+		case 0x0e:  // Player Position
+		case 0x0f:  // Player Position And Look
+		case 0x10:  // Player Look
+		{
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cProtocol_1_12_1:
 
@@ -1314,6 +1337,29 @@ bool cProtocol_1_12_1::HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketT
 
 
 
+
+bool cProtocol_1_12_1::IsAbsoluteMovementPacket(UInt32 a_PacketType) const
+{
+	if (m_State != State::Game)
+	{
+		return false;
+	}
+
+	switch (a_PacketType)
+	{
+		case 0x0d:  // Player Position
+		case 0x0e:  // Player Position And Look
+		case 0x0f:  // Player Look
+		{
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cProtocol_1_12_2::
 
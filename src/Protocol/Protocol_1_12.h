@@ -43,6 +43,7 @@ protected:
 	virtual void HandlePacketAdvancementTab(cByteBuffer & a_ByteBuffer);
 	virtual void HandleCraftRecipe(cByteBuffer & a_ByteBuffer);
 	virtual void HandlePacketCraftingBookData(cByteBuffer & a_ByteBuffer);
+	virtual bool IsAbsoluteMovementPacket(UInt32 a_PacketType) const override;
 
 	virtual void WriteEntityMetadata(cPacketizer & a_Pkt, const cEntity & a_Entity) const override;
 	virtual void WriteMobMetadata(cPacketizer & a_Pkt, const cMonster & a_Mob) const override;
@@ -67,6 +68,7 @@ protected:
 	virtual Version GetProtocolVersion() const override;
 
 	virtual bool HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketType) override;
+	virtual bool IsAbsoluteMovementPacket(UInt32 a_PacketType) const override;
 };
 
 
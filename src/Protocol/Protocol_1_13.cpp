@@ -106,7 +106,7 @@ void cProtocol_1_13::SendBlockChanges(int a_ChunkX, int a_ChunkZ, const sSetBloc
 
 
 
-void cProtocol_1_13::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cProtocol_1_13::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY)
 {
 	// TODO
 }
@@ -658,6 +658,29 @@ bool cProtocol_1_13::HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketTyp
 
 
 
+bool cProtocol_1_13::IsAbsoluteMovementPacket(UInt32 a_PacketType) const
+{
+	if (m_State != State::Game)
+	{
+		return false;
+	}
+
+	switch (a_PacketType)
+	{
+		case 0x10:  // Player Position
+		case 0x11:  // Player Position And Look
+		case 0x12:  // Player Look
+		{
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
+
 void cProtocol_1_13::HandlePacketNameItem(cByteBuffer & a_ByteBuffer)
 {
 	HANDLE_READ(a_ByteBuffer, ReadVarUTF8String, AString, NewItemName);
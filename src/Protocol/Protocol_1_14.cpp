@@ -271,6 +271,16 @@ bool cProtocol_1_14::HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketTyp
 
 
 
+bool cProtocol_1_14::IsAbsoluteMovementPacket(UInt32 a_PacketType) const
+{
+	// The game state packets aren't handled yet:
+	return false;
+}
+
+
+
+
+
 void cProtocol_1_14::HandlePacketBlockDig(cByteBuffer & a_ByteBuffer)
 {
 }
@@ -52,6 +52,7 @@ protected:
 	virtual void HandlePacketBlockDig(cByteBuffer & a_ByteBuffer) override;
 	virtual void HandlePacketBlockPlace(cByteBuffer & a_ByteBuffer) override;
 	virtual void HandlePacketUpdateSign(cByteBuffer & a_ByteBuffer) override;
+	virtual bool IsAbsoluteMovementPacket(UInt32 a_PacketType) const override;
 
 	virtual void WriteEntityMetadata(cPacketizer & a_Pkt, const cEntity & a_Entity) const override {}
 	virtual void WriteMobMetadata(cPacketizer & a_Pkt, const cMonster & a_Mob) const override {}
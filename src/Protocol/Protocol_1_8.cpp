@@ -198,6 +198,59 @@ void cProtocol_1_8_0::DataPrepared(ContiguousByteBuffer & a_Data)
 
 
 
+bool cProtocol_1_8_0::CanSplitReceivedData(void) const
+{
+	// Encryption and compression are both settled by the time the game state is reached.
+	// The incoming comm log is written only from DataReceived(), so that the packets are logged in the order they're handled.
+	return ((m_State == State::Game) && !g_ShouldLogCommIn);
+}
+
+
+
+
+
+void cProtocol_1_8_0::SplitReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data, cReceivedPackets & a_Packets)
+{
+	ASSERT(m_State == State::Game);
+
+	if (m_IsEncrypted)
+	{
+		m_Decryptor.ProcessData(a_Data.data(), a_Data.size());
+	}
+
+	if (!a_Buffer.Write(a_Data.data(), a_Data.size()))
+	{
+		// Too much data in the incoming queue, the server is probably too busy:
+		throw std::runtime_error("The server is busy; please try again later.");
+	}
+
+	SplitPackets(a_Buffer, [&a_Packets](std::unique_ptr<cByteBuffer> a_Packet)
+		{
+			UInt32 PacketType;
+			if (!a_Packet->ReadVarInt(PacketType))
+			{
+				// Not enough data, HandlePacket() would ignore the packet too
+				return;
+			}
+			a_Packet->ResetRead();
+			a_Packets.push_back({PacketType, std::move(a_Packet)});
+		}
+	);
+}
+
+
+
+
+
+void cProtocol_1_8_0::HandleReceivedPacket(sReceivedPacket & a_Packet)
+{
+	HandlePacket(*a_Packet.m_Data);
+}
+
+
+
+
+
 void cProtocol_1_8_0::SendAttachEntity(const cEntity & a_Entity, const cEntity & a_Vehicle)
 {
 	ASSERT(m_State == 3);  // In game mode?
@@ -914,7 +967,7 @@ void cProtocol_1_8_0::SendPaintingSpawn(const cPainting & a_Painting)
 
 
 
-void cProtocol_1_8_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cProtocol_1_8_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY)
 {
 	ASSERT(m_State == 3);  // In game mode?
 
@@ -930,14 +983,23 @@ void cProtocol_1_8_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_Da
 		Pkt.WriteBEUInt8(static_cast<UInt8>(Decorator.GetPixelZ()));
 	}
 
-	Pkt.WriteBEUInt8(128);
-	Pkt.WriteBEUInt8(128);
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataSizeX));
+	if (a_DataSizeX == 0)
+	{
+		// No pixel data, decorators only
+		return;
+	}
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataSizeY));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartX));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartY));
-	Pkt.WriteVarInt32(static_cast<UInt32>(a_Map.GetData().size()));
-	for (auto itr = a_Map.GetData().cbegin(); itr != a_Map.GetData().cend(); ++itr)
+	Pkt.WriteVarInt32(static_cast<UInt32>(a_DataSizeX * a_DataSizeY));
+	const auto & Data = a_Map.GetData();
+	for (int z = a_DataStartY; z < a_DataStartY + a_DataSizeY; ++z)
 	{
-		Pkt.WriteBEUInt8(*itr);
+		for (int x = a_DataStartX; x < a_DataStartX + a_DataSizeX; ++x)
+		{
+			Pkt.WriteBEUInt8(Data[static_cast<size_t>(x) + static_cast<size_t>(z) * a_Map.GetWidth()]);
+		}
 	}
 }
 
@@ -2171,6 +2233,29 @@ bool cProtocol_1_8_0::HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketTy
 
 
 
+bool cProtocol_1_8_0::IsAbsoluteMovementPacket(UInt32 a_PacketType) const
+{
+	if (m_State != State::Game)
+	{
+		return false;
+	}
+
+	switch (a_PacketType)
+	{
+		case 0x04:  // Player Position
+		case 0x05:  // Player Look
+		case 0x06:  // Player Position And Look
+		{
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
+
 void cProtocol_1_8_0::HandlePacketStatusPing(cByteBuffer & a_ByteBuffer)
 {
 	HANDLE_READ(a_ByteBuffer, ReadBEInt64, Int64, Timestamp);
@@ -3828,6 +3913,36 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 	}
 
 	// Handle all complete packets:
+	SplitPackets(a_Buffer, [this](std::unique_ptr<cByteBuffer> a_Packet)
+		{
+			HandlePacket(*a_Packet);
+		}
+	);
+
+	// Log any leftover bytes into the logfile:
+	if (g_ShouldLogCommIn && (a_Buffer.GetReadableSpace() > 0) && m_CommLogFile.IsOpen())
+	{
+		ContiguousByteBuffer AllData;
+		size_t OldReadableSpace = a_Buffer.GetReadableSpace();
+		a_Buffer.ReadAll(AllData);
+		a_Buffer.ResetRead();
+		a_Buffer.SkipRead(a_Buffer.GetReadableSpace() - OldReadableSpace);
+		ASSERT(a_Buffer.GetReadableSpace() == OldReadableSpace);
+		AString Hex;
+		CreateHexDump(Hex, AllData.data(), AllData.size(), 16);
+		m_CommLogFile.Printf("There are %zu (0x%zx) bytes of non-parse-able data left in the buffer:\n%s",
+			a_Buffer.GetReadableSpace(), a_Buffer.GetReadableSpace(), Hex.c_str()
+		);
+		m_CommLogFile.Flush();
+	}
+}
+
+
+
+
+
+void cProtocol_1_8_0::SplitPackets(cByteBuffer & a_Buffer, cFunctionRef<void(std::unique_ptr<cByteBuffer>)> a_OnPacket)
+{
 	for (;;)
 	{
 		UInt32 PacketLen;
@@ -3852,8 +3967,7 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 			UInt32 UncompressedSize;
 			if (!a_Buffer.ReadVarInt(UncompressedSize))
 			{
-				m_Client->Kick("Compression packet incomplete");
-				return;
+				throw std::runtime_error("Compression packet incomplete");
 			}
 
 			NumBytesRead -= static_cast<UInt32>(a_Buffer.GetReadableSpace());  // How many bytes has the UncompressedSize taken up?
@@ -3868,42 +3982,25 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 
 				const auto UncompressedData = m_Extractor.Extract(UncompressedSize);
 				const auto Uncompressed = UncompressedData.GetView();
-				cByteBuffer bb(Uncompressed.size());
+				auto bb = std::make_unique<cByteBuffer>(Uncompressed.size());
 
 				// Compression was used, move the uncompressed data:
-				VERIFY(bb.Write(Uncompressed.data(), Uncompressed.size()));
+				VERIFY(bb->Write(Uncompressed.data(), Uncompressed.size()));
 
-				HandlePacket(bb);
+				a_OnPacket(std::move(bb));
 				continue;
 			}
 		}
 
 		// Move the packet payload to a separate cByteBuffer, bb:
-		cByteBuffer bb(PacketLen);
+		auto bb = std::make_unique<cByteBuffer>(PacketLen);
 
 		// No compression was used, move directly:
-		VERIFY(a_Buffer.ReadToByteBuffer(bb, static_cast<size_t>(PacketLen)));
+		VERIFY(a_Buffer.ReadToByteBuffer(*bb, static_cast<size_t>(PacketLen)));
 		a_Buffer.CommitRead();
 
-		HandlePacket(bb);
+		a_OnPacket(std::move(bb));
 	}  // for (ever)
-
-	// Log any leftover bytes into the logfile:
-	if (g_ShouldLogCommIn && (a_Buffer.GetReadableSpace() > 0) && m_CommLogFile.IsOpen())
-	{
-		ContiguousByteBuffer AllData;
-		size_t OldReadableSpace = a_Buffer.GetReadableSpace();
-		a_Buffer.ReadAll(AllData);
-		a_Buffer.ResetRead();
-		a_Buffer.SkipRead(a_Buffer.GetReadableSpace() - OldReadableSpace);
-		ASSERT(a_Buffer.GetReadableSpace() == OldReadableSpace);
-		AString Hex;
-		CreateHexDump(Hex, AllData.data(), AllData.size(), 16);
-		m_CommLogFile.Printf("There are %zu (0x%zx) bytes of non-parse-able data left in the buffer:\n%s",
-			a_Buffer.GetReadableSpace(), a_Buffer.GetReadableSpace(), Hex.c_str()
-		);
-		m_CommLogFile.Flush();
-	}
 }
 
 
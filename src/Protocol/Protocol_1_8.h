@@ -15,6 +15,7 @@ Declares the 1.8 protocol classes:
 
 #include "Protocol.h"
 #include "../ByteBuffer.h"
+#include "../FunctionRef.h"
 #include "../Registries/CustomStatistics.h"
 
 #include "../mbedTLS++/AesCfb128Decryptor.h"
@@ -39,6 +40,10 @@ public:
 	virtual void DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data) override;
 	virtual void DataPrepared(ContiguousByteBuffer & a_Data) override;
 
+	virtual bool CanSplitReceivedData(void) const override;
+	virtual void SplitReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data, cReceivedPackets & a_Packets) override;
+	virtual void HandleReceivedPacket(sReceivedPacket & a_Packet) override;
+
 	// Sending stuff to clients (alphabetically sorted):
 	virtual void SendAttachEntity               (const cEntity & a_Entity, const cEntity & a_Vehicle) override;
 	virtual void SendBlockAction                (int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType) override;
@@ -82,7 +87,7 @@ public:
 	virtual void SendLeashEntity                (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo) override;
 	virtual void SendLogin                      (const cPlayer & a_Player, const cWorld & a_World) override;
 	virtual void SendLoginSuccess               (void) override;
-	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY) override;
+	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY) override;
 	virtual void SendPaintingSpawn              (const cPainting & a_Painting) override;
 	virtual void SendPlayerAbilities            (void) override;
 	virtual void SendParticleEffect             (const AString & a_ParticleName, float a_SrcX, float a_SrcY, float a_SrcZ, float a_OffsetX, float a_OffsetY, float a_OffsetZ, float a_ParticleData, int a_ParticleAmount) override;
@@ -166,6 +171,8 @@ protected:
 	Returns true if the packet was understood, false if it was an unknown packet. */
 	virtual bool HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketType);
 
+	virtual bool IsAbsoluteMovementPacket(UInt32 a_PacketType) const override;
+
 	// Packet handlers while in the Status state (m_State == 1):
 	virtual void HandlePacketStatusPing(cByteBuffer & a_ByteBuffer);
 	virtual void HandlePacketStatusRequest(cByteBuffer & a_ByteBuffer);
@@ -254,6 +261,10 @@ private:
 	/** Adds the received (unencrypted) data to m_ReceivedData, parses complete packets */
 	void AddReceivedData(cByteBuffer & a_Buffer, ContiguousByteBufferView a_Data);
 
+	/** Removes all the complete packets from a_Buffer and calls a_OnPacket with each one's data, decompressed if needed.
+	Throws a std::runtime_error if a compressed packet is malformed. */
+	void SplitPackets(cByteBuffer & a_Buffer, cFunctionRef<void(std::unique_ptr<cByteBuffer>)> a_OnPacket);
+
 	/** Converts an entity to a protocol-specific entity type.
 	Only entities that the Send Spawn Entity packet supports are valid inputs to this method */
 	static UInt8 GetProtocolEntityType(const cEntity & a_Entity);
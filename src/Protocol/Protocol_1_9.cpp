@@ -447,7 +447,7 @@ void cProtocol_1_9_0::SendPaintingSpawn(const cPainting & a_Painting)
 
 
 
-void cProtocol_1_9_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cProtocol_1_9_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY)
 {
 	ASSERT(m_State == 3);  // In game mode?
 
@@ -464,14 +464,23 @@ void cProtocol_1_9_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_Da
 		Pkt.WriteBEUInt8(static_cast<UInt8>(Decorator.GetPixelZ()));
 	}
 
-	Pkt.WriteBEUInt8(128);
-	Pkt.WriteBEUInt8(128);
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataSizeX));
+	if (a_DataSizeX == 0)
+	{
+		// No pixel data, decorators only
+		return;
+	}
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataSizeY));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartX));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartY));
-	Pkt.WriteVarInt32(static_cast<UInt32>(a_Map.GetData().size()));
-	for (auto itr = a_Map.GetData().cbegin(); itr != a_Map.GetData().cend(); ++itr)
+	Pkt.WriteVarInt32(static_cast<UInt32>(a_DataSizeX * a_DataSizeY));
+	const auto & Data = a_Map.GetData();
+	for (int z = a_DataStartY; z < a_DataStartY + a_DataSizeY; ++z)
 	{
-		Pkt.WriteBEUInt8(*itr);
+		for (int x = a_DataStartX; x < a_DataStartX + a_DataSizeX; ++x)
+		{
+			Pkt.WriteBEUInt8(Data[static_cast<size_t>(x) + static_cast<size_t>(z) * a_Map.GetWidth()]);
+		}
 	}
 }
 
@@ -858,6 +867,29 @@ bool cProtocol_1_9_0::HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketTy
 
 
 
+bool cProtocol_1_9_0::IsAbsoluteMovementPacket(UInt32 a_PacketType) const
+{
+	if (m_State != State::Game)
+	{
+		return false;
+	}
+
+	switch (a_PacketType)
+	{
+		case 0x0c:  // Player Position
+		case 0x0d:  // Player Position And Look
+		case 0x0e:  // Player Look
+		{
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
+
 void cProtocol_1_9_0::HandlePacketAnimation(cByteBuffer & a_ByteBuffer)
 {
 	HANDLE_READ(a_ByteBuffer, ReadVarInt, Int32, Hand);
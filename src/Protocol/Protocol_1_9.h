@@ -49,7 +49,7 @@ public:
 	virtual void SendExperienceOrb        (const cExpOrb & a_ExpOrb) override;
 	virtual void SendKeepAlive            (UInt32 a_PingID) override;
 	virtual void SendLeashEntity          (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo) override;
-	virtual void SendMapData              (const cMap & a_Map, int a_DataStartX, int a_DataStartY) override;
+	virtual void SendMapData              (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataSizeX, int a_DataSizeY) override;
 	virtual void SendPaintingSpawn        (const cPainting & a_Painting) override;
 	virtual void SendPlayerMoveLook       (void) override;
 	virtual void SendPlayerPermissionLevel() override;
@@ -92,6 +92,7 @@ protected:
 	virtual void HandlePacketVehicleMove            (cByteBuffer & a_ByteBuffer);
 	virtual void HandlePacketWindowClick            (cByteBuffer & a_ByteBuffer) override;
 	virtual void HandleVanillaPluginMessage         (cByteBuffer & a_ByteBuffer, std::string_view a_Channel) override;
+	virtual bool IsAbsoluteMovementPacket(UInt32 a_PacketType) const override;
 
 	virtual void ParseItemMetadata(cItem & a_Item, ContiguousByteBufferView a_Metadata) const override;
 	virtual void SendEntitySpawn(const cEntity & a_Entity, const UInt8 a_ObjectType, const Int32 a_ObjectData) override;
@@ -36,6 +36,7 @@
 #include "CraftingRecipes.h"
 #include "Protocol/RecipeMapper.h"
 #include "Bindings/PluginManager.h"
+#include "Bindings/LuaWorkerPool.h"
 #include "MonsterConfig.h"
 #include "Entities/Player.h"
 #include "Blocks/BlockHandler.h"
@@ -153,6 +154,9 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 
 	LOG("Starting server...");
 
+	// Spread the network connections over more event loops, if configured:
+	cNetwork::StartEventLoops(static_cast<unsigned>(std::max(settingsRepo->GetValueSetI("Network", "NumEventLoops", 1), 1)));
+
 	// cClientHandle::FASTBREAK_PERCENTAGE = settingsRepo->GetValueSetI("AntiCheat", "FastBreakPercentage", 97) / 100.0f;
 	cClientHandle::FASTBREAK_PERCENTAGE = 0;  // AntiCheat disabled due to bugs. We will enabled it once they are fixed. See #3506.
 
@@ -179,6 +183,9 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	LOGD("Loading worlds...");
 	LoadWorlds(dd, *settingsRepo, IsNewIniFile);
 
+	LOGD("Starting Lua worker threads...");
+	m_LuaWorkerPool = std::make_unique<cLuaWorkerPool>(static_cast<unsigned>(std::max(settingsRepo->GetValueSetI("LuaWorkers", "NumThreads", 2), 1)));
+
 	LOGD("Loading plugin manager...");
 	m_PluginManager = new cPluginManager(dd);
 	m_PluginManager->ReloadPluginsNow(*settingsRepo);
@@ -186,6 +193,9 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	LOGD("Loading MonsterConfig...");
 	m_MonsterConfig = new cMonsterConfig;
 
+	LOGD("Starting player data storage...");
+	m_PlayerDataStorage.Start();
+
 	// This sets stuff in motion
 	LOGD("Starting Authenticator...");
 	m_Authenticator.Start(*settingsRepo);
@@ -232,6 +242,9 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	LOGD("Stopping authenticator...");
 	m_Authenticator.Stop();
 
+	LOGD("Writing player data...");
+	m_PlayerDataStorage.Stop();
+
 	LOGD("Freeing MonsterConfig...");
 	delete m_MonsterConfig; m_MonsterConfig = nullptr;
 	delete m_WebAdmin; m_WebAdmin = nullptr;
@@ -243,6 +256,9 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	LOGD("Stopping plugin manager...");
 	delete m_PluginManager; m_PluginManager = nullptr;
 
+	LOGD("Stopping Lua worker threads...");
+	m_LuaWorkerPool.reset();
+
 	LOG("Cleaning up...");
 	delete m_Server; m_Server = nullptr;
 
@@ -927,6 +943,9 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 	int SumNumInLighting = 0;
 	int SumNumInGenerator = 0;
 	int SumMem = 0;
+	size_t SumNumTicked = 0;
+	size_t SumNumResting = 0;
+	size_t SumCacheBytes = 0;
 	for (auto & Entry : m_WorldsByName)
 	{
 		auto & World = Entry.second;
@@ -944,6 +963,18 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		a_Output.Out("  Num chunks in generator queue: %zu", NumInGenerator);
 		a_Output.Out("  Num chunks in storage load queue: %zu", NumInLoadQueue);
 		a_Output.Out("  Num chunks in storage save queue: %zu", NumInSaveQueue);
+		size_t NumTicked = 0;
+		size_t NumResting = 0;
+		World.GetEntityStats(NumTicked, NumResting);
+		a_Output.Out("  Num entities ticked by chunks: %zu", NumTicked);
+		a_Output.Out("  Num entities at rest: %zu", NumResting);
+		const auto CacheStats = World.GetStorage().GetChunkCache().GetStats();
+		a_Output.Out("  Compressed chunk cache: %zu chunks, %zu of %zu KiB", CacheStats.m_NumEntries, (CacheStats.m_NumBytes + 1023) / 1024, CacheStats.m_MaxBytes / 1024);
+		a_Output.Out("  Compressed chunk cache hits / misses / evictions: %llu / %llu / %llu",
+			static_cast<unsigned long long>(CacheStats.m_NumHits),
+			static_cast<unsigned long long>(CacheStats.m_NumMisses),
+			static_cast<unsigned long long>(CacheStats.m_NumEvictions)
+		);
 		int Mem = NumValid * static_cast<int>(sizeof(cChunk));
 		a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (Mem + 1023) / 1024, (Mem + 1024 * 1024 - 1) / (1024 * 1024));
 		a_Output.Out("  Per-chunk memory size breakdown:");
@@ -957,12 +988,18 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		SumNumInLighting += NumInLighting;
 		SumNumInGenerator += NumInGenerator;
 		SumMem += Mem;
+		SumNumTicked += NumTicked;
+		SumNumResting += NumResting;
+		SumCacheBytes += CacheStats.m_NumBytes;
 	}
 	a_Output.Out("Totals:");
 	a_Output.Out("  Num loaded chunks: %d", SumNumValid);
 	a_Output.Out("  Num dirty chunks: %d", SumNumDirty);
 	a_Output.Out("  Num chunks in lighting queue: %d", SumNumInLighting);
 	a_Output.Out("  Num chunks in generator queue: %d", SumNumInGenerator);
+	a_Output.Out("  Num entities ticked by chunks: %zu", SumNumTicked);
+	a_Output.Out("  Num entities at rest: %zu", SumNumResting);
+	a_Output.Out("  Memory used by compressed chunk caches: %zu KiB", (SumCacheBytes + 1023) / 1024);
 	a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (SumMem + 1023) / 1024, (SumMem + 1024 * 1024 - 1) / (1024 * 1024));
 }
 
@@ -7,6 +7,7 @@
 #include "Protocol/Authenticator.h"
 #include "Protocol/MojangAPI.h"
 #include "RankManager.h"
+#include "WorldStorage/PlayerDataStorage.h"
 #include "ChunkDef.h"
 
 
@@ -21,6 +22,7 @@ class cRecipeMapper;
 class cFurnaceRecipe;
 class cWebAdmin;
 class cPluginManager;
+class cLuaWorkerPool;
 class cServer;
 class cWorld;
 class cPlayer;
@@ -110,9 +112,13 @@ public:
 	cWebAdmin *        GetWebAdmin       (void) { return m_WebAdmin; }         // tolua_export
 	cPluginManager *   GetPluginManager  (void) { return m_PluginManager; }    // tolua_export
 	cAuthenticator &   GetAuthenticator  (void) { return m_Authenticator; }
+	cPlayerDataStorage & GetPlayerDataStorage(void) { return m_PlayerDataStorage; }
 	cMojangAPI &       GetMojangAPI      (void) { return *m_MojangAPI; }
 	cRankManager *     GetRankManager    (void) { return m_RankManager.get(); }
 
+	/** Returns the thread pool on which the plugins' Lua workers run. */
+	cLuaWorkerPool &   GetLuaWorkerPool  (void) { return *m_LuaWorkerPool; }
+
 	/** Queues a console command for execution through the cServer class.
 	The command will be executed in the tick thread
 	The command's output will be written to the a_Output callback
@@ -224,7 +230,9 @@ private:
 	std::unique_ptr<cBrewingRecipes> m_BrewingRecipes;
 	cWebAdmin *        m_WebAdmin;
 	cPluginManager *   m_PluginManager;
+	std::unique_ptr<cLuaWorkerPool> m_LuaWorkerPool;
 	cAuthenticator     m_Authenticator;
+	cPlayerDataStorage m_PlayerDataStorage;
 	cMojangAPI *       m_MojangAPI;
 
 	std::unique_ptr<cRankManager> m_RankManager;
@@ -8,6 +8,7 @@
 #include "Root.h"
 #include "World.h"
 #include "Bindings/PluginManager.h"
+#include "Bindings/PluginLua.h"
 #include "ChatColor.h"
 #include "Entities/Player.h"
 #include "Inventory.h"
@@ -352,7 +353,7 @@ void cServer::Tick(float a_Dt)
 
 void cServer::TickClients(float a_Dt)
 {
-	cClientHandlePtrs RemoveClients;
+	cClientHandlePtrs Clients;
 	{
 		cCSLock Lock(m_CSClients);
 
@@ -369,13 +370,22 @@ void cServer::TickClients(float a_Dt)
 			}
 		}  // for itr - m_ClientsToRemove[]
 		m_ClientsToRemove.clear();
+		Clients = m_Clients;
+	}
+
+	// Tick the remaining clients without holding the CS, finishing a login creates the cPlayer and calls plugin hooks:
+	for (const auto & Client : Clients)
+	{
+		Client->ServerTick(a_Dt);
+	}
 
-		// Tick the remaining clients, take out those that have been destroyed into RemoveClients
+	// Take out the clients that have been destroyed into RemoveClients:
+	cClientHandlePtrs RemoveClients;
+	{
+		cCSLock Lock(m_CSClients);
 		for (auto itr = m_Clients.begin(); itr != m_Clients.end();)
 		{
 			auto & Client = *itr;
-
-			Client->ServerTick(a_Dt);
 			if (Client->IsDestroyed())
 			{
 				// Delete the client later, when CS is not held, to avoid deadlock: https://forum.cuberite.org/thread-374.html
@@ -568,12 +578,31 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 		return;
 	}
 
+	else if (split[0] == "pregen")
+	{
+		ExecutePreGenCommand(split, a_Output);
+		a_Output.Finished();
+		return;
+	}
+
 	else if (split[0].compare("luastats") == 0)
 	{
 		a_Output.Out(cLuaStateTracker::GetStats());
 		a_Output.Finished();
 		return;
 	}
+	else if (split[0] == "hookstats")
+	{
+		ExecuteHookStatsCommand(split, a_Output);
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0] == "luaprofile")
+	{
+		ExecuteLuaProfileCommand(split, a_Output);
+		a_Output.Finished();
+		return;
+	}
 	else if (cPluginManager::Get()->ExecuteConsoleCommand(split, a_Output, a_Cmd))
 	{
 		a_Output.Finished();
@@ -631,6 +660,219 @@ void cServer::PrintHelp(const AStringVector & a_Split, cCommandOutputCallback &
 
 
 
+void cServer::ExecutePreGenCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
+{
+	// "pregen" alone reports the status of all worlds:
+	if (a_Split.size() < 2)
+	{
+		cRoot::Get()->ForEachWorld([&a_Output](cWorld & a_World)
+			{
+				a_Output.Out(a_World.GetPreGenerator().GetStatusText());
+				return false;
+			}
+		);
+		return;
+	}
+
+	auto World = cRoot::Get()->GetWorld(a_Split[1]);
+	if (World == nullptr)
+	{
+		a_Output.Out("Unknown world \"%s\"", a_Split[1].c_str());
+		return;
+	}
+	auto & PreGenerator = World->GetPreGenerator();
+	if (a_Split.size() < 3)
+	{
+		a_Output.Out(PreGenerator.GetStatusText());
+		return;
+	}
+
+	if (a_Split[2] == "stop")
+	{
+		PreGenerator.Stop();
+		a_Output.Out("Pre-generation stopped");
+		return;
+	}
+	else if ((a_Split[2] == "radius") && ((a_Split.size() == 4) || (a_Split.size() == 6)))
+	{
+		int Radius = 0;
+		int CenterChunkX = 0, CenterChunkZ = 0;
+		cChunkDef::BlockToChunk(World->GetSpawnX(), World->GetSpawnZ(), CenterChunkX, CenterChunkZ);
+		if (
+			!StringToInteger(a_Split[3], Radius) ||
+			((a_Split.size() == 6) && (!StringToInteger(a_Split[4], CenterChunkX) || !StringToInteger(a_Split[5], CenterChunkZ))) ||
+			!PreGenerator.PreGenerateRadius(CenterChunkX, CenterChunkZ, Radius)
+		)
+		{
+			a_Output.Out("Invalid radius or center");
+			return;
+		}
+		a_Output.Out(PreGenerator.GetStatusText());
+		return;
+	}
+	else if ((a_Split[2] == "rect") && (a_Split.size() == 7))
+	{
+		int MinChunkX, MinChunkZ, MaxChunkX, MaxChunkZ;
+		if (
+			!StringToInteger(a_Split[3], MinChunkX) || !StringToInteger(a_Split[4], MinChunkZ) ||
+			!StringToInteger(a_Split[5], MaxChunkX) || !StringToInteger(a_Split[6], MaxChunkZ) ||
+			!PreGenerator.PreGenerateRect(MinChunkX, MinChunkZ, MaxChunkX, MaxChunkZ)
+		)
+		{
+			a_Output.Out("Invalid rectangle");
+			return;
+		}
+		a_Output.Out(PreGenerator.GetStatusText());
+		return;
+	}
+
+	a_Output.Out("Usage:");
+	a_Output.Out("  pregen - shows the status of all worlds");
+	a_Output.Out("  pregen <World> radius <Radius> [<ChunkX> <ChunkZ>] - pre-generates a circle of chunks, around spawn by default");
+	a_Output.Out("  pregen <World> rect <MinChunkX> <MinChunkZ> <MaxChunkX> <MaxChunkZ> - pre-generates a rectangle of chunks");
+	a_Output.Out("  pregen <World> stop - cancels the world's pre-generation");
+}
+
+
+
+
+
+void cServer::ExecuteHookStatsCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
+{
+	auto PluginManager = cPluginManager::Get();
+	if ((a_Split.size() >= 2) && (a_Split[1] == "reset"))
+	{
+		PluginManager->ResetHookStats();
+		a_Output.Out("Hook statistics reset");
+		return;
+	}
+
+	// Report the hooks that took the most time, the list can be limited by the optional parameter:
+	size_t MaxLines = 20;
+	if ((a_Split.size() >= 2) && !StringToInteger(a_Split[1], MaxLines))
+	{
+		a_Output.Out("Usage:");
+		a_Output.Out("  hookstats [<NumLines>] - lists the plugins' hook handlers that took the most time");
+		a_Output.Out("  hookstats reset - clears the statistics");
+		return;
+	}
+	auto Stats = PluginManager->GetHookStats();
+	if (Stats.empty())
+	{
+		a_Output.Out("No hook calls recorded");
+		return;
+	}
+	a_Output.Out(Printf("%-20s %-28s %10s %12s %10s %10s %9s", "Plugin", "Hook", "Calls", "Total ms", "Avg ms", "Max ms", "Overruns"));
+	for (size_t i = 0; (i < Stats.size()) && (i < MaxLines); i++)
+	{
+		const auto & Item = Stats[i];
+		const auto TotalMSec = std::chrono::duration<double, std::milli>(Item.m_Stats.m_TotalTime).count();
+		a_Output.Out(Printf("%-20s %-28s %10llu %12.2f %10.3f %10.2f %9llu",
+			Item.m_PluginName.c_str(),
+			cPluginManager::GetHookName(Item.m_HookType).c_str(),
+			static_cast<unsigned long long>(Item.m_Stats.m_NumCalls),
+			TotalMSec,
+			TotalMSec / static_cast<double>(Item.m_Stats.m_NumCalls),
+			std::chrono::duration<double, std::milli>(Item.m_Stats.m_MaxTime).count(),
+			static_cast<unsigned long long>(Item.m_Stats.m_NumOverruns)
+		));
+	}
+}
+
+
+
+
+
+void cServer::ExecuteLuaProfileCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
+{
+	if (a_Split.size() >= 3)
+	{
+		const auto & Action = a_Split[2];
+		bool IsHandled = true;
+		bool IsFound = cPluginManager::Get()->DoWithPlugin(a_Split[1], [&](cPlugin & a_Plugin)
+			{
+				if (!a_Plugin.IsLoaded())
+				{
+					a_Output.Out("Plugin %s is not loaded", a_Plugin.GetName().c_str());
+					return true;
+				}
+				auto & Plugin = static_cast<cPluginLua &>(a_Plugin);
+				if (Action == "start")
+				{
+					int Interval = 1000;
+					if ((a_Split.size() >= 4) && (!StringToInteger(a_Split[3], Interval) || (Interval <= 0)))
+					{
+						a_Output.Out("Invalid sampling interval \"%s\"", a_Split[3].c_str());
+						return true;
+					}
+					Plugin.StartProfiling(Interval);
+					a_Output.Out("Profiling plugin %s, sampling every %d Lua instructions", Plugin.GetName().c_str(), Interval);
+				}
+				else if (Action == "stop")
+				{
+					Plugin.StopProfiling();
+					a_Output.Out("Profiling of plugin %s stopped", Plugin.GetName().c_str());
+				}
+				else if (Action == "reset")
+				{
+					Plugin.ResetProfile();
+					a_Output.Out("Profile of plugin %s reset", Plugin.GetName().c_str());
+				}
+				else if (Action == "report")
+				{
+					size_t MaxLines = 20;
+					if ((a_Split.size() >= 4) && !StringToInteger(a_Split[3], MaxLines))
+					{
+						a_Output.Out("Invalid number of lines \"%s\"", a_Split[3].c_str());
+						return true;
+					}
+					std::chrono::nanoseconds TotalTime;
+					auto Locations = Plugin.GetProfile(TotalTime);
+					const auto TotalMSec = std::chrono::duration<double, std::milli>(TotalTime).count();
+					a_Output.Out("Plugin %s: %.2f ms sampled in %u lines%s",
+						Plugin.GetName().c_str(), TotalMSec, static_cast<unsigned>(Locations.size()),
+						Plugin.IsProfiling() ? ", profiling is running" : ""
+					);
+					for (size_t i = 0; (i < Locations.size()) && (i < MaxLines); i++)
+					{
+						const auto & Location = Locations[i];
+						const auto MSec = std::chrono::duration<double, std::milli>(Location.m_Time).count();
+						a_Output.Out(Printf("%10.2f ms %5.1f %% %8llu samples  %s:%d  %s",
+							MSec, (TotalMSec > 0) ? (100 * MSec / TotalMSec) : 0.0,
+							static_cast<unsigned long long>(Location.m_NumSamples),
+							Location.m_Source.c_str(), Location.m_Line, Location.m_Function.c_str()
+						));
+					}
+				}
+				else
+				{
+					IsHandled = false;
+				}
+				return true;
+			}
+		);
+		if (!IsFound)
+		{
+			a_Output.Out("Unknown plugin \"%s\"", a_Split[1].c_str());
+			return;
+		}
+		if (IsHandled)
+		{
+			return;
+		}
+	}
+
+	a_Output.Out("Usage:");
+	a_Output.Out("  luaprofile <Plugin> start [<Interval>] - starts sampling the plugin's Lua code every <Interval> instructions (1000 by default)");
+	a_Output.Out("  luaprofile <Plugin> stop - stops sampling, keeps the results");
+	a_Output.Out("  luaprofile <Plugin> report [<NumLines>] - lists the Lua lines where the plugin spent the most time");
+	a_Output.Out("  luaprofile <Plugin> reset - clears the results");
+}
+
+
+
+
+
 void cServer::BindBuiltInConsoleCommands(void)
 {
 	// Create an empty handler - the actual handling for the commands is performed before they are handed off to cPluginManager
@@ -660,6 +902,9 @@ void cServer::BindBuiltInConsoleCommands(void)
 	PlgMgr->BindConsoleCommand("load",            nullptr, handler, "Adds and enables the specified plugin");
 	PlgMgr->BindConsoleCommand("unload",          nullptr, handler, "Disables the specified plugin");
 	PlgMgr->BindConsoleCommand("destroyentities", nullptr, handler, "Destroys all entities in all worlds");
+	PlgMgr->BindConsoleCommand("pregen",          nullptr, handler, "Pre-generates an area of a world in the background");
+	PlgMgr->BindConsoleCommand("hookstats",       nullptr, handler, "Lists the time spent in the plugins' hook handlers");
+	PlgMgr->BindConsoleCommand("luaprofile",      nullptr, handler, "Profiles the Lua code of the specified plugin");
 }
 
 
@@ -113,6 +113,15 @@ public:
 	/** Lists all available console commands and their helpstrings */
 	void PrintHelp(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
 
+	/** Executes the "pregen" console command, controlling the worlds' background pre-generation. */
+	void ExecutePreGenCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+
+	/** Executes the "hookstats" console command, reporting (or resetting) the time plugins spend in their hook handlers. */
+	void ExecuteHookStatsCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+
+	/** Executes the "luaprofile" console command, controlling the sampling profiler of a plugin's Lua code. */
+	void ExecuteLuaProfileCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+
 	/** Binds the built-in console commands with the plugin manager */
 	static void BindBuiltInConsoleCommands(void);
 
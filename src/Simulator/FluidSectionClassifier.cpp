@@ -0,0 +1,166 @@
+
+// FluidSectionClassifier.cpp
+
+// Implements the cFluidSectionClassifier class that finds the fluid blocks in a chunk section that stay unchanged when simulated
+
+#include "Globals.h"
+
+#include "FluidSectionClassifier.h"
+
+
+
+
+
+/** Number of bits in each word of a section bitmap. */
+static const size_t BitsPerWord = cFluidSectionClassifier::BitsPerWord;
+
+/** Number of words in a section bitmap holding a single layer (Y level) of the section. */
+static const size_t WordsPerLayer = cChunkDef::Width * cChunkDef::Width / BitsPerWord;
+
+
+
+
+
+/** Returns the bitmap with each bit taken from the bit a_Shift positions below it, a_Shift < 64.
+The bits shifted in at the bottom are zero. */
+static cFluidSectionClassifier::cSectionBitmap ShiftUp(const cFluidSectionClassifier::cSectionBitmap & a_Bitmap, unsigned a_Shift)
+{
+	cFluidSectionClassifier::cSectionBitmap Res;
+	Res[0] = a_Bitmap[0] << a_Shift;
+	for (size_t i = 1; i < a_Bitmap.size(); i++)
+	{
+		Res[i] = (a_Bitmap[i] << a_Shift) | (a_Bitmap[i - 1] >> (BitsPerWord - a_Shift));
+	}
+	return Res;
+}
+
+
+
+
+
+/** Returns the bitmap with each bit taken from the bit a_Shift positions above it, a_Shift < 64.
+The bits shifted in at the top are zero. */
+static cFluidSectionClassifier::cSectionBitmap ShiftDown(const cFluidSectionClassifier::cSectionBitmap & a_Bitmap, unsigned a_Shift)
+{
+	cFluidSectionClassifier::cSectionBitmap Res;
+	const auto Last = a_Bitmap.size() - 1;
+	for (size_t i = 0; i < Last; i++)
+	{
+		Res[i] = (a_Bitmap[i] >> a_Shift) | (a_Bitmap[i + 1] << (BitsPerWord - a_Shift));
+	}
+	Res[Last] = a_Bitmap[Last] >> a_Shift;
+	return Res;
+}
+
+
+
+
+
+/** Returns the bitmap of the blocks that are not on the X or Z border of the section.
+Their sideways neighbours are all within the same section. */
+static const cFluidSectionClassifier::cSectionBitmap & GetInnerColumnsBitmap(void)
+{
+	static const auto Bitmap = []()
+	{
+		cFluidSectionClassifier::cSectionBitmap Res{};
+		for (int y = 0; y < cChunkDef::SectionHeight; y++)
+		{
+			for (int z = 1; z < cChunkDef::Width - 1; z++)
+			{
+				for (int x = 1; x < cChunkDef::Width - 1; x++)
+				{
+					const auto Index = cChunkDef::MakeIndex(x, y, z);
+					Res[Index / BitsPerWord] |= UInt64(1) << (Index % BitsPerWord);
+				}
+			}
+		}
+		return Res;
+	}();
+	return Bitmap;
+}
+
+
+
+
+
+cFluidSectionClassifier::cFluidSectionClassifier(BLOCKTYPE a_Fluid, BLOCKTYPE a_StationaryFluid, const std::array<bool, 256> & a_IsSettledNeighbor):
+	m_FluidBlock(a_Fluid),
+	m_StationaryFluidBlock(a_StationaryFluid),
+	m_IsSettledNeighbor(a_IsSettledNeighbor)
+{
+}
+
+
+
+
+
+void cFluidSectionClassifier::RemoveSettledBlocks(const ChunkBlockData & a_BlockData, size_t a_SectionY, cSectionBitmap & a_Scheduled) const
+{
+	// Classify the section's blocks, and the top layer of the section below:
+	cSectionBitmap Sources{}, Settled{}, SettledBelow{};
+	ClassifyBlocks(a_BlockData, a_SectionY, 0, ChunkBlockData::SectionBlockCount, Settled, &Sources);
+	if (a_SectionY > 0)
+	{
+		const auto LayerSize = WordsPerLayer * BitsPerWord;
+		ClassifyBlocks(a_BlockData, a_SectionY - 1, ChunkBlockData::SectionBlockCount - LayerSize, LayerSize, SettledBelow, nullptr);
+	}
+
+	// The neighbour below is one layer down, take the bottom layer from the section below:
+	cSectionBitmap Below;
+	for (size_t i = 0; i < WordsPerLayer; i++)
+	{
+		Below[i] = SettledBelow[a_Scheduled.size() - WordsPerLayer + i];
+	}
+	for (size_t i = WordsPerLayer; i < a_Scheduled.size(); i++)
+	{
+		Below[i] = Settled[i - WordsPerLayer];
+	}
+
+	// The sideways neighbours are 1 block (X) and a row of blocks (Z) away; the wrapped-around bits are masked out by the inner columns:
+	const auto & Inner = GetInnerColumnsBitmap();
+	const auto XMinus = ShiftUp(Settled, 1);
+	const auto XPlus = ShiftDown(Settled, 1);
+	const auto ZMinus = ShiftUp(Settled, cChunkDef::Width);
+	const auto ZPlus = ShiftDown(Settled, cChunkDef::Width);
+	for (size_t i = 0; i < a_Scheduled.size(); i++)
+	{
+		const auto IsSettled = Sources[i] & Inner[i] & Below[i] & XMinus[i] & XPlus[i] & ZMinus[i] & ZPlus[i];
+		a_Scheduled[i] &= ~IsSettled;
+	}
+}
+
+
+
+
+
+void cFluidSectionClassifier::ClassifyBlocks(const ChunkBlockData & a_BlockData, size_t a_SectionY, size_t a_FirstIndex, size_t a_Count, cSectionBitmap & a_Settled, cSectionBitmap * a_Sources) const
+{
+	const auto Blocks = a_BlockData.GetSection(a_SectionY);
+	if (Blocks == nullptr)
+	{
+		// All air, nothing is settled
+		return;
+	}
+	const auto Metas = a_BlockData.GetMetaSection(a_SectionY);
+
+	for (size_t Index = a_FirstIndex; Index < a_FirstIndex + a_Count; Index++)
+	{
+		const auto BlockType = (*Blocks)[Index];
+		// Only sources of this fluid count, a source of the other fluid next to this one reacts with it:
+		const auto IsOwnFluid = (BlockType == m_FluidBlock) || (BlockType == m_StationaryFluidBlock);
+		const auto IsSource = IsOwnFluid && ((Metas == nullptr) || (cChunkDef::ExpandNibble(Metas->data(), Index) == 0));
+		const auto Bit = UInt64(1) << (Index % BitsPerWord);
+		if (IsSource || m_IsSettledNeighbor[BlockType])
+		{
+			a_Settled[Index / BitsPerWord] |= Bit;
+		}
+		if ((a_Sources != nullptr) && IsSource && (BlockType == m_StationaryFluidBlock))
+		{
+			(*a_Sources)[Index / BitsPerWord] |= Bit;
+		}
+	}
+}
+
+
+
+
@@ -0,0 +1,59 @@
+
+// FluidSectionClassifier.h
+
+// Declares the cFluidSectionClassifier class that finds the fluid blocks in a chunk section that stay unchanged when simulated
+
+/*
+Used by cSectionedFluidSimulator to drop blocks from its per-section schedule bitmaps without simulating them one by one.
+The blocks of a section are classified into bitmaps (one bit per block, in the section's block index order), and the
+neighbours of each block are reached by shifting the bitmaps. A stationary source stays unchanged when the blocks on all
+its sides and below it are sources of the same fluid, or blocks that the fluid neither flows into nor reacts with.
+The classifier only reads the chunk's block storage, so that it can be tested without a world.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ChunkData.h"
+
+
+
+
+
+class cFluidSectionClassifier
+{
+public:
+
+	/** Number of bits in each word of a section bitmap. */
+	static constexpr size_t BitsPerWord = 64;
+
+	/** One bit for each block of a section, indexed the same as the blocks within the section. */
+	using cSectionBitmap = std::array<UInt64, ChunkBlockData::SectionBlockCount / BitsPerWord>;
+
+	/** a_IsSettledNeighbor tells, for each block type, whether a stationary source next to it (sideways or below) stays unchanged.
+	Sources of the fluid itself are recognized separately, the table needn't list them. */
+	cFluidSectionClassifier(BLOCKTYPE a_Fluid, BLOCKTYPE a_StationaryFluid, const std::array<bool, 256> & a_IsSettledNeighbor);
+
+	/** Removes the blocks that are known to stay unchanged when simulated from the bitmap of the specified section. */
+	void RemoveSettledBlocks(const ChunkBlockData & a_BlockData, size_t a_SectionY, cSectionBitmap & a_Scheduled) const;
+
+protected:
+
+	BLOCKTYPE m_FluidBlock;
+	BLOCKTYPE m_StationaryFluidBlock;
+
+	/** For each block type, whether a stationary source next to it (sideways or below) is known to stay unchanged. */
+	std::array<bool, 256> m_IsSettledNeighbor;
+
+
+	/** Sets the bits of the blocks in the specified section (starting at a_FirstIndex, a_Count blocks)
+	next to which a stationary source stays unchanged. Stationary sources themselves are stored into a_Sources, if given. */
+	void ClassifyBlocks(const ChunkBlockData & a_BlockData, size_t a_SectionY, size_t a_FirstIndex, size_t a_Count, cSectionBitmap & a_Settled, cSectionBitmap * a_Sources) const;
+};
+
+
+
+
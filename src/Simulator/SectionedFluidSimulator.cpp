@@ -0,0 +1,194 @@
+
+// SectionedFluidSimulator.cpp
+
+// Implements the cSectionedFluidSimulator class representing a fluid simulator that schedules blocks in per-section bitmaps
+
+#include "Globals.h"
+
+#include "SectionedFluidSimulator.h"
+#include "../BlockInfo.h"
+#include "../BlockType.h"
+#include "../Chunk.h"
+
+
+
+
+
+/** Number of bits in each word of a section bitmap. */
+static const size_t BitsPerWord = cFluidSectionClassifier::BitsPerWord;
+
+/** Sections with fewer blocks scheduled are simulated block by block, without removing the settled blocks first;
+classifying the whole section would cost more than it saves. */
+static const size_t MinBlocksForSettledCheck = 256;
+
+
+
+
+
+/** Returns the number of bits set in the bitmap. */
+static size_t CountBits(const cSectionedFluidSimulatorChunkData::cSectionBitmap & a_Bitmap)
+{
+	size_t Res = 0;
+	for (auto Word: a_Bitmap)
+	{
+		while (Word != 0)
+		{
+			Word &= Word - 1;
+			Res++;
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cSectionedFluidSimulatorChunkData::cSlot:
+
+bool cSectionedFluidSimulatorChunkData::cSlot::Add(Vector3i a_RelPos)
+{
+	ASSERT(cChunkDef::IsValidRelPos(a_RelPos));
+
+	auto & Section = m_Sections[static_cast<size_t>(a_RelPos.y / cChunkDef::SectionHeight)];
+	if (Section == nullptr)
+	{
+		Section = std::make_unique<cSectionBitmap>();
+		Section->fill(0);
+	}
+
+	const auto Index = cChunkDef::MakeIndex(a_RelPos.x, a_RelPos.y % cChunkDef::SectionHeight, a_RelPos.z);
+	auto & Word = (*Section)[Index / BitsPerWord];
+	const auto Bit = UInt64(1) << (Index % BitsPerWord);
+	if ((Word & Bit) != 0)
+	{
+		// Already present
+		return false;
+	}
+	Word |= Bit;
+	return true;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cSectionedFluidSimulatorChunkData:
+
+cSectionedFluidSimulatorChunkData::cSectionedFluidSimulatorChunkData(int a_TickDelay) :
+	m_Slots(ToUnsigned(a_TickDelay))
+{
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cSectionedFluidSimulator:
+
+cSectionedFluidSimulator::cSectionedFluidSimulator(
+	cWorld & a_World,
+	BLOCKTYPE a_Fluid,
+	BLOCKTYPE a_StationaryFluid,
+	NIBBLETYPE a_Falloff,
+	int a_TickDelay,
+	int a_NumNeighborsForSource
+):
+	Super(a_World, a_Fluid, a_StationaryFluid, a_Falloff, a_TickDelay, a_NumNeighborsForSource),
+	m_Classifier(a_Fluid, a_StationaryFluid, GetSettledNeighbors())
+{
+}
+
+
+
+
+
+std::array<bool, 256> cSectionedFluidSimulator::GetSettledNeighbors(void)
+{
+	// A stationary source doesn't spread into solid blocks, but it does react with the other fluid:
+	std::array<bool, 256> Res;
+	for (size_t i = 0; i < Res.size(); i++)
+	{
+		const auto BlockType = static_cast<BLOCKTYPE>(i);
+		Res[i] = !IsPassableForFluid(BlockType) && !IsBlockWater(BlockType) && !IsBlockLava(BlockType);
+	}
+	return Res;
+}
+
+
+
+
+
+void cSectionedFluidSimulator::SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk)
+{
+	auto ChunkDataRaw = (m_FluidBlock == E_BLOCK_WATER) ? a_Chunk->GetWaterSimulatorData() : a_Chunk->GetLavaSimulatorData();
+	auto ChunkData = static_cast<cSectionedFluidSimulatorChunkData *>(ChunkDataRaw);
+	auto & Slot = ChunkData->m_Slots[static_cast<size_t>(m_SimSlotNum)];
+
+	for (size_t SectionY = 0; SectionY < cChunkDef::NumSections; SectionY++)
+	{
+		// Take the bitmap out of the slot, so that blocks scheduled while simulating go into a fresh one:
+		auto Scheduled = std::move(Slot.m_Sections[SectionY]);
+		if (Scheduled == nullptr)
+		{
+			continue;
+		}
+		const auto NumScheduled = CountBits(*Scheduled);
+		m_TotalBlocks -= static_cast<int>(NumScheduled);
+
+		if (a_Chunk->GetBlockData().GetSection(SectionY) == nullptr)
+		{
+			// The whole section is air, there's no fluid to simulate
+			continue;
+		}
+		// A stationary source with a falloff of zero may turn into a flowing source when checking for source creation, never skip it then:
+		if ((NumScheduled >= MinBlocksForSettledCheck) && (m_Falloff != 0))
+		{
+			m_Classifier.RemoveSettledBlocks(a_Chunk->GetBlockData(), SectionY, *Scheduled);
+		}
+
+		// Simulate the remaining blocks, in their order within the section:
+		const auto BaseY = static_cast<int>(SectionY) * cChunkDef::SectionHeight;
+		for (size_t WordIdx = 0; WordIdx < Scheduled->size(); WordIdx++)
+		{
+			auto Word = (*Scheduled)[WordIdx];
+			for (size_t Bit = 0; Word != 0; Bit++, Word >>= 1)
+			{
+				if ((Word & 1) == 0)
+				{
+					continue;
+				}
+				const auto Index = WordIdx * BitsPerWord + Bit;
+				const auto Pos = cChunkDef::IndexToCoordinate(Index);
+				SimulateBlock(a_Chunk, Pos.x, BaseY + Pos.y, Pos.z);
+			}
+		}
+	}
+}
+
+
+
+
+
+void cSectionedFluidSimulator::AddBlock(cChunk & a_Chunk, Vector3i a_Position, BLOCKTYPE a_Block)
+{
+	if ((a_Block != m_FluidBlock) && (a_Block != m_StationaryFluidBlock))
+	{
+		return;
+	}
+
+	auto ChunkDataRaw = (m_FluidBlock == E_BLOCK_WATER) ? a_Chunk.GetWaterSimulatorData() : a_Chunk.GetLavaSimulatorData();
+	auto ChunkData = static_cast<cSectionedFluidSimulatorChunkData *>(ChunkDataRaw);
+	if (ChunkData->m_Slots[static_cast<size_t>(m_AddSlotNum)].Add(a_Position))
+	{
+		++m_TotalBlocks;
+	}
+}
+
+
+
+
+
@@ -0,0 +1,98 @@
+
+// SectionedFluidSimulator.h
+
+// Declares the cSectionedFluidSimulator class representing a fluid simulator that schedules blocks in per-section bitmaps
+
+/*
+The flow rules are the same as in the Vanilla simulator, only the scheduling differs. Instead of the per-Z vectors of
+cDelayedFluidSimulatorChunkData, each delay slot keeps one bitmap of 4096 bits per 16x16x16 section of the chunk,
+allocated only while the section has any blocks scheduled. Adding a block is a single bit set, so duplicates cost
+nothing no matter how many blocks are queued, and whole empty sections are skipped when simulating.
+
+Before simulating a heavily scheduled section, its blocks are classified into bitmaps, and the scheduled blocks that
+are known to stay unchanged (stationary sources surrounded only by sources of the same fluid or by solid blocks, such
+as the inside of an ocean) are removed from the schedule using bitwise neighbour operations, without looking at them
+one by one. The remaining blocks are simulated in section order, so that the chunk data accesses stay within a
+single section.
+*/
+
+
+
+
+
+#pragma once
+
+#include "VanillaFluidSimulator.h"
+#include "FluidSectionClassifier.h"
+
+
+
+
+
+class cSectionedFluidSimulatorChunkData:
+	public cFluidSimulatorData
+{
+public:
+
+	/** One bit for each block of a section, indexed the same as the blocks within the section. */
+	using cSectionBitmap = cFluidSectionClassifier::cSectionBitmap;
+
+	class cSlot
+	{
+	public:
+
+		/** Marks the specified block as scheduled.
+		Returns true if added, false if the block was already scheduled. */
+		bool Add(Vector3i a_RelPos);
+
+		/** The bitmaps of the scheduled blocks for each section, nullptr for sections with nothing scheduled. */
+		std::unique_ptr<cSectionBitmap> m_Sections[cChunkDef::NumSections];
+	};
+
+
+	cSectionedFluidSimulatorChunkData(int a_TickDelay);
+
+	/** Slots, one for each delay tick, each containing the blocks to simulate. */
+	std::vector<cSlot> m_Slots;
+};
+
+
+
+
+
+class cSectionedFluidSimulator:
+	public cVanillaFluidSimulator
+{
+	using Super = cVanillaFluidSimulator;
+
+public:
+
+	cSectionedFluidSimulator(
+		cWorld & a_World,
+		BLOCKTYPE a_Fluid,
+		BLOCKTYPE a_StationaryFluid,
+		NIBBLETYPE a_Falloff,
+		int a_TickDelay,
+		int a_NumNeighborsForSource
+	);
+
+protected:
+
+	using cSectionBitmap = cSectionedFluidSimulatorChunkData::cSectionBitmap;
+
+	/** Finds the scheduled blocks in heavily scheduled sections that needn't be simulated. */
+	cFluidSectionClassifier m_Classifier;
+
+
+	// cDelayedFluidSimulator overrides:
+	virtual void SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk) override;
+	virtual void AddBlock(cChunk & a_Chunk, Vector3i a_Position, BLOCKTYPE a_Block) override;
+	virtual cFluidSimulatorData * CreateChunkData(void) override { return new cSectionedFluidSimulatorChunkData(m_TickDelay); }
+
+	/** Returns, for each block type, whether a stationary source next to it (sideways or below) is known to stay unchanged. */
+	std::array<bool, 256> GetSettledNeighbors(void);
+};
+
+
+
+
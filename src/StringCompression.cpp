@@ -134,6 +134,21 @@ Compression::Result Compression::Compressor::CompressZLib(const void * const Inp
 
 
 
+size_t Compression::Compressor::CompressZLib(const ContiguousByteBufferView Input, ContiguousByteBuffer & Output)
+{
+	// The bound is the worst case, the compression cannot fail with that much space:
+	const auto Offset = Output.size();
+	Output.resize(Offset + libdeflate_zlib_compress_bound(m_Handle, Input.size()));
+	const auto BytesWrittenOut = libdeflate_zlib_compress(m_Handle, Input.data(), Input.size(), Output.data() + Offset, Output.size() - Offset);
+	ASSERT(BytesWrittenOut != 0);
+	Output.resize(Offset + BytesWrittenOut);
+	return BytesWrittenOut;
+}
+
+
+
+
+
 Compression::Extractor::Extractor()
 {
 	m_Handle = libdeflate_alloc_decompressor();
@@ -52,6 +52,10 @@ namespace Compression
 		Result CompressZLib(ContiguousByteBufferView Input);
 		Result CompressZLib(const void * Input, size_t Size);
 
+		/** Compresses the input in the zlib format, appending the result to Output. Returns the number of bytes appended.
+		Reusing the same output buffer for many calls avoids the allocations and the copy of the returned Result. */
+		size_t CompressZLib(ContiguousByteBufferView Input, ContiguousByteBuffer & Output);
+
 	private:
 
 		template <auto Algorithm>
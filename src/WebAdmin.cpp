@@ -7,6 +7,7 @@
 #include "Entities/Player.h"
 #include "Server.h"
 #include "Root.h"
+#include "Bindings/PluginLua.h"
 
 #include "HTTP/HTTPServerConnection.h"
 #include "HTTP/HTTPFormParser.h"
@@ -55,6 +56,169 @@ public:
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cPluginStatsWebTab:
+
+/** The built-in WebTab showing the time spent in the plugins' hook handlers and the results of the Lua profiler. */
+class cPluginStatsWebTab:
+	public cWebAdmin::cWebTabCallback
+{
+public:
+
+	virtual bool Call(
+		const HTTPRequest & a_Request,
+		const AString & a_UrlPath,
+		AString & a_Content,
+		AString & a_ContentType
+	) override
+	{
+		UNUSED(a_UrlPath);
+		UNUSED(a_ContentType);
+
+		HandleAction(a_Request);
+		a_Content.append(GetHookStatsHTML());
+		cPluginManager::Get()->ForEachPlugin([&a_Content](cPlugin & a_Plugin)
+			{
+				if (a_Plugin.IsLoaded())
+				{
+					a_Content.append(GetProfileHTML(static_cast<cPluginLua &>(a_Plugin)));
+				}
+				return false;
+			}
+		);
+		return true;
+	}
+
+private:
+
+	/** Executes the action requested by the form buttons, if any. */
+	static void HandleAction(const HTTPRequest & a_Request)
+	{
+		auto Action = a_Request.PostParams.find("action");
+		if (Action == a_Request.PostParams.end())
+		{
+			return;
+		}
+		if (Action->second == "resethooks")
+		{
+			cPluginManager::Get()->ResetHookStats();
+			return;
+		}
+
+		auto PluginName = a_Request.PostParams.find("plugin");
+		if (PluginName == a_Request.PostParams.end())
+		{
+			return;
+		}
+		cPluginManager::Get()->DoWithPlugin(PluginName->second, [&Action](cPlugin & a_Plugin)
+			{
+				if (!a_Plugin.IsLoaded())
+				{
+					return false;
+				}
+				auto & Plugin = static_cast<cPluginLua &>(a_Plugin);
+				if (Action->second == "start")
+				{
+					Plugin.StartProfiling(1000);
+				}
+				else if (Action->second == "stop")
+				{
+					Plugin.StopProfiling();
+				}
+				else if (Action->second == "reset")
+				{
+					Plugin.ResetProfile();
+				}
+				return true;
+			}
+		);
+	}
+
+
+	/** Returns a form with a single button executing the specified action. */
+	static AString GetActionButton(const AString & a_Action, const AString & a_PluginName, const AString & a_Caption)
+	{
+		return Printf(
+			"<form method='POST' style='display: inline'><input type='hidden' name='action' value='%s'/>"
+			"<input type='hidden' name='plugin' value='%s'/><input type='submit' value='%s'/></form>",
+			a_Action.c_str(), cWebAdmin::GetHTMLEscapedString(a_PluginName).c_str(), a_Caption.c_str()
+		);
+	}
+
+
+	/** Returns the table of the hook statistics. */
+	static AString GetHookStatsHTML(void)
+	{
+		AString Res = "<h4>Hook handlers</h4>";
+		Res.append(GetActionButton("resethooks", "", "Reset"));
+		Res.append(
+			"<table><tr><th>Plugin</th><th>Hook</th><th>Calls</th><th>Total ms</th><th>Avg ms</th>"
+			"<th>Max ms</th><th>Budget ms</th><th>Overruns</th></tr>"
+		);
+		auto PluginManager = cPluginManager::Get();
+		for (const auto & Item: PluginManager->GetHookStats())
+		{
+			const auto TotalMSec = std::chrono::duration<double, std::milli>(Item.m_Stats.m_TotalTime).count();
+			Res.append(Printf(
+				"<tr><td>%s</td><td>%s</td><td>%llu</td><td>%.2f</td><td>%.3f</td><td>%.2f</td><td>%.2f</td><td>%llu</td></tr>",
+				cWebAdmin::GetHTMLEscapedString(Item.m_PluginName).c_str(),
+				cPluginManager::GetHookName(Item.m_HookType).c_str(),
+				static_cast<unsigned long long>(Item.m_Stats.m_NumCalls),
+				TotalMSec,
+				TotalMSec / static_cast<double>(Item.m_Stats.m_NumCalls),
+				std::chrono::duration<double, std::milli>(Item.m_Stats.m_MaxTime).count(),
+				PluginManager->GetHookBudget(Item.m_HookType),
+				static_cast<unsigned long long>(Item.m_Stats.m_NumOverruns)
+			));
+		}
+		Res.append("</table>");
+		return Res;
+	}
+
+
+	/** Returns the controls and results of the Lua profiler of the specified plugin. */
+	static AString GetProfileHTML(cPluginLua & a_Plugin)
+	{
+		const auto & Name = a_Plugin.GetName();
+		AString Res = Printf("<h4>Lua profile: %s</h4>", cWebAdmin::GetHTMLEscapedString(Name).c_str());
+		if (a_Plugin.IsProfiling())
+		{
+			Res.append(GetActionButton("stop", Name, "Stop"));
+		}
+		else
+		{
+			Res.append(GetActionButton("start", Name, "Start"));
+		}
+		std::chrono::nanoseconds TotalTime;
+		auto Locations = a_Plugin.GetProfile(TotalTime);
+		if (Locations.empty())
+		{
+			return Res;
+		}
+		Res.append(GetActionButton("reset", Name, "Reset"));
+		Res.append("<table><tr><th>ms</th><th>%</th><th>Samples</th><th>Location</th><th>Function</th></tr>");
+		const auto TotalMSec = std::chrono::duration<double, std::milli>(TotalTime).count();
+		for (size_t i = 0; (i < Locations.size()) && (i < 50); i++)
+		{
+			const auto & Location = Locations[i];
+			const auto MSec = std::chrono::duration<double, std::milli>(Location.m_Time).count();
+			Res.append(Printf(
+				"<tr><td>%.2f</td><td>%.1f</td><td>%llu</td><td>%s:%d</td><td>%s</td></tr>",
+				MSec, (TotalMSec > 0) ? (100 * MSec / TotalMSec) : 0.0,
+				static_cast<unsigned long long>(Location.m_NumSamples),
+				cWebAdmin::GetHTMLEscapedString(Location.m_Source).c_str(), Location.m_Line,
+				cWebAdmin::GetHTMLEscapedString(Location.m_Function).c_str()
+			));
+		}
+		Res.append("</table>");
+		return Res;
+	}
+};
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cWebAdmin:
 
@@ -90,6 +254,9 @@ bool cWebAdmin::Init(void)
 
 	Reload();
 
+	// Add the built-in tabs:
+	AddWebTab("Plugin Performance", "performance", "Server", std::make_shared<cPluginStatsWebTab>());
+
 	// Read the ports to be used:
 	// Note that historically the ports were stored in the "Port" and "PortsIPv6" values
 	m_Ports = ReadUpgradeIniPorts(m_IniFile, "WebAdmin", "Ports", "Port", "PortsIPv6", DEFAULT_WEBADMIN_PORTS);
@@ -39,6 +39,7 @@
 #include "Simulator/NoopRedstoneSimulator.h"
 #include "Simulator/IncrementalRedstoneSimulator/IncrementalRedstoneSimulator.h"
 #include "Simulator/SandSimulator.h"
+#include "Simulator/SectionedFluidSimulator.h"
 #include "Simulator/VanillaFluidSimulator.h"
 #include "Simulator/VaporizeFluidSimulator.h"
 
@@ -149,6 +150,7 @@ cWorld::cWorld(
 #else
 	m_StorageCompressionFactor(6),
 #endif
+	m_StorageChunkCacheSize(32 * 1024),
 	m_IsSavingEnabled(true),
 	m_Dimension(a_Dimension),
 	m_IsSpawnExplicitlySet(false),
@@ -210,6 +212,7 @@ cWorld::cWorld(
 	m_MaxViewDistance(12),
 	m_Scoreboard(this),
 	m_MapManager(this),
+	m_PreGenerator(*this),
 	m_GeneratorCallbacks(*this),
 	m_ChunkSender(*this),
 	m_Lighting(*this),
@@ -249,6 +252,7 @@ cWorld::cWorld(
 		IniFile.SetValueI("General", "UnusedChunkCap", UnusedDirtyChunksCap);
 	}
 	m_UnusedDirtyChunksCap = static_cast<size_t>(UnusedDirtyChunksCap);
+	m_MaxLoadedChunks = static_cast<size_t>(std::max(IniFile.GetValueSetI("General", "MaxLoadedChunks", 0), 0));
 
 	m_BroadcastDeathMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastDeathMessages", true);
 	m_BroadcastAchievementMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastAchievementMessages", true);
@@ -277,6 +281,7 @@ cWorld::cWorld(
 
 	m_StorageSchema               = IniFile.GetValueSet ("Storage",       "Schema",                      m_StorageSchema);
 	m_StorageCompressionFactor    = IniFile.GetValueSetI("Storage",       "CompressionFactor",           m_StorageCompressionFactor);
+	m_StorageChunkCacheSize       = IniFile.GetValueSetI("Storage",       "ChunkCacheSizeKiB",           m_StorageChunkCacheSize);
 	m_MaxCactusHeight             = IniFile.GetValueSetI("Plants",        "MaxCactusHeight",             3);
 	m_MaxSugarcaneHeight          = IniFile.GetValueSetI("Plants",        "MaxSugarcaneHeight",          3);
 	/* TODO: Enable when functionality exists again
@@ -422,10 +427,12 @@ cWorld::cWorld(
 	m_SimulatorManager->RegisterSimulator(m_SandSimulator.get(), 1);
 	m_SimulatorManager->RegisterSimulator(m_FireSimulator.get(), 1);
 
-	m_Storage.Initialize(*this, m_StorageSchema, m_StorageCompressionFactor);
+	m_Storage.Initialize(*this, m_StorageSchema, m_StorageCompressionFactor, static_cast<size_t>(std::max(m_StorageChunkCacheSize, 0)) * 1024);
 	m_Generator.Initialize(m_GeneratorCallbacks, m_GeneratorCallbacks, IniFile);
 
 	m_MapManager.LoadMapData();
+	m_PreGenerator.Initialize(IniFile);
+	m_EntityTracker.Initialize(IniFile);
 
 	// Save any changes that the defaults may have done to the ini file:
 	if (!IniFile.WriteFile(m_IniFileName))
@@ -978,6 +985,7 @@ void cWorld::Stop(cDeadlockDetect & a_DeadlockDetect)
 	IniFile.WriteFile(m_IniFileName);
 
 	m_TickThread.Stop();
+	m_PreGenerator.SaveProgress();
 	m_Lighting.Stop();
 	m_Generator.Stop();
 	m_ChunkSender.Stop();
@@ -1038,8 +1046,11 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 	TickQueuedBlocks();
 	m_ChunkMap.Tick(a_Dt);
 	TickMobs(a_Dt);
+	m_ChunkMap.UpdateEntityTracking();  // After all entities have moved, see cEntityTracker
 	TickQueuedEntityAdditions();
 	m_MapManager.TickMaps();
+	m_PreGenerator.Tick();
+	TickGeneratorInterestPoints();
 	TickQueuedTasks();
 	TickWeather(static_cast<float>(a_Dt.count()));
 
@@ -1067,6 +1078,20 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 			SaveAllChunks();
 		}
 	}
+	else if (
+		(m_MaxLoadedChunks > 0) &&
+		(m_WorldAge - m_LastChunkCheck > std::chrono::seconds(1)) &&
+		(GetNumChunks() > m_MaxLoadedChunks)
+	)
+	{
+		// Too many chunks loaded, unload sooner. Saving the unused dirty chunks lets the next check unload them, too.
+		// The save queue doesn't deduplicate, so wait until the chunks queued by the previous check are saved:
+		UnloadUnusedChunks();
+		if (IsSavingEnabled() && (GetStorageSaveQueueLength() == 0))
+		{
+			m_ChunkMap.SaveUnusedDirtyChunks();
+		}
+	}
 }
 
 
@@ -1107,6 +1132,36 @@ void cWorld::TickWeather(float a_Dt)
 
 
 
+void cWorld::TickGeneratorInterestPoints(void)
+{
+	// Four times a second is often enough even for flying players:
+	if ((m_WorldTickAge % 5_tick) != 0_tick)
+	{
+		return;
+	}
+
+	std::vector<cChunkCoords> Points;
+	Points.reserve(m_Players.size());
+	for (const auto Player : m_Players)
+	{
+		Points.emplace_back(Player->GetChunkX(), Player->GetChunkZ());
+	}
+	std::sort(Points.begin(), Points.end());
+	Points.erase(std::unique(Points.begin(), Points.end()), Points.end());
+
+	// Re-ranking the generator queue is not free, only do it when someone has moved to another chunk:
+	if (Points == m_GeneratorInterestPoints)
+	{
+		return;
+	}
+	m_GeneratorInterestPoints = Points;
+	m_Generator.SetInterestPoints(std::move(Points));
+}
+
+
+
+
+
 void cWorld::TickMobs(std::chrono::milliseconds a_Dt)
 {
 	// _X 2013_10_22: This is a quick fix for #283 - the world needs to be locked while ticking mobs
@@ -1354,6 +1409,16 @@ void cWorld::WakeUpSimulators(Vector3i a_Block)
 void cWorld::WakeUpSimulatorsInArea(const cCuboid & a_Area)
 {
 	m_SimulatorManager->WakeUp(a_Area);
+
+	// Wake up the resting entities in and around the area, they may have lost their support:
+	cBoundingBox Box(Vector3d(a_Area.p1), Vector3d(a_Area.p2) + Vector3d(1, 1, 1));
+	Box.Expand(1, 1, 1);
+	ForEachEntityInBox(Box, [](cEntity & a_Entity)
+		{
+			a_Entity.WakeUp();
+			return false;
+		}
+	);
 }
 
 
@@ -1790,6 +1855,15 @@ bool cWorld::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlock
 
 
 
+bool cWorld::WriteBlockAreaIfLoaded(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes)
+{
+	return m_ChunkMap.WriteBlockAreaIfLoaded(a_Area, a_MinBlockX, a_MinBlockY, a_MinBlockZ, a_DataTypes);
+}
+
+
+
+
+
 void cWorld::SpawnItemPickups(const cItems & a_Pickups, Vector3i a_BlockPos, double a_FlyAwaySpeed, bool a_IsPlayerCreated)
 {
 	auto & random = GetRandomProvider();
@@ -2340,14 +2414,30 @@ bool cWorld::DoWithPlayerByUUID(const cUUID & a_PlayerUUID, cPlayerListCallback
 
 
 
-bool cWorld::DoWithNearestPlayer(Vector3d a_Pos, double a_RangeLimit, cPlayerListCallback a_Callback, bool a_CheckLineOfSight, bool a_IgnoreSpectator)
+bool cWorld::ForEachPlayerInRange(Vector3d a_Pos, double a_Range, cPlayerListCallback a_Callback)
 {
-	double ClosestDistance = a_RangeLimit;
-	cPlayer * ClosestPlayer = nullptr;
+	cLock Lock(*this);
+	return m_PlayerIndex.ForEachPlayerInRange(a_Pos, a_Range, [&a_Callback](cPlayer & a_Player)
+		{
+			return (a_Player.IsTicking() && a_Callback(a_Player));
+		}
+	);
+}
+
 
+
+
+
+bool cWorld::DoWithNearestPlayer(Vector3d a_Pos, double a_RangeLimit, cPlayerListCallback a_Callback, bool a_CheckLineOfSight, bool a_IgnoreSpectator)
+{
 	cLock Lock(*this);
-	for (const auto Player : m_Players)
+
+	// Get the players in range, nearest first, so that the line of sight is traced only until the first visible one:
+	cPlayerSpatialIndex::cNearestPlayers Candidates;
+	m_PlayerIndex.FindNearestPlayers(a_Pos, a_RangeLimit, std::numeric_limits<size_t>::max(), Candidates);
+	for (const auto & Candidate: Candidates)
 	{
+		const auto Player = Candidate.second;
 		if (!Player->IsTicking())
 		{
 			continue;
@@ -2358,36 +2448,18 @@ bool cWorld::DoWithNearestPlayer(Vector3d a_Pos, double a_RangeLimit, cPlayerLis
 			continue;
 		}
 
-		Vector3f Pos = Player->GetPosition();
-		double Distance = (Pos - a_Pos).Length();
-
-		// If the player is too far, skip them:
-		if (Distance > ClosestDistance)
-		{
-			continue;
-		}
-
 		// Check LineOfSight, if requested:
 		if (
 			a_CheckLineOfSight &&
-			!cLineBlockTracer::LineOfSightTrace(*this, a_Pos, Pos, cLineBlockTracer::losAirWater)
+			!cLineBlockTracer::LineOfSightTrace(*this, a_Pos, Player->GetPosition(), cLineBlockTracer::losAirWater)
 		)
 		{
 			continue;
 		}
 
-		ClosestDistance = Distance;
-		ClosestPlayer = Player;
-	}
-
-	if (ClosestPlayer)
-	{
-		return a_Callback(*ClosestPlayer);
-	}
-	else
-	{
-		return false;
+		return a_Callback(*Player);
 	}
+	return false;
 }
 
 
@@ -2507,6 +2579,24 @@ void cWorld::RemoveClientFromChunks(cClientHandle * a_Client)
 
 
 
+void cWorld::PrefetchChunk(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
+{
+	m_ChunkMap.PrefetchChunk(a_ChunkX, a_ChunkZ, a_Client);
+}
+
+
+
+
+
+void cWorld::CancelChunkPrefetch(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
+{
+	m_ChunkMap.CancelChunkPrefetch(a_ChunkX, a_ChunkZ, a_Client);
+}
+
+
+
+
+
 void cWorld::SendChunkTo(int a_ChunkX, int a_ChunkZ, cChunkSender::Priority a_Priority, cClientHandle * a_Client)
 {
 	m_ChunkSender.QueueSendChunkTo(a_ChunkX, a_ChunkZ, a_Priority, a_Client);
@@ -2762,6 +2852,7 @@ OwnedEntity cWorld::RemoveEntity(cEntity & a_Entity)
 		const auto Player = static_cast<cPlayer *>(&a_Entity);
 		LOGD("Removing player %s from world \"%s\"", Player->GetName().c_str(), m_WorldName.c_str());
 		m_Players.erase(std::remove(m_Players.begin(), m_Players.end(), Player), m_Players.end());
+		m_PlayerIndex.Remove(*Player);
 	}
 
 	// Check if the entity is in the chunkmap:
@@ -3118,6 +3209,10 @@ cFluidSimulator * cWorld::InitializeFluidSimulator(cIniFile & a_IniFile, const c
 		{
 			res = new cVanillaFluidSimulator(*this, a_SimulateBlock, a_StationaryBlock, static_cast<NIBBLETYPE>(Falloff), TickDelay, NumNeighborsForSource);
 		}
+		else if (NoCaseCompare(SimulatorName, "sectioned") == 0)
+		{
+			res = new cSectionedFluidSimulator(*this, a_SimulateBlock, a_StationaryBlock, static_cast<NIBBLETYPE>(Falloff), TickDelay, NumNeighborsForSource);
+		}
 		else
 		{
 			// The simulator name doesn't match anything we have, issue a warning:
@@ -3192,7 +3287,19 @@ bool cWorld::cChunkGeneratorCallbacks::IsChunkQueued(cChunkCoords a_Coords)
 
 bool cWorld::cChunkGeneratorCallbacks::HasChunkAnyClients(cChunkCoords a_Coords)
 {
-	return m_World->HasChunkAnyClients(a_Coords.m_ChunkX, a_Coords.m_ChunkZ);
+	// Prefetched chunks count as well, so that their generation is cancelled when the prediction changes:
+	return
+		m_World->HasChunkAnyClients(a_Coords.m_ChunkX, a_Coords.m_ChunkZ) ||
+		m_World->m_ChunkMap.IsChunkPrefetched(a_Coords.m_ChunkX, a_Coords.m_ChunkZ);
+}
+
+
+
+
+
+bool cWorld::cChunkGeneratorCallbacks::CancelChunkIfUnneeded(cChunkCoords a_Coords)
+{
+	return m_World->m_ChunkMap.CancelChunkGenerationIfUnneeded(a_Coords.m_ChunkX, a_Coords.m_ChunkZ);
 }
 
 
@@ -16,6 +16,9 @@
 #include "ForEachChunkProvider.h"
 #include "Scoreboard.h"
 #include "MapManager.h"
+#include "PreGenerator.h"
+#include "EntityTracker.h"
+#include "PlayerSpatialIndex.h"
 #include "Blocks/WorldInterface.h"
 #include "Blocks/BroadcastInterface.h"
 #include "EffectID.h"
@@ -246,6 +249,10 @@ public:
 	/** Finds a player from a partial or complete player name and calls the callback - case-insensitive */
 	bool FindAndDoWithPlayer(const AString & a_PlayerNameHint, cPlayerListCallback a_Callback);  // >> EXPORTED IN MANUALBINDINGS <<
 
+	/** Calls the callback for each player within a_Range of a_Pos (measured to the player's position, i.e. feet).
+	Returns true if all players processed, false if the callback aborted by returning true. */
+	bool ForEachPlayerInRange(Vector3d a_Pos, double a_Range, cPlayerListCallback a_Callback);
+
 	/** Calls the callback for nearest player for given position, Returns false if player not found, otherwise returns the same value as the callback */
 	bool DoWithNearestPlayer(Vector3d a_Pos, double a_RangeLimit, cPlayerListCallback a_Callback, bool a_CheckLineOfSight = true, bool a_IgnoreSpectator = true);
 
@@ -293,6 +300,13 @@ public:
 	/** Removes the client from all chunks it is present in */
 	void RemoveClientFromChunks(cClientHandle * a_Client);
 
+	/** Queues the chunk for loading / generating and keeps it loaded until the client cancels the prefetch.
+	Used for the chunks on the predicted path of the client's player. */
+	void PrefetchChunk(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client);
+
+	/** Cancels the client's prefetch of the chunk, so that it can be unloaded, or its generation cancelled, if nothing else needs it. */
+	void CancelChunkPrefetch(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client);
+
 	/** Sends the chunk to the client specified, if the client doesn't have the chunk yet.
 	If chunk not valid, the request is postponed (ChunkSender will send that chunk when it becomes valid + lighted). */
 	void SendChunkTo(int a_ChunkX, int a_ChunkZ, cChunkSender::Priority a_Priority, cClientHandle * a_Client);
@@ -398,6 +412,10 @@ public:
 	Doesn't wake up simulators, use WakeUpSimulatorsInArea() for that. */
 	virtual bool WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes) override;
 
+	/** Writes the block area into the specified coords, but only if all the chunks it covers are loaded.
+	Returns false, without writing anything, if any of them isn't. Doesn't wake up simulators, same as WriteBlockArea(). */
+	bool WriteBlockAreaIfLoaded(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes);
+
 	// tolua_begin
 
 	/** Spawns item pickups for each item in the list.
@@ -695,6 +713,9 @@ public:
 	/** Returns the associated map manager instance. */
 	cMapManager & GetMapManager(void) { return m_MapManager; }
 
+	/** Returns the service that pre-generates areas of this world in the background. */
+	cPreGenerator & GetPreGenerator(void) { return m_PreGenerator; }
+
 	bool AreCommandBlocksEnabled(void) const { return m_bCommandBlocksEnabled; }
 	void SetCommandBlocksEnabled(bool a_Flag) { m_bCommandBlocksEnabled = a_Flag; }
 
@@ -755,6 +776,9 @@ public:
 	/** Returns the number of chunks loaded and dirty, and in the lighting queue */
 	void GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue);
 
+	/** Returns the number of (non-mob) entities the chunks fully ticked in their last tick, and the number of entities at rest. */
+	void GetEntityStats(size_t & a_NumTicked, size_t & a_NumResting) const { m_ChunkMap.GetEntityStats(a_NumTicked, a_NumResting); }
+
 	// Various queues length queries (cannot be const, they lock their CS):
 	inline size_t GetGeneratorQueueLength  (void) { return m_Generator.GetQueueLength();   }    // tolua_export
 	inline size_t GetLightingQueueLength   (void) { return m_Lighting.GetQueueLength();    }    // tolua_export
@@ -844,6 +868,12 @@ public:
 	cWorldStorage &   GetStorage  (void) { return m_Storage; }
 	cChunkMap *       GetChunkMap (void) { return &m_ChunkMap; }
 
+	/** Returns the tracker deciding which entities are spawned on which clients. */
+	cEntityTracker & GetEntityTracker(void) { return m_EntityTracker; }
+
+	/** Returns the index of the players by chunk. Protected by the chunkmap lock, same as the player list. */
+	cPlayerSpatialIndex & GetPlayerIndex(void) { return m_PlayerIndex; }
+
 	/** Causes the specified block to be ticked on the next Tick() call.
 	Only one block coord per chunk may be set, a second call overwrites the first call */
 	void SetNextBlockToTick(const Vector3i a_BlockPos);  // tolua_export
@@ -916,6 +946,7 @@ private:
 		virtual void OnChunkGenerated  (cChunkDesc & a_ChunkDesc) override;
 		virtual bool IsChunkValid      (cChunkCoords a_Coords) override;
 		virtual bool HasChunkAnyClients(cChunkCoords a_Coords) override;
+		virtual bool CancelChunkIfUnneeded(cChunkCoords a_Coords) override;
 		virtual bool IsChunkQueued     (cChunkCoords a_Coords) override;
 
 		// cPluginInterface overrides:
@@ -932,6 +963,10 @@ private:
 	if this was exceeded. */
 	size_t m_UnusedDirtyChunksCap;
 
+	/** The number of loaded chunks above which the unused chunks are unloaded (and the unused dirty chunks saved) every second instead of every 10 seconds.
+	Zero for no limit. Loaded from config. */
+	size_t m_MaxLoadedChunks;
+
 	AString m_WorldName;
 
 	/** The path to the root directory for the world files. Does not including trailing path specifier. */
@@ -948,6 +983,9 @@ private:
 
 	int m_StorageCompressionFactor;
 
+	/** The memory budget of the storage's compressed chunk cache, in KiB. Zero disables the cache. */
+	int m_StorageChunkCacheSize;
+
 	/** Whether or not writing chunks to disk is currently enabled */
 	std::atomic<bool> m_IsSavingEnabled;
 
@@ -1010,6 +1048,12 @@ private:
 	// Protect with chunk map CS
 	std::vector<cPlayer *> m_Players;
 
+	/** The players in m_Players, bucketed by chunk for the range queries. Protect with chunk map CS. */
+	cPlayerSpatialIndex m_PlayerIndex;
+
+	/** The player chunks last sent to the generator as interest points, sorted. Used only by the tick thread. */
+	std::vector<cChunkCoords> m_GeneratorInterestPoints;
+
 	cWorldStorage m_Storage;
 
 	unsigned int m_MaxPlayers;
@@ -1072,6 +1116,12 @@ private:
 	cScoreboard      m_Scoreboard;
 	cMapManager      m_MapManager;
 
+	/** Pre-generates areas of the world in the background, driven by the tick thread. */
+	cPreGenerator    m_PreGenerator;
+
+	/** Decides which entities are spawned on which clients, and how often their movement is sent. */
+	cEntityTracker   m_EntityTracker;
+
 	/** The callbacks that the ChunkGenerator uses to store new chunks and interface to plugins */
 	cChunkGeneratorCallbacks m_GeneratorCallbacks;
 
@@ -1105,6 +1155,9 @@ private:
 	/** Handles the mob spawning / moving / destroying each tick */
 	void TickMobs(std::chrono::milliseconds a_Dt);
 
+	/** Every few ticks, sends the chunks where the players are to the generator, if changed, so that it prioritises chunks around them. */
+	void TickGeneratorInterestPoints(void);
+
 	/** Sets the chunk data queued in the m_SetChunkDataQueue queue into their chunk. */
 	void TickQueuedChunkDataSets();
 
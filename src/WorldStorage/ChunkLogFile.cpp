@@ -0,0 +1,429 @@
+
+// ChunkLogFile.cpp
+
+// Implements the cChunkLogFile class representing a single append-only file storing the compressed data of a group of chunks
+
+#include "Globals.h"
+#include "ChunkLogFile.h"
+
+#include <libdeflate.h>
+
+
+
+
+
+/** The magic at the start of the file. */
+static const char FILE_MAGIC[4] = {'C', 'W', 'S', 'L'};
+
+/** The version of the file format, written after the magic. */
+static const UInt32 FILE_VERSION = 2;
+
+/** The size of the file header: the magic and the version. */
+static const size_t FILE_HEADER_SIZE = 8;
+
+/** The magic at the start of each record, so that the records can be found again after a damaged one. */
+static const char RECORD_MAGIC[4] = {'C', 'W', 'S', 'R'};
+
+/** The size of the record header: the magic, the coords, the timestamp, the data size, the data checksum and the header checksum. */
+static const size_t RECORD_HEADER_SIZE = 28;
+
+/** The size of the blocks read when looking for the next valid record after a damaged one. */
+static const size_t SCAN_BLOCK_SIZE = 64 KiB;
+
+/** Files smaller than this are never compacted, the space saved is not worth the rewrite. */
+static const size_t MIN_COMPACTION_SIZE = 1 MiB;
+
+
+
+
+
+cChunkLogFile::cChunkLogFile(const AString & a_FileName):
+	m_FileName(a_FileName),
+	m_EndOffset(0),
+	m_LiveSize(0)
+{
+}
+
+
+
+
+
+bool cChunkLogFile::Open(bool a_ShouldCreate)
+{
+	if (m_File.IsOpen())
+	{
+		// Already open
+		return true;
+	}
+
+	if (!a_ShouldCreate && !cFile::IsFile(m_FileName))
+	{
+		return false;
+	}
+
+	if (!m_File.Open(m_FileName, cFile::fmReadWrite))
+	{
+		return false;
+	}
+
+	m_Index.clear();
+	if (m_File.GetSize() <= 0)
+	{
+		if (!WriteHeader())
+		{
+			LOGWARNING("Cannot write the header of chunk log file \"%s\"", m_FileName.c_str());
+			m_File.Close();
+			return false;
+		}
+		return true;
+	}
+
+	if (!ReadIndex())
+	{
+		LOGWARNING("File \"%s\" is not a chunk log file, the chunks in it will not be loaded", m_FileName.c_str());
+		m_File.Close();
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+bool cChunkLogFile::GetTimeStamp(const cChunkCoords & a_Chunk, UInt32 & a_TimeStamp) const
+{
+	const auto itr = m_Index.find(a_Chunk);
+	if (itr == m_Index.end())
+	{
+		return false;
+	}
+	a_TimeStamp = itr->second.m_TimeStamp;
+	return true;
+}
+
+
+
+
+
+bool cChunkLogFile::GetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Data)
+{
+	const auto itr = m_Index.find(a_Chunk);
+	if (itr == m_Index.end())
+	{
+		return false;
+	}
+
+	const auto & Record = itr->second;
+	if (m_File.Seek(static_cast<int>(Record.m_DataOffset)) < 0)
+	{
+		return false;
+	}
+	a_Data = m_File.Read(Record.m_DataSize);
+	return (a_Data.size() == Record.m_DataSize) && (GetChecksum(a_Data) == Record.m_Checksum);
+}
+
+
+
+
+
+bool cChunkLogFile::SetChunkData(const cChunkCoords & a_Chunk, const ContiguousByteBufferView a_Data, const UInt32 a_TimeStamp)
+{
+	// The offsets need to fit the int that cFile::Seek() takes:
+	if (m_EndOffset + RECORD_HEADER_SIZE + a_Data.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+	{
+		LOGWARNING("Cannot save chunk [%d, %d], file \"%s\" is too large", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, m_FileName.c_str());
+		return false;
+	}
+	return AppendRecord(a_Chunk, a_Data, a_TimeStamp, GetChecksum(a_Data));
+}
+
+
+
+
+
+bool cChunkLogFile::CompactIfNeeded(void)
+{
+	if ((m_EndOffset < MIN_COMPACTION_SIZE) || (m_LiveSize * 2 >= m_EndOffset))
+	{
+		return true;
+	}
+	return Compact();
+}
+
+
+
+
+
+bool cChunkLogFile::Compact(void)
+{
+	ASSERT(m_File.IsOpen());
+
+	// Copy the records in the order of the file, so that the reads are sequential:
+	std::vector<std::pair<cChunkCoords, sRecord>> Records(m_Index.begin(), m_Index.end());
+	std::sort(Records.begin(), Records.end(), [](const auto & a_First, const auto & a_Second)
+		{
+			return (a_First.second.m_DataOffset < a_Second.second.m_DataOffset);
+		}
+	);
+
+	const auto TempFileName = m_FileName + ".tmp";
+	cFile::DeleteFile(TempFileName);
+	cChunkLogFile Compacted(TempFileName);
+	if (!Compacted.Open(true))
+	{
+		LOGWARNING("Cannot compact chunk log file \"%s\": cannot create file \"%s\"", m_FileName.c_str(), TempFileName.c_str());
+		return false;
+	}
+	ContiguousByteBuffer Data;
+	for (const auto & Record: Records)
+	{
+		if (!GetChunkData(Record.first, Data))
+		{
+			LOGWARNING("Chunk [%d, %d] in file \"%s\" is corrupted, dropping it",
+				Record.first.m_ChunkX, Record.first.m_ChunkZ, m_FileName.c_str()
+			);
+			continue;
+		}
+		if (!Compacted.AppendRecord(Record.first, Data, Record.second.m_TimeStamp, Record.second.m_Checksum))
+		{
+			LOGWARNING("Cannot compact chunk log file \"%s\": writing file \"%s\" failed", m_FileName.c_str(), TempFileName.c_str());
+			Compacted.m_File.Close();
+			cFile::DeleteFile(TempFileName);
+			return false;
+		}
+	}
+
+	// The new file must be complete on the disk before it replaces the old one:
+	if (!Compacted.m_File.Sync())
+	{
+		LOGWARNING("Cannot compact chunk log file \"%s\": writing file \"%s\" failed", m_FileName.c_str(), TempFileName.c_str());
+		Compacted.m_File.Close();
+		cFile::DeleteFile(TempFileName);
+		return false;
+	}
+	Compacted.m_File.Close();
+	m_File.Close();
+
+	// Replace the old file; some platforms refuse to rename over an existing file, remove it first there:
+	bool IsReplaced = cFile::Rename(TempFileName, m_FileName);
+	if (!IsReplaced && cFile::DeleteFile(m_FileName))
+	{
+		IsReplaced = cFile::Rename(TempFileName, m_FileName);
+	}
+	if (IsReplaced)
+	{
+		m_Index = std::move(Compacted.m_Index);
+		m_EndOffset = Compacted.m_EndOffset;
+		m_LiveSize = Compacted.m_LiveSize;
+	}
+	else
+	{
+		LOGWARNING("Cannot compact chunk log file \"%s\": cannot replace it with file \"%s\"", m_FileName.c_str(), TempFileName.c_str());
+		cFile::DeleteFile(TempFileName);
+	}
+
+	if (!m_File.Open(m_FileName, cFile::fmReadWrite))
+	{
+		LOGWARNING("Cannot reopen chunk log file \"%s\", chunks in that file will not be loaded until restart", m_FileName.c_str());
+		m_Index.clear();
+		return false;
+	}
+	return IsReplaced;
+}
+
+
+
+
+
+bool cChunkLogFile::ReadIndex(void)
+{
+	std::byte Header[FILE_HEADER_SIZE];
+	if (
+		(m_File.Seek(0) < 0) ||
+		(m_File.Read(Header, sizeof(Header)) != sizeof(Header)) ||
+		(std::memcmp(Header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) ||
+		(GetBEInt(Header + sizeof(FILE_MAGIC)) != static_cast<int>(FILE_VERSION))
+	)
+	{
+		return false;
+	}
+
+	const auto FileSize = static_cast<size_t>(m_File.GetSize());
+	m_EndOffset = FILE_HEADER_SIZE;
+	m_LiveSize = FILE_HEADER_SIZE;
+	size_t Offset = FILE_HEADER_SIZE;
+	ContiguousByteBuffer Data;
+	while (Offset + RECORD_HEADER_SIZE <= FileSize)
+	{
+		cChunkCoords Chunk(0, 0);
+		sRecord Record;
+		if (!ReadRecordHeader(Offset, Chunk, Record))
+		{
+			// The header is damaged, its size cannot be trusted; continue with the next valid record, if there's any:
+			const auto Next = FindNextRecord(Offset + 1, FileSize);
+			if (Next < FileSize)
+			{
+				LOGWARNING("File \"%s\" is damaged between offsets %zu and %zu, the chunks saved there are lost",
+					m_FileName.c_str(), Offset, Next
+				);
+			}
+			Offset = Next;
+			continue;
+		}
+		if (Record.m_DataOffset + static_cast<size_t>(Record.m_DataSize) > FileSize)
+		{
+			// An incomplete record, the server has crashed while writing it. Nothing valid can follow it:
+			break;
+		}
+
+		// Only index the records that are intact; a record that isn't is dead space that compaction will drop.
+		// Its header is valid, so the next record is still found and the next save doesn't overwrite it:
+		Data = m_File.Read(Record.m_DataSize);
+		Offset = Record.m_DataOffset + Record.m_DataSize;
+		m_EndOffset = Offset;
+		if ((Data.size() != Record.m_DataSize) || (GetChecksum(Data) != Record.m_Checksum))
+		{
+			LOGWARNING("Chunk [%d, %d] in file \"%s\" at offset %u is corrupted, ignoring it",
+				Chunk.m_ChunkX, Chunk.m_ChunkZ, m_FileName.c_str(), Record.m_DataOffset
+			);
+			continue;
+		}
+		if (const auto itr = m_Index.find(Chunk); itr != m_Index.end())
+		{
+			m_LiveSize -= RECORD_HEADER_SIZE + itr->second.m_DataSize;
+		}
+		m_Index[Chunk] = Record;
+		m_LiveSize += RECORD_HEADER_SIZE + Record.m_DataSize;
+	}
+	return true;
+}
+
+
+
+
+
+bool cChunkLogFile::ReadRecordHeader(const size_t a_Offset, cChunkCoords & a_Chunk, sRecord & a_Record)
+{
+	std::byte RecordHeader[RECORD_HEADER_SIZE];
+	if (
+		(m_File.Seek(static_cast<int>(a_Offset)) < 0) ||
+		(m_File.Read(RecordHeader, sizeof(RecordHeader)) != sizeof(RecordHeader)) ||
+		(std::memcmp(RecordHeader, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0) ||
+		(static_cast<UInt32>(GetBEInt(RecordHeader + 24)) != GetChecksum({RecordHeader, 24}))
+	)
+	{
+		return false;
+	}
+	a_Chunk = cChunkCoords(GetBEInt(RecordHeader + 4), GetBEInt(RecordHeader + 8));
+	a_Record.m_DataOffset = static_cast<UInt32>(a_Offset + RECORD_HEADER_SIZE);
+	a_Record.m_TimeStamp = static_cast<UInt32>(GetBEInt(RecordHeader + 12));
+	a_Record.m_DataSize = static_cast<UInt32>(GetBEInt(RecordHeader + 16));
+	a_Record.m_Checksum = static_cast<UInt32>(GetBEInt(RecordHeader + 20));
+	return true;
+}
+
+
+
+
+
+size_t cChunkLogFile::FindNextRecord(size_t a_Offset, const size_t a_FileSize)
+{
+	ContiguousByteBuffer Block;
+	cChunkCoords Chunk(0, 0);
+	sRecord Record;
+	while (a_Offset + RECORD_HEADER_SIZE <= a_FileSize)
+	{
+		if (m_File.Seek(static_cast<int>(a_Offset)) < 0)
+		{
+			break;
+		}
+		Block = m_File.Read(std::min(SCAN_BLOCK_SIZE, a_FileSize - a_Offset));
+		if (Block.size() < sizeof(RECORD_MAGIC))
+		{
+			break;
+		}
+		for (size_t i = 0; i + sizeof(RECORD_MAGIC) <= Block.size(); i++)
+		{
+			// The magic alone may also appear in the data, only a header with a matching checksum counts:
+			if ((std::memcmp(Block.data() + i, RECORD_MAGIC, sizeof(RECORD_MAGIC)) == 0) && ReadRecordHeader(a_Offset + i, Chunk, Record))
+			{
+				return a_Offset + i;
+			}
+		}
+
+		// The next block overlaps this one, in case a magic spans the boundary:
+		a_Offset += Block.size() - (sizeof(RECORD_MAGIC) - 1);
+	}
+	return a_FileSize;
+}
+
+
+
+
+
+bool cChunkLogFile::WriteHeader(void)
+{
+	std::byte Header[FILE_HEADER_SIZE];
+	std::memcpy(Header, FILE_MAGIC, sizeof(FILE_MAGIC));
+	SetBEInt(Header + sizeof(FILE_MAGIC), static_cast<Int32>(FILE_VERSION));
+	if ((m_File.Seek(0) < 0) || (m_File.Write(Header, sizeof(Header)) != sizeof(Header)))
+	{
+		return false;
+	}
+	m_EndOffset = FILE_HEADER_SIZE;
+	m_LiveSize = FILE_HEADER_SIZE;
+	return true;
+}
+
+
+
+
+
+bool cChunkLogFile::AppendRecord(const cChunkCoords & a_Chunk, const ContiguousByteBufferView a_Data, const UInt32 a_TimeStamp, const UInt32 a_Checksum)
+{
+	std::byte RecordHeader[RECORD_HEADER_SIZE];
+	std::memcpy(RecordHeader, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+	SetBEInt(RecordHeader + 4,  a_Chunk.m_ChunkX);
+	SetBEInt(RecordHeader + 8,  a_Chunk.m_ChunkZ);
+	SetBEInt(RecordHeader + 12, static_cast<Int32>(a_TimeStamp));
+	SetBEInt(RecordHeader + 16, static_cast<Int32>(a_Data.size()));
+	SetBEInt(RecordHeader + 20, static_cast<Int32>(a_Checksum));
+	SetBEInt(RecordHeader + 24, static_cast<Int32>(GetChecksum({RecordHeader, 24})));
+	if (
+		(m_File.Seek(static_cast<int>(m_EndOffset)) < 0) ||
+		(m_File.Write(RecordHeader, sizeof(RecordHeader)) != sizeof(RecordHeader)) ||
+		(m_File.Write(a_Data.data(), a_Data.size()) != static_cast<int>(a_Data.size()))
+	)
+	{
+		// The next record will overwrite whatever got written
+		return false;
+	}
+
+	sRecord Record;
+	Record.m_DataOffset = static_cast<UInt32>(m_EndOffset + RECORD_HEADER_SIZE);
+	Record.m_DataSize = static_cast<UInt32>(a_Data.size());
+	Record.m_TimeStamp = a_TimeStamp;
+	Record.m_Checksum = a_Checksum;
+	if (const auto itr = m_Index.find(a_Chunk); itr != m_Index.end())
+	{
+		m_LiveSize -= RECORD_HEADER_SIZE + itr->second.m_DataSize;
+	}
+	m_Index[a_Chunk] = Record;
+	m_LiveSize += RECORD_HEADER_SIZE + a_Data.size();
+	m_EndOffset += RECORD_HEADER_SIZE + a_Data.size();
+	return true;
+}
+
+
+
+
+
+UInt32 cChunkLogFile::GetChecksum(const ContiguousByteBufferView a_Data)
+{
+	return libdeflate_crc32(0, a_Data.data(), a_Data.size());
+}
+
+
+
+
@@ -0,0 +1,132 @@
+
+// ChunkLogFile.h
+
+// Declares the cChunkLogFile class representing a single append-only file storing the compressed data of a group of chunks
+
+/*
+The file is a log of records, each holding one version of one chunk's data; saving a chunk appends a new record.
+The file starts with a header:
+	- 4 bytes: the magic "CWSL"
+	- 4 bytes: the version of the format, big-endian, currently 2
+Each record consists of:
+	- 4 bytes: the magic "CWSR"
+	- 4 bytes: ChunkX, big-endian
+	- 4 bytes: ChunkZ, big-endian
+	- 4 bytes: the time when the chunk was saved (Unix time), big-endian
+	- 4 bytes: the size of the data, big-endian
+	- 4 bytes: the CRC32 of the data, big-endian
+	- 4 bytes: the CRC32 of the record header's previous 24 bytes, big-endian
+	- the data itself
+
+When opened, the file is scanned and the index of the newest record of each chunk is built in memory.
+A record whose data doesn't match its checksum is skipped, its (verified) header still tells where the next record starts.
+A record header that doesn't match its checksum cannot be trusted for the size, so the scan looks for the next valid
+record header from there on; the records after a damaged header are not lost. New records are appended after the last
+valid record, so only the garbage at the very end of the file (such as a record the server crashed while writing)
+is ever overwritten.
+The older versions of the chunks are dead space; once they take up more than half of the file, the file is compacted,
+by writing the live records into a new file that then replaces the old one.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+#include "../OSSupport/File.h"
+
+
+
+
+
+class cChunkLogFile
+{
+public:
+
+	cChunkLogFile(const AString & a_FileName);
+
+	/** Opens the file and builds the index of the chunks in it.
+	If a_ShouldCreate is true, the file is created if it doesn't exist, otherwise a missing file fails.
+	Returns true if the file is open (including when it already was), false on failure. */
+	bool Open(bool a_ShouldCreate);
+
+	/** Closes the file, flushing the written data. Open() reopens it. */
+	void Close(void) { m_File.Close(); }
+
+	/** Writes the appended records through to the disk, so that they survive a crash. Returns true on success. */
+	bool Sync(void) { return m_File.Sync(); }
+
+	/** Returns the time when the chunk was saved into the file; returns false if the file doesn't have the chunk. */
+	bool GetTimeStamp(const cChunkCoords & a_Chunk, UInt32 & a_TimeStamp) const;
+
+	/** Reads the chunk's data into a_Data. Returns false if the file doesn't have the chunk, or the data cannot be read or is corrupted. */
+	bool GetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Data);
+
+	/** Appends the chunk's data, replacing the previous version of the chunk. Returns true on success. */
+	bool SetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data, UInt32 a_TimeStamp);
+
+	/** Compacts the file if the dead records take up more than half of it. Returns false if compaction was needed but failed. */
+	bool CompactIfNeeded(void);
+
+	/** Rewrites the file with only the newest record of each chunk. Returns true on success.
+	On failure the file stays as it was, unless it cannot be reopened. */
+	bool Compact(void);
+
+	const AString & GetFileName(void) const { return m_FileName; }
+
+	/** Returns the number of bytes used by the file, including the dead records. */
+	size_t GetFileSize(void) const { return m_EndOffset; }
+
+	/** Returns the number of bytes used by the header and the newest record of each chunk. */
+	size_t GetLiveSize(void) const { return m_LiveSize; }
+
+protected:
+
+	/** The position of the newest record of a single chunk. */
+	struct sRecord
+	{
+		/** The offset of the record's data in the file. */
+		UInt32 m_DataOffset;
+		UInt32 m_DataSize;
+		UInt32 m_TimeStamp;
+		UInt32 m_Checksum;
+	};
+
+	AString m_FileName;
+	cFile m_File;
+
+	/** The newest record of each chunk in the file. */
+	std::unordered_map<cChunkCoords, sRecord, cChunkCoordsHash> m_Index;
+
+	/** The offset where the next record will be written; the end of the last valid record. */
+	size_t m_EndOffset;
+
+	/** The number of bytes used by the header and the records in m_Index. */
+	size_t m_LiveSize;
+
+
+	/** Reads the records from the open file, building the index. Returns false if the file is not a chunk log file. */
+	bool ReadIndex(void);
+
+	/** Reads the record header at the specified offset into a_Chunk and a_Record.
+	Returns false if it cannot be read or it is damaged (the magic or the header checksum doesn't match). */
+	bool ReadRecordHeader(size_t a_Offset, cChunkCoords & a_Chunk, sRecord & a_Record);
+
+	/** Returns the offset of the first valid record header at or after a_Offset, or a_FileSize if there is none. */
+	size_t FindNextRecord(size_t a_Offset, size_t a_FileSize);
+
+	/** Writes a new header into the open, empty, file. */
+	bool WriteHeader(void);
+
+	/** Writes a record at m_EndOffset into the open file and adds it to the index. */
+	bool AppendRecord(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data, UInt32 a_TimeStamp, UInt32 a_Checksum);
+
+	/** Returns the CRC32 of the data. */
+	static UInt32 GetChecksum(ContiguousByteBufferView a_Data);
+};
+
+
+
+
@@ -0,0 +1,167 @@
+
+// CompressedChunkCache.cpp
+
+// Implements the cCompressedChunkCache class representing the in-memory cache of the compressed chunk data, used by the storage schemas
+
+#include "Globals.h"
+#include "CompressedChunkCache.h"
+
+
+
+
+
+/** The approximate number of bytes used by an entry besides its data: the list node, the index node and the buffer's own allocation overhead. */
+static const size_t ENTRY_OVERHEAD = 96;
+
+
+
+
+
+cCompressedChunkCache::cCompressedChunkCache(void):
+	m_MaxBytes(0),
+	m_NumBytes(0),
+	m_NumHits(0),
+	m_NumMisses(0),
+	m_NumEvictions(0)
+{
+}
+
+
+
+
+
+void cCompressedChunkCache::SetMaxBytes(size_t a_MaxBytes)
+{
+	cCSLock Lock(m_CS);
+	m_MaxBytes = a_MaxBytes;
+	EvictToFit(0);
+}
+
+
+
+
+
+void cCompressedChunkCache::Store(const cChunkCoords & a_Chunk, const ContiguousByteBufferView a_Data)
+{
+	cCSLock Lock(m_CS);
+
+	// Drop the old data first, so that it doesn't count against the budget:
+	if (const auto itr = m_Index.find(a_Chunk); itr != m_Index.end())
+	{
+		RemoveEntry(itr->second);
+	}
+
+	const auto Size = GetEntrySize(a_Data.size());
+	if (Size > m_MaxBytes)
+	{
+		return;
+	}
+	EvictToFit(Size);
+
+	m_Entries.emplace_front(a_Chunk, a_Data);
+	m_Index.emplace(a_Chunk, m_Entries.begin());
+	m_NumBytes += Size;
+}
+
+
+
+
+
+bool cCompressedChunkCache::Retrieve(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Data)
+{
+	cCSLock Lock(m_CS);
+	const auto itr = m_Index.find(a_Chunk);
+	if (itr == m_Index.end())
+	{
+		m_NumMisses += 1;
+		return false;
+	}
+	m_NumHits += 1;
+	m_Entries.splice(m_Entries.begin(), m_Entries, itr->second);
+	a_Data = itr->second->m_Data;
+	return true;
+}
+
+
+
+
+
+void cCompressedChunkCache::Touch(const cChunkCoords & a_Chunk)
+{
+	cCSLock Lock(m_CS);
+	if (const auto itr = m_Index.find(a_Chunk); itr != m_Index.end())
+	{
+		m_Entries.splice(m_Entries.begin(), m_Entries, itr->second);
+	}
+}
+
+
+
+
+
+void cCompressedChunkCache::Remove(const cChunkCoords & a_Chunk)
+{
+	cCSLock Lock(m_CS);
+	if (const auto itr = m_Index.find(a_Chunk); itr != m_Index.end())
+	{
+		RemoveEntry(itr->second);
+	}
+}
+
+
+
+
+
+cCompressedChunkCache::sStats cCompressedChunkCache::GetStats(void) const
+{
+	cCSLock Lock(m_CS);
+	sStats Stats;
+	Stats.m_NumEntries = m_Entries.size();
+	Stats.m_NumBytes = m_NumBytes;
+	Stats.m_MaxBytes = m_MaxBytes;
+	Stats.m_NumHits = m_NumHits;
+	Stats.m_NumMisses = m_NumMisses;
+	Stats.m_NumEvictions = m_NumEvictions;
+	return Stats;
+}
+
+
+
+
+
+size_t cCompressedChunkCache::GetEntrySize(size_t a_DataSize)
+{
+	return a_DataSize + ENTRY_OVERHEAD;
+}
+
+
+
+
+
+void cCompressedChunkCache::RemoveEntry(cEntries::iterator a_Entry)
+{
+	ASSERT(m_CS.IsLocked());
+	const auto Size = GetEntrySize(a_Entry->m_Data.size());
+	ASSERT(m_NumBytes >= Size);
+	m_NumBytes -= Size;
+	m_Index.erase(a_Entry->m_Chunk);
+	m_Entries.erase(a_Entry);
+}
+
+
+
+
+
+void cCompressedChunkCache::EvictToFit(size_t a_NumBytes)
+{
+	ASSERT(m_CS.IsLocked());
+	while (!m_Entries.empty() && (m_NumBytes + a_NumBytes > m_MaxBytes))
+	{
+		RemoveEntry(std::prev(m_Entries.end()));
+		m_NumEvictions += 1;
+	}
+}
+
+
+
+
@@ -0,0 +1,118 @@
+
+// CompressedChunkCache.h
+
+// Declares the cCompressedChunkCache class representing the in-memory cache of the compressed chunk data, used by the storage schemas
+
+/*
+The loaded chunks (cChunkMap) are the hot tier; once a chunk is unloaded, loading it again used to mean reading it from the region file.
+Players moving back and forth around the edge of their view distance make the same chunks unload and load over and over.
+This cache is the second tier: it keeps the compressed chunk data, exactly as it is stored in the region file,
+so that loading a recently used chunk doesn't need to touch the disk.
+
+The cache is write-through: the schema stores the data into it whenever it saves or loads a chunk, so the cached data is always the newest.
+The entries are evicted in the least-recently-used order, to keep the total size within the configured budget.
+An unloaded chunk is marked as used, so that the chunks unloaded last are the last to be evicted.
+
+The cache is thread-safe; it is used by the storage thread for loading and saving and by the tick thread for the unloads.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+
+
+
+
+class cCompressedChunkCache
+{
+public:
+
+	/** The statistics of the cache, for the chunk stats console command. */
+	struct sStats
+	{
+		size_t m_NumEntries;
+		size_t m_NumBytes;
+		size_t m_MaxBytes;
+		UInt64 m_NumHits;
+		UInt64 m_NumMisses;
+		UInt64 m_NumEvictions;
+	};
+
+
+	cCompressedChunkCache(void);
+
+	/** Sets the memory budget, in bytes, evicting the least recently used entries if it is exceeded. Zero disables the cache. */
+	void SetMaxBytes(size_t a_MaxBytes);
+
+	/** Stores the compressed data of the chunk, replacing the previous data of the same chunk.
+	Evicts the least recently used entries to make space. The data is not stored if it alone wouldn't fit into the budget. */
+	void Store(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data);
+
+	/** Copies the cached data of the chunk into a_Data and marks the entry as the most recently used.
+	Returns false if the chunk is not cached. */
+	bool Retrieve(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Data);
+
+	/** Marks the chunk's entry, if any, as the most recently used. */
+	void Touch(const cChunkCoords & a_Chunk);
+
+	/** Removes the chunk's entry, if any. Used when the cached data cannot be trusted anymore. */
+	void Remove(const cChunkCoords & a_Chunk);
+
+	/** Returns the current statistics of the cache. */
+	sStats GetStats(void) const;
+
+protected:
+
+	/** The cached data of a single chunk. */
+	struct sEntry
+	{
+		cChunkCoords m_Chunk;
+		ContiguousByteBuffer m_Data;
+
+		sEntry(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data):
+			m_Chunk(a_Chunk),
+			m_Data(a_Data)
+		{
+		}
+	};
+
+	using cEntries = std::list<sEntry>;
+
+
+	/** Protects all the members below. */
+	mutable cCriticalSection m_CS;
+
+	/** The memory budget, in bytes. */
+	size_t m_MaxBytes;
+
+	/** The memory used by all the entries, in bytes, as counted by GetEntrySize(). */
+	size_t m_NumBytes;
+
+	/** The entries, the most recently used first. */
+	cEntries m_Entries;
+
+	/** The entries indexed by their chunk, for the lookups. */
+	std::unordered_map<cChunkCoords, cEntries::iterator, cChunkCoordsHash> m_Index;
+
+	UInt64 m_NumHits;
+	UInt64 m_NumMisses;
+	UInt64 m_NumEvictions;
+
+
+	/** Returns the number of bytes of the budget that an entry with data of the specified size uses. */
+	static size_t GetEntrySize(size_t a_DataSize);
+
+	/** Removes the specified entry. Expects m_CS to be held. */
+	void RemoveEntry(cEntries::iterator a_Entry);
+
+	/** Evicts the least recently used entries until a_NumBytes more bytes fit into the budget. Expects m_CS to be held. */
+	void EvictToFit(size_t a_NumBytes);
+};
+
+
+
+
@@ -16,6 +16,16 @@
 	#define NBT_RESERVE_SIZE 200
 #endif  // NBT_RESERVE_SIZE
 
+/** Compound tags with at least this many children get a hash table for looking the children up by name. */
+static const size_t CHILD_INDEX_MIN_CHILDREN = 12;
+
+/** The maximum number of tags that a thread keeps allocated for reuse by the next parser.
+Storage grown larger by parsing an exceptionally large NBT is freed instead. */
+static const size_t MAX_SPARE_TAGS = 64 * 1024;
+
+/** The maximum capacity of the output buffer that a thread keeps for reuse by the next writer. */
+static const size_t MAX_SPARE_WRITER_OUTPUT = 4 MiB;
+
 #ifdef _MSC_VER
 	// Dodge a C4127 (conditional expression is constant) for this specific macro usage
 	#define PROPAGATE_ERROR(X) do { auto Err = (X); if (Err != eNBTParseError::npSuccess) return Err; } while ((false, false))
@@ -117,6 +127,30 @@ AString cNBTParseErrorCategory::message(int a_Condition) const
 	UNREACHABLE("Unsupported nbt parse error");
 }
 
+
+
+
+
+
+
+/** The storage kept by each thread after a parser or writer is destroyed, so that the next parser or writer can reuse it. */
+struct sSpareNBTStorage
+{
+	std::vector<std::vector<cFastNBTTag>> m_Tags;
+	std::vector<std::vector<int>> m_ChildIndices;
+	std::vector<ContiguousByteBuffer> m_WriterOutputs;
+};
+
+/** The maximum number of storage sets kept by a thread; more than one is only needed when parsing the lazy tags or nesting writers. */
+static const size_t MAX_SPARE_STORAGES = 2;
+
+/** Returns the current thread's spare tag storage. */
+sSpareNBTStorage & GetSpareStorage(void)
+{
+	thread_local sSpareNBTStorage Spare;
+	return Spare;
+}
+
 }  // namespace (anonymous)
 
 
@@ -149,8 +183,10 @@ std::error_code make_error_code(eNBTParseError a_Err) noexcept
 
 cParsedNBT::cParsedNBT(const ContiguousByteBufferView a_Data) :
 	m_Data(a_Data),
-	m_Pos(0)
+	m_Pos(0),
+	m_LazyTagNames(nullptr)
 {
+	AcquireStorage();
 	m_Error = Parse();
 }
 
@@ -158,6 +194,52 @@ cParsedNBT::cParsedNBT(const ContiguousByteBufferView a_Data) :
 
 
 
+cParsedNBT::cParsedNBT(const ContiguousByteBufferView a_Data, const cTagNames & a_LazyTagNames) :
+	m_Data(a_Data),
+	m_Pos(0),
+	m_LazyTagNames(&a_LazyTagNames)
+{
+	AcquireStorage();
+	m_Error = Parse();
+	m_LazyTagNames = nullptr;
+}
+
+
+
+
+
+cParsedNBT::cParsedNBT(const cParsedNBT & a_Parent, int a_LazyTag) :
+	m_Pos(0),
+	m_LazyTagNames(nullptr)
+{
+	ASSERT(a_Parent.IsLazy(a_LazyTag));
+	const auto & LazyTag = a_Parent.m_Tags[static_cast<size_t>(a_LazyTag)];
+
+	// Keep the positions in the parent's data, so that the name of the new root stays valid:
+	m_Data = a_Parent.m_Data.substr(0, LazyTag.m_DataStart + LazyTag.m_DataLength);
+	m_Pos = LazyTag.m_DataStart;
+
+	AcquireStorage();
+	m_Tags.emplace_back(LazyTag.m_Type, -1);
+	m_Tags.back().m_NameHash = LazyTag.m_NameHash;
+	m_Tags.back().m_NameStart = LazyTag.m_NameStart;
+	m_Tags.back().m_NameLength = LazyTag.m_NameLength;
+	m_Error = ReadTag();
+}
+
+
+
+
+
+cParsedNBT::~cParsedNBT()
+{
+	ReleaseStorage();
+}
+
+
+
+
+
 eNBTParseError cParsedNBT::Parse(void)
 {
 	if (m_Data.size() < 3)
@@ -178,6 +260,7 @@ eNBTParseError cParsedNBT::Parse(void)
 	m_Pos = 1;
 
 	PROPAGATE_ERROR(ReadString(m_Tags.back().m_NameStart, m_Tags.back().m_NameLength));
+	m_Tags.back().m_NameHash = HashName(m_Data.data() + m_Tags.back().m_NameStart, m_Tags.back().m_NameLength);
 	return ReadCompound();
 }
 
@@ -206,6 +289,7 @@ eNBTParseError cParsedNBT::ReadCompound(void)
 	// Reads the latest tag as a compound
 	size_t ParentIdx = m_Tags.size() - 1;
 	int PrevSibling = -1;
+	size_t NumChildren = 0;
 	for (;;)
 	{
 		NEEDBYTES(1, eNBTParseError::npCompoundImbalancedTag);
@@ -230,10 +314,25 @@ eNBTParseError cParsedNBT::ReadCompound(void)
 			m_Tags[ParentIdx].m_FirstChild = static_cast<int>(m_Tags.size()) - 1;
 		}
 		PrevSibling = static_cast<int>(m_Tags.size()) - 1;
+		NumChildren += 1;
 		PROPAGATE_ERROR(ReadString(m_Tags.back().m_NameStart, m_Tags.back().m_NameLength));
+		m_Tags.back().m_NameHash = HashName(m_Data.data() + m_Tags.back().m_NameStart, m_Tags.back().m_NameLength);
+		if (ShouldSkipLatestTag())
+		{
+			// Remember where the contents are, so that they can be parsed later:
+			const auto Start = m_Pos;
+			PROPAGATE_ERROR(SkipTagContents(TagType));
+			m_Tags.back().m_DataStart = Start;
+			m_Tags.back().m_DataLength = m_Pos - Start;
+			continue;
+		}
 		PROPAGATE_ERROR(ReadTag());
 	}  // while (true)
 	m_Tags[ParentIdx].m_LastChild = PrevSibling;
+	if (NumChildren >= CHILD_INDEX_MIN_CHILDREN)
+	{
+		BuildChildIndex(ParentIdx, NumChildren);
+	}
 	return eNBTParseError::npSuccess;
 }
 
@@ -372,13 +471,206 @@ eNBTParseError cParsedNBT::ReadTag(void)
 
 
 
+eNBTParseError cParsedNBT::SkipTagContents(eTagType a_Type)
+{
+	switch (a_Type)
+	{
+		case TAG_Byte:
+		case TAG_Short:
+		case TAG_Int:
+		case TAG_Long:
+		case TAG_Float:
+		case TAG_Double:
+		{
+			NEEDBYTES(GetMinTagSize(a_Type), eNBTParseError::npSimpleMissing);
+			m_Pos += GetMinTagSize(a_Type);
+			return eNBTParseError::npSuccess;
+		}
+
+		case TAG_String:
+		{
+			size_t Start, Length;
+			return ReadString(Start, Length);
+		}
+
+		case TAG_ByteArray:
+		case TAG_IntArray:
+		{
+			NEEDBYTES(4, eNBTParseError::npArrayMissingLength);
+			const auto Count = GetBEInt(m_Data.data() + m_Pos);
+			m_Pos += 4;
+			if (Count < 0)
+			{
+				return eNBTParseError::npArrayInvalidLength;
+			}
+			const auto Length = static_cast<size_t>(Count) * ((a_Type == TAG_IntArray) ? 4 : 1);
+			NEEDBYTES(Length, eNBTParseError::npArrayInvalidLength);
+			m_Pos += Length;
+			return eNBTParseError::npSuccess;
+		}
+
+		case TAG_List:
+		{
+			NEEDBYTES(1, eNBTParseError::npListMissingType);
+			const auto ItemTypeNum = m_Data[m_Pos];
+			if ((ItemTypeNum < std::byte(TAG_Min)) || (ItemTypeNum > std::byte(TAG_Max)))
+			{
+				return eNBTParseError::npUnknownTag;
+			}
+			const auto ItemType = static_cast<eTagType>(ItemTypeNum);
+			m_Pos++;
+			NEEDBYTES(4, eNBTParseError::npListMissingLength);
+			const auto Count = GetBEInt(m_Data.data() + m_Pos);
+			m_Pos += 4;
+			if ((Count < 0) || (Count > static_cast<int>((m_Data.size() - m_Pos) / GetMinTagSize(ItemType))))
+			{
+				return eNBTParseError::npListInvalidLength;
+			}
+			for (int i = 0; i < Count; i++)
+			{
+				PROPAGATE_ERROR(SkipTagContents(ItemType));
+			}
+			return eNBTParseError::npSuccess;
+		}
+
+		case TAG_Compound:
+		{
+			for (;;)
+			{
+				NEEDBYTES(1, eNBTParseError::npCompoundImbalancedTag);
+				const auto TagTypeNum = m_Data[m_Pos];
+				if ((TagTypeNum < std::byte(TAG_Min)) || (TagTypeNum > std::byte(TAG_Max)))
+				{
+					return eNBTParseError::npUnknownTag;
+				}
+				m_Pos++;
+				if (TagTypeNum == std::byte(TAG_End))
+				{
+					return eNBTParseError::npSuccess;
+				}
+				size_t NameStart, NameLength;
+				PROPAGATE_ERROR(ReadString(NameStart, NameLength));
+				PROPAGATE_ERROR(SkipTagContents(static_cast<eTagType>(TagTypeNum)));
+			}
+		}
+
+		case TAG_Min:
+		{
+			return eNBTParseError::npUnknownTag;
+		}
+	}
+	UNREACHABLE("Unsupported nbt tag type");
+}
+
+
+
+
+
+bool cParsedNBT::ShouldSkipLatestTag(void) const
+{
+	if (m_LazyTagNames == nullptr)
+	{
+		return false;
+	}
+	const auto & Tag = m_Tags.back();
+	if ((Tag.m_Type != TAG_List) && (Tag.m_Type != TAG_Compound))
+	{
+		// Nothing to gain by skipping a simple tag
+		return false;
+	}
+	const std::string_view Name(reinterpret_cast<const char *>(m_Data.data()) + Tag.m_NameStart, Tag.m_NameLength);
+	return std::find(m_LazyTagNames->begin(), m_LazyTagNames->end(), Name) != m_LazyTagNames->end();
+}
+
+
+
+
+
+void cParsedNBT::BuildChildIndex(size_t a_TagIdx, size_t a_NumChildren)
+{
+	// Keep the table at most half full, so that the probe sequences stay short:
+	size_t NumSlots = 1;
+	while (NumSlots < 2 * a_NumChildren)
+	{
+		NumSlots *= 2;
+	}
+	const auto Mask = static_cast<UInt32>(NumSlots - 1);
+	const auto Start = m_ChildIndex.size();
+	m_ChildIndex.push_back(static_cast<int>(Mask));
+	m_ChildIndex.resize(Start + 1 + NumSlots, -1);
+
+	for (int Child = m_Tags[a_TagIdx].m_FirstChild; Child != -1; Child = m_Tags[static_cast<size_t>(Child)].m_NextSibling)
+	{
+		const auto & ChildTag = m_Tags[static_cast<size_t>(Child)];
+		const auto ChildName = reinterpret_cast<const char *>(m_Data.data()) + ChildTag.m_NameStart;
+		for (auto Slot = ChildTag.m_NameHash & Mask;; Slot = (Slot + 1) & Mask)
+		{
+			auto & Entry = m_ChildIndex[Start + 1 + Slot];
+			if (Entry == -1)
+			{
+				Entry = Child;
+				break;
+			}
+			if (IsNamed(Entry, ChildTag.m_NameHash, ChildName, ChildTag.m_NameLength))
+			{
+				// A duplicate name, the lookups return the first child of the name
+				break;
+			}
+		}
+	}
+	m_Tags[a_TagIdx].m_ChildIndex = static_cast<int>(Start);
+}
+
+
+
+
+
+void cParsedNBT::AcquireStorage(void)
+{
+	auto & Spare = GetSpareStorage();
+	if (!Spare.m_Tags.empty())
+	{
+		m_Tags = std::move(Spare.m_Tags.back());
+		Spare.m_Tags.pop_back();
+	}
+	if (!Spare.m_ChildIndices.empty())
+	{
+		m_ChildIndex = std::move(Spare.m_ChildIndices.back());
+		Spare.m_ChildIndices.pop_back();
+	}
+}
+
+
+
+
+
+void cParsedNBT::ReleaseStorage(void)
+{
+	auto & Spare = GetSpareStorage();
+	if ((m_Tags.capacity() <= MAX_SPARE_TAGS) && (Spare.m_Tags.size() < MAX_SPARE_STORAGES))
+	{
+		m_Tags.clear();
+		Spare.m_Tags.push_back(std::move(m_Tags));
+	}
+	if ((m_ChildIndex.capacity() <= MAX_SPARE_TAGS) && (Spare.m_ChildIndices.size() < MAX_SPARE_STORAGES))
+	{
+		m_ChildIndex.clear();
+		Spare.m_ChildIndices.push_back(std::move(m_ChildIndex));
+	}
+}
+
+
+
+
+
 int cParsedNBT::FindChildByName(int a_Tag, const char * a_Name, size_t a_NameLength) const
 {
 	if (a_Tag < 0)
 	{
 		return -1;
 	}
-	if (m_Tags[static_cast<size_t>(a_Tag)].m_Type != TAG_Compound)
+	const auto & Tag = m_Tags[static_cast<size_t>(a_Tag)];
+	if (Tag.m_Type != TAG_Compound)
 	{
 		return -1;
 	}
@@ -387,12 +679,26 @@ int cParsedNBT::FindChildByName(int a_Tag, const char * a_Name, size_t a_NameLen
 	{
 		a_NameLength = strlen(a_Name);
 	}
-	for (int Child = m_Tags[static_cast<size_t>(a_Tag)].m_FirstChild; Child != -1; Child = m_Tags[static_cast<size_t>(Child)].m_NextSibling)
+	const auto NameHash = HashName(a_Name, a_NameLength);
+
+	// Use the hash table, if the tag has one:
+	if (Tag.m_ChildIndex >= 0)
 	{
-		if (
-			(m_Tags[static_cast<size_t>(Child)].m_NameLength == a_NameLength) &&
-			(memcmp(m_Data.data() + m_Tags[static_cast<size_t>(Child)].m_NameStart, a_Name, a_NameLength) == 0)
-		)
+		const auto Start = static_cast<size_t>(Tag.m_ChildIndex);
+		const auto Mask = static_cast<UInt32>(m_ChildIndex[Start]);
+		for (auto Slot = NameHash & Mask;; Slot = (Slot + 1) & Mask)
+		{
+			const auto Child = m_ChildIndex[Start + 1 + Slot];
+			if ((Child == -1) || IsNamed(Child, NameHash, a_Name, a_NameLength))
+			{
+				return Child;
+			}
+		}
+	}
+
+	for (int Child = Tag.m_FirstChild; Child != -1; Child = m_Tags[static_cast<size_t>(Child)].m_NextSibling)
+	{
+		if (IsNamed(Child, NameHash, a_Name, a_NameLength))
 		{
 			return Child;
 		}
@@ -462,14 +768,40 @@ size_t cParsedNBT::GetMinTagSize(eTagType a_TagType)
 
 
 
+UInt32 cParsedNBT::HashName(const void * a_Name, size_t a_NameLength)
+{
+	// FNV-1a, the names are short:
+	auto Name = static_cast<const unsigned char *>(a_Name);
+	UInt32 Hash = 2166136261u;
+	for (size_t i = 0; i < a_NameLength; i++)
+	{
+		Hash = (Hash ^ Name[i]) * 16777619u;
+	}
+	return Hash;
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cFastNBTWriter:
 
-cFastNBTWriter::cFastNBTWriter(const AString & a_RootTagName) :
+cFastNBTWriter::cFastNBTWriter(const std::string_view a_RootTagName) :
 	m_CurrentStack(0)
 {
+	auto & Spare = GetSpareStorage().m_WriterOutputs;
+	if (!Spare.empty())
+	{
+		m_Result = std::move(Spare.back());
+		Spare.pop_back();
+	}
+	else
+	{
+		m_Result.reserve(100 KiB);
+	}
+
 	m_Stack[0].m_Type = TAG_Compound;
-	m_Result.reserve(100 KiB);
 	m_Result.push_back(std::byte(TAG_Compound));
 	WriteString(a_RootTagName);
 }
@@ -478,7 +810,22 @@ cFastNBTWriter::cFastNBTWriter(const AString & a_RootTagName) :
 
 
 
-void cFastNBTWriter::BeginCompound(const AString & a_Name)
+cFastNBTWriter::~cFastNBTWriter()
+{
+	// Leave the output buffer for the next writer on this thread:
+	auto & Spare = GetSpareStorage().m_WriterOutputs;
+	if ((Spare.size() < MAX_SPARE_STORAGES) && (m_Result.capacity() <= MAX_SPARE_WRITER_OUTPUT))
+	{
+		m_Result.clear();
+		Spare.push_back(std::move(m_Result));
+	}
+}
+
+
+
+
+
+void cFastNBTWriter::BeginCompound(const std::string_view a_Name)
 {
 	if (m_CurrentStack >= MAX_STACK - 1)
 	{
@@ -509,7 +856,7 @@ void cFastNBTWriter::EndCompound(void)
 
 
 
-void cFastNBTWriter::BeginList(const AString & a_Name, eTagType a_ChildrenType)
+void cFastNBTWriter::BeginList(const std::string_view a_Name, eTagType a_ChildrenType)
 {
 	if (m_CurrentStack >= MAX_STACK - 1)
 	{
@@ -548,7 +895,7 @@ void cFastNBTWriter::EndList(void)
 
 
 
-void cFastNBTWriter::AddByte(const AString & a_Name, unsigned char a_Value)
+void cFastNBTWriter::AddByte(const std::string_view a_Name, unsigned char a_Value)
 {
 	TagCommon(a_Name, TAG_Byte);
 	m_Result.push_back(std::byte(a_Value));
@@ -558,7 +905,7 @@ void cFastNBTWriter::AddByte(const AString & a_Name, unsigned char a_Value)
 
 
 
-void cFastNBTWriter::AddShort(const AString & a_Name, Int16 a_Value)
+void cFastNBTWriter::AddShort(const std::string_view a_Name, Int16 a_Value)
 {
 	TagCommon(a_Name, TAG_Short);
 	UInt16 Value = htons(static_cast<UInt16>(a_Value));
@@ -569,7 +916,7 @@ void cFastNBTWriter::AddShort(const AString & a_Name, Int16 a_Value)
 
 
 
-void cFastNBTWriter::AddInt(const AString & a_Name, Int32 a_Value)
+void cFastNBTWriter::AddInt(const std::string_view a_Name, Int32 a_Value)
 {
 	TagCommon(a_Name, TAG_Int);
 	UInt32 Value = htonl(static_cast<UInt32>(a_Value));
@@ -580,7 +927,7 @@ void cFastNBTWriter::AddInt(const AString & a_Name, Int32 a_Value)
 
 
 
-void cFastNBTWriter::AddLong(const AString & a_Name, Int64 a_Value)
+void cFastNBTWriter::AddLong(const std::string_view a_Name, Int64 a_Value)
 {
 	TagCommon(a_Name, TAG_Long);
 	UInt64 Value = HostToNetwork8(&a_Value);
@@ -591,7 +938,7 @@ void cFastNBTWriter::AddLong(const AString & a_Name, Int64 a_Value)
 
 
 
-void cFastNBTWriter::AddFloat(const AString & a_Name, float a_Value)
+void cFastNBTWriter::AddFloat(const std::string_view a_Name, float a_Value)
 {
 	TagCommon(a_Name, TAG_Float);
 	UInt32 Value = HostToNetwork4(&a_Value);
@@ -602,7 +949,7 @@ void cFastNBTWriter::AddFloat(const AString & a_Name, float a_Value)
 
 
 
-void cFastNBTWriter::AddDouble(const AString & a_Name, double a_Value)
+void cFastNBTWriter::AddDouble(const std::string_view a_Name, double a_Value)
 {
 	TagCommon(a_Name, TAG_Double);
 	UInt64 Value = HostToNetwork8(&a_Value);
@@ -613,7 +960,7 @@ void cFastNBTWriter::AddDouble(const AString & a_Name, double a_Value)
 
 
 
-void cFastNBTWriter::AddString(const AString & a_Name, const std::string_view a_Value)
+void cFastNBTWriter::AddString(const std::string_view a_Name, const std::string_view a_Value)
 {
 	TagCommon(a_Name, TAG_String);
 	const UInt16 Length = htons(static_cast<UInt16>(a_Value.size()));
@@ -625,7 +972,7 @@ void cFastNBTWriter::AddString(const AString & a_Name, const std::string_view a_
 
 
 
-void cFastNBTWriter::AddByteArray(const AString & a_Name, const char * a_Value, size_t a_NumElements)
+void cFastNBTWriter::AddByteArray(const std::string_view a_Name, const char * a_Value, size_t a_NumElements)
 {
 	TagCommon(a_Name, TAG_ByteArray);
 	UInt32 len = htonl(static_cast<UInt32>(a_NumElements));
@@ -637,7 +984,7 @@ void cFastNBTWriter::AddByteArray(const AString & a_Name, const char * a_Value,
 
 
 
-void cFastNBTWriter::AddByteArray(const AString & a_Name, size_t a_NumElements, unsigned char a_Value)
+void cFastNBTWriter::AddByteArray(const std::string_view a_Name, size_t a_NumElements, unsigned char a_Value)
 {
 	TagCommon(a_Name, TAG_ByteArray);
 	UInt32 len = htonl(static_cast<UInt32>(a_NumElements));
@@ -649,7 +996,7 @@ void cFastNBTWriter::AddByteArray(const AString & a_Name, size_t a_NumElements,
 
 
 
-void cFastNBTWriter::AddIntArray(const AString & a_Name, const Int32 * a_Value, size_t a_NumElements)
+void cFastNBTWriter::AddIntArray(const std::string_view a_Name, const Int32 * a_Value, size_t a_NumElements)
 {
 	TagCommon(a_Name, TAG_IntArray);
 	UInt32 len = htonl(static_cast<UInt32>(a_NumElements));
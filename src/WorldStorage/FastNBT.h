@@ -7,10 +7,20 @@
 The fast parser parses the data into a vector of cFastNBTTag structures. These structures describe the NBT tree,
 but themselves are allocated in a vector, thus minimizing reallocation.
 The structures have a minimal constructor, setting all member "pointers" to "invalid".
+The vectors are reused: when a parser is destroyed, its storage is kept by the thread for the next parser, so that parsing
+one chunk after another on the storage thread doesn't allocate the tag storage anew for each chunk.
+
+Compound tags with many children get a hash table of their children while parsing, so that FindChildByName()
+doesn't need to compare the names of all the preceding siblings.
+
+The parser can be given a list of tag names that the caller is not interested in. List and Compound tags of those names
+are skipped in a single pass without creating any tags for their contents; such a "lazy" tag can still be parsed later,
+by constructing another cParsedNBT for it.
 
 The fast writer doesn't need a NBT tree structure built beforehand, it is commanded to open, append and close tags
 (just like XML); it keeps the internal tag stack and reports errors in usage.
-It directly outputs a string containing the serialized NBT data.
+It directly outputs a string containing the serialized NBT data. The output buffer is reused the same way as the parser's tag storage,
+so a writer starts with the capacity that the previous writer on the same thread has grown to.
 */
 
 
@@ -60,6 +70,9 @@ public:
 
 	eTagType m_Type;
 
+	/** Hash of the tag's name, used for speeding up the lookups by name. */
+	UInt32 m_NameHash;
+
 	// The following members are indices into the data stream. m_DataLength == 0 if no data available
 	// They must not be pointers, because the datastream may be copied into another AString object in the meantime.
 	size_t m_NameStart;
@@ -75,8 +88,12 @@ public:
 	int m_FirstChild;
 	int m_LastChild;
 
+	/** For Compound tags with many children, the index into cParsedNBT::m_ChildIndex where the hash table of the children starts; -1 if none. */
+	int m_ChildIndex;
+
 	cFastNBTTag(eTagType a_Type, int a_Parent) :
 		m_Type(a_Type),
+		m_NameHash(0),
 		m_NameStart(0),
 		m_NameLength(0),
 		m_DataStart(0),
@@ -85,12 +102,14 @@ public:
 		m_PrevSibling(-1),
 		m_NextSibling(-1),
 		m_FirstChild(-1),
-		m_LastChild(-1)
+		m_LastChild(-1),
+		m_ChildIndex(-1)
 	{
 	}
 
 	cFastNBTTag(eTagType a_Type, int a_Parent, int a_PrevSibling) :
 		m_Type(a_Type),
+		m_NameHash(0),
 		m_NameStart(0),
 		m_NameLength(0),
 		m_DataStart(0),
@@ -99,7 +118,8 @@ public:
 		m_PrevSibling(a_PrevSibling),
 		m_NextSibling(-1),
 		m_FirstChild(-1),
-		m_LastChild(-1)
+		m_LastChild(-1),
+		m_ChildIndex(-1)
 	{
 	}
 } ;
@@ -152,8 +172,26 @@ Each primitive tag also stores the length of the contained data, in bytes.
 class cParsedNBT
 {
 public:
+
+	/** Names of the tags whose contents should not be parsed. */
+	using cTagNames = std::vector<std::string_view>;
+
+
 	cParsedNBT(ContiguousByteBufferView a_Data);
 
+	/** Parses the data, skipping the contents of all the List and Compound tags (at any depth) whose name is in a_LazyTagNames.
+	The skipped tags are present in the tree, but have no children; see IsLazy(). */
+	cParsedNBT(ContiguousByteBufferView a_Data, const cTagNames & a_LazyTagNames);
+
+	/** Parses the contents of a tag that a_Parent has skipped (see IsLazy()); the tag becomes the root of the tree.
+	The tag indices are not compatible with a_Parent's. a_Parent's data must stay valid throughout this object's life. */
+	cParsedNBT(const cParsedNBT & a_Parent, int a_LazyTag);
+
+	cParsedNBT(const cParsedNBT &) = delete;
+	cParsedNBT & operator = (const cParsedNBT &) = delete;
+
+	~cParsedNBT();
+
 	bool IsValid(void) const { return (m_Error == eNBTParseError::npSuccess); }
 
 	/** Returns the error code for the parsing of the NBT data. */
@@ -177,6 +215,14 @@ public:
 	/** Returns the previous sibling of the specified tag, or -1 if none. */
 	int GetPrevSibling(int a_Tag) const { return m_Tags[static_cast<size_t>(a_Tag)].m_PrevSibling; }
 
+	/** Returns true if the tag is a List or Compound whose contents were skipped while parsing.
+	The tag has no children; to access them, parse the tag by constructing another cParsedNBT for it. */
+	bool IsLazy(int a_Tag) const
+	{
+		const auto & Tag = m_Tags[static_cast<size_t>(a_Tag)];
+		return ((Tag.m_Type == TAG_List) || (Tag.m_Type == TAG_Compound)) && (Tag.m_DataLength > 0);
+	}
+
 	/** Returns the length of the tag's data, in bytes.
 	Not valid for Compound or List tags! */
 	size_t GetDataLength(int a_Tag) const
@@ -201,7 +247,8 @@ public:
 		return FindChildByName(a_Tag, a_Name.c_str(), a_Name.length());
 	}
 
-	/** Returns the direct child tag of the specified name, or -1 if no such tag. */
+	/** Returns the direct child tag of the specified name, or -1 if no such tag.
+	If there are multiple children of the same name, returns the first one. */
 	int FindChildByName(int a_Tag, const char * a_Name, size_t a_NameLength = 0) const;
 
 	/** Returns the child tag of the specified path (Name1 / Name2 / Name3...), or -1 if no such tag. */
@@ -303,18 +350,54 @@ protected:
 	std::vector<cFastNBTTag> m_Tags;
 	eNBTParseError           m_Error;  // npSuccess if parsing succeeded
 
+	/** The hash tables of the children of the compound tags that have many children, see cFastNBTTag::m_ChildIndex.
+	Each table starts with its size mask, followed by the slots containing the child tag indices, -1 for empty slots. */
+	std::vector<int> m_ChildIndex;
+
 	// Used while parsing:
 	size_t m_Pos;
 
+	/** The names of the tags not to parse, nullptr if all tags are parsed. */
+	const cTagNames * m_LazyTagNames;
+
 	eNBTParseError Parse(void);
 	eNBTParseError ReadString(size_t & a_StringStart, size_t & a_StringLen);  // Reads a simple string (2 bytes length + data), sets the string descriptors
 	eNBTParseError ReadCompound(void);  // Reads the latest tag as a compound
 	eNBTParseError ReadList(eTagType a_ChildrenType);  // Reads the latest tag as a list of items of type a_ChildrenType
 	eNBTParseError ReadTag(void);       // Reads the latest tag, depending on its m_Type setting
 
+	/** Skips the contents of a tag of the specified type, without creating any tags. */
+	eNBTParseError SkipTagContents(eTagType a_Type);
+
+	/** Returns true if the latest tag should be skipped instead of parsed. */
+	bool ShouldSkipLatestTag(void) const;
+
+	/** Returns true if the tag's name is the one specified, a_NameHash being the name's hash. */
+	bool IsNamed(int a_Tag, UInt32 a_NameHash, const char * a_Name, size_t a_NameLength) const
+	{
+		const auto & Tag = m_Tags[static_cast<size_t>(a_Tag)];
+		return (
+			(Tag.m_NameHash == a_NameHash) &&
+			(Tag.m_NameLength == a_NameLength) &&
+			(memcmp(m_Data.data() + Tag.m_NameStart, a_Name, a_NameLength) == 0)
+		);
+	}
+
+	/** Builds the hash table of the children of the specified compound tag. */
+	void BuildChildIndex(size_t a_TagIdx, size_t a_NumChildren);
+
+	/** Takes the tag storage left over by the previous parser on this thread, if any. */
+	void AcquireStorage(void);
+
+	/** Returns the tag storage so that the next parser on this thread can reuse it. */
+	void ReleaseStorage(void);
+
 	/** Returns the minimum size, in bytes, of the specified tag type.
 	Used for sanity-checking. */
 	static size_t GetMinTagSize(eTagType a_TagType);
+
+	/** Returns the hash of the specified tag name. */
+	static UInt32 HashName(const void * a_Name, size_t a_NameLength);
 } ;
 
 
@@ -324,30 +407,42 @@ protected:
 class cFastNBTWriter
 {
 public:
-	cFastNBTWriter(const AString & a_RootTagName = "");
+	cFastNBTWriter(std::string_view a_RootTagName = "");
+
+	cFastNBTWriter(const cFastNBTWriter &) = delete;
+	cFastNBTWriter & operator = (const cFastNBTWriter &) = delete;
+
+	~cFastNBTWriter();
 
-	void BeginCompound(const AString & a_Name);
+	void BeginCompound(std::string_view a_Name);
 	void EndCompound(void);
 
-	void BeginList(const AString & a_Name, eTagType a_ChildrenType);
+	void BeginList(std::string_view a_Name, eTagType a_ChildrenType);
 	void EndList(void);
 
-	void AddByte     (const AString & a_Name, unsigned char a_Value);
-	void AddShort    (const AString & a_Name, Int16 a_Value);
-	void AddInt      (const AString & a_Name, Int32 a_Value);
-	void AddLong     (const AString & a_Name, Int64 a_Value);
-	void AddFloat    (const AString & a_Name, float a_Value);
-	void AddDouble   (const AString & a_Name, double a_Value);
-	void AddString   (const AString & a_Name, std::string_view a_Value);
-	void AddByteArray(const AString & a_Name, const char * a_Value, size_t a_NumElements);
-	void AddByteArray(const AString & a_Name, size_t a_NumElements, unsigned char a_Value);
-	void AddIntArray (const AString & a_Name, const Int32 * a_Value, size_t a_NumElements);
-
-	void AddByteArray(const AString & a_Name, const AString & a_Value)
+	void AddByte     (std::string_view a_Name, unsigned char a_Value);
+	void AddShort    (std::string_view a_Name, Int16 a_Value);
+	void AddInt      (std::string_view a_Name, Int32 a_Value);
+	void AddLong     (std::string_view a_Name, Int64 a_Value);
+	void AddFloat    (std::string_view a_Name, float a_Value);
+	void AddDouble   (std::string_view a_Name, double a_Value);
+	void AddString   (std::string_view a_Name, std::string_view a_Value);
+	void AddByteArray(std::string_view a_Name, const char * a_Value, size_t a_NumElements);
+	void AddByteArray(std::string_view a_Name, size_t a_NumElements, unsigned char a_Value);
+	void AddIntArray (std::string_view a_Name, const Int32 * a_Value, size_t a_NumElements);
+
+	void AddByteArray(std::string_view a_Name, const AString & a_Value)
 	{
 		AddByteArray(a_Name, a_Value.data(), a_Value.size());
 	}
 
+	/** Makes space for at least a_NumBytes more bytes of output, so that writing them doesn't reallocate the output. */
+	void Reserve(size_t a_NumBytes)
+	{
+		m_Result.reserve(m_Result.size() + a_NumBytes);
+	}
+
+	/** Returns the output written so far. The view is valid until the writer is destroyed. */
 	ContiguousByteBufferView GetResult(void) const { return m_Result; }
 
 	void Finish(void);
@@ -368,13 +463,14 @@ protected:
 	sParent m_Stack[MAX_STACK];
 	int     m_CurrentStack;
 
+	/** The output. Taken over from the previous writer on this thread, if any, so that its capacity is reused. */
 	ContiguousByteBuffer m_Result;
 
 	bool IsStackTopCompound(void) const { return (m_Stack[m_CurrentStack].m_Type == TAG_Compound); }
 
 	void WriteString(std::string_view a_Data);
 
-	inline void TagCommon(const AString & a_Name, eTagType a_Type)
+	inline void TagCommon(std::string_view a_Name, eTagType a_Type)
 	{
 		// If we're directly inside a list, check that the list is of the correct type:
 		ASSERT((m_Stack[m_CurrentStack].m_Type != TAG_List) || (m_Stack[m_CurrentStack].m_ItemType == a_Type));
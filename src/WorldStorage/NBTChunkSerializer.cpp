@@ -53,9 +53,18 @@
 
 
 
+/** The upper estimate of a single section's size in the NBT, in bytes: the four byte arrays with their type, name and length, the Y tag and the compound's end. */
+static const size_t SECTION_NBT_SIZE =
+	ChunkBlockData::SectionBlockCount + ChunkBlockData::SectionMetaCount + 2 * ChunkLightData::SectionLightCount +
+	4 * (1 + 2 + 10 + 4) + (1 + 2 + 1 + 1) + 1;
+
+
+
+
+
 /** Collects and stores the chunk data via the cChunkDataCallback interface */
 class SerializerCollector final :
-	public cChunkDataCopyCollector
+	public cChunkDataCallback
 {
 public:
 
@@ -104,6 +113,68 @@ public:
 
 
 
+	virtual void ChunkData(const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData) override
+	{
+		// Write the sections straight from the chunk's storage; this is called before any entities, so no list is open yet:
+		ASSERT(!mIsTagOpen);
+		size_t NumSections = 0;
+		ChunkDef_ForEachSection(a_BlockData, a_LightData,
+		{
+			NumSections += 1;
+		});
+		mWriter.Reserve(NumSections * SECTION_NBT_SIZE);
+
+		mWriter.BeginList("Sections", TAG_Compound);
+		ChunkDef_ForEachSection(a_BlockData, a_LightData,
+		{
+			mWriter.BeginCompound("");
+
+			if (Blocks != nullptr)
+			{
+				mWriter.AddByteArray("Blocks", reinterpret_cast<const char *>(Blocks->data()), Blocks->size());
+			}
+			else
+			{
+				mWriter.AddByteArray("Blocks", ChunkBlockData::SectionBlockCount, ChunkBlockData::DefaultValue);
+			}
+
+			if (Metas != nullptr)
+			{
+				mWriter.AddByteArray("Data", reinterpret_cast<const char *>(Metas->data()), Metas->size());
+			}
+			else
+			{
+				mWriter.AddByteArray("Data", ChunkBlockData::SectionMetaCount, ChunkBlockData::DefaultMetaValue);
+			}
+
+			if (BlockLights != nullptr)
+			{
+				mWriter.AddByteArray("BlockLight", reinterpret_cast<const char *>(BlockLights->data()), BlockLights->size());
+			}
+			else
+			{
+				mWriter.AddByteArray("BlockLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultBlockLightValue);
+			}
+
+			if (SkyLights != nullptr)
+			{
+				mWriter.AddByteArray("SkyLight", reinterpret_cast<const char *>(SkyLights->data()), SkyLights->size());
+			}
+			else
+			{
+				mWriter.AddByteArray("SkyLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue);
+			}
+
+			mWriter.AddByte("Y", static_cast<unsigned char>(Y));
+			mWriter.EndCompound();
+		});
+		mWriter.EndList();  // "Sections"
+	}
+
+
+
+
+
 	virtual void HeightMap(const cChunkDef::HeightMap & a_HeightMap) override
 	{
 		for (int RelZ = 0; RelZ < cChunkDef::Width; RelZ++)
@@ -1200,53 +1271,6 @@ void NBTChunkSerializer::Serialize(const cWorld & aWorld, cChunkCoords aCoords,
 	// Save heightmap (Vanilla require this):
 	aWriter.AddIntArray("HeightMap", reinterpret_cast<const int *>(serializer.Heights), ARRAYCOUNT(serializer.Heights));
 
-	// Save blockdata:
-	aWriter.BeginList("Sections", TAG_Compound);
-	ChunkDef_ForEachSection(serializer.m_BlockData, serializer.m_LightData,
-	{
-		aWriter.BeginCompound("");
-
-		if (Blocks != nullptr)
-		{
-			aWriter.AddByteArray("Blocks", reinterpret_cast<const char *>(Blocks->data()), Blocks->size());
-		}
-		else
-		{
-			aWriter.AddByteArray("Blocks", ChunkBlockData::SectionBlockCount, ChunkBlockData::DefaultValue);
-		}
-
-		if (Metas != nullptr)
-		{
-			aWriter.AddByteArray("Data", reinterpret_cast<const char *>(Metas->data()), Metas->size());
-		}
-		else
-		{
-			aWriter.AddByteArray("Data", ChunkBlockData::SectionMetaCount, ChunkBlockData::DefaultMetaValue);
-		}
-
-		if (BlockLights != nullptr)
-		{
-			aWriter.AddByteArray("BlockLight", reinterpret_cast<const char *>(BlockLights->data()), BlockLights->size());
-		}
-		else
-		{
-			aWriter.AddByteArray("BlockLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultBlockLightValue);
-		}
-
-		if (SkyLights != nullptr)
-		{
-			aWriter.AddByteArray("SkyLight", reinterpret_cast<const char *>(SkyLights->data()), SkyLights->size());
-		}
-		else
-		{
-			aWriter.AddByteArray("SkyLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue);
-		}
-
-		aWriter.AddByte("Y", static_cast<unsigned char>(Y));
-		aWriter.EndCompound();
-	});
-	aWriter.EndList();  // "Sections"
-
 	// Store the information that the lighting is valid.
 	// For compatibility reason, the default is "invalid" (missing) - this means older data is re-lighted upon loading.
 	if (serializer.mIsLightValid)
@@ -0,0 +1,344 @@
+
+// PlayerDataStorage.cpp
+
+// Implements the cPlayerDataStorage class representing the thread that reads and writes the player data files
+
+#include "Globals.h"
+#include "PlayerDataStorage.h"
+#include "../JsonUtils.h"
+
+#include <json/json.h>
+
+
+
+
+
+/** Prefetched files that haven't been loaded for this long are dropped (the player has probably disconnected during the login). */
+static const auto PREFETCH_EXPIRATION = std::chrono::seconds(60);
+
+
+
+
+
+cPlayerDataStorage::cPlayerDataStorage(void):
+	Super("Player Data Storage"),
+	m_IsRunning(false)
+{
+}
+
+
+
+
+
+cPlayerDataStorage::~cPlayerDataStorage()
+{
+	Stop();
+}
+
+
+
+
+
+void cPlayerDataStorage::Start(void)
+{
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_IsRunning = true;
+	}
+	Super::Start();
+}
+
+
+
+
+
+void cPlayerDataStorage::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_evtQueued.Set();
+	Super::Stop();
+}
+
+
+
+
+
+void cPlayerDataStorage::Save(const AString & a_FileName, Json::Value && a_Data)
+{
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		if (m_IsRunning)
+		{
+			QueueFile(a_FileName);
+			m_PendingWrites[a_FileName] = std::make_unique<Json::Value>(std::move(a_Data));
+
+			// The prefetched contents are outdated now:
+			m_ReadResults.erase(a_FileName);
+			return;
+		}
+	}
+
+	WriteFile(a_FileName, a_Data);
+}
+
+
+
+
+
+void cPlayerDataStorage::Prefetch(const AString & a_FileName)
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	PurgeStaleReadResults();
+	if (!m_IsRunning || (m_PendingReads.count(a_FileName) > 0) || (m_ReadResults.count(a_FileName) > 0))
+	{
+		return;
+	}
+	QueueFile(a_FileName);
+	m_PendingReads.insert(a_FileName);
+}
+
+
+
+
+
+bool cPlayerDataStorage::IsReadyToLoad(const AString & a_FileName)
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	if (m_PendingWrites.count(a_FileName) > 0)
+	{
+		// Will be loaded from the queued data
+		return true;
+	}
+	return (m_PendingReads.count(a_FileName) == 0) && (m_BusyFileName != a_FileName);
+}
+
+
+
+
+
+bool cPlayerDataStorage::Load(const AString & a_FileName, AString & a_Contents)
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+
+	// If the file is being read or written right now, wait for it:
+	m_FileProcessed.wait(Lock, [this, &a_FileName]() { return (m_BusyFileName != a_FileName); });
+
+	// The data queued for writing is the newest there is:
+	if (const auto itr = m_PendingWrites.find(a_FileName); itr != m_PendingWrites.end())
+	{
+		Json::Value Data(*itr->second);
+		Lock.unlock();
+		a_Contents = JsonUtils::WriteStyledString(Data);
+		return true;
+	}
+
+	// Use the prefetched contents, if available:
+	if (const auto itr = m_ReadResults.find(a_FileName); itr != m_ReadResults.end())
+	{
+		auto Result = std::move(itr->second);
+		m_ReadResults.erase(itr);
+		Lock.unlock();
+		return ExtractReadResult(a_FileName, std::move(Result), a_Contents);
+	}
+
+	// The storage thread hasn't got to the file yet, don't wait for the files queued before it and read it right away:
+	m_PendingReads.erase(a_FileName);
+	Lock.unlock();
+	return ExtractReadResult(a_FileName, ReadFile(a_FileName), a_Contents);
+}
+
+
+
+
+
+size_t cPlayerDataStorage::GetQueueLength(void)
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	return m_Queue.size();
+}
+
+
+
+
+
+void cPlayerDataStorage::Execute(void)
+{
+	for (;;)
+	{
+		AString FileName;
+		std::unique_ptr<Json::Value> Data;
+		bool ShouldRead;
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			if (m_Queue.empty())
+			{
+				if (m_ShouldTerminate)
+				{
+					// Everything has been written; from now on, the callers do their own I/O:
+					m_IsRunning = false;
+					return;
+				}
+				Lock.unlock();
+				m_evtQueued.Wait();
+				continue;
+			}
+
+			FileName = std::move(m_Queue.front());
+			m_Queue.pop_front();
+			if (const auto itr = m_PendingWrites.find(FileName); itr != m_PendingWrites.end())
+			{
+				Data = std::move(itr->second);
+				m_PendingWrites.erase(itr);
+			}
+			ShouldRead = (m_PendingReads.erase(FileName) > 0);
+			m_BusyFileName = FileName;
+		}
+
+		// Write the data, if any. A prefetch of the same file then gets the data just written:
+		sReadResult Result;
+		if (Data != nullptr)
+		{
+			Result.m_Contents = WriteFile(FileName, *Data);
+			Result.m_Exists = true;
+			Result.m_HasFailed = false;
+			Result.m_ReadTime = std::chrono::steady_clock::now();
+		}
+		else if (ShouldRead)
+		{
+			Result = ReadFile(FileName);
+		}
+
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			if (ShouldRead)
+			{
+				m_ReadResults[FileName] = std::move(Result);
+			}
+			m_BusyFileName.clear();
+		}
+		m_FileProcessed.notify_all();
+	}
+}
+
+
+
+
+
+void cPlayerDataStorage::QueueFile(const AString & a_FileName)
+{
+	if ((m_PendingWrites.count(a_FileName) > 0) || (m_PendingReads.count(a_FileName) > 0))
+	{
+		// Already queued
+		return;
+	}
+	m_Queue.push_back(a_FileName);
+	m_evtQueued.Set();
+}
+
+
+
+
+
+void cPlayerDataStorage::PurgeStaleReadResults(void)
+{
+	const auto Now = std::chrono::steady_clock::now();
+	for (auto itr = m_ReadResults.begin(); itr != m_ReadResults.end();)
+	{
+		if (Now - itr->second.m_ReadTime > PREFETCH_EXPIRATION)
+		{
+			itr = m_ReadResults.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+
+
+
+
+AString cPlayerDataStorage::WriteFile(const AString & a_FileName, const Json::Value & a_Data)
+{
+	auto Contents = JsonUtils::WriteStyledString(a_Data);
+
+	// Make sure the folder exists:
+	const auto LastSeparator = a_FileName.find_last_of("/\\");
+	if (LastSeparator != AString::npos)
+	{
+		cFile::CreateFolderRecursive(a_FileName.substr(0, LastSeparator));
+	}
+
+	// Write into a temporary file first, so that the old file stays intact if the write fails midway:
+	const auto TempFileName = a_FileName + ".tmp";
+	{
+		cFile File;
+		if (!File.Open(TempFileName, cFile::fmWrite))
+		{
+			LOGWARNING("Error writing player data to file \"%s\": cannot open file. Player will lose their progress", TempFileName.c_str());
+			return Contents;
+		}
+		if (File.Write(Contents.data(), Contents.size()) != static_cast<int>(Contents.size()))
+		{
+			LOGWARNING("Error writing player data to file \"%s\": cannot save data. Player will lose their progress", TempFileName.c_str());
+			return Contents;
+		}
+	}
+
+	// Replace the old file; some platforms refuse to rename over an existing file, remove it first there:
+	if (!cFile::Rename(TempFileName, a_FileName))
+	{
+		cFile::DeleteFile(a_FileName);
+		if (!cFile::Rename(TempFileName, a_FileName))
+		{
+			LOGWARNING("Error writing player data to file \"%s\": cannot rename the temporary file \"%s\"", a_FileName.c_str(), TempFileName.c_str());
+		}
+	}
+	return Contents;
+}
+
+
+
+
+
+cPlayerDataStorage::sReadResult cPlayerDataStorage::ReadFile(const AString & a_FileName)
+{
+	sReadResult Result;
+	Result.m_Exists = cFile::IsFile(a_FileName);
+	Result.m_HasFailed = false;
+	Result.m_ReadTime = std::chrono::steady_clock::now();
+	if (!Result.m_Exists)
+	{
+		return Result;
+	}
+
+	cFile File;
+	if (!File.Open(a_FileName, cFile::fmRead) || (File.ReadRestOfFile(Result.m_Contents) < 0))
+	{
+		Result.m_HasFailed = true;
+	}
+	return Result;
+}
+
+
+
+
+
+bool cPlayerDataStorage::ExtractReadResult(const AString & a_FileName, sReadResult && a_Result, AString & a_Contents)
+{
+	if (a_Result.m_HasFailed)
+	{
+		throw std::runtime_error(fmt::format("Cannot read the player data file \"{}\".", a_FileName));
+	}
+	if (!a_Result.m_Exists)
+	{
+		return false;
+	}
+	a_Contents = std::move(a_Result.m_Contents);
+	return true;
+}
+
+
+
+
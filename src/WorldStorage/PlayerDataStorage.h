@@ -0,0 +1,143 @@
+
+// PlayerDataStorage.h
+
+// Declares the cPlayerDataStorage class representing the thread that reads and writes the player data files
+
+/*
+The player data (the player's file in the "players" folder and their statistics file) used to be written on the calling thread,
+which is the tick thread on disconnect, world change and autosave. Now the tick thread only snapshots the data into a Json::Value
+and queues it here; the storage thread serializes it and writes it into a temporary file, which is then renamed over the real file,
+so that a crash in the middle of writing doesn't leave a truncated file behind.
+Repeated saves of the same file that are still waiting in the queue are coalesced, only the latest data is written.
+
+The files can also be prefetched: cClientHandle asks for the player's files as soon as the player's UUID is known
+and only creates the cPlayer object (which loads them) once they have been read.
+Loading always sees the latest data, even if it is still waiting in the queue to be written.
+
+When the thread is not running (before the server starts and after it stops), all operations are done on the calling thread.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/IsThread.h"
+
+// fwd:
+namespace Json
+{
+	class Value;
+}
+
+
+
+
+
+class cPlayerDataStorage:
+	public cIsThread
+{
+	using Super = cIsThread;
+
+public:
+
+	cPlayerDataStorage(void);
+	virtual ~cPlayerDataStorage() override;
+
+	/** Starts the storage thread. The thread may be started and stopped repeatedly. */
+	void Start(void);
+
+	/** Writes all the queued data and stops the storage thread. The thread may be started and stopped repeatedly. */
+	void Stop(void);
+
+	/** Queues the data to be written into the specified file, replacing any data queued for the same file that hasn't been written yet.
+	The folder of the file is created if it doesn't exist. */
+	void Save(const AString & a_FileName, Json::Value && a_Data);
+
+	/** Queues the specified file to be read in the background, so that a later Load() of the same file doesn't need to wait for the disk.
+	The prefetched contents are dropped if nobody loads them for a while. */
+	void Prefetch(const AString & a_FileName);
+
+	/** Returns true if the file doesn't need any more disk access before it can be loaded:
+	it has been prefetched, or it has data queued to be written. */
+	bool IsReadyToLoad(const AString & a_FileName);
+
+	/** Returns the current contents of the specified file, including the data queued for it that hasn't been written yet.
+	Uses the prefetched contents if available, waits for the file to be written if it is being written, otherwise reads it.
+	Returns false if the file doesn't exist; throws a std::runtime_error if it exists but cannot be read. */
+	bool Load(const AString & a_FileName, AString & a_Contents);
+
+	/** Returns the number of files queued for reading or writing. */
+	size_t GetQueueLength(void);
+
+protected:
+
+	/** The result of reading a single file. */
+	struct sReadResult
+	{
+		/** True if the file exists. */
+		bool m_Exists;
+
+		/** True if the file exists, but couldn't be read. */
+		bool m_HasFailed;
+
+		/** The contents of the file, valid if it exists and has been read. */
+		AString m_Contents;
+
+		/** When was the file read, used for dropping the prefetched files that nobody has loaded. */
+		std::chrono::steady_clock::time_point m_ReadTime;
+	};
+
+
+	/** Protects all the members below. */
+	std::mutex m_Mutex;
+
+	/** Set while the storage thread is running; the operations are done synchronously on the calling thread if not set. */
+	bool m_IsRunning;
+
+	/** The files having pending work (a write, a prefetch, or both), in the order in which they were queued. Each file is listed at most once. */
+	std::deque<AString> m_Queue;
+
+	/** The latest data queued for writing into each file. */
+	std::unordered_map<AString, std::unique_ptr<Json::Value>> m_PendingWrites;
+
+	/** The files queued for prefetching. */
+	std::unordered_set<AString> m_PendingReads;
+
+	/** The files that have been prefetched and not yet loaded. */
+	std::unordered_map<AString, sReadResult> m_ReadResults;
+
+	/** The file that the storage thread is currently reading or writing. Empty if none. */
+	AString m_BusyFileName;
+
+	/** Set when a file is added to the queue. */
+	cEvent m_evtQueued;
+
+	/** Notified when the storage thread has finished reading or writing a file (m_BusyFileName has been cleared). */
+	std::condition_variable m_FileProcessed;
+
+
+	// cIsThread override:
+	virtual void Execute(void) override;
+
+	/** Adds the file to m_Queue and wakes up the storage thread, unless the file is already queued. Expects m_Mutex to be held. */
+	void QueueFile(const AString & a_FileName);
+
+	/** Drops the prefetched files that nobody loaded in time. Expects m_Mutex to be held. */
+	void PurgeStaleReadResults(void);
+
+	/** Serializes the data and writes it into the file, through a temporary file. Logs a warning on failure.
+	Returns the serialized data. */
+	static AString WriteFile(const AString & a_FileName, const Json::Value & a_Data);
+
+	/** Reads the file from the disk. */
+	static sReadResult ReadFile(const AString & a_FileName);
+
+	/** Returns the contents of the read result, as specified in Load(). */
+	static bool ExtractReadResult(const AString & a_FileName, sReadResult && a_Result, AString & a_Contents);
+};
+
+
+
+
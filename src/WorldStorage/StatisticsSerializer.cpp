@@ -13,24 +13,6 @@
 
 
 
-static auto MakeStatisticsDirectory(const std::string & WorldPath, std::string && FileName)
-{
-	// Even though stats are shared between worlds, they are (usually) saved
-	// inside the folder of the default world.
-
-	// Path to the world's statistics folder.
-	const auto Path = WorldPath + cFile::GetPathSeparator() + "stats";
-
-	// Ensure that the directory exists.
-	cFile::CreateFolder(Path);
-
-	return Path + cFile::GetPathSeparator() + std::move(FileName) + ".json";
-}
-
-
-
-
-
 static void SaveStatToJSON(const StatisticsManager & Manager, Json::Value & a_Out)
 {
 	if (Manager.Custom.empty())
@@ -71,11 +53,17 @@ static void LoadCustomStatFromJSON(StatisticsManager & Manager, const Json::Valu
 
 
 
-void StatisticsSerializer::Load(StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName)
+std::string StatisticsSerializer::GetFileName(const std::string & WorldPath, const std::string & FileName)
 {
-	Json::Value Root;
-	InputFileStream(MakeStatisticsDirectory(WorldPath, std::move(FileName))) >> Root;
+	return WorldPath + cFile::GetPathSeparator() + "stats" + cFile::GetPathSeparator() + FileName + ".json";
+}
+
 
+
+
+
+void StatisticsSerializer::FromJson(StatisticsManager & Manager, const Json::Value & Root)
+{
 	LoadCustomStatFromJSON(Manager, Root["stats"]["custom"]);
 }
 
@@ -83,12 +71,12 @@ void StatisticsSerializer::Load(StatisticsManager & Manager, const std::string &
 
 
 
-void StatisticsSerializer::Save(const StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName)
+Json::Value StatisticsSerializer::ToJson(const StatisticsManager & Manager)
 {
 	Json::Value Root;
 
 	SaveStatToJSON(Manager, Root["stats"]);
 	Root["DataVersion"] = NamespaceSerializer::DataVersion();
 
-	OutputFileStream(MakeStatisticsDirectory(WorldPath, std::move(FileName))) << Root;
+	return Root;
 }
@@ -22,9 +22,12 @@ namespace Json { class Value; }
 
 namespace StatisticsSerializer
 {
-	/* Try to load the player statistics. */
-	void Load(StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName);
+	/* Returns the path of the player statistics file. */
+	std::string GetFileName(const std::string & WorldPath, const std::string & FileName);
 
-	/* Try to save the player statistics. */
-	void Save(const StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName);
+	/* Loads the player statistics from the JSON stored in the statistics file. */
+	void FromJson(StatisticsManager & Manager, const Json::Value & Root);
+
+	/* Returns the JSON to store in the statistics file. */
+	Json::Value ToJson(const StatisticsManager & Manager);
 }
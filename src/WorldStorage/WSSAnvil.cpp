@@ -18,6 +18,7 @@
 #include "../Root.h"
 #include "../BlockType.h"
 #include "../JsonUtils.h"
+#include <filesystem>
 
 #include "../BlockEntities/BannerEntity.h"
 #include "../BlockEntities/BeaconEntity.h"
@@ -78,6 +79,22 @@ Since only the header is actually in the memory, this number can be high, but st
 */
 #define MAX_MCA_FILES 32
 
+/** The compression factor used while the save queue is long. */
+static const int FAST_COMPRESSION_FACTOR = 1;
+
+/** The save queue length above which the chunks are compressed with FAST_COMPRESSION_FACTOR,
+so that saving catches up faster, at the cost of somewhat larger region files. */
+static const size_t FAST_COMPRESSION_QUEUE_LENGTH = 500;
+
+/** The size of a sector of the region file. */
+static const size_t MCA_SECTOR_SIZE = 4 KiB;
+
+/** A region file is compacted once it has at least this many free sectors... */
+static const size_t MCA_COMPACT_MIN_FREE_SECTORS = 64;
+
+/** ... and at least this fraction (1 / N) of its sectors is free. */
+static const size_t MCA_COMPACT_FREE_FRACTION = 4;
+
 
 
 
@@ -85,9 +102,11 @@ Since only the header is actually in the memory, this number can be high, but st
 ////////////////////////////////////////////////////////////////////////////////
 // cWSSAnvil:
 
-cWSSAnvil::cWSSAnvil(cWorld * a_World, int a_CompressionFactor) :
+cWSSAnvil::cWSSAnvil(cWorld * a_World, int a_CompressionFactor, cCompressedChunkCache & a_ChunkCache) :
 	Super(a_World),
-	m_Compressor(a_CompressionFactor)
+	m_Compressor(a_CompressionFactor),
+	m_CompressionFactor(a_CompressionFactor),
+	m_ChunkCache(a_ChunkCache)
 {
 	// Create a level.dat file for mapping tools, if it doesn't already exist:
 	AString fnam;
@@ -142,13 +161,29 @@ cWSSAnvil::~cWSSAnvil()
 bool cWSSAnvil::LoadChunk(const cChunkCoords & a_Chunk)
 {
 	ContiguousByteBuffer ChunkData;
+	if (m_ChunkCache.Retrieve(a_Chunk, ChunkData))
+	{
+		// The cached data is the same as in the region file, no need to read it on failure:
+		if (!LoadChunkFromData(a_Chunk, ChunkData))
+		{
+			m_ChunkCache.Remove(a_Chunk);
+			return false;
+		}
+		return true;
+	}
+
 	if (!GetChunkData(a_Chunk, ChunkData))
 	{
 		// The reason for failure is already printed in GetChunkData()
 		return false;
 	}
 
-	return LoadChunkFromData(a_Chunk, ChunkData);
+	if (!LoadChunkFromData(a_Chunk, ChunkData))
+	{
+		return false;
+	}
+	m_ChunkCache.Store(a_Chunk, ChunkData);
+	return true;
 }
 
 
@@ -159,15 +194,19 @@ bool cWSSAnvil::SaveChunk(const cChunkCoords & a_Chunk)
 {
 	try
 	{
-		if (!SetChunkData(a_Chunk, SaveChunkToData(a_Chunk).GetView()))
+		const auto DataSize = SaveChunkToData(a_Chunk, m_SaveBuffer);
+		if (!SetChunkData(a_Chunk, m_SaveBuffer))
 		{
 			LOGWARNING("Cannot store chunk [%d, %d] data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+			m_ChunkCache.Remove(a_Chunk);
 			return false;
 		}
+		m_ChunkCache.Store(a_Chunk, ContiguousByteBufferView(m_SaveBuffer).substr(MCA_CHUNK_HEADER_LENGTH, DataSize));
 	}
 	catch (const std::exception & Oops)
 	{
 		LOGWARNING("Cannot serialize chunk [%d, %d] into data: %s", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, Oops.what());
+		m_ChunkCache.Remove(a_Chunk);
 		return false;
 	}
 
@@ -244,7 +283,7 @@ bool cWSSAnvil::GetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBuffer
 
 
 
-bool cWSSAnvil::SetChunkData(const cChunkCoords & a_Chunk, const ContiguousByteBufferView a_Data)
+bool cWSSAnvil::SetChunkData(const cChunkCoords & a_Chunk, const ContiguousByteBufferView a_Sectors)
 {
 	cCSLock Lock(m_CS);
 	cMCAFile * File = LoadMCAFile(a_Chunk);
@@ -252,7 +291,7 @@ bool cWSSAnvil::SetChunkData(const cChunkCoords & a_Chunk, const ContiguousByteB
 	{
 		return false;
 	}
-	return File->SetChunkData(a_Chunk, a_Data);
+	return File->SetChunkData(a_Chunk, a_Sectors);
 }
 
 
@@ -316,8 +355,9 @@ bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, const Contiguous
 {
 	try
 	{
+		// The tags that are not loaded (UnusedTags) have their contents skipped instead of parsed:
 		const auto Extracted = m_Extractor.ExtractZLib(a_Data);
-		cParsedNBT NBT(Extracted.GetView());
+		cParsedNBT NBT(Extracted.GetView(), UnusedTags);
 
 		if (!NBT.IsValid())
 		{
@@ -339,13 +379,41 @@ bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, const Contiguous
 
 
 
-Compression::Result cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk)
+size_t cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Sectors)
 {
 	cFastNBTWriter Writer;
 	NBTChunkSerializer::Serialize(*m_World, a_Chunk, Writer);
 	Writer.Finish();
 
-	return m_Compressor.CompressZLib(Writer.GetResult());
+	// Compress right behind the space for the chunk header:
+	a_Sectors.assign(MCA_CHUNK_HEADER_LENGTH, std::byte(0));
+	const auto DataSize = GetCompressor().CompressZLib(Writer.GetResult(), a_Sectors);
+
+	// The chunk header is the big-endian length of the data including the compression type, and the compression type (2 = zlib):
+	const auto Length = htonl(static_cast<UInt32>(DataSize + 1));
+	std::memcpy(a_Sectors.data(), &Length, sizeof(Length));
+	a_Sectors[4] = std::byte(2);
+
+	// Pad to whole sectors:
+	a_Sectors.resize((a_Sectors.size() + MCA_SECTOR_SIZE - 1) / MCA_SECTOR_SIZE * MCA_SECTOR_SIZE, std::byte(0));
+	return DataSize;
+}
+
+
+
+
+
+Compression::Compressor & cWSSAnvil::GetCompressor(void)
+{
+	if ((m_CompressionFactor <= FAST_COMPRESSION_FACTOR) || (m_World->GetStorageSaveQueueLength() <= FAST_COMPRESSION_QUEUE_LENGTH))
+	{
+		return m_Compressor;
+	}
+	if (m_FastCompressor == nullptr)
+	{
+		m_FastCompressor = std::make_unique<Compression::Compressor>(FAST_COMPRESSION_FACTOR);
+	}
+	return *m_FastCompressor;
 }
 
 
@@ -4021,6 +4089,57 @@ bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, ContiguousB
 
 
 
+bool cWSSAnvil::cMCAFile::GetChunkTimeStamp(const cChunkCoords & a_Chunk, UInt32 & a_TimeStamp)
+{
+	if (!OpenFile(true))
+	{
+		return false;
+	}
+	const auto Index = GetChunkIndex(a_Chunk);
+	if ((ntohl(m_Header[Index]) >> 8) < 2)
+	{
+		return false;
+	}
+	a_TimeStamp = ntohl(m_TimeStamps[Index]);
+	return true;
+}
+
+
+
+
+
+bool cWSSAnvil::cMCAFile::RemoveChunk(const cChunkCoords & a_Chunk)
+{
+	if (!OpenFile(true))
+	{
+		return false;
+	}
+	const auto Index = GetChunkIndex(a_Chunk);
+	m_Header[Index] = 0;
+	m_TimeStamps[Index] = 0;
+	return (
+		(m_File.Seek(static_cast<int>(sizeof(m_Header[0]) * static_cast<size_t>(Index))) >= 0) &&
+		(m_File.Write(&m_Header[Index], sizeof(m_Header[0])) == sizeof(m_Header[0])) &&
+		(m_File.Seek(static_cast<int>(sizeof(m_Header) + sizeof(m_TimeStamps[0]) * static_cast<size_t>(Index))) >= 0) &&
+		(m_File.Write(&m_TimeStamps[Index], sizeof(m_TimeStamps[0])) == sizeof(m_TimeStamps[0]))
+	);
+}
+
+
+
+
+
+int cWSSAnvil::cMCAFile::GetChunkIndex(const cChunkCoords & a_Chunk)
+{
+	const int LocalX = a_Chunk.m_ChunkX - FAST_FLOOR_DIV(a_Chunk.m_ChunkX, 32) * 32;
+	const int LocalZ = a_Chunk.m_ChunkZ - FAST_FLOOR_DIV(a_Chunk.m_ChunkZ, 32) * 32;
+	return LocalX + 32 * LocalZ;
+}
+
+
+
+
+
 const std::byte * cWSSAnvil::GetSectionData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, size_t a_Length)
 {
 	int Child = a_NBT.FindChildByName(a_Tag, a_ChildName);
@@ -4035,8 +4154,10 @@ const std::byte * cWSSAnvil::GetSectionData(const cParsedNBT & a_NBT, int a_Tag,
 
 
 
-bool cWSSAnvil::cMCAFile::SetChunkData(const cChunkCoords & a_Chunk, const ContiguousByteBufferView a_Data)
+bool cWSSAnvil::cMCAFile::SetChunkData(const cChunkCoords & a_Chunk, const ContiguousByteBufferView a_Sectors)
 {
+	ASSERT((a_Sectors.size() > MCA_CHUNK_HEADER_LENGTH) && (a_Sectors.size() % MCA_SECTOR_SIZE == 0));
+
 	if (!OpenFile(false))
 	{
 		LOGWARNING("Cannot save chunk [%d, %d], opening file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
@@ -4053,69 +4174,58 @@ bool cWSSAnvil::cMCAFile::SetChunkData(const cChunkCoords & a_Chunk, const Conti
 	{
 		LocalZ = 32 + LocalZ;
 	}
+	const int Index = LocalX + 32 * LocalZ;
 
-	unsigned ChunkSector = FindFreeLocation(LocalX, LocalZ, a_Data.size());
-
-	// Store the chunk data:
-	m_File.Seek(static_cast<int>(ChunkSector * 4096));
-	UInt32 ChunkSize = htonl(static_cast<UInt32>(a_Data.size() + 1));
-	if (m_File.Write(&ChunkSize, 4) != 4)
-	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing(1) data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
-		return false;
-	}
-	char CompressionType = 2;
-	if (m_File.Write(&CompressionType, 1) != 1)
+	const auto NumSectors = static_cast<unsigned>(a_Sectors.size() / MCA_SECTOR_SIZE);
+	if (NumSectors > 255)
 	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing(2) data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
-		return false;
-	}
-	if (m_File.Write(a_Data.data(), a_Data.size()) != static_cast<int>(a_Data.size()))
-	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing(3) data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
+		LOGWARNING("Cannot save chunk [%d, %d], the data is too large (%u KiB, maximum is 1024 KiB). Remove some entities and retry.",
+			a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, NumSectors * 4
+		);
 		return false;
 	}
 
-	// Add padding to 4K boundary:
-	size_t BytesWritten = a_Data.size() + MCA_CHUNK_HEADER_LENGTH;
-	if (BytesWritten % 4096 != 0)
-	{
-		static const char Padding[4095] = {0};
-		m_File.Write(Padding, 4096 - (BytesWritten % 4096));
-	}
-
-	// Store the header:
-	ChunkSize = (static_cast<UInt32>(a_Data.size()) + MCA_CHUNK_HEADER_LENGTH + 4095) / 4096;  // Round data size up to nearest 4KB sector, make it a sector number
-	if (ChunkSize > 255)
+	// Store the chunk data, including its header and the padding, in a single write:
+	const unsigned OldChunkSector = ntohl(m_Header[Index]) >> 8;
+	const unsigned ChunkSector = FindFreeLocation(LocalX, LocalZ, NumSectors);
+	if (
+		(m_File.Seek(static_cast<int>(ChunkSector * MCA_SECTOR_SIZE)) < 0) ||
+		(m_File.Write(a_Sectors.data(), a_Sectors.size()) != static_cast<int>(a_Sectors.size()))
+	)
 	{
-		LOGWARNING("Cannot save chunk [%d, %d], the data is too large (%u KiB, maximum is 1024 KiB). Remove some entities and retry.",
-			a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, static_cast<unsigned>(ChunkSize * 4)
-		);
+		LOGWARNING("Cannot save chunk [%d, %d], writing data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
 		return false;
 	}
 
 	// Store the header info in the table
-	m_Header[LocalX + 32 * LocalZ] = htonl(static_cast<UInt32>((ChunkSector << 8) | ChunkSize));
+	m_Header[Index] = htonl(static_cast<UInt32>((ChunkSector << 8) | NumSectors));
 
 	// Set the modification time
-	m_TimeStamps[LocalX + 32 * LocalZ] =  htonl(static_cast<UInt32>(time(nullptr)));
+	m_TimeStamps[Index] = htonl(static_cast<UInt32>(time(nullptr)));
 
-	if (m_File.Seek(0) < 0)
-	{
-		LOGWARNING("Cannot save chunk [%d, %d], seeking in file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
-		return false;
-	}
-	if (m_File.Write(m_Header, sizeof(m_Header)) != sizeof(m_Header))
+	// Write only the chunk's own entries of the header and the timestamps:
+	if (
+		(m_File.Seek(static_cast<int>(sizeof(m_Header[0]) * static_cast<size_t>(Index))) < 0) ||
+		(m_File.Write(&m_Header[Index], sizeof(m_Header[0])) != sizeof(m_Header[0]))
+	)
 	{
 		LOGWARNING("Cannot save chunk [%d, %d], writing header to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
 		return false;
 	}
-	if (m_File.Write(m_TimeStamps, sizeof(m_TimeStamps)) != sizeof(m_TimeStamps))
+	if (
+		(m_File.Seek(static_cast<int>(sizeof(m_Header) + sizeof(m_TimeStamps[0]) * static_cast<size_t>(Index))) < 0) ||
+		(m_File.Write(&m_TimeStamps[Index], sizeof(m_TimeStamps[0])) != sizeof(m_TimeStamps[0]))
+	)
 	{
 		LOGWARNING("Cannot save chunk [%d, %d], writing timestamps to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
 		return false;
 	}
 
+	// The chunk has left a hole behind, compact the file if there's too much free space:
+	if ((OldChunkSector >= 2) && (ChunkSector != OldChunkSector))
+	{
+		CompactIfWasteful();
+	}
 	return true;
 }
 
@@ -4123,26 +4233,197 @@ bool cWSSAnvil::cMCAFile::SetChunkData(const cChunkCoords & a_Chunk, const Conti
 
 
 
-unsigned cWSSAnvil::cMCAFile::FindFreeLocation(int a_LocalX, int a_LocalZ, const size_t a_DataSize)
+unsigned cWSSAnvil::cMCAFile::FindFreeLocation(int a_LocalX, int a_LocalZ, const unsigned a_NumSectors)
 {
 	// See if it fits the current location:
-	unsigned ChunkLocation = ntohl(m_Header[a_LocalX + 32 * a_LocalZ]);
-	unsigned ChunkLen = ChunkLocation & 0xff;
-	if (a_DataSize + MCA_CHUNK_HEADER_LENGTH <= (ChunkLen * 4096))
+	const int Index = a_LocalX + 32 * a_LocalZ;
+	unsigned ChunkLocation = ntohl(m_Header[Index]);
+	if (a_NumSectors <= (ChunkLocation & 0xff))
 	{
 		return ChunkLocation >> 8;
 	}
 
-	// Doesn't fit, append to the end of file (we're wasting a lot of space, TODO: fix this later)
-	unsigned MaxLocation = 2 << 8;  // Minimum sector is #2 - after the headers
-	for (size_t i = 0; i < ARRAYCOUNT(m_Header); i++)
+	// The chunk's own sectors are free once it moves:
+	const auto IsUsed = GetUsedSectors(Index);
+	const auto Hole = FindFreeRun(IsUsed, a_NumSectors, static_cast<unsigned>(IsUsed.size()));
+	if (Hole != 0)
 	{
-		ChunkLocation = ntohl(m_Header[i]);
-		ChunkLocation = ChunkLocation + ((ChunkLocation & 0xff) << 8);  // Add the number of sectors used; don't care about the 4th byte
-		if (MaxLocation < ChunkLocation)
+		return Hole;
+	}
+
+	// No hole is large enough, append to the end of file (over the free sectors at the end, if any):
+	unsigned End = static_cast<unsigned>(IsUsed.size());
+	while ((End > 2) && !IsUsed[End - 1])
+	{
+		End--;
+	}
+	return End;
+}
+
+
+
+
+
+std::vector<bool> cWSSAnvil::cMCAFile::GetUsedSectors(const int a_ExceptIndex) const
+{
+	// The first two sectors hold the header and the timestamps:
+	std::vector<bool> IsUsed(2, true);
+	for (int i = 0; i < MCA_MAX_CHUNKS; i++)
+	{
+		const unsigned ChunkLocation = ntohl(m_Header[i]);
+		const unsigned Offset = ChunkLocation >> 8;
+		const unsigned NumSectors = ChunkLocation & 0xff;
+		if ((i == a_ExceptIndex) || (Offset < 2) || (NumSectors == 0))
 		{
-			MaxLocation = ChunkLocation;
+			continue;
 		}
+		if (IsUsed.size() < Offset + NumSectors)
+		{
+			IsUsed.resize(Offset + NumSectors, false);
+		}
+		std::fill_n(IsUsed.begin() + Offset, NumSectors, true);
 	}  // for i - m_Header[]
-	return MaxLocation >> 8;
+	return IsUsed;
+}
+
+
+
+
+
+unsigned cWSSAnvil::cMCAFile::FindFreeRun(const std::vector<bool> & a_IsUsed, const unsigned a_NumSectors, const unsigned a_Limit)
+{
+	unsigned RunStart = 2;
+	const auto Limit = std::min(a_Limit, static_cast<unsigned>(a_IsUsed.size()));
+	for (unsigned Sector = 2; Sector < Limit; Sector++)
+	{
+		if (a_IsUsed[Sector])
+		{
+			RunStart = Sector + 1;
+		}
+		else if (Sector + 1 - RunStart == a_NumSectors)
+		{
+			return RunStart;
+		}
+	}
+	return 0;
+}
+
+
+
+
+
+void cWSSAnvil::cMCAFile::CompactIfWasteful(void)
+{
+	const auto IsUsed = GetUsedSectors(-1);
+	const auto FileSectors = static_cast<size_t>(std::max(m_File.GetSize(), 0L)) / MCA_SECTOR_SIZE;
+	const auto NumUsed = static_cast<size_t>(std::count(IsUsed.begin(), IsUsed.end(), true));
+	const auto NumFree = std::max(FileSectors, NumUsed) - NumUsed;
+	if ((NumFree >= MCA_COMPACT_MIN_FREE_SECTORS) && (NumFree * MCA_COMPACT_FREE_FRACTION >= FileSectors))
+	{
+		Compact();
+	}
+}
+
+
+
+
+
+bool cWSSAnvil::cMCAFile::Compact(void)
+{
+	if (!OpenFile(true))
+	{
+		return false;
+	}
+
+	// Move the chunks into the holes, the last ones first, so that the end of the file becomes free.
+	// The old locations stay marked as used until the new header entries are written, so the moved data
+	// never overwrites a chunk the header still points to, and the file stays valid if the server dies midway:
+	auto IsUsed = GetUsedSectors(-1);
+	std::vector<int> Order;
+	for (int i = 0; i < MCA_MAX_CHUNKS; i++)
+	{
+		const unsigned ChunkLocation = ntohl(m_Header[i]);
+		if (((ChunkLocation >> 8) >= 2) && ((ChunkLocation & 0xff) != 0))
+		{
+			Order.push_back(i);
+		}
+	}
+	std::sort(Order.begin(), Order.end(), [this](int a_Index1, int a_Index2)
+		{
+			return (ntohl(m_Header[a_Index1]) > ntohl(m_Header[a_Index2]));
+		}
+	);
+	std::vector<std::pair<int, UInt32>> Moved;
+	for (const auto Index: Order)
+	{
+		const unsigned ChunkLocation = ntohl(m_Header[Index]);
+		const unsigned Offset = ChunkLocation >> 8;
+		const unsigned NumSectors = ChunkLocation & 0xff;
+		const auto Hole = FindFreeRun(IsUsed, NumSectors, Offset);
+		if (Hole == 0)
+		{
+			continue;
+		}
+		if (m_File.Seek(static_cast<int>(Offset * MCA_SECTOR_SIZE)) < 0)
+		{
+			break;
+		}
+		const auto Data = m_File.Read(NumSectors * MCA_SECTOR_SIZE);
+		if (
+			(Data.size() != NumSectors * MCA_SECTOR_SIZE) ||
+			(m_File.Seek(static_cast<int>(Hole * MCA_SECTOR_SIZE)) < 0) ||
+			(m_File.Write(Data.data(), Data.size()) != static_cast<int>(Data.size()))
+		)
+		{
+			LOGWARNING("Cannot compact region file \"%s\", moving a chunk failed", m_FileName.c_str());
+			break;
+		}
+		std::fill_n(IsUsed.begin() + Hole, NumSectors, true);
+		Moved.emplace_back(Index, htonl(static_cast<UInt32>((Hole << 8) | NumSectors)));
+	}
+	if (Moved.empty())
+	{
+		return true;
+	}
+
+	// Point the header to the new locations, only once the moved data is on the disk:
+	if (!m_File.Sync())
+	{
+		LOGWARNING("Cannot compact region file \"%s\", syncing the moved chunks failed", m_FileName.c_str());
+		return false;
+	}
+	for (const auto & Entry: Moved)
+	{
+		m_Header[Entry.first] = Entry.second;
+		if (
+			(m_File.Seek(static_cast<int>(sizeof(m_Header[0]) * static_cast<size_t>(Entry.first))) < 0) ||
+			(m_File.Write(&m_Header[Entry.first], sizeof(m_Header[0])) != sizeof(m_Header[0]))
+		)
+		{
+			LOGWARNING("Cannot compact region file \"%s\", writing the header failed", m_FileName.c_str());
+			return false;
+		}
+	}
+	if (!m_File.Sync())
+	{
+		LOGWARNING("Cannot compact region file \"%s\", syncing the header failed", m_FileName.c_str());
+		return false;
+	}
+
+	// Cut off the free sectors at the end. The file is closed for that, it is reopened (and its header re-read) on the next access:
+	IsUsed = GetUsedSectors(-1);
+	auto End = IsUsed.size();
+	while ((End > 2) && !IsUsed[End - 1])
+	{
+		End--;
+	}
+	m_File.Close();
+	std::error_code Error;
+	std::filesystem::resize_file(m_FileName, End * MCA_SECTOR_SIZE, Error);
+	if (Error)
+	{
+		LOGWARNING("Cannot truncate region file \"%s\": %s", m_FileName.c_str(), Error.message().c_str());
+		return false;
+	}
+	return true;
 }
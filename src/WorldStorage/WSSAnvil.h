@@ -53,7 +53,19 @@ class cWSSAnvil:
 
 public:
 
-	cWSSAnvil(cWorld * a_World, int a_CompressionFactor);
+	/** The chunk NBT tags that the loader doesn't use, parsed lazily so that their contents are skipped. */
+	static inline const cParsedNBT::cTagNames UnusedTags =
+	{
+		"ActiveEffects",
+		"ArmorItems",
+		"Attributes",
+		"HandItems",
+		"LiquidTicks",
+		"Passengers",
+		"TileTicks",
+	};
+
+	cWSSAnvil(cWorld * a_World, int a_CompressionFactor, cCompressedChunkCache & a_ChunkCache);
 	virtual ~cWSSAnvil() override;
 
 protected:
@@ -65,7 +77,14 @@ protected:
 		cMCAFile(cWSSAnvil & a_ParentSchema, const AString & a_FileName, int a_RegionX, int a_RegionZ);
 
 		bool GetChunkData  (const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Data);
-		bool SetChunkData  (const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data);
+		/** Stores the chunk's data. a_Sectors is the data prefixed with the chunk header and padded to whole sectors, as made by SaveChunkToData(). */
+		bool SetChunkData  (const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Sectors);
+
+		/** Returns the time when the chunk was saved, in a_TimeStamp. Returns false if the file doesn't have the chunk. */
+		bool GetChunkTimeStamp(const cChunkCoords & a_Chunk, UInt32 & a_TimeStamp);
+
+		/** Removes the chunk from the file, its sectors become free. Returns true on success. */
+		bool RemoveChunk(const cChunkCoords & a_Chunk);
 
 		int             GetRegionX (void) const {return m_RegionX; }
 		int             GetRegionZ (void) const {return m_RegionZ; }
@@ -87,11 +106,31 @@ protected:
 		// Chunk timestamps, following the chunk headers
 		unsigned m_TimeStamps[MCA_MAX_CHUNKS];
 
-		/** Finds a free location large enough to hold a_Data. Returns the sector number. */
-		unsigned FindFreeLocation(int a_LocalX, int a_LocalZ, size_t a_DataSize);
+		/** Finds a free location for a_NumSectors sectors of the chunk's data. Returns the sector number.
+		Keeps the chunk's current location if the data fits, otherwise uses the first large enough run of free sectors,
+		so that the holes left by the chunks that grew get reused instead of the file growing. */
+		unsigned FindFreeLocation(int a_LocalX, int a_LocalZ, unsigned a_NumSectors);
+
+		/** Returns the sectors used by the headers and the chunks, except the chunk at a_ExceptIndex (-1 for none).
+		The free sectors at the end of the file are not included. */
+		std::vector<bool> GetUsedSectors(int a_ExceptIndex) const;
+
+		/** Returns the first sector of the first run of a_NumSectors free sectors that ends before a_Limit, or 0 if there's none. */
+		static unsigned FindFreeRun(const std::vector<bool> & a_IsUsed, unsigned a_NumSectors, unsigned a_Limit);
+
+		/** Compacts the file if enough of its sectors are free, see Compact(). */
+		void CompactIfWasteful(void);
+
+		/** Moves the chunks from the end of the file into the free sectors before them, then truncates the file.
+		Safe against crashes: the data is moved and synced before the header entries are updated and synced,
+		and the file is truncated only after that. Returns false if any of the steps fails. */
+		bool Compact(void);
 
 		/** Opens a MCA file either for a Read operation (fails if doesn't exist) or for a Write operation (creates new if not found) */
 		bool OpenFile(bool a_IsForReading);
+
+		/** Returns the index of the chunk's entries in m_Header and m_TimeStamps. */
+		static int GetChunkIndex(const cChunkCoords & a_Chunk);
 	} ;
 	typedef std::list<cMCAFile *> cMCAFiles;
 
@@ -101,6 +140,19 @@ protected:
 	Compression::Extractor m_Extractor;
 	Compression::Compressor m_Compressor;
 
+	/** The compressor with the fastest compression factor, used instead of m_Compressor while the save queue is long.
+	Created on first use. */
+	std::unique_ptr<Compression::Compressor> m_FastCompressor;
+
+	/** The compression factor of m_Compressor. */
+	int m_CompressionFactor;
+
+	/** The sectors of the chunk being saved; kept between the saves so that its memory is reused. */
+	ContiguousByteBuffer m_SaveBuffer;
+
+	/** The compressed data of the recently saved and loaded chunks, so that reloading them doesn't need to read the region files. */
+	cCompressedChunkCache & m_ChunkCache;
+
 	/** Reports that the specified chunk failed to load and saves the chunk data to an external file. */
 	void ChunkLoadFailed(int a_ChunkX, int a_ChunkZ, const AString & a_Reason, ContiguousByteBufferView a_ChunkDataToSave);
 
@@ -110,14 +162,20 @@ protected:
 	/** Copies a_Length bytes of data from the specified NBT Tag's Child into the a_Destination buffer */
 	const std::byte * GetSectionData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, size_t a_Length);
 
-	/** Sets chunk data into the correct file; locks file CS as needed */
-	bool SetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data);
+	/** Sets chunk data into the correct file; locks file CS as needed.
+	a_Sectors is the data prefixed with the chunk header and padded to whole sectors, as made by SaveChunkToData(). */
+	bool SetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Sectors);
 
 	/** Loads the chunk from the data (no locking needed) */
 	bool LoadChunkFromData(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data);
 
-	/** Saves the chunk into datastream (no locking needed) */
-	Compression::Result SaveChunkToData(const cChunkCoords & a_Chunk);
+	/** Saves the chunk into a_Sectors, compressed, prefixed with the chunk header and padded to whole sectors,
+	so that it can be written into the region file as a whole (no locking needed).
+	Returns the size of the compressed data, which follows the chunk header. */
+	size_t SaveChunkToData(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Sectors);
+
+	/** Returns the compressor to use for the next chunk: the fast one while the save queue is long, m_Compressor otherwise. */
+	Compression::Compressor & GetCompressor(void);
 
 	/** Loads the chunk from NBT data (no locking needed).
 	a_RawChunkData is the raw (compressed) chunk data, used for offloading when chunk loading fails. */
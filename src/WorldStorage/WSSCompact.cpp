@@ -0,0 +1,184 @@
+
+// WSSCompact.cpp
+
+// Implements the cWSSCompact class representing the "compact" world storage schema, storing chunks in append-only log files
+
+#include "Globals.h"
+#include "WSSCompact.h"
+#include "../World.h"
+
+
+
+
+
+/** The size of the group of chunks stored in a single log file, in chunks along each axis. */
+static const int LOG_FILE_GROUP_SIZE = 128;
+
+/** Maximum number of log files kept open. */
+static const size_t MAX_LOG_FILES = 8;
+
+
+
+
+
+cWSSCompact::cWSSCompact(cWorld * a_World, int a_CompressionFactor, cCompressedChunkCache & a_ChunkCache, bool a_ReadsAnvil):
+	Super(a_World, a_CompressionFactor, a_ChunkCache),
+	m_ReadsAnvil(a_ReadsAnvil)
+{
+}
+
+
+
+
+
+cChunkLogFile * cWSSCompact::GetLogFile(const cChunkCoords & a_Chunk, bool a_ShouldCreate)
+{
+	ASSERT(m_CS.IsLocked());
+
+	const auto FolderName = Printf("%s%ccompact", m_World->GetDataPath().c_str(), cFile::PathSeparator());
+	const auto FileName = Printf("%s%cc.%d.%d.cwl", FolderName.c_str(), cFile::PathSeparator(),
+		FAST_FLOOR_DIV(a_Chunk.m_ChunkX, LOG_FILE_GROUP_SIZE), FAST_FLOOR_DIV(a_Chunk.m_ChunkZ, LOG_FILE_GROUP_SIZE)
+	);
+
+	// Is it already open?
+	for (auto itr = m_LogFiles.begin(); itr != m_LogFiles.end(); ++itr)
+	{
+		if ((*itr)->GetFileName() == FileName)
+		{
+			// Move the file to front and return it; reopen it if a compaction has failed to:
+			m_LogFiles.splice(m_LogFiles.begin(), m_LogFiles, itr);
+			return m_LogFiles.front()->Open(a_ShouldCreate) ? m_LogFiles.front().get() : nullptr;
+		}
+	}
+
+	// Open it anew:
+	if (a_ShouldCreate)
+	{
+		cFile::CreateFolder(FolderName);
+	}
+	auto File = std::make_unique<cChunkLogFile>(FileName);
+	if (!File->Open(a_ShouldCreate))
+	{
+		return nullptr;
+	}
+	m_LogFiles.push_front(std::move(File));
+
+	// Close the least recently used file, if there are too many open:
+	if (m_LogFiles.size() > MAX_LOG_FILES)
+	{
+		m_LogFiles.pop_back();
+	}
+	return m_LogFiles.front().get();
+}
+
+
+
+
+
+bool cWSSCompact::LoadChunk(const cChunkCoords & a_Chunk)
+{
+	// As the fallback, the Anvil schema has already looked into the cache:
+	ContiguousByteBuffer ChunkData;
+	if (m_ReadsAnvil && m_ChunkCache.Retrieve(a_Chunk, ChunkData))
+	{
+		// The cached data is the newest data of the chunk, whichever file it is in:
+		if (!LoadChunkFromData(a_Chunk, ChunkData))
+		{
+			m_ChunkCache.Remove(a_Chunk);
+			return false;
+		}
+		return true;
+	}
+
+	{
+		cCSLock Lock(m_CS);
+
+		// Load from the file that has the newest data of the chunk:
+		UInt32 LogTimeStamp = 0;
+		UInt32 AnvilTimeStamp = 0;
+		const auto LogFile = GetLogFile(a_Chunk, false);
+		const bool IsInLog = (LogFile != nullptr) && LogFile->GetTimeStamp(a_Chunk, LogTimeStamp);
+		const auto MCAFile = m_ReadsAnvil ? LoadMCAFile(a_Chunk) : nullptr;
+		const bool IsInAnvil = (MCAFile != nullptr) && MCAFile->GetChunkTimeStamp(a_Chunk, AnvilTimeStamp);
+		if (IsInAnvil && (!IsInLog || (AnvilTimeStamp > LogTimeStamp)))
+		{
+			if (!MCAFile->GetChunkData(a_Chunk, ChunkData))
+			{
+				// The reason for failure is already printed in GetChunkData()
+				return false;
+			}
+		}
+		else if (IsInLog)
+		{
+			if (!LogFile->GetChunkData(a_Chunk, ChunkData))
+			{
+				ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ,
+					Printf("Cannot read chunk data from file %s, or the data is corrupted.", LogFile->GetFileName().c_str()), ChunkData
+				);
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	if (!LoadChunkFromData(a_Chunk, ChunkData))
+	{
+		return false;
+	}
+	m_ChunkCache.Store(a_Chunk, ChunkData);
+	return true;
+}
+
+
+
+
+
+bool cWSSCompact::SaveChunk(const cChunkCoords & a_Chunk)
+{
+	try
+	{
+		// The log files store the compressed data without the Anvil chunk header and sector padding:
+		const auto DataSize = SaveChunkToData(a_Chunk, m_SaveBuffer);
+		const auto ChunkData = ContiguousByteBufferView(m_SaveBuffer).substr(MCA_CHUNK_HEADER_LENGTH, DataSize);
+
+		cCSLock Lock(m_CS);
+		const auto LogFile = GetLogFile(a_Chunk, true);
+		if ((LogFile == nullptr) || !LogFile->SetChunkData(a_Chunk, ChunkData, static_cast<UInt32>(time(nullptr))))
+		{
+			LOGWARNING("Cannot store chunk [%d, %d] data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+			m_ChunkCache.Remove(a_Chunk);
+			return false;
+		}
+		m_ChunkCache.Store(a_Chunk, ChunkData);
+
+		// The region file's copy is outdated now, remove it so that the Anvil schema doesn't load it if selected again.
+		// The record must be on the disk first, otherwise a crash could lose both copies:
+		UInt32 AnvilTimeStamp = 0;
+		const auto MCAFile = LoadMCAFile(a_Chunk);
+		if ((MCAFile != nullptr) && MCAFile->GetChunkTimeStamp(a_Chunk, AnvilTimeStamp))
+		{
+			if (!LogFile->Sync() || !MCAFile->RemoveChunk(a_Chunk))
+			{
+				LOGWARNING("Cannot remove chunk [%d, %d] from its region file, will retry on the next save", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+			}
+		}
+
+		LogFile->CompactIfNeeded();
+	}
+	catch (const std::exception & Oops)
+	{
+		LOGWARNING("Cannot serialize chunk [%d, %d] into data: %s", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, Oops.what());
+		m_ChunkCache.Remove(a_Chunk);
+		return false;
+	}
+
+	// Everything successful
+	return true;
+}
+
+
+
+
@@ -0,0 +1,63 @@
+
+// WSSCompact.h
+
+// Declares the cWSSCompact class representing the "compact" world storage schema, storing chunks in append-only log files
+
+/*
+The chunks are stored in the same zlib-compressed NBT as in Anvil, but instead of the 4 KiB sectors of the region files,
+they are appended to a log file per group of 128 x 128 chunks (cChunkLogFile).
+This saves the sector padding (2 KiB per chunk on average), writes sequentially and keeps fewer files open.
+
+The schema reads the Anvil region files as well, so switching an existing world to it needs no conversion:
+a chunk that isn't in the log files yet is loaded from its region file, and when saved, it is moved into the log file.
+Switching back works the same way: the Anvil schema doesn't find the moved chunks in the region files
+and the storage falls back to this schema for them.
+Both schemas record the time each chunk was saved; when a chunk is in both, the newer one is loaded.
+*/
+
+
+
+
+
+#pragma once
+
+#include "WSSAnvil.h"
+#include "ChunkLogFile.h"
+
+
+
+
+
+class cWSSCompact:
+	public cWSSAnvil
+{
+	using Super = cWSSAnvil;
+
+public:
+
+	/** If a_ReadsAnvil is true, the chunks are loaded from the Anvil region files as well, and moved into the log files when saved.
+	It is false when the schema is only the fallback for the chunks saved while it was selected. */
+	cWSSCompact(cWorld * a_World, int a_CompressionFactor, cCompressedChunkCache & a_ChunkCache, bool a_ReadsAnvil);
+
+protected:
+
+	/** The open log files, the most recently used first. Protected by Super::m_CS. */
+	std::list<std::unique_ptr<cChunkLogFile>> m_LogFiles;
+
+	/** True if the chunks are loaded from the Anvil region files as well (the schema is selected for saving). */
+	const bool m_ReadsAnvil;
+
+
+	/** Returns the log file for the chunk, opening it if needed. Expects m_CS to be held.
+	If the file doesn't exist, it is created if a_ShouldCreate is true, otherwise returns nullptr. */
+	cChunkLogFile * GetLogFile(const cChunkCoords & a_Chunk, bool a_ShouldCreate);
+
+	// cWSSchema overrides:
+	virtual bool LoadChunk(const cChunkCoords & a_Chunk) override;
+	virtual bool SaveChunk(const cChunkCoords & a_Chunk) override;
+	virtual const AString GetName(void) const override {return "compact"; }
+};
+
+
+
+
@@ -8,6 +8,7 @@
 #include "Globals.h"
 #include "WorldStorage.h"
 #include "WSSAnvil.h"
+#include "WSSCompact.h"
 #include "../World.h"
 #include "../Generating/ChunkGenerator.h"
 #include "../Entities/Entity.h"
@@ -40,7 +41,8 @@ protected:
 cWorldStorage::cWorldStorage(void) :
 	Super("World Storage Executor"),
 	m_World(nullptr),
-	m_SaveSchema(nullptr)
+	m_SaveSchema(nullptr),
+	m_ShouldDropLoads(false)
 {
 }
 
@@ -60,10 +62,11 @@ cWorldStorage::~cWorldStorage()
 
 
 
-void cWorldStorage::Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor)
+void cWorldStorage::Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor, size_t a_ChunkCacheSize)
 {
 	m_World = &a_World;
 	m_StorageSchemaName = a_StorageSchemaName;
+	m_ChunkCache.SetMaxBytes(a_ChunkCacheSize);
 	InitSchemas(a_StorageCompressionFactor);
 }
 
@@ -84,16 +87,16 @@ void cWorldStorage::WaitForFinish(void)
 {
 	LOGD("Waiting for the world storage to finish saving");
 
-	{
-		m_LoadQueue.Clear();
-	}
+	// The load queue can only be emptied by the storage thread, let it drop the chunks instead of loading them:
+	m_ShouldDropLoads = true;
+	m_QueueWaiter.NotifyAll();
 
 	// Wait for the saving to finish:
 	WaitForSaveQueueEmpty();
 
 	// Wait for the thread to finish:
 	m_ShouldTerminate = true;
-	m_Event.Set();  // Wake up the thread if waiting
+	m_QueueWaiter.NotifyAll();  // Wake up the thread if waiting
 	Super::Stop();
 	LOGD("World storage thread finished");
 }
@@ -104,7 +107,7 @@ void cWorldStorage::WaitForFinish(void)
 
 void cWorldStorage::WaitForLoadQueueEmpty(void)
 {
-	m_LoadQueue.BlockTillEmpty();
+	m_LoadQueue.WaitUntilEmpty();
 }
 
 
@@ -113,7 +116,7 @@ void cWorldStorage::WaitForLoadQueueEmpty(void)
 
 void cWorldStorage::WaitForSaveQueueEmpty(void)
 {
-	m_SaveQueue.BlockTillEmpty();
+	m_SaveQueue.WaitUntilEmpty();
 }
 
 
@@ -144,8 +147,8 @@ void cWorldStorage::QueueLoadChunk(int a_ChunkX, int a_ChunkZ)
 	ASSERT((a_ChunkZ > -0x08000000) && (a_ChunkZ < 0x08000000));
 	ASSERT(m_World->IsChunkQueued(a_ChunkX, a_ChunkZ));
 
-	m_LoadQueue.EnqueueItem({ a_ChunkX, a_ChunkZ });
-	m_Event.Set();
+	m_LoadQueue.Push(cChunkCoords(a_ChunkX, a_ChunkZ));
+	m_QueueWaiter.NotifyAll();
 }
 
 
@@ -156,8 +159,8 @@ void cWorldStorage::QueueSaveChunk(int a_ChunkX, int a_ChunkZ)
 {
 	ASSERT(m_World->IsChunkValid(a_ChunkX, a_ChunkZ));
 
-	m_SaveQueue.EnqueueItem({ a_ChunkX, a_ChunkZ });
-	m_Event.Set();
+	m_SaveQueue.Push(cChunkCoords(a_ChunkX, a_ChunkZ));
+	m_QueueWaiter.NotifyAll();
 }
 
 
@@ -167,7 +170,20 @@ void cWorldStorage::QueueSaveChunk(int a_ChunkX, int a_ChunkZ)
 void cWorldStorage::InitSchemas(int a_StorageCompressionFactor)
 {
 	// The first schema added is considered the default
-	m_Schemas.push_back(new cWSSAnvil    (m_World, a_StorageCompressionFactor));
+	// The compact schema reads the Anvil region files itself, so it replaces the Anvil schema when selected;
+	// otherwise it is there for loading the chunks saved while it was selected, if it ever was:
+	if (NoCaseCompare(m_StorageSchemaName, "compact") == 0)
+	{
+		m_Schemas.push_back(new cWSSCompact(m_World, a_StorageCompressionFactor, m_ChunkCache, true));
+	}
+	else
+	{
+		m_Schemas.push_back(new cWSSAnvil(m_World, a_StorageCompressionFactor, m_ChunkCache));
+		if (cFile::IsFolder(Printf("%s%ccompact", m_World->GetDataPath().c_str(), cFile::PathSeparator())))
+		{
+			m_Schemas.push_back(new cWSSCompact(m_World, a_StorageCompressionFactor, m_ChunkCache, false));
+		}
+	}
 	m_Schemas.push_back(new cWSSForgetful(m_World));
 	// Add new schemas here
 
@@ -204,7 +220,11 @@ void cWorldStorage::Execute(void)
 {
 	while (!m_ShouldTerminate)
 	{
-		m_Event.Wait();
+		m_QueueWaiter.Wait([this]()
+			{
+				return (m_ShouldTerminate || !m_LoadQueue.IsEmpty() || !m_SaveQueue.IsEmpty());
+			}
+		);
 		// Process both queues until they are empty again:
 		bool Success;
 		do
@@ -228,12 +248,18 @@ bool cWorldStorage::LoadOneChunk(void)
 {
 	// Dequeue an item, bail out if there's none left:
 	cChunkCoords ToLoad(0, 0);
-	bool ShouldLoad = m_LoadQueue.TryDequeueItem(ToLoad);
+	bool ShouldLoad = m_LoadQueue.TryPop(ToLoad);
 	if (!ShouldLoad)
 	{
 		return false;
 	}
 
+	// When finishing, the queued chunks are dropped, same as if they were never queued:
+	if (m_ShouldDropLoads)
+	{
+		return true;
+	}
+
 	// Load the chunk:
 	LoadChunk(ToLoad.m_ChunkX, ToLoad.m_ChunkZ);
 
@@ -248,7 +274,7 @@ bool cWorldStorage::SaveOneChunk(void)
 {
 	// Dequeue one chunk to save:
 	cChunkCoords ToSave(0, 0);
-	bool ShouldSave = m_SaveQueue.TryDequeueItem(ToSave);
+	bool ShouldSave = m_SaveQueue.TryPop(ToSave);
 	if (!ShouldSave)
 	{
 		return false;
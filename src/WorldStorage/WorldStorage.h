@@ -13,8 +13,9 @@
 #pragma once
 
 #include "../OSSupport/IsThread.h"
-#include "../OSSupport/Queue.h"
+#include "../OSSupport/LockFreeQueue.h"
 #include "ChunkDef.h"
+#include "CompressedChunkCache.h"
 
 
 
@@ -65,8 +66,9 @@ public:
 	/** Queues a chunk to be saved, asynchronously. */
 	void QueueSaveChunk(int a_ChunkX, int a_ChunkZ);
 
-	/** Initializes the storage schemas, ready to be started. */
-	void Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor);
+	/** Initializes the storage schemas, ready to be started.
+	a_ChunkCacheSize is the memory budget of the compressed chunk cache, in bytes; zero disables the cache. */
+	void Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor, size_t a_ChunkCacheSize);
 	void Stop(void);  // Hide the cIsThread's Stop() method, we need to signal the event
 	void WaitForFinish(void);
 	void WaitForLoadQueueEmpty(void);
@@ -75,13 +77,17 @@ public:
 	size_t GetLoadQueueLength(void);
 	size_t GetSaveQueueLength(void);
 
+	/** Returns the cache of the compressed data of the recently saved and loaded chunks. */
+	cCompressedChunkCache & GetChunkCache(void) { return m_ChunkCache; }
+
 protected:
 
 	cWorld * m_World;
 	AString  m_StorageSchemaName;
 
-	cQueue<cChunkCoords> m_LoadQueue;
-	cQueue<cChunkCoords> m_SaveQueue;
+	/** The chunks to load and to save. Pushed by any thread, popped only by the storage thread. */
+	cMpscQueue<cChunkCoords> m_LoadQueue;
+	cMpscQueue<cChunkCoords> m_SaveQueue;
 
 	/** All the storage schemas (all used for loading) */
 	cWSSchemaList m_Schemas;
@@ -89,8 +95,14 @@ protected:
 	/** The one storage schema used for saving */
 	cWSSchema * m_SaveSchema;
 
-	/** Set when there's any addition to the queues */
-	cEvent m_Event;
+	/** The compressed data of the recently saved and loaded chunks, shared by the schemas that support it. */
+	cCompressedChunkCache m_ChunkCache;
+
+	/** Notified when there's any addition to the queues, or the thread should terminate */
+	cQueueWaiter m_QueueWaiter;
+
+	/** Set when finishing; the chunks still queued for loading are then dropped instead of loaded. */
+	std::atomic<bool> m_ShouldDropLoads;
 
 
 	/** Loads the chunk specified; returns true on success, false on failure */
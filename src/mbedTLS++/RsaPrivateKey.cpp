@@ -121,6 +121,7 @@ int cRsaPrivateKey::Decrypt(const ContiguousByteBufferView a_EncryptedData, Byte
 		return -1;
 	}
 	size_t DecryptedLength;
+	cCSLock Lock(m_CS);
 	int res = mbedtls_rsa_pkcs1_decrypt(
 		&m_Rsa, mbedtls_ctr_drbg_random, m_CtrDrbg.GetInternal(), &DecryptedLength,
 		reinterpret_cast<const unsigned char *>(a_EncryptedData.data()), a_DecryptedData, a_DecryptedMaxLength
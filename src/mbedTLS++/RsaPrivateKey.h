@@ -49,6 +49,9 @@ protected:
 	/** The random generator used for generating the key and encryption / decryption */
 	cCtrDrbgContext m_CtrDrbg;
 
+	/** Protects m_Rsa's blinding values and m_CtrDrbg, the server key is used by logins on all the network event loops. */
+	cCriticalSection m_CS;
+
 
 	/** Returns the internal context ptr. Only use in mbedTLS API calls. */
 	mbedtls_rsa_context * GetInternal(void) { return &m_Rsa; }
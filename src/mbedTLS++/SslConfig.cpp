@@ -167,6 +167,34 @@ void cSslConfig::SetRng(cCtrDrbgContextPtr a_CtrDrbg)
 
 
 
+void cSslConfig::SetThreadLocalRng()
+{
+	m_CtrDrbg.reset();
+	mbedtls_ssl_conf_rng(&m_Config, ThreadLocalRandom, nullptr);
+}
+
+
+
+
+
+int cSslConfig::ThreadLocalRandom(void * a_Unused, unsigned char * a_Output, size_t a_Length)
+{
+	UNUSED(a_Unused);
+
+	// CTR-DRBG is not thread-safe, each thread gets its own, seeded on first use:
+	thread_local cCtrDrbgContext CtrDrbg;
+	int res = CtrDrbg.Initialize("Cuberite", 8);
+	if (res != 0)
+	{
+		return res;
+	}
+	return mbedtls_ctr_drbg_random(&CtrDrbg.m_CtrDrbg, a_Output, a_Length);
+}
+
+
+
+
+
 void cSslConfig::SetDebugCallback(cDebugCallback a_CallbackFun, void * a_CallbackData)
 {
 	mbedtls_ssl_conf_dbg(&m_Config, a_CallbackFun, a_CallbackData);
@@ -230,11 +258,9 @@ std::shared_ptr<cSslConfig> cSslConfig::MakeDefaultConfig(bool a_IsClient)
 
 	Ret->InitDefaults(a_IsClient);
 
-	{
-		auto CtrDrbg = std::make_shared<cCtrDrbgContext>();
-		CtrDrbg->Initialize("Cuberite", 8);
-		Ret->SetRng(std::move(CtrDrbg));
-	}
+	// The default configs are shared by links on all the network event loops, and TLS records may also be
+	// encrypted on the thread sending the data, so a single CTR-DRBG would be used concurrently:
+	Ret->SetThreadLocalRng();
 
 	Ret->SetAuthMode(eSslAuthMode::None);  // We cannot verify because we don't have a CA chain
 
@@ -55,6 +55,10 @@ public:
 	/** Set the random number generator. */
 	void SetRng(cCtrDrbgContextPtr a_CtrDrbg);
 
+	/** Set the random number generator to a CTR-DRBG private to each calling thread.
+	Used when the config is shared by links running on several network event loops. */
+	void SetThreadLocalRng();
+
 	/** Set the debug callback. */
 	void SetDebugCallback(cDebugCallback a_CallbackFun, void * a_CallbackData);
 
@@ -84,6 +88,9 @@ private:
 	/** Returns a pointer to the wrapped mbedtls representation. */
 	const mbedtls_ssl_config * GetInternal() const { return &m_Config; }
 
+	/** The mbedTLS RNG callback used by SetThreadLocalRng(), generates the random from the calling thread's CTR-DRBG. */
+	static int ThreadLocalRandom(void * a_Unused, unsigned char * a_Output, size_t a_Length);
+
 	mbedtls_ssl_config m_Config;
 	cCtrDrbgContextPtr m_CtrDrbg;
 	cX509CertPtr m_OwnCert;
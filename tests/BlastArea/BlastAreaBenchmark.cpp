@@ -0,0 +1,381 @@
+
+// BlastAreaBenchmark.cpp
+
+// Checks that tracing explosions in a cBlastArea destroys the same blocks as tracing them directly in the world,
+// and measures the speed of both by detonating a 10x10x10 cube of TNT
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockType.h"
+#include "Physics/BlastArea.h"
+
+
+
+
+
+/** Power of a TNT explosion. */
+static const int TNT_POWER = 4;
+
+/** Size of the TNT cube, in blocks. */
+static const int CUBE_SIZE = 10;
+
+/** The height at which the TNT cube is placed, on top of the stone. */
+static const int GROUND_HEIGHT = 64;
+
+
+
+
+
+/** A simple world made of chunks stored in a hashmap, so that reading a block costs a chunk lookup, similar to the real world. */
+class cTestWorld
+{
+public:
+
+	cTestWorld(void)
+	{
+		// Stone ground, with a TNT cube on top:
+		for (int ChunkX = -2; ChunkX <= 2; ChunkX++)
+		{
+			for (int ChunkZ = -2; ChunkZ <= 2; ChunkZ++)
+			{
+				auto & Chunk = m_Chunks[MakeKey(ChunkX, ChunkZ)];
+				Chunk.assign(cChunkDef::NumBlocks, E_BLOCK_AIR);
+				for (int y = 0; y < GROUND_HEIGHT; y++)
+				{
+					for (int i = 0; i < cChunkDef::Width * cChunkDef::Width; i++)
+					{
+						Chunk[static_cast<size_t>(i + y * cChunkDef::Width * cChunkDef::Width)] = E_BLOCK_STONE;
+					}
+				}
+			}
+		}
+		for (int y = 0; y < CUBE_SIZE; y++) for (int z = 0; z < CUBE_SIZE; z++) for (int x = 0; x < CUBE_SIZE; x++)
+		{
+			SetBlock({x, GROUND_HEIGHT + y, z}, E_BLOCK_TNT);
+		}
+	}
+
+
+	/** Returns true if the chunk containing the specified column is present. */
+	bool HasColumn(int a_BlockX, int a_BlockZ) const
+	{
+		int ChunkX, ChunkZ;
+		cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
+		return (m_Chunks.find(MakeKey(ChunkX, ChunkZ)) != m_Chunks.end());
+	}
+
+
+	/** Returns the block at the specified coords, which must be in a present chunk and at a valid height. */
+	BLOCKTYPE GetBlock(Vector3i a_Pos) const
+	{
+		const auto ChunkPos = cChunkDef::BlockToChunk(a_Pos);
+		const auto RelPos = cChunkDef::AbsoluteToRelative(a_Pos, ChunkPos);
+		return m_Chunks.at(MakeKey(ChunkPos.m_ChunkX, ChunkPos.m_ChunkZ))[cChunkDef::MakeIndex(RelPos)];
+	}
+
+
+	/** Sets the block at the specified coords, which must be in a present chunk and at a valid height. */
+	void SetBlock(Vector3i a_Pos, BLOCKTYPE a_BlockType)
+	{
+		const auto ChunkPos = cChunkDef::BlockToChunk(a_Pos);
+		const auto RelPos = cChunkDef::AbsoluteToRelative(a_Pos, ChunkPos);
+		m_Chunks.at(MakeKey(ChunkPos.m_ChunkX, ChunkPos.m_ChunkZ))[cChunkDef::MakeIndex(RelPos)] = a_BlockType;
+	}
+
+
+	/** Returns the blocks of the chunk containing the specified column, and the index of the column's bottom block in them.
+	Returns nullptr if the chunk isn't present. The blocks above are at multiples of cChunkDef::Width * cChunkDef::Width. */
+	const BLOCKTYPE * GetColumn(int a_BlockX, int a_BlockZ, size_t & a_Index) const
+	{
+		const auto ChunkPos = cChunkDef::BlockToChunk({a_BlockX, 0, a_BlockZ});
+		const auto itr = m_Chunks.find(MakeKey(ChunkPos.m_ChunkX, ChunkPos.m_ChunkZ));
+		if (itr == m_Chunks.end())
+		{
+			return nullptr;
+		}
+		a_Index = cChunkDef::MakeIndex(cChunkDef::AbsoluteToRelative({a_BlockX, 0, a_BlockZ}, ChunkPos));
+		return itr->second.data();
+	}
+
+
+	/** Returns the number of blocks of the specified type in the whole world. */
+	size_t CountBlocks(BLOCKTYPE a_BlockType) const
+	{
+		size_t Res = 0;
+		for (const auto & Chunk: m_Chunks)
+		{
+			Res += static_cast<size_t>(std::count(Chunk.second.begin(), Chunk.second.end(), a_BlockType));
+		}
+		return Res;
+	}
+
+protected:
+
+	std::unordered_map<Int64, std::vector<BLOCKTYPE>> m_Chunks;
+
+
+	static Int64 MakeKey(int a_ChunkX, int a_ChunkZ)
+	{
+		return (static_cast<Int64>(a_ChunkX) << 32) | static_cast<UInt32>(a_ChunkZ);
+	}
+};
+
+
+
+
+
+/** Returns the directions of the destruction rays, in the order they are traced, the same as cBlastArea uses. */
+static std::vector<Vector3f> GetRayDirections(void)
+{
+	std::vector<Vector3f> Res;
+	const int HalfSide = 8;
+	for (int x = -HalfSide; x < HalfSide; x++) for (int z = -HalfSide; z < HalfSide; z++)
+	{
+		Res.emplace_back(x, +HalfSide, z);
+		Res.emplace_back(x, -HalfSide, z);
+	}
+	for (int x = -HalfSide; x < HalfSide; x++) for (int y = -HalfSide + 1; y < HalfSide - 1; y++)
+	{
+		Res.emplace_back(x, y, +HalfSide);
+		Res.emplace_back(x, y, -HalfSide);
+	}
+	for (int z = -HalfSide + 1; z < HalfSide - 1; z++) for (int y = -HalfSide + 1; y < HalfSide - 1; y++)
+	{
+		Res.emplace_back(+HalfSide, y, z);
+		Res.emplace_back(-HalfSide, y, z);
+	}
+	return Res;
+}
+
+
+
+
+
+/** Traces the explosion directly in the world, reading each block from its chunk and destroying it right away,
+the way Explodinator did before cBlastArea.
+The ray positions are kept relative to a_Frame, so that the floating-point rounding is the same as in cBlastArea. */
+static std::vector<Vector3i> TraceInWorld(cTestWorld & a_World, Vector3f a_Position, Vector3i a_Frame, MTRand & a_Random)
+{
+	static const auto Directions = GetRayDirections();
+	std::vector<Vector3i> Destroyed;
+	const auto Origin = a_Position - Vector3f(a_Frame);
+	for (const auto & Direction: Directions)
+	{
+		const auto Step = Direction.NormalizeCopy() * 0.3f;
+		auto Intensity = TNT_POWER * (0.7f + a_Random.RandReal(0.6f));
+		auto Checkpoint = Origin;
+		while (Intensity > 0)
+		{
+			const auto Position = Checkpoint.Floor() + a_Frame;
+			if (!cChunkDef::IsValidHeight(Position.y) || !a_World.HasColumn(Position.x, Position.z))
+			{
+				break;
+			}
+			const auto Block = a_World.GetBlock(Position);
+			Intensity -= cBlastArea::GetExplosionAbsorption(Block);
+			if (Intensity <= 0)
+			{
+				break;
+			}
+			if (Block != E_BLOCK_AIR)
+			{
+				a_World.SetBlock(Position, E_BLOCK_AIR);
+				Destroyed.push_back(Position);
+			}
+			Checkpoint += Step;
+			Intensity -= 0.225f;
+		}
+	}
+	return Destroyed;
+}
+
+
+
+
+
+/** Fills the blast area from the world, the same way Explodinator fills it from the chunks. */
+static void FillArea(const cTestWorld & a_World, cBlastArea & a_Area)
+{
+	const auto Min = a_Area.GetMinPos();
+	const auto Max = a_Area.GetMaxPos();
+	for (int z = Min.z; z <= Max.z; z++)
+	{
+		for (int x = Min.x; x <= Max.x; x++)
+		{
+			size_t Index;
+			const auto Blocks = a_World.GetColumn(x, z, Index);
+			if (Blocks == nullptr)
+			{
+				continue;
+			}
+			for (int y = Min.y; y <= Max.y; y++)
+			{
+				a_Area.SetBlock({x, y, z}, Blocks[Index + static_cast<size_t>(y * cChunkDef::Width * cChunkDef::Width)]);
+			}
+		}
+	}
+}
+
+
+
+
+
+/** Traces the explosion in a cBlastArea filled from the world, then applies the destroyed blocks to the world. */
+static std::vector<Vector3i> TraceInArea(cTestWorld & a_World, Vector3f a_Position, MTRand & a_Random)
+{
+	cBlastArea Area(a_Position.Floor(), cBlastArea::GetRadiusForPower(TNT_POWER));
+	FillArea(a_World, Area);
+	auto Destroyed = Area.TraceDestruction(a_Position, TNT_POWER, a_Random);
+	for (const auto & Pos: Destroyed)
+	{
+		a_World.SetBlock(Pos, E_BLOCK_AIR);
+	}
+	return Destroyed;
+}
+
+
+
+
+
+/** Detonates all the TNT of the cube, one block at a time. The TNT destroyed by earlier explosions still explodes later, as if primed.
+a_Trace is called for each explosion with the world, the explosion's position and the random generator.
+Returns the list of blocks destroyed by each explosion. */
+template <typename TraceFn>
+static std::vector<std::vector<Vector3i>> DetonateCube(cTestWorld & a_World, TraceFn a_Trace)
+{
+	std::seed_seq Seed{ 1, 2, 3 };
+	MTRand Random(Seed);
+	std::vector<std::vector<Vector3i>> Res;
+	for (int y = 0; y < CUBE_SIZE; y++) for (int z = 0; z < CUBE_SIZE; z++) for (int x = 0; x < CUBE_SIZE; x++)
+	{
+		const Vector3i Pos(x, GROUND_HEIGHT + y, z);
+		a_World.SetBlock(Pos, E_BLOCK_AIR);
+		Res.push_back(a_Trace(a_World, Vector3f(Pos) + Vector3f(0.5f, 0.5f, 0.5f), Random));
+	}
+	return Res;
+}
+
+
+
+
+
+static void testDestructionMatchesWorld()
+{
+	cTestWorld ReferenceWorld, AreaWorld;
+	TEST_EQUAL(ReferenceWorld.CountBlocks(E_BLOCK_TNT), static_cast<size_t>(CUBE_SIZE * CUBE_SIZE * CUBE_SIZE));
+
+	// Detonate the cube in both worlds, measuring the time:
+	auto Start = std::chrono::steady_clock::now();
+	auto ReferenceResults = DetonateCube(ReferenceWorld, [](cTestWorld & a_World, Vector3f a_Position, MTRand & a_Random)
+		{
+			const auto Radius = cBlastArea::GetRadiusForPower(TNT_POWER);
+			const auto Frame = a_Position.Floor() - Vector3i(Radius, std::min(a_Position.Floor().y, Radius), Radius);
+			return TraceInWorld(a_World, a_Position, Frame, a_Random);
+		}
+	);
+	auto ReferenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+	Start = std::chrono::steady_clock::now();
+	auto AreaResults = DetonateCube(AreaWorld, TraceInArea);
+	auto AreaMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+	// Both must destroy the same blocks, in the same order:
+	TEST_EQUAL(ReferenceResults.size(), AreaResults.size());
+	size_t NumDestroyed = 0;
+	for (size_t i = 0; i < ReferenceResults.size(); i++)
+	{
+		TEST_EQUAL(ReferenceResults[i].size(), AreaResults[i].size());
+		for (size_t j = 0; j < ReferenceResults[i].size(); j++)
+		{
+			TEST_EQUAL(ReferenceResults[i][j], AreaResults[i][j]);
+		}
+		NumDestroyed += AreaResults[i].size();
+	}
+	TEST_EQUAL(ReferenceWorld.CountBlocks(E_BLOCK_TNT), AreaWorld.CountBlocks(E_BLOCK_TNT));
+	TEST_EQUAL(ReferenceWorld.CountBlocks(E_BLOCK_STONE), AreaWorld.CountBlocks(E_BLOCK_STONE));
+	TEST_GREATER_THAN_OR_EQUAL(NumDestroyed, 1U);
+
+	const auto NumExplosions = static_cast<double>(AreaResults.size());
+	LOG("Detonated %zu TNT blocks, %zu blocks destroyed", AreaResults.size(), NumDestroyed);
+	LOG("Tracing in the world: %.3f ms total, %.3f us per explosion", ReferenceMs, ReferenceMs * 1000 / NumExplosions);
+	LOG("Tracing in the area:  %.3f ms total, %.3f us per explosion", AreaMs, AreaMs * 1000 / NumExplosions);
+}
+
+
+
+
+
+static void testEnclosedExplosion()
+{
+	// An explosion inside a bedrock box must not destroy anything, not even the bedrock:
+	const Vector3i Centre(100, 100, 100);
+	cBlastArea Area(Centre, cBlastArea::GetRadiusForPower(TNT_POWER));
+	const auto Min = Area.GetMinPos();
+	const auto Max = Area.GetMaxPos();
+	for (int y = Min.y; y <= Max.y; y++) for (int z = Min.z; z <= Max.z; z++) for (int x = Min.x; x <= Max.x; x++)
+	{
+		const auto IsWall = (std::abs(x - Centre.x) == 2) || (std::abs(y - Centre.y) == 2) || (std::abs(z - Centre.z) == 2);
+		const auto IsInside = (std::abs(x - Centre.x) <= 2) && (std::abs(y - Centre.y) <= 2) && (std::abs(z - Centre.z) <= 2);
+		Area.SetBlock({x, y, z}, (IsWall && IsInside) ? E_BLOCK_BEDROCK : (IsInside ? E_BLOCK_AIR : E_BLOCK_STONE));
+	}
+	MTRand Random;
+	const Vector3f Position(Vector3f(Centre) + Vector3f(0.5f, 0.5f, 0.5f));
+	TEST_EQUAL(Area.TraceDestruction(Position, TNT_POWER, Random).size(), 0U);
+
+	// Entities inside the box are fully exposed, entities outside are fully shielded:
+	const double SquareRadius = 4 * TNT_POWER * TNT_POWER;
+	TEST_EQUAL(Area.CalculateExposure(Position, cBoundingBox(Vector3d(Centre) + Vector3d(0.5, 0, 0.5), 0.3, 1), SquareRadius), 1.0f);
+	TEST_EQUAL(Area.CalculateExposure(Position, cBoundingBox(Vector3d(Centre) + Vector3d(4.5, 0, 0.5), 0.3, 1), SquareRadius), 0.0f);
+}
+
+
+
+
+
+static void testOpenExplosion()
+{
+	// An explosion in the air destroys nothing and exposes everything in range:
+	const Vector3i Centre(-50, 200, 30);
+	cBlastArea Area(Centre, cBlastArea::GetRadiusForPower(TNT_POWER));
+	const auto Min = Area.GetMinPos();
+	const auto Max = Area.GetMaxPos();
+	for (int z = Min.z; z <= Max.z; z++) for (int x = Min.x; x <= Max.x; x++)
+	{
+		Area.SetBlock({x, Min.y, z}, E_BLOCK_AIR);
+	}
+	MTRand Random;
+	const Vector3f Position(Vector3f(Centre) + Vector3f(0.5f, 0.5f, 0.5f));
+	TEST_EQUAL(Area.TraceDestruction(Position, TNT_POWER, Random).size(), 0U);
+	TEST_EQUAL(Area.CalculateExposure(Position, cBoundingBox(Vector3d(Centre) + Vector3d(-3.5, 0, 2.5), 0.3, 1.8), 4 * TNT_POWER * TNT_POWER), 1.0f);
+
+	// Columns without data stop the rays, as chunks that aren't loaded:
+	cBlastArea Empty(Centre, cBlastArea::GetRadiusForPower(TNT_POWER));
+	TEST_EQUAL(Empty.CalculateExposure(Position, cBoundingBox(Vector3d(Centre) + Vector3d(-3.5, 0, 2.5), 0.3, 1.8), 4 * TNT_POWER * TNT_POWER), 0.0f);
+}
+
+
+
+
+
+static void testHugePower()
+{
+	// Plugins may ask for any power, the area must stay bounded:
+	const auto Radius = cBlastArea::GetRadiusForPower(std::numeric_limits<int>::max());
+	TEST_LESS_THAN_OR_EQUAL(Radius, 64);
+	TEST_EQUAL(cBlastArea::GetRadiusForPower(std::numeric_limits<int>::max()), cBlastArea::GetRadiusForPower(1000));
+	TEST_EQUAL(cBlastArea::GetRadiusForPower(-5), 0);
+
+	const Vector3i Centre(0, 64, 0);
+	cBlastArea Area(Centre, 1000000);
+	TEST_EQUAL(Area.GetMaxPos().x - Area.GetMinPos().x, 2 * Radius);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("BlastAreaBenchmark",
+	testEnclosedExplosion();
+	testOpenExplosion();
+	testHugePower();
+	testDestructionMatchesWorld();
+)
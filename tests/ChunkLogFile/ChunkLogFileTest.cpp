@@ -0,0 +1,267 @@
+
+// ChunkLogFileTest.cpp
+
+// Tests the storing, the crash recovery and the compaction of the cChunkLogFile class,
+// and compares the file size to the sectors that the Anvil region files would use for the same data
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "WorldStorage/ChunkLogFile.h"
+
+#include <filesystem>
+
+
+
+
+
+/** The file used by the tests, in the current folder. */
+static const char TEST_FILE_NAME[] = "ChunkLogFileTest.cwl";
+
+/** The size of the data stored by the tests. */
+static const size_t DATA_SIZE = 10000;
+
+/** The size of the header that the file stores before the data of each record. */
+static const size_t RECORD_HEADER_SIZE = 28;
+
+
+
+
+
+/** Returns the data of the specified size, all set to the specified value. */
+static ContiguousByteBuffer MakeData(unsigned char a_Value, size_t a_Size = DATA_SIZE)
+{
+	return ContiguousByteBuffer(a_Size, static_cast<std::byte>(a_Value));
+}
+
+
+
+
+
+/** Returns true if the file has the chunk with data made by MakeData(a_Value). */
+static bool HasData(cChunkLogFile & a_File, cChunkCoords a_Chunk, unsigned char a_Value)
+{
+	ContiguousByteBuffer Data;
+	return a_File.GetChunkData(a_Chunk, Data) && (Data == MakeData(a_Value));
+}
+
+
+
+
+
+/** Tests that stored data is loaded back, both from the same object and after reopening the file. */
+static void TestStoreLoad()
+{
+	cFile::DeleteFile(TEST_FILE_NAME);
+	{
+		cChunkLogFile File(TEST_FILE_NAME);
+		TEST_FALSE(File.Open(false));
+		TEST_TRUE(File.Open(true));
+		TEST_TRUE(File.SetChunkData({0, 0}, MakeData(1), 100));
+		TEST_TRUE(File.SetChunkData({-1, 5}, MakeData(2), 101));
+		TEST_TRUE(File.SetChunkData({0, 0}, MakeData(3), 102));
+		TEST_TRUE(HasData(File, {0, 0}, 3));
+		TEST_TRUE(HasData(File, {-1, 5}, 2));
+
+		ContiguousByteBuffer Data;
+		TEST_FALSE(File.GetChunkData({5, -1}, Data));
+		TEST_EQUAL(File.GetFileSize(), 8 + 3 * (RECORD_HEADER_SIZE + DATA_SIZE));
+		TEST_EQUAL(File.GetLiveSize(), 8 + 2 * (RECORD_HEADER_SIZE + DATA_SIZE));
+	}
+
+	// The index is rebuilt from the file:
+	cChunkLogFile File(TEST_FILE_NAME);
+	TEST_TRUE(File.Open(false));
+	TEST_TRUE(HasData(File, {0, 0}, 3));
+	TEST_TRUE(HasData(File, {-1, 5}, 2));
+	UInt32 TimeStamp = 0;
+	TEST_TRUE(File.GetTimeStamp({0, 0}, TimeStamp));
+	TEST_EQUAL(TimeStamp, 102);
+	TEST_FALSE(File.GetTimeStamp({5, -1}, TimeStamp));
+	TEST_EQUAL(File.GetLiveSize(), 8 + 2 * (RECORD_HEADER_SIZE + DATA_SIZE));
+}
+
+
+
+
+
+/** Tests that an incomplete last record, as left by a crash while saving, is ignored and overwritten. */
+static void TestIncompleteRecord()
+{
+	cFile::DeleteFile(TEST_FILE_NAME);
+	{
+		cChunkLogFile File(TEST_FILE_NAME);
+		TEST_TRUE(File.Open(true));
+		TEST_TRUE(File.SetChunkData({0, 0}, MakeData(1), 100));
+		TEST_TRUE(File.SetChunkData({1, 0}, MakeData(2), 100));
+		TEST_TRUE(File.SetChunkData({2, 0}, MakeData(3), 100));
+	}
+
+	// Cut the last record short, as if the server crashed while writing it:
+	std::filesystem::resize_file(TEST_FILE_NAME, 8 + 2 * (RECORD_HEADER_SIZE + DATA_SIZE) + RECORD_HEADER_SIZE + 100);
+	{
+		cChunkLogFile File(TEST_FILE_NAME);
+		TEST_TRUE(File.Open(false));
+		TEST_TRUE(HasData(File, {0, 0}, 1));
+		TEST_TRUE(HasData(File, {1, 0}, 2));
+		ContiguousByteBuffer Data;
+		TEST_FALSE(File.GetChunkData({2, 0}, Data));
+		TEST_EQUAL(File.GetFileSize(), 8 + 2 * (RECORD_HEADER_SIZE + DATA_SIZE));
+		TEST_TRUE(File.SetChunkData({2, 0}, MakeData(4), 100));
+	}
+
+	cChunkLogFile File(TEST_FILE_NAME);
+	TEST_TRUE(File.Open(false));
+	TEST_TRUE(HasData(File, {0, 0}, 1));
+	TEST_TRUE(HasData(File, {1, 0}, 2));
+	TEST_TRUE(HasData(File, {2, 0}, 4));
+}
+
+
+
+
+
+/** Tests that a record whose data doesn't match its checksum is ignored, without losing the records after it. */
+static void TestCorruptedRecord()
+{
+	cFile::DeleteFile(TEST_FILE_NAME);
+	{
+		cChunkLogFile File(TEST_FILE_NAME);
+		TEST_TRUE(File.Open(true));
+		TEST_TRUE(File.SetChunkData({0, 0}, MakeData(1), 100));
+		TEST_TRUE(File.SetChunkData({1, 0}, MakeData(2), 100));
+	}
+	{
+		// Overwrite a byte in the middle of the first record's data:
+		cFile Raw(TEST_FILE_NAME, cFile::fmReadWrite);
+		const std::byte Garbage[1] = {std::byte(0xff)};
+		Raw.Seek(8 + RECORD_HEADER_SIZE + 100);
+		TEST_EQUAL(Raw.Write(Garbage, sizeof(Garbage)), 1);
+	}
+
+	cChunkLogFile File(TEST_FILE_NAME);
+	TEST_TRUE(File.Open(false));
+	ContiguousByteBuffer Data;
+	TEST_FALSE(File.GetChunkData({0, 0}, Data));
+	TEST_TRUE(HasData(File, {1, 0}, 2));
+	TEST_EQUAL(File.GetFileSize(), 8 + 2 * (RECORD_HEADER_SIZE + DATA_SIZE));
+}
+
+
+
+
+
+/** Tests that a record with a damaged header is skipped by scanning for the next valid record,
+and that the records after it are neither lost nor overwritten by the next save. */
+static void TestCorruptedHeader()
+{
+	cFile::DeleteFile(TEST_FILE_NAME);
+	{
+		cChunkLogFile File(TEST_FILE_NAME);
+		TEST_TRUE(File.Open(true));
+		TEST_TRUE(File.SetChunkData({0, 0}, MakeData(1), 100));
+		TEST_TRUE(File.SetChunkData({1, 0}, MakeData(2), 100));
+		TEST_TRUE(File.SetChunkData({2, 0}, MakeData(3), 100));
+	}
+	{
+		// Overwrite the data size in the second record's header, so that it points past the end of the file:
+		cFile Raw(TEST_FILE_NAME, cFile::fmReadWrite);
+		const std::byte Garbage[1] = {std::byte(0x7f)};
+		Raw.Seek(static_cast<int>(8 + RECORD_HEADER_SIZE + DATA_SIZE + 16));
+		TEST_EQUAL(Raw.Write(Garbage, sizeof(Garbage)), 1);
+	}
+	{
+		cChunkLogFile File(TEST_FILE_NAME);
+		TEST_TRUE(File.Open(false));
+		TEST_TRUE(HasData(File, {0, 0}, 1));
+		ContiguousByteBuffer Data;
+		TEST_FALSE(File.GetChunkData({1, 0}, Data));
+		TEST_TRUE(HasData(File, {2, 0}, 3));
+		TEST_EQUAL(File.GetFileSize(), 8 + 3 * (RECORD_HEADER_SIZE + DATA_SIZE));
+		TEST_TRUE(File.SetChunkData({3, 0}, MakeData(4), 100));
+	}
+
+	cChunkLogFile File(TEST_FILE_NAME);
+	TEST_TRUE(File.Open(false));
+	TEST_TRUE(HasData(File, {0, 0}, 1));
+	TEST_TRUE(HasData(File, {2, 0}, 3));
+	TEST_TRUE(HasData(File, {3, 0}, 4));
+}
+
+
+
+
+
+/** Tests that the file is compacted once the old versions of the chunks take up more than half of it. */
+static void TestCompaction()
+{
+	cFile::DeleteFile(TEST_FILE_NAME);
+	cChunkLogFile File(TEST_FILE_NAME);
+	TEST_TRUE(File.Open(true));
+	TEST_TRUE(File.SetChunkData({7, 7}, MakeData(7), 100));
+
+	// Save the same chunk over and over, the file compacts itself when needed:
+	size_t MaxFileSize = 0;
+	for (int i = 0; i < 300; i++)
+	{
+		TEST_TRUE(File.SetChunkData({0, 0}, MakeData(static_cast<unsigned char>(i)), 100));
+		TEST_TRUE(File.CompactIfNeeded());
+		MaxFileSize = std::max(MaxFileSize, File.GetFileSize());
+	}
+	TEST_LESS_THAN_OR_EQUAL(MaxFileSize, 1 MiB + RECORD_HEADER_SIZE + DATA_SIZE);
+	TEST_TRUE(HasData(File, {0, 0}, 299 % 256));
+	TEST_TRUE(HasData(File, {7, 7}, 7));
+
+	TEST_TRUE(File.Compact());
+	TEST_EQUAL(File.GetFileSize(), 8 + 2 * (RECORD_HEADER_SIZE + DATA_SIZE));
+	TEST_EQUAL(File.GetFileSize(), File.GetLiveSize());
+	TEST_EQUAL(cFile::GetSize(TEST_FILE_NAME), static_cast<long>(File.GetFileSize()));
+	TEST_FALSE(cFile::Exists(AString(TEST_FILE_NAME) + ".tmp"));
+
+	// The compacted file is still usable and reopens fine:
+	TEST_TRUE(File.SetChunkData({1, 1}, MakeData(1), 100));
+	File.Close();
+	cChunkLogFile Reopened(TEST_FILE_NAME);
+	TEST_TRUE(Reopened.Open(false));
+	TEST_TRUE(HasData(Reopened, {0, 0}, 299 % 256));
+	TEST_TRUE(HasData(Reopened, {7, 7}, 7));
+	TEST_TRUE(HasData(Reopened, {1, 1}, 1));
+}
+
+
+
+
+
+/** Stores chunks of the sizes typical for compressed chunks and logs the file size,
+compared to the size of a region file holding the same chunks in 4 KiB sectors. */
+static void CompareSizeToAnvil()
+{
+	cFile::DeleteFile(TEST_FILE_NAME);
+	cChunkLogFile File(TEST_FILE_NAME);
+	TEST_TRUE(File.Open(true));
+	size_t AnvilSize = 8 KiB;  // The region file header
+	for (int i = 0; i < 1024; i++)
+	{
+		// Deterministic sizes between 1 KiB and 21 KiB:
+		const auto Size = 1 KiB + static_cast<size_t>((i * 7919) % 20480);
+		TEST_TRUE(File.SetChunkData({i % 32, i / 32}, MakeData(0, Size), 100));
+		AnvilSize += (Size + 5 + 4 KiB - 1) / (4 KiB) * (4 KiB);
+	}
+	TEST_LESS_THAN_OR_EQUAL(File.GetFileSize(), AnvilSize);
+	LOG("1024 chunks: %zu KiB in the log file, %zu KiB in a region file (%.1f %%)",
+		File.GetFileSize() / 1024, AnvilSize / 1024, 100.0 * static_cast<double>(File.GetFileSize()) / static_cast<double>(AnvilSize)
+	);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ChunkLogFile",
+	TestStoreLoad();
+	TestIncompleteRecord();
+	TestCorruptedRecord();
+	TestCorruptedHeader();
+	TestCompaction();
+	CompareSizeToAnvil();
+	cFile::DeleteFile(TEST_FILE_NAME);
+)
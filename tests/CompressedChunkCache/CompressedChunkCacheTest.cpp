@@ -0,0 +1,143 @@
+
+// CompressedChunkCacheTest.cpp
+
+// Tests the LRU eviction and the memory budget of the cCompressedChunkCache class
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "WorldStorage/CompressedChunkCache.h"
+
+
+
+
+
+/** The size of the data stored by the tests; large enough for the per-entry overhead not to matter. */
+static const size_t DATA_SIZE = 10000;
+
+/** A budget that fits three entries of DATA_SIZE, but not four. */
+static const size_t BUDGET_FOR_THREE = 3 * DATA_SIZE + 600;
+
+
+
+
+
+/** Returns DATA_SIZE bytes of data, all set to the specified value. */
+static ContiguousByteBuffer MakeData(unsigned char a_Value)
+{
+	return ContiguousByteBuffer(DATA_SIZE, static_cast<std::byte>(a_Value));
+}
+
+
+
+
+
+/** Returns true if the chunk is cached with data made by MakeData(a_Value). */
+static bool HasData(cCompressedChunkCache & a_Cache, cChunkCoords a_Chunk, unsigned char a_Value)
+{
+	ContiguousByteBuffer Data;
+	return a_Cache.Retrieve(a_Chunk, Data) && (Data == MakeData(a_Value));
+}
+
+
+
+
+
+/** Tests that stored data is retrieved, replaced and removed. */
+static void TestStoreRetrieve()
+{
+	cCompressedChunkCache Cache;
+	Cache.SetMaxBytes(BUDGET_FOR_THREE);
+	Cache.Store({0, 0}, MakeData(1));
+	Cache.Store({-1, 5}, MakeData(2));
+	TEST_TRUE(HasData(Cache, {0, 0}, 1));
+	TEST_TRUE(HasData(Cache, {-1, 5}, 2));
+
+	ContiguousByteBuffer Data;
+	TEST_FALSE(Cache.Retrieve({5, -1}, Data));
+
+	// Replacing the data doesn't count the old data against the budget:
+	Cache.Store({0, 0}, MakeData(3));
+	TEST_TRUE(HasData(Cache, {0, 0}, 3));
+	TEST_EQUAL(Cache.GetStats().m_NumEntries, 2);
+
+	Cache.Remove({0, 0});
+	TEST_FALSE(Cache.Retrieve({0, 0}, Data));
+
+	const auto Stats = Cache.GetStats();
+	TEST_EQUAL(Stats.m_NumEntries, 1);
+	TEST_EQUAL(Stats.m_NumHits, 3);
+	TEST_EQUAL(Stats.m_NumMisses, 2);
+	TEST_EQUAL(Stats.m_NumEvictions, 0);
+}
+
+
+
+
+
+/** Tests that the least recently used entries are evicted to keep within the budget. */
+static void TestEviction()
+{
+	cCompressedChunkCache Cache;
+	Cache.SetMaxBytes(BUDGET_FOR_THREE);
+	Cache.Store({0, 0}, MakeData(0));
+	Cache.Store({1, 0}, MakeData(1));
+	Cache.Store({2, 0}, MakeData(2));
+
+	// Use the oldest two, so that {2, 0} becomes the least recently used:
+	TEST_TRUE(HasData(Cache, {0, 0}, 0));
+	Cache.Touch({1, 0});
+
+	Cache.Store({3, 0}, MakeData(3));
+	ContiguousByteBuffer Data;
+	TEST_FALSE(Cache.Retrieve({2, 0}, Data));
+	TEST_TRUE(HasData(Cache, {0, 0}, 0));
+	TEST_TRUE(HasData(Cache, {1, 0}, 1));
+	TEST_TRUE(HasData(Cache, {3, 0}, 3));
+
+	auto Stats = Cache.GetStats();
+	TEST_EQUAL(Stats.m_NumEntries, 3);
+	TEST_EQUAL(Stats.m_NumEvictions, 1);
+	TEST_LESS_THAN_OR_EQUAL(Stats.m_NumBytes, Stats.m_MaxBytes);
+
+	// Shrinking the budget evicts right away, the least recently used first:
+	Cache.SetMaxBytes(BUDGET_FOR_THREE / 3);
+	Stats = Cache.GetStats();
+	TEST_EQUAL(Stats.m_NumEntries, 1);
+	TEST_LESS_THAN_OR_EQUAL(Stats.m_NumBytes, Stats.m_MaxBytes);
+	TEST_TRUE(HasData(Cache, {3, 0}, 3));
+}
+
+
+
+
+
+/** Tests that data larger than the whole budget is not stored and that a zero budget disables the cache. */
+static void TestLimits()
+{
+	cCompressedChunkCache Cache;
+	Cache.Store({0, 0}, MakeData(0));
+	TEST_EQUAL(Cache.GetStats().m_NumEntries, 0);
+
+	Cache.SetMaxBytes(DATA_SIZE / 2);
+	Cache.Store({0, 0}, MakeData(0));
+	TEST_EQUAL(Cache.GetStats().m_NumEntries, 0);
+	TEST_EQUAL(Cache.GetStats().m_NumBytes, 0);
+
+	// Data too large replaces the old data, which is outdated by then:
+	Cache.SetMaxBytes(BUDGET_FOR_THREE);
+	Cache.Store({0, 0}, MakeData(1));
+	Cache.SetMaxBytes(DATA_SIZE + DATA_SIZE / 2);
+	Cache.Store({0, 0}, ContiguousByteBuffer(2 * DATA_SIZE, std::byte(2)));
+	ContiguousByteBuffer Data;
+	TEST_FALSE(Cache.Retrieve({0, 0}, Data));
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("CompressedChunkCache",
+	TestStoreRetrieve();
+	TestEviction();
+	TestLimits();
+)
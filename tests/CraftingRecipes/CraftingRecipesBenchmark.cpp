@@ -0,0 +1,234 @@
+
+// CraftingRecipesBenchmark.cpp
+
+// Checks that the indexed recipe lookup finds the same recipes as a full linear search over crafting.txt,
+// and measures the speed of the linear, indexed and memoized lookups
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "CraftingRecipes.h"
+
+
+
+
+
+/** Number of times each grid is looked up when measuring the speed. */
+static const int NUM_ROUNDS = 20;
+
+
+
+
+
+/** Exposes the internals of cCraftingRecipes for testing. */
+class cCraftingRecipesTest:
+	public cCraftingRecipes
+{
+public:
+
+	using cCraftingRecipes::FindRecipe;
+	using cCraftingRecipes::FindRecipeMemoized;
+
+
+	/** Returns the number of loaded recipes. */
+	size_t GetNumRecipes(void) const
+	{
+		return m_Recipes.size();
+	}
+
+
+	/** Fills a_Grid (3x3) with the ingredients of the specified recipe.
+	Returns false if the "anywhere" ingredients couldn't be placed. */
+	bool FillGridForRecipe(size_t a_RecipeIdx, cItem * a_Grid) const
+	{
+		for (int i = 0; i < MAX_GRID_WIDTH * MAX_GRID_HEIGHT; i++)
+		{
+			a_Grid[i].Empty();
+		}
+		const auto & Ingredients = m_Recipes[a_RecipeIdx]->m_Ingredients;
+
+		// Regular ingredients first, so that the "anywhere" ones take the remaining cells:
+		for (const auto & Slot: Ingredients)
+		{
+			if ((Slot.x >= 0) && (Slot.y >= 0))
+			{
+				PlaceItem(Slot.m_Item, a_Grid[Slot.x + MAX_GRID_WIDTH * Slot.y]);
+			}
+		}
+		for (const auto & Slot: Ingredients)
+		{
+			if ((Slot.x >= 0) && (Slot.y >= 0))
+			{
+				continue;
+			}
+			bool HasPlaced = false;
+			for (int y = 0; (y < MAX_GRID_HEIGHT) && !HasPlaced; y++) for (int x = 0; x < MAX_GRID_WIDTH; x++)
+			{
+				if (((Slot.x >= 0) && (Slot.x != x)) || ((Slot.y >= 0) && (Slot.y != y)) || !a_Grid[x + MAX_GRID_WIDTH * y].IsEmpty())
+				{
+					continue;
+				}
+				PlaceItem(Slot.m_Item, a_Grid[x + MAX_GRID_WIDTH * y]);
+				HasPlaced = true;
+				break;
+			}
+			if (!HasPlaced)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	/** Finds the recipe by trying all the recipes in order, the way the lookup worked before the index was added.
+	Returns the index of the first matching recipe, or -1 if none. */
+	int FindRecipeLinear(const cItem * a_Grid)
+	{
+		for (size_t i = 0; i < m_Recipes.size(); i++)
+		{
+			const auto Recipe = m_Recipes[i];
+			for (int y = 0; y <= MAX_GRID_HEIGHT - Recipe->m_Height; y++) for (int x = 0; x <= MAX_GRID_WIDTH - Recipe->m_Width; x++)
+			{
+				std::unique_ptr<cRecipe> Match(MatchRecipe(a_Grid, MAX_GRID_WIDTH, MAX_GRID_HEIGHT, MAX_GRID_WIDTH, Recipe, x, y));
+				if (Match != nullptr)
+				{
+					return static_cast<int>(i);
+				}
+			}
+		}
+		return -1;
+	}
+
+
+	/** Returns the result item of the specified recipe. */
+	const cItem & GetResult(size_t a_RecipeIdx) const
+	{
+		return m_Recipes[a_RecipeIdx]->m_Result;
+	}
+
+protected:
+
+	/** Places a full stack of the ingredient into the grid cell. */
+	static void PlaceItem(const cItem & a_Ingredient, cItem & a_Cell)
+	{
+		a_Cell = a_Ingredient;
+		a_Cell.m_ItemCount = 64;
+		if (a_Cell.m_ItemDamage < 0)
+		{
+			a_Cell.m_ItemDamage = 0;
+		}
+	}
+};
+
+
+
+
+
+/** Measures the time it takes to call a_Lookup NUM_ROUNDS times for each grid, in milliseconds.
+a_Lookup receives the grid's index and the grid itself. */
+template <typename LookupFn>
+static double MeasureLookups(const std::vector<std::vector<cItem>> & a_Grids, LookupFn a_Lookup)
+{
+	auto Start = std::chrono::steady_clock::now();
+	for (int Round = 0; Round < NUM_ROUNDS; Round++)
+	{
+		for (size_t i = 0; i < a_Grids.size(); i++)
+		{
+			a_Lookup(i, a_Grids[i].data());
+		}
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+}
+
+
+
+
+
+static void testAllRecipes()
+{
+	cCraftingRecipesTest Recipes;
+	LOG("Loaded %zu recipes", Recipes.GetNumRecipes());
+	TEST_GREATER_THAN_OR_EQUAL(Recipes.GetNumRecipes(), 100U);
+
+	// Build a grid for each recipe and check that the indexed lookup agrees with the linear search:
+	std::vector<std::vector<cItem>> Grids;
+	for (size_t i = 0; i < Recipes.GetNumRecipes(); i++)
+	{
+		std::vector<cItem> Grid(cCraftingRecipes::MAX_GRID_WIDTH * cCraftingRecipes::MAX_GRID_HEIGHT);
+		if (!Recipes.FillGridForRecipe(i, Grid.data()))
+		{
+			continue;
+		}
+		auto Expected = Recipes.FindRecipeLinear(Grid.data());
+		TEST_NOTEQUAL(Expected, -1);
+		std::unique_ptr<cCraftingRecipes::cRecipe> Indexed(Recipes.FindRecipe(Grid.data(), cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT));
+		TEST_NOTEQUAL(Indexed, nullptr);
+		TEST_EQUAL(Indexed->m_Result.m_ItemType, Recipes.GetResult(static_cast<size_t>(Expected)).m_ItemType);
+		TEST_EQUAL(Indexed->m_Result.m_ItemDamage, Recipes.GetResult(static_cast<size_t>(Expected)).m_ItemDamage);
+		TEST_EQUAL(Indexed->m_Result.m_ItemCount, Recipes.GetResult(static_cast<size_t>(Expected)).m_ItemCount);
+		Grids.push_back(std::move(Grid));
+	}
+	LOG("Checked %zu recipe grids", Grids.size());
+
+	// A grid matching no recipe:
+	{
+		std::vector<cItem> Grid(cCraftingRecipes::MAX_GRID_WIDTH * cCraftingRecipes::MAX_GRID_HEIGHT);
+		Grid[0] = cItem(E_BLOCK_BEDROCK, 1);
+		Grid[4] = cItem(E_BLOCK_BEDROCK, 1);
+		TEST_EQUAL(Recipes.FindRecipeLinear(Grid.data()), -1);
+		std::unique_ptr<cCraftingRecipes::cRecipe> Indexed(Recipes.FindRecipe(Grid.data(), cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT));
+		TEST_EQUAL(Indexed, nullptr);
+		std::unique_ptr<cCraftingRecipes::cRecipe> Memoized(Recipes.FindRecipeMemoized(1, Grid.data(), cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT));
+		TEST_EQUAL(Memoized, nullptr);
+		Memoized.reset(Recipes.FindRecipeMemoized(1, Grid.data(), cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT));
+		TEST_EQUAL(Memoized, nullptr);
+	}
+
+	// The memoized lookup must return the same recipe on a repeated lookup, even with fewer items in the grid (shift-crafting):
+	for (auto & Grid: Grids)
+	{
+		std::unique_ptr<cCraftingRecipes::cRecipe> First(Recipes.FindRecipeMemoized(1, Grid.data(), cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT));
+		for (auto & Item: Grid)
+		{
+			if (!Item.IsEmpty())
+			{
+				Item.m_ItemCount = 63;
+			}
+		}
+		std::unique_ptr<cCraftingRecipes::cRecipe> Second(Recipes.FindRecipeMemoized(1, Grid.data(), cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT));
+		TEST_NOTEQUAL(First, nullptr);
+		TEST_NOTEQUAL(Second, nullptr);
+		TEST_EQUAL(First->m_Result.m_ItemType, Second->m_Result.m_ItemType);
+		TEST_EQUAL(First->m_Ingredients.size(), Second->m_Ingredients.size());
+	}
+
+	// Measure the speed of the lookups:
+	auto LinearMs = MeasureLookups(Grids, [&Recipes](size_t a_Index, const cItem * a_Grid)
+		{
+			Recipes.FindRecipeLinear(a_Grid);
+		}
+	);
+	auto IndexedMs = MeasureLookups(Grids, [&Recipes](size_t a_Index, const cItem * a_Grid)
+		{
+			delete Recipes.FindRecipe(a_Grid, cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT);
+		}
+	);
+	auto MemoizedMs = MeasureLookups(Grids, [&Recipes](size_t a_Index, const cItem * a_Grid)
+		{
+			// Each grid gets its own "player", so that the repeated lookups hit the memo:
+			delete Recipes.FindRecipeMemoized(static_cast<UInt32>(a_Index), a_Grid, cCraftingRecipes::MAX_GRID_WIDTH, cCraftingRecipes::MAX_GRID_HEIGHT);
+		}
+	);
+	auto NumLookups = static_cast<double>(Grids.size()) * NUM_ROUNDS;
+	LOG("Linear lookup:   %.3f ms total, %.3f us per lookup", LinearMs, LinearMs * 1000 / NumLookups);
+	LOG("Indexed lookup:  %.3f ms total, %.3f us per lookup", IndexedMs, IndexedMs * 1000 / NumLookups);
+	LOG("Memoized lookup: %.3f ms total, %.3f us per lookup", MemoizedMs, MemoizedMs * 1000 / NumLookups);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("CraftingRecipesBenchmark",
+	testAllRecipes();
+)
@@ -0,0 +1,541 @@
+
+// FastNBTBenchmark.cpp
+
+// Checks that parsing with lazy tags and the hashed child lookups give the same results as a full parse with linear lookups,
+// and measures the speed of loading chunk NBTs, either generated ones or the chunks from the region files given on the command line,
+// and the speed of writing the generated chunks
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "StringCompression.h"
+#include "WorldStorage/FastNBT.h"
+#include "WorldStorage/WSSAnvil.h"
+
+
+
+
+
+/** Number of entities, block entities and tile ticks in each generated chunk; a busy farm chunk. */
+static const int NUM_ENTITIES = 150;
+static const int NUM_BLOCK_ENTITIES = 60;
+static const int NUM_TILE_TICKS = 1000;
+
+/** Number of chunks generated when no region files are given. */
+static const int NUM_GENERATED_CHUNKS = 20;
+
+/** Number of times each chunk is loaded in the timed runs. */
+static const int NUM_REPETITIONS = 20;
+
+
+
+
+
+/** Writes a list of doubles. */
+static void AddDoubles(cFastNBTWriter & a_Writer, const AString & a_Name, std::initializer_list<double> a_Values)
+{
+	a_Writer.BeginList(a_Name, TAG_Double);
+	for (const auto Value: a_Values)
+	{
+		a_Writer.AddDouble("", Value);
+	}
+	a_Writer.EndList();
+}
+
+
+
+
+
+/** Writes an item compound, as Vanilla does. */
+static void AddItem(cFastNBTWriter & a_Writer, int a_Slot, const AString & a_ID, unsigned char a_Count)
+{
+	a_Writer.BeginCompound("");
+	if (a_Slot >= 0)
+	{
+		a_Writer.AddByte("Slot", static_cast<unsigned char>(a_Slot));
+	}
+	a_Writer.AddString("id", a_ID);
+	a_Writer.AddByte("Count", a_Count);
+	a_Writer.AddShort("Damage", 0);
+	a_Writer.EndCompound();
+}
+
+
+
+
+
+/** Writes a mob, with all the tags that Vanilla writes for a mob. */
+static void AddMob(cFastNBTWriter & a_Writer, int a_Index)
+{
+	a_Writer.BeginCompound("");
+	a_Writer.AddString("id", "minecraft:cow");
+	AddDoubles(a_Writer, "Pos", {a_Index % 16 + 0.5, 64, a_Index / 16 + 0.5});
+	AddDoubles(a_Writer, "Motion", {0, -0.0784, 0});
+	a_Writer.BeginList("Rotation", TAG_Float);
+	a_Writer.AddFloat("", 90);
+	a_Writer.AddFloat("", 0);
+	a_Writer.EndList();
+	a_Writer.AddFloat("FallDistance", 0);
+	a_Writer.AddShort("Fire", -1);
+	a_Writer.AddShort("Air", 300);
+	a_Writer.AddByte("OnGround", 1);
+	a_Writer.AddByte("NoGravity", 0);
+	a_Writer.AddByte("Invulnerable", 0);
+	a_Writer.AddInt("PortalCooldown", 0);
+	a_Writer.AddLong("UUIDMost", a_Index);
+	a_Writer.AddLong("UUIDLeast", -a_Index);
+	a_Writer.AddFloat("Health", 10);
+	a_Writer.AddFloat("AbsorptionAmount", 0);
+	a_Writer.AddShort("HurtTime", 0);
+	a_Writer.AddInt("HurtByTimestamp", 0);
+	a_Writer.AddShort("DeathTime", 0);
+	a_Writer.AddByte("FallFlying", 0);
+	a_Writer.AddByte("CanPickUpLoot", 0);
+	a_Writer.AddByte("PersistenceRequired", 0);
+	a_Writer.AddByte("LeftHanded", 0);
+	a_Writer.AddInt("Age", a_Index - NUM_ENTITIES / 2);
+	a_Writer.AddInt("InLove", 0);
+	a_Writer.BeginList("Attributes", TAG_Compound);
+	for (const auto & Name: {"generic.maxHealth", "generic.knockbackResistance", "generic.movementSpeed", "generic.armor", "generic.armorToughness", "generic.followRange"})
+	{
+		a_Writer.BeginCompound("");
+		a_Writer.AddString("Name", Name);
+		a_Writer.AddDouble("Base", 1);
+		a_Writer.BeginList("Modifiers", TAG_Compound);
+		a_Writer.BeginCompound("");
+		a_Writer.AddString("Name", "Random spawn bonus");
+		a_Writer.AddDouble("Amount", 0.05);
+		a_Writer.AddInt("Operation", 1);
+		a_Writer.EndCompound();
+		a_Writer.EndList();
+		a_Writer.EndCompound();
+	}
+	a_Writer.EndList();
+	a_Writer.BeginList("ArmorItems", TAG_Compound);
+	for (int i = 0; i < 4; i++)
+	{
+		a_Writer.BeginCompound("");
+		a_Writer.EndCompound();
+	}
+	a_Writer.EndList();
+	a_Writer.BeginList("HandItems", TAG_Compound);
+	for (int i = 0; i < 2; i++)
+	{
+		a_Writer.BeginCompound("");
+		a_Writer.EndCompound();
+	}
+	a_Writer.EndList();
+	a_Writer.BeginList("ArmorDropChances", TAG_Float);
+	for (int i = 0; i < 4; i++)
+	{
+		a_Writer.AddFloat("", 0.085f);
+	}
+	a_Writer.EndList();
+	a_Writer.BeginList("HandDropChances", TAG_Float);
+	for (int i = 0; i < 2; i++)
+	{
+		a_Writer.AddFloat("", 0.085f);
+	}
+	a_Writer.EndList();
+	a_Writer.EndCompound();
+}
+
+
+
+
+
+/** Returns the NBT of a generated chunk, laid out the way Vanilla saves chunks. */
+static ContiguousByteBuffer GenerateChunk(int a_ChunkX)
+{
+	cFastNBTWriter Writer;
+	Writer.AddInt("DataVersion", 1343);
+	Writer.BeginCompound("Level");
+	Writer.AddInt("xPos", a_ChunkX);
+	Writer.AddInt("zPos", 0);
+	Writer.AddLong("LastUpdate", 123456);
+	Writer.AddLong("InhabitedTime", 654321);
+	Writer.AddByte("TerrainPopulated", 1);
+	Writer.AddByte("LightPopulated", 1);
+
+	Writer.BeginList("Sections", TAG_Compound);
+	for (int y = 0; y < 16; y++)
+	{
+		Writer.BeginCompound("");
+		Writer.AddByte("Y", static_cast<unsigned char>(y));
+		Writer.AddByteArray("Blocks", 4096, static_cast<unsigned char>(y + a_ChunkX));
+		Writer.AddByteArray("Data", 2048, 0);
+		Writer.AddByteArray("BlockLight", 2048, 0);
+		Writer.AddByteArray("SkyLight", 2048, 0xff);
+		Writer.EndCompound();
+	}
+	Writer.EndList();
+
+	Writer.AddByteArray("Biomes", 256, 1);
+	Int32 HeightMap[256];
+	std::fill(std::begin(HeightMap), std::end(HeightMap), 64);
+	Writer.AddIntArray("HeightMap", HeightMap, ARRAYCOUNT(HeightMap));
+
+	Writer.BeginList("Entities", TAG_Compound);
+	for (int i = 0; i < NUM_ENTITIES; i++)
+	{
+		AddMob(Writer, i);
+	}
+	Writer.EndList();
+
+	Writer.BeginList("TileEntities", TAG_Compound);
+	for (int i = 0; i < NUM_BLOCK_ENTITIES; i++)
+	{
+		Writer.BeginCompound("");
+		Writer.AddString("id", "minecraft:chest");
+		Writer.AddInt("x", a_ChunkX * 16 + i % 16);
+		Writer.AddInt("y", 70 + i / 16);
+		Writer.AddInt("z", 0);
+		Writer.BeginList("Items", TAG_Compound);
+		for (int Slot = 0; Slot < 27; Slot++)
+		{
+			AddItem(Writer, Slot, "minecraft:wheat", static_cast<unsigned char>(1 + Slot));
+		}
+		Writer.EndList();
+		Writer.EndCompound();
+	}
+	Writer.EndList();
+
+	Writer.BeginList("TileTicks", TAG_Compound);
+	for (int i = 0; i < NUM_TILE_TICKS; i++)
+	{
+		Writer.BeginCompound("");
+		Writer.AddString("i", "minecraft:flowing_water");
+		Writer.AddInt("p", 0);
+		Writer.AddInt("t", i % 10);
+		Writer.AddInt("x", a_ChunkX * 16 + i % 16);
+		Writer.AddInt("y", i / 256);
+		Writer.AddInt("z", (i / 16) % 16);
+		Writer.EndCompound();
+	}
+	Writer.EndList();
+	Writer.EndCompound();
+	Writer.Finish();
+	return ContiguousByteBuffer(Writer.GetResult());
+}
+
+
+
+
+
+/** Reads all the chunks from the specified region file and appends their NBTs to a_Chunks. */
+static void ReadRegionFile(const AString & a_FileName, std::vector<ContiguousByteBuffer> & a_Chunks)
+{
+	const auto Contents = cFile::ReadWholeFile(a_FileName);
+	const auto Data = reinterpret_cast<const std::byte *>(Contents.data());
+	if (Contents.size() < 8192)
+	{
+		throw std::runtime_error(fmt::format("File \"{}\" is not a region file.", a_FileName));
+	}
+
+	Compression::Extractor Extractor;
+	for (size_t i = 0; i < 1024; i++)
+	{
+		// The header contains the 3-byte offset and 1-byte size of each chunk, in 4 KiB sectors:
+		const auto Location = static_cast<UInt32>(GetBEInt(Data + i * 4));
+		const auto Offset = static_cast<size_t>(Location >> 8) * 4096;
+		if ((Location == 0) || (Offset + 5 > Contents.size()))
+		{
+			continue;
+		}
+
+		// Each chunk starts with its 4-byte length and 1-byte compression method:
+		const auto Length = static_cast<size_t>(GetBEInt(Data + Offset));
+		if ((Length < 1) || (Offset + 4 + Length > Contents.size()) || (Data[Offset + 4] != std::byte(2)))
+		{
+			// Invalid or not ZLib-compressed, skip
+			continue;
+		}
+		const auto Extracted = Extractor.ExtractZLib({Data + Offset + 5, Length - 1});
+		a_Chunks.emplace_back(Extracted.GetView());
+	}
+	LOG("Read %zu chunks from \"%s\"", a_Chunks.size(), a_FileName.c_str());
+}
+
+
+
+
+
+/** Does the same lookups as cWSSAnvil does when loading the chunk and returns a checksum of the values found. */
+static UInt64 LoadChunk(const cParsedNBT & a_NBT)
+{
+	UInt64 Checksum = 0;
+	auto AddInt = [&](int a_Tag)
+	{
+		if ((a_Tag >= 0) && (a_NBT.GetType(a_Tag) == TAG_Int))
+		{
+			Checksum = Checksum * 31 + static_cast<UInt64>(a_NBT.GetInt(a_Tag));
+		}
+	};
+	auto AddPresence = [&](int a_Tag)
+	{
+		Checksum = Checksum * 31 + ((a_Tag >= 0) ? 1 : 0);
+	};
+
+	const auto Level = a_NBT.FindChildByName(0, "Level");
+	if (Level < 0)
+	{
+		return 0;
+	}
+	AddInt(a_NBT.FindChildByName(Level, "xPos"));
+	AddInt(a_NBT.FindChildByName(Level, "zPos"));
+
+	const auto Sections = a_NBT.FindChildByName(Level, "Sections");
+	if (Sections >= 0)
+	{
+		for (int Section = a_NBT.GetFirstChild(Sections); Section >= 0; Section = a_NBT.GetNextSibling(Section))
+		{
+			for (const auto & Name: {"Y", "Blocks", "Add", "Data", "BlockLight", "SkyLight"})
+			{
+				const auto Child = a_NBT.FindChildByName(Section, Name);
+				AddPresence(Child);
+				if ((Child >= 0) && (a_NBT.GetType(Child) == TAG_ByteArray) && (a_NBT.GetDataLength(Child) > 0))
+				{
+					Checksum = Checksum * 31 + static_cast<UInt64>(a_NBT.GetData(Child)[0]);
+				}
+			}
+		}
+	}
+	AddPresence(a_NBT.FindChildByName(Level, "Biomes"));
+	AddPresence(a_NBT.FindChildByName(Level, "MCSBiomes"));
+	AddPresence(a_NBT.FindChildByName(Level, "HeightMap"));
+
+	const auto Entities = a_NBT.FindChildByName(Level, "Entities");
+	if ((Entities >= 0) && (a_NBT.GetType(Entities) == TAG_List))
+	{
+		for (int Entity = a_NBT.GetFirstChild(Entities); Entity >= 0; Entity = a_NBT.GetNextSibling(Entity))
+		{
+			for (const auto & Name: {
+				"id", "Pos", "Motion", "Rotation", "Health", "Fire", "OnGround", "Air", "DropChances", "HandDropChances",
+				"ArmorDropChances", "CanPickUpLoot", "CustomName", "CustomNameVisible", "Age", "InLove", "Equipment"
+			})
+			{
+				AddPresence(a_NBT.FindChildByName(Entity, Name));
+			}
+			AddInt(a_NBT.FindChildByName(Entity, "Age"));
+		}
+	}
+
+	const auto BlockEntities = a_NBT.FindChildByName(Level, "TileEntities");
+	if ((BlockEntities >= 0) && (a_NBT.GetType(BlockEntities) == TAG_List))
+	{
+		for (int BlockEntity = a_NBT.GetFirstChild(BlockEntities); BlockEntity >= 0; BlockEntity = a_NBT.GetNextSibling(BlockEntity))
+		{
+			AddInt(a_NBT.FindChildByName(BlockEntity, "x"));
+			AddInt(a_NBT.FindChildByName(BlockEntity, "y"));
+			AddInt(a_NBT.FindChildByName(BlockEntity, "z"));
+			AddPresence(a_NBT.FindChildByName(BlockEntity, "id"));
+			const auto Items = a_NBT.FindChildByName(BlockEntity, "Items");
+			if ((Items < 0) || (a_NBT.GetType(Items) != TAG_List))
+			{
+				continue;
+			}
+			for (int Item = a_NBT.GetFirstChild(Items); Item >= 0; Item = a_NBT.GetNextSibling(Item))
+			{
+				for (const auto & Name: {"Slot", "id", "Count", "Damage", "tag"})
+				{
+					AddPresence(a_NBT.FindChildByName(Item, Name));
+				}
+			}
+		}
+	}
+	return Checksum;
+}
+
+
+
+
+
+/** Checks that FindChildByName() finds the same child as a linear search by the name, for all the children of all the compounds. */
+static void CheckLookups(const cParsedNBT & a_NBT, int a_Tag)
+{
+	for (int Child = a_NBT.GetFirstChild(a_Tag); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+	{
+		if (a_NBT.GetType(a_Tag) == TAG_Compound)
+		{
+			// The first child of the name is the expected result:
+			const auto Name = a_NBT.GetName(Child);
+			int Expected = a_NBT.GetFirstChild(a_Tag);
+			while (a_NBT.GetName(Expected) != Name)
+			{
+				Expected = a_NBT.GetNextSibling(Expected);
+			}
+			TEST_EQUAL(a_NBT.FindChildByName(a_Tag, Name), Expected);
+		}
+		CheckLookups(a_NBT, Child);
+	}
+	if (a_NBT.GetType(a_Tag) == TAG_Compound)
+	{
+		TEST_EQUAL(a_NBT.FindChildByName(a_Tag, "NonexistentTag"), -1);
+	}
+}
+
+
+
+
+
+/** Checks that the lazy tags are exactly the tags that the full parse has children for, and that they parse into the same trees.
+Returns the number of lazy tags found. */
+static int CheckLazyTags(const cParsedNBT & a_Full, int a_FullTag, const cParsedNBT & a_Lazy, int a_LazyTag)
+{
+	TEST_EQUAL(a_Full.GetType(a_FullTag), a_Lazy.GetType(a_LazyTag));
+	TEST_EQUAL(a_Full.GetName(a_FullTag), a_Lazy.GetName(a_LazyTag));
+	if (a_Lazy.IsLazy(a_LazyTag))
+	{
+		cParsedNBT Subtree(a_Lazy, a_LazyTag);
+		TEST_TRUE(Subtree.IsValid());
+		TEST_FALSE(Subtree.IsLazy(Subtree.GetRoot()));
+		CheckLazyTags(a_Full, a_FullTag, Subtree, Subtree.GetRoot());
+		return 1;
+	}
+
+	int NumLazy = 0;
+	int LazyChild = a_Lazy.GetFirstChild(a_LazyTag);
+	for (int FullChild = a_Full.GetFirstChild(a_FullTag); FullChild >= 0; FullChild = a_Full.GetNextSibling(FullChild))
+	{
+		TEST_GREATER_THAN_OR_EQUAL(LazyChild, 0);
+		NumLazy += CheckLazyTags(a_Full, FullChild, a_Lazy, LazyChild);
+		LazyChild = a_Lazy.GetNextSibling(LazyChild);
+	}
+	TEST_EQUAL(LazyChild, -1);
+	return NumLazy;
+}
+
+
+
+
+
+/** Checks that both parsing modes give the same results on all the chunks. */
+static void TestConsistency(const std::vector<ContiguousByteBuffer> & a_Chunks)
+{
+	int NumLazy = 0;
+	for (const auto & Chunk: a_Chunks)
+	{
+		cParsedNBT Full(Chunk);
+		cParsedNBT Lazy(Chunk, cWSSAnvil::UnusedTags);
+		TEST_TRUE(Full.IsValid());
+		TEST_TRUE(Lazy.IsValid());
+		CheckLookups(Full, Full.GetRoot());
+		CheckLookups(Lazy, Lazy.GetRoot());
+		NumLazy += CheckLazyTags(Full, Full.GetRoot(), Lazy, Lazy.GetRoot());
+		TEST_EQUAL(LoadChunk(Full), LoadChunk(Lazy));
+	}
+	LOG("Checked %zu chunks, %d tags skipped lazily", a_Chunks.size(), NumLazy);
+}
+
+
+
+
+
+/** Parses and loads all the chunks repeatedly, with or without the lazy tags, and logs the time it took. */
+static void Benchmark(const std::vector<ContiguousByteBuffer> & a_Chunks, bool a_UseLazyTags)
+{
+	size_t NumBytes = 0;
+	for (const auto & Chunk: a_Chunks)
+	{
+		NumBytes += Chunk.size();
+	}
+
+	UInt64 Checksum = 0;
+	const auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < NUM_REPETITIONS; i++)
+	{
+		for (const auto & Chunk: a_Chunks)
+		{
+			if (a_UseLazyTags)
+			{
+				Checksum += LoadChunk(cParsedNBT(Chunk, cWSSAnvil::UnusedTags));
+			}
+			else
+			{
+				Checksum += LoadChunk(cParsedNBT(Chunk));
+			}
+		}
+	}
+	const auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(std::chrono::steady_clock::now() - Start);
+	const auto NumLoads = static_cast<double>(a_Chunks.size()) * NUM_REPETITIONS;
+	LOG("%s parse: %.1f usec per chunk, %.1f MiB/s (checksum %llu)",
+		a_UseLazyTags ? "Lazy" : "Full",
+		Elapsed.count() / NumLoads,
+		static_cast<double>(NumBytes) * NUM_REPETITIONS / (1024 * 1024) / (Elapsed.count() / 1e6),
+		static_cast<unsigned long long>(Checksum)
+	);
+}
+
+
+
+
+
+/** Generates the chunks repeatedly and logs the time it took, to measure the writer. */
+static void BenchmarkWriting(void)
+{
+	size_t NumBytes = 0;
+	const auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < NUM_REPETITIONS; i++)
+	{
+		for (int ChunkX = 0; ChunkX < NUM_GENERATED_CHUNKS; ChunkX++)
+		{
+			NumBytes += GenerateChunk(ChunkX).size();
+		}
+	}
+	const auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(std::chrono::steady_clock::now() - Start);
+	LOG("Write: %.1f usec per chunk, %.1f MiB/s",
+		Elapsed.count() / (NUM_GENERATED_CHUNKS * NUM_REPETITIONS),
+		static_cast<double>(NumBytes) / (1024 * 1024) / (Elapsed.count() / 1e6)
+	);
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOG("Test started");
+
+	try
+	{
+		std::vector<ContiguousByteBuffer> Chunks;
+		if (argc > 1)
+		{
+			for (int i = 1; i < argc; i++)
+			{
+				ReadRegionFile(argv[i], Chunks);
+			}
+		}
+		else
+		{
+			LOG("No region files given, generating %d chunks. Usage: %s [<region file> ...]", NUM_GENERATED_CHUNKS, argv[0]);
+			for (int i = 0; i < NUM_GENERATED_CHUNKS; i++)
+			{
+				Chunks.push_back(GenerateChunk(i));
+			}
+		}
+
+		TestConsistency(Chunks);
+		Benchmark(Chunks, false);
+		Benchmark(Chunks, true);
+		BenchmarkWriting();
+	}
+	catch (const TestException & exc)
+	{
+		LOGERROR("Test has failed at file %s, line %d, function %s: %s",
+			exc.mFileName.c_str(),
+			exc.mLineNumber,
+			exc.mFunctionName.c_str(),
+			exc.mMessage.c_str()
+		);
+		return 1;
+	}
+	catch (const std::exception & exc)
+	{
+		LOGERROR("Test has failed, an exception was thrown: %s", exc.what());
+		return 1;
+	}
+
+	LOG("Test finished");
+	return 0;
+}
@@ -0,0 +1,188 @@
+
+// FluidSectionClassifierTest.cpp
+
+// Tests that the cFluidSectionClassifier class skips only the fluid blocks that stay unchanged,
+// and keeps the ones next to the other fluid, so that they still react with it
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockType.h"
+#include "Simulator/FluidSectionClassifier.h"
+
+
+
+
+
+/** The section that holds the fluid in the tests; the section below is filled with stone. */
+static const size_t FLUID_SECTION = 1;
+
+/** The Y coord of the middle of FLUID_SECTION. */
+static const int MIDDLE_Y = static_cast<int>(FLUID_SECTION) * cChunkDef::SectionHeight + cChunkDef::SectionHeight / 2;
+
+
+
+
+
+/** Returns the settled neighbour table used by the simulators: everything but air and the fluids. */
+static std::array<bool, 256> GetSettledNeighbors()
+{
+	std::array<bool, 256> Res;
+	for (size_t i = 0; i < Res.size(); i++)
+	{
+		Res[i] = (i != E_BLOCK_AIR) && ((i < E_BLOCK_WATER) || (i > E_BLOCK_STATIONARY_LAVA));
+	}
+	return Res;
+}
+
+
+
+
+
+/** Fills the section below FLUID_SECTION with stone and FLUID_SECTION with sources of the specified fluid. */
+static void FillPool(ChunkBlockData & a_BlockData, BLOCKTYPE a_Fluid)
+{
+	for (int y = 0; y < static_cast<int>(FLUID_SECTION + 1) * cChunkDef::SectionHeight; y++)
+	{
+		for (int z = 0; z < cChunkDef::Width; z++)
+		{
+			for (int x = 0; x < cChunkDef::Width; x++)
+			{
+				a_BlockData.SetBlock({x, y, z}, (y < cChunkDef::SectionHeight * static_cast<int>(FLUID_SECTION)) ? static_cast<BLOCKTYPE>(E_BLOCK_STONE) : static_cast<BLOCKTYPE>(a_Fluid));
+			}
+		}
+	}
+}
+
+
+
+
+
+/** Returns the bitmap with all the blocks of the section scheduled. */
+static cFluidSectionClassifier::cSectionBitmap ScheduleAll()
+{
+	cFluidSectionClassifier::cSectionBitmap Res;
+	Res.fill(~UInt64(0));
+	return Res;
+}
+
+
+
+
+
+/** Returns true if the block, given by its absolute coords within FLUID_SECTION, is scheduled in the bitmap. */
+static bool IsScheduled(const cFluidSectionClassifier::cSectionBitmap & a_Scheduled, Vector3i a_Pos)
+{
+	const auto Index = cChunkDef::MakeIndex(a_Pos.x, a_Pos.y - static_cast<int>(FLUID_SECTION) * cChunkDef::SectionHeight, a_Pos.z);
+	return (a_Scheduled[Index / cFluidSectionClassifier::BitsPerWord] & (UInt64(1) << (Index % cFluidSectionClassifier::BitsPerWord))) != 0;
+}
+
+
+
+
+
+/** Tests that a pool of a single fluid has its inside skipped, but not its borders and top. */
+static void TestPool()
+{
+	ChunkBlockData BlockData;
+	FillPool(BlockData, E_BLOCK_STATIONARY_WATER);
+	cFluidSectionClassifier Classifier(E_BLOCK_WATER, E_BLOCK_STATIONARY_WATER, GetSettledNeighbors());
+	auto Scheduled = ScheduleAll();
+	Classifier.RemoveSettledBlocks(BlockData, FLUID_SECTION, Scheduled);
+
+	TEST_FALSE(IsScheduled(Scheduled, {8, MIDDLE_Y, 8}));
+	TEST_FALSE(IsScheduled(Scheduled, {1, MIDDLE_Y + 7, 14}));
+
+	// The border blocks have neighbours in other chunks, they are always simulated:
+	TEST_TRUE(IsScheduled(Scheduled, {0, MIDDLE_Y, 8}));
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y, 15}));
+
+	// A source above air flows down into it, the source above that one is settled on the one below:
+	BlockData.SetBlock({8, MIDDLE_Y - 1, 8}, E_BLOCK_AIR);
+	Scheduled = ScheduleAll();
+	Classifier.RemoveSettledBlocks(BlockData, FLUID_SECTION, Scheduled);
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y, 8}));
+	TEST_FALSE(IsScheduled(Scheduled, {8, MIDDLE_Y + 1, 8}));
+}
+
+
+
+
+
+/** Tests that lava next to a water source stays scheduled, so that it hardens into obsidian. */
+static void TestLavaNextToWater()
+{
+	ChunkBlockData BlockData;
+	FillPool(BlockData, E_BLOCK_STATIONARY_LAVA);
+	BlockData.SetBlock({8, MIDDLE_Y, 8}, E_BLOCK_STATIONARY_WATER);
+	cFluidSectionClassifier Classifier(E_BLOCK_LAVA, E_BLOCK_STATIONARY_LAVA, GetSettledNeighbors());
+	auto Scheduled = ScheduleAll();
+	Classifier.RemoveSettledBlocks(BlockData, FLUID_SECTION, Scheduled);
+
+	TEST_TRUE(IsScheduled(Scheduled, {7, MIDDLE_Y, 8}));
+	TEST_TRUE(IsScheduled(Scheduled, {9, MIDDLE_Y, 8}));
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y, 7}));
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y, 9}));
+
+	// The lava above the water flows down into it:
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y + 1, 8}));
+
+	// The lava away from the water is skipped:
+	TEST_FALSE(IsScheduled(Scheduled, {8, MIDDLE_Y - 1, 8}));
+	TEST_FALSE(IsScheduled(Scheduled, {6, MIDDLE_Y, 8}));
+	TEST_FALSE(IsScheduled(Scheduled, {7, MIDDLE_Y, 7}));
+}
+
+
+
+
+
+/** Tests that water next to or above a lava source stays scheduled, so that it turns the lava into stone. */
+static void TestWaterNextToLava()
+{
+	ChunkBlockData BlockData;
+	FillPool(BlockData, E_BLOCK_STATIONARY_WATER);
+	BlockData.SetBlock({8, MIDDLE_Y, 8}, E_BLOCK_STATIONARY_LAVA);
+	cFluidSectionClassifier Classifier(E_BLOCK_WATER, E_BLOCK_STATIONARY_WATER, GetSettledNeighbors());
+	auto Scheduled = ScheduleAll();
+	Classifier.RemoveSettledBlocks(BlockData, FLUID_SECTION, Scheduled);
+
+	TEST_TRUE(IsScheduled(Scheduled, {7, MIDDLE_Y, 8}));
+	TEST_TRUE(IsScheduled(Scheduled, {9, MIDDLE_Y, 8}));
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y, 7}));
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y, 9}));
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y + 1, 8}));
+	TEST_FALSE(IsScheduled(Scheduled, {8, MIDDLE_Y - 1, 8}));
+	TEST_FALSE(IsScheduled(Scheduled, {8, MIDDLE_Y + 2, 8}));
+}
+
+
+
+
+
+/** Tests that flowing fluid and fluid next to flowing fluid stays scheduled. */
+static void TestFlowing()
+{
+	ChunkBlockData BlockData;
+	FillPool(BlockData, E_BLOCK_STATIONARY_WATER);
+	BlockData.SetBlock({8, MIDDLE_Y, 8}, E_BLOCK_WATER);
+	BlockData.SetMeta({8, MIDDLE_Y, 8}, 2);
+	cFluidSectionClassifier Classifier(E_BLOCK_WATER, E_BLOCK_STATIONARY_WATER, GetSettledNeighbors());
+	auto Scheduled = ScheduleAll();
+	Classifier.RemoveSettledBlocks(BlockData, FLUID_SECTION, Scheduled);
+
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y, 8}));
+	TEST_TRUE(IsScheduled(Scheduled, {7, MIDDLE_Y, 8}));
+	TEST_TRUE(IsScheduled(Scheduled, {8, MIDDLE_Y + 1, 8}));
+	TEST_FALSE(IsScheduled(Scheduled, {6, MIDDLE_Y, 8}));
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("FluidSectionClassifier",
+	TestPool();
+	TestLavaNextToWater();
+	TestWaterNextToLava();
+	TestFlowing();
+)
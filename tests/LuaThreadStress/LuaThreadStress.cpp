@@ -4,6 +4,7 @@
 
 #include "Globals.h"
 #include "Bindings/LuaState.h"
+#include "Bindings/LuaWorkerPool.h"
 #include <thread>
 #include <random>
 
@@ -14,6 +15,13 @@
 /** How long the threading test should run. */
 static const int NUM_SECONDS_TO_TEST = 10;
 
+/** Number of the workers in the worker test. */
+static const int NUM_WORKERS = 8;
+
+/** Number of the threads posting messages to the workers, and the number of messages each of them posts. */
+static const int NUM_POSTING_THREADS = 4;
+static const int NUM_MESSAGES_PER_THREAD = 10000;
+
 
 
 
@@ -138,6 +146,138 @@ static int DoTest(void)
 
 
 
+/** Posts messages to random workers from a separate Lua state, as a plugin would.
+Each message is (Seed, Value, {Seed, Seed + 1, Seed + 2}), with the seeds unique across all the threads. */
+static void runPosting(std::vector<cLuaWorkerPtr> * a_Workers, int a_ThreadIdx, std::atomic<int> * a_FailResult)
+{
+	cLuaState L("LuaThreadStress posting thread");
+	L.Create();
+	std::minstd_rand rnd;
+	rnd.seed(static_cast<unsigned>(a_ThreadIdx));
+	for (int i = 0; i < NUM_MESSAGES_PER_THREAD; ++i)
+	{
+		cLuaState::cLock lock(L);
+		auto seed = a_ThreadIdx * NUM_MESSAGES_PER_THREAD + i;
+		lua_pushnumber(L, seed);
+		lua_pushnumber(L, static_cast<lua_Number>(rnd() % 1000));
+		lua_createtable(L, 3, 0);
+		for (int j = 0; j < 3; ++j)
+		{
+			lua_pushnumber(L, seed + j);
+			lua_rawseti(L, -2, j + 1);
+		}
+		auto & worker = (*a_Workers)[rnd() % a_Workers->size()];
+		if (!worker->Post(L, 1, 3))
+		{
+			LOGWARNING("Failed to post a message to a worker");
+			*a_FailResult = 5;
+		}
+		lua_settop(L, 0);
+	}
+}
+
+
+
+
+
+static int DoWorkerTest(void)
+{
+	cLuaState L("LuaThreadStress worker test");
+	L.Create();
+	if (!L.LoadFile("Test.lua"))
+	{
+		return 4;
+	}
+
+	// Create the workers, all delivering their messages into L:
+	cLuaWorkerPool pool(4);
+	std::vector<cLuaWorkerPtr> workers;
+	for (int i = 0; i < NUM_WORKERS; ++i)
+	{
+		cLuaState::cCallbackPtr callback;
+		{
+			cLuaState::cLock lock(L);
+			L.GetNamedGlobal("onWorkerMessage", callback);
+		}
+		auto worker = std::make_shared<cLuaWorker>(pool, std::move(callback), Printf("TestWorker %d", i));
+		if (!worker->Open("TestWorker.lua", worker))
+		{
+			return 4;
+		}
+		workers.push_back(worker);
+	}
+
+	// Post the messages from several threads at once:
+	std::atomic<int> failResult(0);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < NUM_POSTING_THREADS; ++i)
+	{
+		threads.emplace_back(runPosting, &workers, i, &failResult);
+	}
+	for (auto & t: threads)
+	{
+		t.join();
+	}
+
+	// Wait for all the answers:
+	const int numExpected = NUM_POSTING_THREADS * NUM_MESSAGES_PER_THREAD;
+	int numReceived = 0, numBad = 0;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		{
+			cLuaState::cLock lock(L);
+			L.Call("getWorkerStats", cLuaState::Return, numReceived, numBad);
+		}
+		if (numReceived >= numExpected)
+		{
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	LOG("Workers answered %d out of %d messages, %d answers were bad.", numReceived, numExpected, numBad);
+	if ((numReceived != numExpected) || (numBad != 0))
+	{
+		return 6;
+	}
+
+	// Close a worker while it still has messages to process, it must not accept any more:
+	{
+		cLuaState::cLock lock(L);
+		for (int i = 0; i < 1000; ++i)
+		{
+			lua_pushnumber(L, i);
+			lua_pushnumber(L, i);
+			lua_createtable(L, 0, 0);
+			workers[0]->Post(L, 1, 3);
+			lua_settop(L, 0);
+		}
+	}
+	workers[0]->Close();
+	{
+		cLuaState::cLock lock(L);
+		lua_pushnumber(L, 0);
+		if (workers[0]->IsOpen() || workers[0]->Post(L, 1, 1))
+		{
+			LOGWARNING("A closed worker still accepts messages");
+			failResult = 7;
+		}
+		lua_settop(L, 0);
+	}
+
+	// Release the workers, as Lua's garbage collector would:
+	for (auto & worker: workers)
+	{
+		worker->Release();
+	}
+	workers.clear();
+	return failResult.load();
+}
+
+
+
+
+
 int main()
 {
 	LOG("LuaThreadStress starting.");
@@ -149,6 +289,14 @@ int main()
 		return res;
 	}
 
+	LOG("LuaThreadStress worker test starting.");
+	res = DoWorkerTest();
+	LOG("LuaThreadStress worker test done: %s", (res == 0) ? "success" : "failure");
+	if (res != 0)
+	{
+		return res;
+	}
+
 	LOG("LuaThreadStress finished.");
 	return 0;
 }
@@ -15,3 +15,36 @@ function getCallback(a_Seed)
 		return a_Param + a_Seed
 	end
 end
+
+
+
+
+
+--- Number of the messages received from the workers, and how many of them had unexpected contents
+g_NumWorkerMessages = 0
+g_NumBadWorkerMessages = 0
+
+--- The callback receiving the messages posted by the workers running TestWorker.lua
+-- The C++ code posts (Seed, Value, {Seed, Seed + 1, Seed + 2}) to the worker, which answers with (Seed, 2 * Value, Sum, {seed = Seed, nested = {Value}})
+function onWorkerMessage(a_Seed, a_DoubleValue, a_Sum, a_Table)
+	g_NumWorkerMessages = g_NumWorkerMessages + 1
+	if (
+		(type(a_Table) ~= "table") or
+		(a_Table.seed ~= a_Seed) or
+		(type(a_Table.nested) ~= "table") or
+		(a_Table.nested[1] * 2 ~= a_DoubleValue) or
+		(a_Sum ~= 3 * a_Seed + 3)
+	) then
+		print("Bad message received from a worker for seed " .. tostring(a_Seed))
+		g_NumBadWorkerMessages = g_NumBadWorkerMessages + 1
+	end
+end
+
+
+
+
+
+--- Returns the number of the messages received from the workers and the number of the bad ones among them
+function getWorkerStats()
+	return g_NumWorkerMessages, g_NumBadWorkerMessages
+end
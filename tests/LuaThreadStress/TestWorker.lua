@@ -0,0 +1,27 @@
+-- TestWorker.lua
+
+-- Implements the worker side of the cLuaWorker test
+-- This file is loaded into each cLuaWorker's state
+
+
+
+
+
+-- The workers must not have access to the server API nor to the files and the process:
+assert(cRoot == nil)
+assert(io == nil)
+assert(os.exit == nil)
+assert(os.time ~= nil)
+
+
+
+
+
+--- Handles a message posted by the C++ code, answers with the values computed from it
+function OnMessage(a_Seed, a_Value, a_Table)
+	local sum = 0
+	for _, v in ipairs(a_Table) do
+		sum = sum + v
+	end
+	PostMessage(a_Seed, a_Value * 2, sum, {seed = a_Seed, nested = {a_Value}})
+end
@@ -0,0 +1,235 @@
+// StressQueues.cpp
+
+// Stress-tests the lock-free queues and compares their throughput to cQueue
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "OSSupport/LockFreeQueue.h"
+#include "OSSupport/Queue.h"
+
+
+
+
+
+/** Number of items pushed by each producer thread. */
+static const int NUM_ITEMS = 200000;
+
+/** Number of producer (and, for cMpmcQueue, consumer) threads in the multi-threaded tests. */
+static const int NUM_THREADS = 4;
+
+/** Capacity of the bounded queues; kept small so that the producers run into a full queue often. */
+static const size_t QUEUE_CAPACITY = 256;
+
+
+
+
+
+/** Encodes the producer index and the per-producer sequence number into a single queue item. */
+static int MakeItem(int a_Producer, int a_Sequence)
+{
+	return a_Producer * NUM_ITEMS + a_Sequence;
+}
+
+
+
+
+
+/** Logs the throughput and the contention counters of a single run. */
+static void LogResult(const char * a_Name, int a_NumItems, std::chrono::steady_clock::duration a_Duration, const sQueueStats & a_Stats)
+{
+	auto Msec = std::max<long long>(1, std::chrono::duration_cast<std::chrono::milliseconds>(a_Duration).count());
+	LOG("%s: %d items in %lld msec (%lld items / sec); retries: %llu, full: %llu, parks: %llu",
+		a_Name, a_NumItems, Msec, static_cast<long long>(a_NumItems) * 1000 / Msec,
+		static_cast<unsigned long long>(a_Stats.m_NumRetries),
+		static_cast<unsigned long long>(a_Stats.m_NumFull),
+		static_cast<unsigned long long>(a_Stats.m_NumParks)
+	);
+}
+
+
+
+
+
+/** A single producer pushes a sequence, a single consumer checks that it arrives complete and in order. */
+static void TestSpsc()
+{
+	cSpscQueue<int> Queue(QUEUE_CAPACITY);
+	TEST_EQUAL(Queue.GetCapacity(), QUEUE_CAPACITY);
+	TEST_TRUE(Queue.IsEmpty());
+
+	auto StartTime = std::chrono::steady_clock::now();
+	std::thread Producer([&Queue]()
+		{
+			for (int i = 0; i < NUM_ITEMS; i++)
+			{
+				Queue.Push(i);
+			}
+		}
+	);
+	int NumOutOfOrder = 0;
+	for (int i = 0; i < NUM_ITEMS; i++)
+	{
+		if (Queue.Pop() != i)
+		{
+			NumOutOfOrder += 1;
+		}
+	}
+	Producer.join();
+	LogResult("cSpscQueue", NUM_ITEMS, std::chrono::steady_clock::now() - StartTime, Queue.GetStats());
+
+	TEST_EQUAL(NumOutOfOrder, 0);
+	TEST_TRUE(Queue.IsEmpty());
+	int Dummy;
+	TEST_TRUE(!Queue.TryPop(Dummy));
+}
+
+
+
+
+
+/** Several producers push their own sequences, the single consumer checks that each sequence arrives complete and in order. */
+static void TestMpsc()
+{
+	cMpscQueue<int> Queue;
+	auto StartTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> Producers;
+	for (int p = 0; p < NUM_THREADS; p++)
+	{
+		Producers.emplace_back([&Queue, p]()
+			{
+				for (int i = 0; i < NUM_ITEMS; i++)
+				{
+					Queue.Push(MakeItem(p, i));
+				}
+			}
+		);
+	}
+	std::vector<int> NextSequence(NUM_THREADS, 0);
+	int NumOutOfOrder = 0;
+	for (int i = 0; i < NUM_ITEMS * NUM_THREADS; i++)
+	{
+		auto Item = Queue.Pop();
+		auto Producer = Item / NUM_ITEMS;
+		if (Item % NUM_ITEMS != NextSequence[static_cast<size_t>(Producer)]++)
+		{
+			NumOutOfOrder += 1;
+		}
+	}
+	for (auto & Producer: Producers)
+	{
+		Producer.join();
+	}
+	LogResult("cMpscQueue", NUM_ITEMS * NUM_THREADS, std::chrono::steady_clock::now() - StartTime, Queue.GetStats());
+
+	TEST_EQUAL(NumOutOfOrder, 0);
+	TEST_TRUE(Queue.IsEmpty());
+	Queue.WaitUntilEmpty();  // Must not block on an empty queue
+
+	// Items left in the queue are destroyed with it:
+	cMpscQueue<std::unique_ptr<int>> Owning;
+	Owning.Push(std::make_unique<int>(1));
+	Owning.Push(std::make_unique<int>(2));
+	TEST_EQUAL(Owning.Size(), 2);
+	TEST_EQUAL(*Owning.Pop(), 1);
+}
+
+
+
+
+
+/** Several producers and several consumers share the queue, checks that every item is popped exactly once. */
+static void TestMpmc()
+{
+	cMpmcQueue<int> Queue(QUEUE_CAPACITY);
+	std::atomic<long long> Sum(0);
+	auto StartTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> Threads;
+	for (int t = 0; t < NUM_THREADS; t++)
+	{
+		Threads.emplace_back([&Queue, t]()
+			{
+				for (int i = 0; i < NUM_ITEMS; i++)
+				{
+					Queue.Push(MakeItem(t, i));
+				}
+			}
+		);
+		Threads.emplace_back([&Queue, &Sum]()
+			{
+				long long LocalSum = 0;
+				int Item;
+				for (int i = 0; i < NUM_ITEMS; i++)
+				{
+					Queue.Pop(Item);
+					LocalSum += Item;
+				}
+				Sum += LocalSum;
+			}
+		);
+	}
+	for (auto & Thread: Threads)
+	{
+		Thread.join();
+	}
+	LogResult("cMpmcQueue", NUM_ITEMS * NUM_THREADS, std::chrono::steady_clock::now() - StartTime, Queue.GetStats());
+
+	long long Expected = 0;
+	for (int i = 0; i < NUM_ITEMS * NUM_THREADS; i++)
+	{
+		Expected += i;
+	}
+	TEST_EQUAL(Sum.load(), Expected);
+	TEST_TRUE(Queue.IsEmpty());
+
+	// A full queue refuses items without consuming them:
+	cMpmcQueue<std::unique_ptr<int>> Small(2);
+	TEST_TRUE(Small.TryPush(std::make_unique<int>(1)));
+	TEST_TRUE(Small.TryPush(std::make_unique<int>(2)));
+	auto Extra = std::make_unique<int>(3);
+	TEST_TRUE(!Small.TryPush(std::move(Extra)));
+	TEST_TRUE((Extra != nullptr));
+	TEST_EQUAL(Small.GetStats().m_NumFull, 1);
+}
+
+
+
+
+
+/** Runs the same scenario as TestMpsc() on cQueue, as the baseline for the throughput comparison. */
+static void BenchmarkLockedQueue()
+{
+	cQueue<int> Queue;
+	auto StartTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> Producers;
+	for (int p = 0; p < NUM_THREADS; p++)
+	{
+		Producers.emplace_back([&Queue, p]()
+			{
+				for (int i = 0; i < NUM_ITEMS; i++)
+				{
+					Queue.EnqueueItem(MakeItem(p, i));
+				}
+			}
+		);
+	}
+	for (int i = 0; i < NUM_ITEMS * NUM_THREADS; i++)
+	{
+		Queue.DequeueItem();
+	}
+	for (auto & Producer: Producers)
+	{
+		Producer.join();
+	}
+	LogResult("cQueue", NUM_ITEMS * NUM_THREADS, std::chrono::steady_clock::now() - StartTime, sQueueStats());
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("StressQueues",
+	TestSpsc();
+	TestMpsc();
+	TestMpmc();
+	BenchmarkLockedQueue();
+)